@@ -0,0 +1,103 @@
+#include "config/RootDir.h"
+#include "utils/logger/Logger.hpp"
+#include "utils/model-loader/MeshFile.hpp"
+#include "utils/model-loader/ModelLoader.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// cooks model sources into the engine's .mesh files next to them, in both vertex formats, so the
+// engine maps them instead of importing the sources on every start
+//
+// usage: mesh-cooker [--force] [<model> ...]
+// without models, everything under resources/models is cooked, files that are already newer than
+// their source are skipped unless --force is given
+
+namespace {
+bool _isModelSource(std::filesystem::path const &path) {
+    auto const extension = path.extension().string();
+    return extension == ".gltf" || extension == ".glb" || extension == ".obj" ||
+           extension == ".fbx";
+}
+
+std::vector<std::string> _findModelSources() {
+    std::vector<std::string> sourcePaths;
+    std::error_code errorCode;
+    for (auto const &entry : std::filesystem::recursive_directory_iterator(
+             kPathToResourceFolder + "models/", errorCode)) {
+        if (entry.is_regular_file() && _isModelSource(entry.path())) {
+            sourcePaths.push_back(entry.path().generic_string());
+        }
+    }
+    return sourcePaths;
+}
+
+bool _cook(std::string const &sourcePath, VertexFormat vertexFormat, Logger *logger) {
+    auto const model = ModelLoader::loadModelFromPath(sourcePath, logger, vertexFormat);
+    if (!model) {
+        return false;
+    }
+
+    // written next to the final file and renamed, so the engine never maps half a file
+    std::string const cookedPath    = MeshFile::getCookedPath(sourcePath, vertexFormat);
+    std::string const temporaryPath = cookedPath + ".tmp";
+    std::error_code errorCode;
+    if (!MeshFile::write(temporaryPath, *model, vertexFormat)) {
+        std::filesystem::remove(temporaryPath, errorCode);
+        logger->error("mesh-cooker: failed to write {}", cookedPath);
+        return false;
+    }
+    std::filesystem::rename(temporaryPath, cookedPath, errorCode);
+    if (errorCode) {
+        std::filesystem::remove(temporaryPath, errorCode);
+        logger->error("mesh-cooker: failed to replace {}", cookedPath);
+        return false;
+    }
+    logger->info("mesh-cooker: cooked {} ({} meshes)", cookedPath, model->meshes.size());
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    Logger logger{};
+
+    bool isForced = false;
+    std::vector<std::string> sourcePaths;
+    for (int i = 1; i < argc; i++) {
+        std::string const argument = argv[i];
+        if (argument == "--force") {
+            isForced = true;
+        } else {
+            // the engine and the loader split paths at forward slashes
+            sourcePaths.push_back(std::filesystem::path(argument).generic_string());
+        }
+    }
+    if (sourcePaths.empty()) {
+        sourcePaths = _findModelSources();
+    }
+
+    size_t cookedCount  = 0;
+    size_t skippedCount = 0;
+    size_t failedCount  = 0;
+    for (auto const &sourcePath : sourcePaths) {
+        for (auto const vertexFormat : {VertexFormat::kFloat, VertexFormat::kQuantized}) {
+            if (!isForced &&
+                MeshFile::isFresh(sourcePath, MeshFile::getCookedPath(sourcePath, vertexFormat))) {
+                skippedCount++;
+                continue;
+            }
+            if (_cook(sourcePath, vertexFormat, &logger)) {
+                cookedCount++;
+            } else {
+                failedCount++;
+            }
+        }
+    }
+
+    logger.info("mesh-cooker: {} cooked, {} up to date, {} failed", cookedCount, skippedCount,
+                failedCount);
+    return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -13,6 +13,7 @@ FOR %%a IN (%*) DO (
     REM check if this is a game main parameter
     if [%%a] == [GameScript] set GAME_MAIN=GameScript
     if [%%a] == [Benchmark] set GAME_MAIN=Benchmark
+    if [%%a] == [BenchmarkPerEntity] set GAME_MAIN=BenchmarkPerEntity
 )
 
 set BINARY_DIR=build/%BUILD_TYPE%/
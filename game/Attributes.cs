@@ -1,4 +1,5 @@
 using System;
+using System.Linq;
 
 namespace Game
 {
@@ -8,10 +9,68 @@ namespace Game
     [AttributeUsage(AttributeTargets.Method)]
     public class UpdateSystemAttribute : Attribute { }
 
+    // called once per chunk of up to ChunkSize entities, with a ComponentChunk<T> per queried
+    // component instead of a ref T, e.g. void Move(float dt, ComponentChunk<Transform> transforms)
+    [AttributeUsage(AttributeTargets.Method)]
+    public class ChunkedUpdateSystemAttribute : Attribute
+    {
+        public int ChunkSize { get; set; } = 1024;
+    }
+
+    // splits the entities of an update system into batches that the host hands to it from several
+    // threads at once, per entity systems in batches of 1024 entities and chunked ones chunk by
+    // chunk, so it must only touch the entities it is handed and guard any static state it writes
+    [AttributeUsage(AttributeTargets.Method)]
+    public class ParallelAttribute : Attribute { }
+
+    // declares an owning group on a system class: the host keeps the owned components packed in
+    // the same order and walks the group for every query covering it, a component can be owned
+    // by one group only, the ones in Get are only looked up
+    // the host needs the layout in g_group_factories, e.g.
+    // [OwningGroup(typeof(Velocity), Get = new[] { typeof(Transform) })]
+    [AttributeUsage(AttributeTargets.Class, AllowMultiple = true)]
+    public class OwningGroupAttribute : Attribute
+    {
+        public Type[] Owned { get; }
+        public Type[] Get { get; set; } = Type.EmptyTypes;
+        public OwningGroupAttribute(params Type[] owned) => Owned = owned;
+    }
+
+    // a struct the host stores as a component of the same name, size and alignment, registered
+    // at startup by its layout, e.g. [Component] public struct Velocity { public Vector3 velocity; }
+    // one the host has no type of its own for is kept from that layout alone: it can be added,
+    // removed, read, walked with EngineBindings.GetStorage, put in prefabs and filtered by
+    // With/Without, but not queried as a system parameter
+    [AttributeUsage(AttributeTargets.Struct)]
+    public class ComponentAttribute : Attribute { }
+
+    // a struct with no fields that only marks entities, the host keeps no values for it, e.g.
+    // [Tag] public struct Rat { }, see EngineBindings.AddTag
+    [AttributeUsage(AttributeTargets.Struct)]
+    public class TagAttribute : Attribute { }
+
+    // the components a system is handed, in the order of its parameters: the ones it writes,
+    // then the ones in ReadOnly, e.g. [Query(typeof(Transform), ReadOnly = new[] { typeof(Mesh) })]
+    // systems that don't write what the others read or write run concurrently with them, so
+    // static state shared between systems must be guarded, or only touched by systems that
+    // conflict on a component anyway
+    // the entities and components an update system creates, destroys, adds or removes take effect
+    // at the next sync point: before the next Exclusive system, which runs alone, or at the end
+    // of the frame, the id of a created entity can be used right away, to add components to it
+    // typeof(Entity) hands over the entity itself, it's only read, a query needs a component
+    // besides it, one the host has no kernel for is logged and not registered
+    // only the entities with every tag or component in With and none in Without are handed over,
+    // neither is a parameter, entities with the Disabled tag are skipped unless With names it
     [AttributeUsage(AttributeTargets.Method)]
     public class QueryAttribute : Attribute
     {
         public Type[] Components { get; }
+        public Type[] ReadOnly { get; set; } = Type.EmptyTypes;
+        public Type[] With { get; set; } = Type.EmptyTypes;
+        public Type[] Without { get; set; } = Type.EmptyTypes;
+        public bool Exclusive { get; set; }
         public QueryAttribute(params Type[] comps) => Components = comps;
+
+        public Type[] AllComponents => Components.Concat(ReadOnly).ToArray();
     }
 }
\ No newline at end of file
@@ -6,16 +6,26 @@ using System.Diagnostics;
 
 namespace Game
 {
-#if Benchmark
+// Benchmark dispatches the animation system in chunks, BenchmarkPerEntity once per entity, compare
+// the Runtime Update time both report with enableFrameTiming
+#if Benchmark || BenchmarkPerEntity
+    [OwningGroup(typeof(Transform), typeof(Mesh), typeof(Material))]
+    [OwningGroup(typeof(Velocity), Get = new[] { typeof(Transform) })]
     public static class BenchmarkSystems
     {
         private static float _testTimer = 0;  // 用于降低日志频率
         private static StreamWriter _logWriter = null;
+        // systems log from the scheduler's worker threads
+        private static readonly object _logLock = new object();
         
         // 基准测试变量
         private static List<uint> _benchmarkEntityIds = new List<uint>();
         private static uint _cameraId = 0;
         private static int _entityCount = 10000;
+        // e.g. set BENCHMARK_PER_ENTITY_CREATION=1 to create the entities with a host call per
+        // component of every entity instead of one per component type, to compare the two
+        private static bool _isPerEntityCreation = false;
+        private const int kBenchmarkModelId = 3;
         private static float _diskRadius = 10.0f;  // Configurable disk radius for entity placement
         private static Stopwatch _creationStopwatch = new Stopwatch();
         private static Stopwatch _frameStopwatch = new Stopwatch();
@@ -33,6 +43,14 @@ namespace Game
         {
             // Initialize logging system
             InitializeLogging();
+
+            // e.g. set BENCHMARK_ENTITY_COUNT=100000 to compare owning groups against views
+            if (int.TryParse(Environment.GetEnvironmentVariable("BENCHMARK_ENTITY_COUNT"), out int entityCount)
+                && entityCount > 0)
+            {
+                _entityCount = entityCount;
+            }
+            _isPerEntityCreation = Environment.GetEnvironmentVariable("BENCHMARK_PER_ENTITY_CREATION") == "1";
             Log("=== 🚀 Starting Benchmark System ===");
             Log($"🎯 Creating {_entityCount} entities for performance testing...");
 
@@ -43,20 +61,22 @@ namespace Game
             _creationStopwatch.Start();
 
             // Create benchmark entities
-            for (int i = 0; i < _entityCount; i++)
+            if (_isPerEntityCreation)
             {
-                CreateBenchmarkEntity(i);
-                
-                // Log progress every 1000 entities
-                if ((i + 1) % 1000 == 0)
+                for (int i = 0; i < _entityCount; i++)
                 {
-                    Log($"📊 Created {i + 1}/{_entityCount} entities...");
+                    CreateBenchmarkEntity(i);
                 }
             }
+            else
+            {
+                CreateBenchmarkEntitiesBulk();
+            }
 
             _creationStopwatch.Stop();
-            Log($"✅ Entity creation completed in {_creationStopwatch.ElapsedMilliseconds}ms");
-            Log($"⚡ Average time per entity: {_creationStopwatch.ElapsedMilliseconds / (double)_entityCount:F3}ms");
+            double creationMs = _creationStopwatch.Elapsed.TotalMilliseconds;
+            Log($"✅ Entity creation ({(_isPerEntityCreation ? "per entity" : "bulk")}) of {_entityCount} entities completed in {creationMs:F2}ms");
+            Log($"⚡ Average time per entity: {creationMs * 1000.0 / _entityCount:F3}µs");
 
             // Create camera for viewing
             CreateBenchmarkCamera();
@@ -105,9 +125,12 @@ namespace Game
                 string logMessage = $"[{timestamp}] {message}";
 
                 // Output to both console and log file
-                Console.WriteLine(logMessage);
-                _logWriter?.WriteLine(logMessage);
-                _logWriter?.Flush();  // Ensure immediate file write
+                lock (_logLock)
+                {
+                    Console.WriteLine(logMessage);
+                    _logWriter?.WriteLine(logMessage);
+                    _logWriter?.Flush();  // Ensure immediate file write
+                }
             }
             catch (Exception ex)
             {
@@ -145,12 +168,51 @@ namespace Game
             Log("=== All meshes registered successfully ===");
         }
 
+        // every component type of all the entities in one host call
+        private static void CreateBenchmarkEntitiesBulk()
+        {
+            var ids = new uint[_entityCount];
+            var transforms = new Transform[_entityCount];
+            var velocities = new Velocity[_entityCount];
+            var meshes = new Mesh[_entityCount];
+            var materials = new Material[_entityCount];
+            for (int i = 0; i < _entityCount; i++)
+            {
+                transforms[i] = CreateTransformForEntity(i);
+                meshes[i] = new Mesh { modelId = kBenchmarkModelId };
+                materials[i] = CreateMaterialForModel(kBenchmarkModelId, i);
+            }
+
+            EngineBindings.CreateEntities(ids);
+            EngineBindings.AddComponents<Transform>(ids, transforms);
+            EngineBindings.AddComponents<Velocity>(ids, velocities);
+            EngineBindings.AddComponents<Mesh>(ids, meshes);
+            EngineBindings.AddComponents<Material>(ids, materials);
+            _benchmarkEntityIds.AddRange(ids);
+        }
+
         private static void CreateBenchmarkEntity(int index)
         {
             // Create entity
             uint entityId = EngineBindings.CreateEntity();
             _benchmarkEntityIds.Add(entityId);
 
+            EngineBindings.AddComponent(entityId, CreateTransformForEntity(index));
+
+            // Add Velocity component for potential movement
+            var velocity = new Velocity { velocity = new Vector3(0, 0, 0) };
+            EngineBindings.AddComponent(entityId, velocity);
+
+            var mesh = new Mesh { modelId = kBenchmarkModelId };
+            EngineBindings.AddComponent(entityId, mesh);
+
+            // Add Material component with different colors based on model
+            var material = CreateMaterialForModel(kBenchmarkModelId, index);
+            EngineBindings.AddComponent(entityId, material);
+        }
+
+        private static Transform CreateTransformForEntity(int index)
+        {
             // Position entities randomly in a disk pattern
             var random = new Random(index + 42); // Use index as seed for reproducible randomness
             
@@ -167,29 +229,12 @@ namespace Game
             z *= _diskRadius;
             float y = 0;
 
-            // Add Transform component
-            var transform = new Transform 
+            return new Transform 
             { 
                 position = new Vector3(x, y, z), 
                 scale = new Vector3(0.5f), 
                 rotation = new Vector3(0, 0, 0) 
             };
-            
-            Log($"Adding transform: {transform.position}, {transform.scale}, {transform.rotation}");
-
-            EngineBindings.AddTransform(entityId, transform);
-
-            // Add Velocity component for potential movement
-            var velocity = new Velocity { velocity = new Vector3(0, 0, 0) };
-            EngineBindings.AddVelocity(entityId, velocity);
-
-            int modelId = 3;
-            var mesh = new Mesh { modelId = modelId };
-            EngineBindings.AddMesh(entityId, mesh);
-
-            // Add Material component with different colors based on model
-            var material = CreateMaterialForModel(modelId, index);
-            EngineBindings.AddMaterial(entityId, material);
         }
 
         private static Material CreateMaterialForModel(int modelId, int index)
@@ -260,7 +305,7 @@ namespace Game
         {
             // === 创建摄像机实体 ===
             _cameraId = EngineBindings.CreateEntity();
-            EngineBindings.AddCamera(_cameraId, new iCamera 
+            EngineBindings.AddComponent(_cameraId, new iCamera 
             { 
                 fov = 60.0f, 
                 nearPlane = 0.1f, 
@@ -268,7 +313,7 @@ namespace Game
             });
             
             // 初始摄像机位置
-            EngineBindings.AddTransform(_cameraId, new Transform 
+            EngineBindings.AddComponent(_cameraId, new Transform 
             { 
                 position = new Vector3(0, _cameraFixedHeight, -_cameraDistance),
                 rotation = new Vector3(0, 0, 0),
@@ -278,7 +323,9 @@ namespace Game
             Log("📹 Created benchmark camera");
         }
 
+#if BenchmarkPerEntity
         [UpdateSystem]
+        [Parallel]
         [Query(typeof(Transform), typeof(Velocity))]
         public static void BenchmarkAnimationSystem(float deltaTime, UIntPtr transformPtr, UIntPtr velocityPtr)
         {
@@ -300,10 +347,30 @@ namespace Game
                 );
             }
         }
+#else
+        [ChunkedUpdateSystem]
+        [Parallel]
+        [Query(typeof(Transform), typeof(Velocity))]
+        public static void BenchmarkAnimationSystem(float deltaTime, ComponentChunk<Transform> transforms, ComponentChunk<Velocity> velocities)
+        {
+            // the same work per entity as the per entity version, only the transitions differ
+            for (int i = 0; i < velocities.Length; i++)
+            {
+                float time = _testTimer;
+                float waveStrength = 0.5f;
+
+                velocities[i].velocity = new Vector3(
+                    MathF.Sin(time * 2.0f) * waveStrength,
+                    MathF.Sin(time * 1.5f) * waveStrength * 0.5f,
+                    MathF.Cos(time * 1.8f) * waveStrength
+                );
+            }
+        }
+#endif
 
         // 摄像机系统 - 鼠标自由操控
         [UpdateSystem]
-        [Query(typeof(Transform), typeof(iCamera))]
+        [Query(typeof(Transform), ReadOnly = new[] { typeof(iCamera) })]
         public static void BenchmarkCameraSystem(float dt, ref Transform transform, ref iCamera camera)
         {
             // 获取鼠标移动量
@@ -0,0 +1,32 @@
+using System;
+
+namespace Game
+{
+    // one component of a [ChunkedUpdateSystem] query for every entity of the chunk, indexed like a
+    // Span<T>; the host hands over a pointer per entity, as the queried components aren't laid out
+    // contiguously in its storage
+    public readonly unsafe ref struct ComponentChunk<T> where T : unmanaged
+    {
+        private readonly void** _pointers;
+
+        public int Length { get; }
+
+        public ComponentChunk(void** pointers, int length)
+        {
+            _pointers = pointers;
+            Length = length;
+        }
+
+        public ref T this[int index]
+        {
+            get
+            {
+                if ((uint)index >= (uint)Length)
+                {
+                    throw new IndexOutOfRangeException();
+                }
+                return ref *(T*)_pointers[index];
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+using System;
+
+namespace Game
+{
+    // every value of a [Component] next to the entity each one belongs to, see
+    // EngineBindings.GetStorage, indexed like a Span<T>; the host hands over its page table, as a
+    // storage of one of its own types is split into pages of PageSize values; valid until the next
+    // structural change to the component, which from an update system is the next sync point
+    public readonly unsafe ref struct ComponentStorage<T> where T : unmanaged
+    {
+        private readonly void** _pages;
+
+        public ReadOnlySpan<uint> Entities { get; }
+        public int PageSize { get; }
+
+        public int Length => Entities.Length;
+
+        public ComponentStorage(void** pages, int pageSize, ReadOnlySpan<uint> entities)
+        {
+            _pages = pages;
+            PageSize = pageSize;
+            Entities = entities;
+        }
+
+        // the component of Entities[index]
+        public ref T this[int index]
+        {
+            get
+            {
+                if ((uint)index >= (uint)Length)
+                {
+                    throw new IndexOutOfRangeException();
+                }
+                return ref ((T*)_pages[index / PageSize])[index % PageSize];
+            }
+        }
+    }
+}
@@ -4,6 +4,19 @@ using System.Runtime.InteropServices;
 
 namespace Game
 {
+    // the entity a system is handed, queried like a component, e.g. to destroy it
+    [StructLayout(LayoutKind.Sequential)]
+    public struct Entity
+    {
+        public uint id;
+    }
+
+    // the host skips a disabled entity, neither drawing it nor handing it to systems whose query
+    // doesn't name Disabled in With
+    [Tag]
+    public struct Disabled { }
+
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct Transform
     {
@@ -12,6 +25,7 @@ namespace Game
         public Vector3 scale; // 缩放
     }
 
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct iCamera
     {
@@ -21,12 +35,14 @@ namespace Game
     }
 
 
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct Velocity
     {
         public Vector3 velocity;
     }
 
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct Player
     {
@@ -44,12 +60,14 @@ namespace Game
     //     public string modelPath;
     // }
 
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct Mesh
     {
         public int modelId;  // 使用ID而不是字符串路径，避免marshalling问题
     }
 
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct Material
     {
@@ -68,6 +86,7 @@ namespace Game
         public string modelPath;
     }
 
+    [Component]
     [StructLayout(LayoutKind.Sequential)]
     public struct GameStats
     {
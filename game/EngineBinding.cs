@@ -1,4 +1,7 @@
 using System;
+using System.Numerics;
+using System.Reflection;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 
 namespace Game
@@ -8,23 +11,30 @@ namespace Game
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate uint CreateEntityDel();
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddTransformDel(uint e, Transform t);
+        public delegate void DestroyEntityDel(uint entityId);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddCameraDel(uint e, iCamera c);
+        public unsafe delegate void CreateEntitiesDel(int count, uint* outIds);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddVelocityDel(uint e, Velocity v);
+        public delegate int RegisterComponentDel([MarshalAs(UnmanagedType.LPStr)] string name, int size, int alignment);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddPlayerDel(uint e, Player p);
+        public unsafe delegate void AddComponentDel(int typeId, uint entityId, void* component);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddMeshDel(uint e, Mesh m);
+        public delegate void RemoveComponentDel(int typeId, uint entityId);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddMaterialDel(uint e, Material mat);
+        public unsafe delegate void* GetComponentDel(int typeId, uint entityId);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void AddGameStatsDel(uint e, GameStats stats);
+        public unsafe delegate void** GetStorageDel(int typeId, int* count, int* pageSize, uint** entities);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void RemoveComponentDel(uint entityId);
+        public unsafe delegate void AddComponentsBulkDel(int typeId, uint* entityIds, void* components, int count);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        public delegate void DestroyEntityDel(uint entityId);
+        public unsafe delegate int RegisterPrefabDel(int count, int* typeIds, void** components);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public unsafe delegate void InstantiatePrefabDel(int prefabId, int count, NativePrefabOverride* overrides,
+                                                         int overrideCount, uint* outIds);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate int RegisterTagDel([MarshalAs(UnmanagedType.LPStr)] string name);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate void TagDel(int tagId, uint entityId);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate bool IsKeyPressedDel(int keyCode);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
@@ -35,20 +45,19 @@ namespace Game
         public delegate void GetMouseDeltaDel(out float dx, out float dy);
 
         public static CreateEntityDel CreateEntity = null!;
-        public static AddTransformDel AddTransform = null!;
-        public static AddCameraDel AddCamera = null!;
-        public static AddVelocityDel AddVelocity = null!;
-        public static AddPlayerDel AddPlayer = null!;
-        public static AddMeshDel AddMesh = null!;
-        public static AddMaterialDel AddMaterial = null!;
-        public static AddGameStatsDel AddGameStats = null!;
-        public static RemoveComponentDel RemoveTransform = null!;
-        public static RemoveComponentDel RemoveVelocity = null!;
-        public static RemoveComponentDel RemovePlayer = null!;
-        public static RemoveComponentDel RemoveMesh = null!;
-        public static RemoveComponentDel RemoveMaterial = null!;
-        public static RemoveComponentDel RemoveGameStats = null!;
         public static DestroyEntityDel DestroyEntity = null!;
+        public static CreateEntitiesDel CreateEntitiesBulk = null!;
+        public static RegisterComponentDel RegisterComponentNative = null!;
+        public static AddComponentDel AddComponentNative = null!;
+        public static RemoveComponentDel RemoveComponentNative = null!;
+        public static GetComponentDel GetComponentNative = null!;
+        public static GetStorageDel GetStorageNative = null!;
+        public static AddComponentsBulkDel AddComponentsBulk = null!;
+        public static RegisterPrefabDel RegisterPrefabNative = null!;
+        public static InstantiatePrefabDel InstantiatePrefabNative = null!;
+        public static RegisterTagDel RegisterTagNative = null!;
+        public static TagDel AddTagNative = null!;
+        public static TagDel RemoveTagNative = null!;
         public static IsKeyPressedDel IsKeyPressed = null!;
         public static IsKeyPressedDel IsKeyJustPressed = null!;
         public static IsKeyPressedDel IsKeyJustReleased = null!;
@@ -60,34 +69,32 @@ namespace Game
         {
             CreateEntity = Marshal.GetDelegateForFunctionPointer<CreateEntityDel>(
                                 getProc("CreateEntity"));
-            AddTransform = Marshal.GetDelegateForFunctionPointer<AddTransformDel>(
-                                getProc("AddTransform"));
-            AddCamera = Marshal.GetDelegateForFunctionPointer<AddCameraDel>(
-                                getProc("AddCamera"));
-            AddVelocity = Marshal.GetDelegateForFunctionPointer<AddVelocityDel>(
-                                getProc("AddVelocity"));
-            AddPlayer = Marshal.GetDelegateForFunctionPointer<AddPlayerDel>(
-                                getProc("AddPlayer"));
-            AddMesh = Marshal.GetDelegateForFunctionPointer<AddMeshDel>(
-                                getProc("AddMesh"));
-            AddMaterial = Marshal.GetDelegateForFunctionPointer<AddMaterialDel>(
-                                getProc("AddMaterial"));
-            AddGameStats = Marshal.GetDelegateForFunctionPointer<AddGameStatsDel>(
-                                getProc("AddGameStats"));
-            RemoveTransform = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
-                                getProc("HostRemoveComponentTransform"));
-            RemoveVelocity = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
-                                getProc("HostRemoveComponentVelocity"));
-            RemovePlayer = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
-                                getProc("HostRemoveComponentPlayer"));
-            RemoveMesh = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
-                                getProc("HostRemoveComponentMesh"));
-            RemoveMaterial = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
-                                getProc("HostRemoveComponentMaterial"));
-            RemoveGameStats = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
-                                getProc("HostRemoveComponentGameStats"));
             DestroyEntity = Marshal.GetDelegateForFunctionPointer<DestroyEntityDel>(
                                 getProc("HostDestroyEntity"));
+            CreateEntitiesBulk = Marshal.GetDelegateForFunctionPointer<CreateEntitiesDel>(
+                                getProc("HostCreateEntities"));
+            RegisterComponentNative = Marshal.GetDelegateForFunctionPointer<RegisterComponentDel>(
+                                getProc("HostRegisterComponent"));
+            AddComponentNative = Marshal.GetDelegateForFunctionPointer<AddComponentDel>(
+                                getProc("HostAddComponent"));
+            RemoveComponentNative = Marshal.GetDelegateForFunctionPointer<RemoveComponentDel>(
+                                getProc("HostRemoveComponent"));
+            GetComponentNative = Marshal.GetDelegateForFunctionPointer<GetComponentDel>(
+                                getProc("HostGetComponent"));
+            GetStorageNative = Marshal.GetDelegateForFunctionPointer<GetStorageDel>(
+                                getProc("HostGetStorage"));
+            AddComponentsBulk = Marshal.GetDelegateForFunctionPointer<AddComponentsBulkDel>(
+                                getProc("HostAddComponentsBulk"));
+            RegisterPrefabNative = Marshal.GetDelegateForFunctionPointer<RegisterPrefabDel>(
+                                getProc("HostRegisterPrefab"));
+            InstantiatePrefabNative = Marshal.GetDelegateForFunctionPointer<InstantiatePrefabDel>(
+                                getProc("HostInstantiatePrefab"));
+            RegisterTagNative = Marshal.GetDelegateForFunctionPointer<RegisterTagDel>(
+                                getProc("HostRegisterTag"));
+            AddTagNative = Marshal.GetDelegateForFunctionPointer<TagDel>(
+                                getProc("HostAddTag"));
+            RemoveTagNative = Marshal.GetDelegateForFunctionPointer<TagDel>(
+                                getProc("HostRemoveTag"));
             IsKeyPressed = Marshal.GetDelegateForFunctionPointer<IsKeyPressedDel>(
                                 getProc("IsKeyPressed"));
             IsKeyJustPressed = Marshal.GetDelegateForFunctionPointer<IsKeyPressedDel>(
@@ -101,6 +108,224 @@ namespace Game
             GetMouseDelta = Marshal.GetDelegateForFunctionPointer<GetMouseDeltaDel>(
                                 getProc("GetMouseDelta"));
         }
+
+        // the entity gets a copy of component, replacing the one it has
+        public static unsafe void AddComponent<T>(uint entityId, in T component) where T : unmanaged
+        {
+            fixed (T* componentPtr = &component)
+            {
+                AddComponentNative(ComponentTypeId<T>.Value, entityId, componentPtr);
+            }
+        }
+
+        public static void RemoveComponent<T>(uint entityId) where T : unmanaged
+        {
+            RemoveComponentNative(ComponentTypeId<T>.Value, entityId);
+        }
+
+        // a copy of the entity's T, false if it has none
+        public static unsafe bool TryGetComponent<T>(uint entityId, out T component) where T : unmanaged
+        {
+            T* componentPtr = (T*)GetComponentNative(ComponentTypeId<T>.Value, entityId);
+            component = componentPtr != null ? *componentPtr : default;
+            return componentPtr != null;
+        }
+
+        // every T and its entity, in a single host call, for any [Component]
+        public static unsafe ComponentStorage<T> GetStorage<T>() where T : unmanaged
+        {
+            int count;
+            int pageSize;
+            uint* entities;
+            void** pages = GetStorageNative(ComponentTypeId<T>.Value, &count, &pageSize, &entities);
+            if (pages == null)
+            {
+                return default;
+            }
+            return new ComponentStorage<T>(pages, pageSize, new ReadOnlySpan<uint>(entities, count));
+        }
+
+        // a new entity for every element of ids, in a single host call
+        public static unsafe void CreateEntities(Span<uint> ids)
+        {
+            fixed (uint* idPtr = ids)
+            {
+                CreateEntitiesBulk(ids.Length, idPtr);
+            }
+        }
+
+        // ids[i] gets components[i], in a single host call, the entities must not have a T yet,
+        // e.g. ones just made by CreateEntities
+        public static unsafe void AddComponents<T>(ReadOnlySpan<uint> ids, ReadOnlySpan<T> components)
+            where T : unmanaged
+        {
+            if (ids.Length != components.Length)
+            {
+                throw new ArgumentException("One component per entity is needed", nameof(components));
+            }
+            fixed (uint* idPtr = ids)
+            fixed (T* componentPtr = components)
+            {
+                AddComponentsBulk(ComponentTypeId<T>.Value, idPtr, componentPtr, ids.Length);
+            }
+        }
+
+        // returns the id to instantiate the prefab with, registered up front, e.g. from a
+        // [StartupSystem]
+        public static unsafe int RegisterPrefab(PrefabTemplate prefab)
+        {
+            int count = prefab.TypeIds.Count;
+            if (count == 0)
+            {
+                throw new ArgumentException("A prefab needs a component", nameof(prefab));
+            }
+            int[] typeIds = prefab.TypeIds.ToArray();
+            byte[] values = prefab.Values.ToArray();
+            fixed (int* typeIdPtr = typeIds)
+            fixed (byte* valuePtr = values)
+            {
+                void** components = stackalloc void*[count];
+                for (int k = 0; k < count; k++)
+                {
+                    components[k] = valuePtr + prefab.Offsets[k];
+                }
+                int prefabId = RegisterPrefabNative(count, typeIdPtr, components);
+                if (prefabId < 0)
+                {
+                    throw new ArgumentException("A component of the prefab isn't registered with the host",
+                                                nameof(prefab));
+                }
+                return prefabId;
+            }
+        }
+
+        // count entities with the components of the prefab, in a single host call, positions
+        // (one per entity, or empty) override the position of its Transform, and ids (one per
+        // entity, or empty) gets the entities
+        public static unsafe void Instantiate(int prefabId, int count, ReadOnlySpan<Vector3> positions = default,
+                                              Span<uint> ids = default)
+        {
+            if (!positions.IsEmpty && positions.Length != count)
+            {
+                throw new ArgumentException("One position per entity is needed", nameof(positions));
+            }
+            if (!ids.IsEmpty && ids.Length != count)
+            {
+                throw new ArgumentException("One id per entity is needed", nameof(ids));
+            }
+            fixed (Vector3* positionPtr = positions)
+            fixed (uint* idPtr = ids)
+            {
+                var position = new NativePrefabOverride
+                {
+                    TypeId = ComponentTypeId<Transform>.Value,
+                    Offset = (int)Marshal.OffsetOf<Transform>(nameof(Transform.position)),
+                    Size = sizeof(Vector3),
+                    Stride = sizeof(Vector3),
+                    Data = positionPtr,
+                };
+                InstantiatePrefabNative(prefabId, count, &position, positions.IsEmpty ? 0 : 1, idPtr);
+            }
+        }
+
+        // the same, with each of the overrides (one value per entity) applied to every entity's
+        // copy of the prefab
+        public static unsafe void Instantiate(int prefabId, int count, PrefabOverrides overrides,
+                                              Span<uint> ids = default)
+        {
+            if (overrides.Counts.Exists(overrideCount => overrideCount != count))
+            {
+                throw new ArgumentException("One value per entity is needed", nameof(overrides));
+            }
+            if (!ids.IsEmpty && ids.Length != count)
+            {
+                throw new ArgumentException("One id per entity is needed", nameof(ids));
+            }
+            int overrideCount = overrides.TypeIds.Count;
+            byte[] values = overrides.Values.ToArray();
+            NativePrefabOverride* nativeOverrides = stackalloc NativePrefabOverride[overrideCount];
+            fixed (byte* valuePtr = values)
+            fixed (uint* idPtr = ids)
+            {
+                for (int k = 0; k < overrideCount; k++)
+                {
+                    nativeOverrides[k] = new NativePrefabOverride
+                    {
+                        TypeId = overrides.TypeIds[k],
+                        Offset = overrides.FieldOffsets[k],
+                        Size = overrides.Sizes[k],
+                        Stride = overrides.Sizes[k],
+                        Data = valuePtr + overrides.Offsets[k],
+                    };
+                }
+                InstantiatePrefabNative(prefabId, count, nativeOverrides, count == 0 ? 0 : overrideCount, idPtr);
+            }
+        }
+
+        // the host's id of the [Tag] struct, every one is registered before the systems are
+        public static int RegisterTag(Type tag)
+        {
+            if (tag.GetCustomAttribute<TagAttribute>() == null)
+            {
+                throw new ArgumentException($"{tag.Name} is no [Tag] struct", nameof(tag));
+            }
+            return RegisterTagNative(tag.Name);
+        }
+
+        // from an update system they take effect at the next sync point, like components do
+        public static void AddTag<T>(uint entityId) where T : struct
+        {
+            AddTagNative(TagId<T>.Value, entityId);
+        }
+
+        public static void RemoveTag<T>(uint entityId) where T : struct
+        {
+            RemoveTagNative(TagId<T>.Value, entityId);
+        }
+
+        internal static class TagId<T> where T : struct
+        {
+            public static readonly int Value = RegisterTag(typeof(T));
+        }
+
+        // registers the [Component] struct, or looks up its id once registered
+        public static void RegisterComponent(Type component)
+        {
+            if (component.GetCustomAttribute<ComponentAttribute>() == null)
+            {
+                throw new ArgumentException($"{component.Name} is no [Component] struct", nameof(component));
+            }
+            RuntimeHelpers.RunClassConstructor(
+                typeof(ComponentTypeId<>).MakeGenericType(component).TypeHandle);
+        }
+
+        // the host's id of every component type, registered by name and layout once, so a struct
+        // that no longer matches the host's fails here instead of corrupting its storage, and one
+        // the host has no type for gets a storage made from its layout
+        internal static unsafe class ComponentTypeId<T> where T : unmanaged
+        {
+            public static readonly int Value = Resolve();
+
+            private static int Resolve()
+            {
+                int alignment = sizeof(AlignmentOf<T>) - sizeof(T);
+                int id = RegisterComponentNative(typeof(T).Name, sizeof(T), alignment);
+                if (id < 0)
+                {
+                    throw new InvalidOperationException(
+                        $"{typeof(T).Name} ({sizeof(T)} bytes, aligned to {alignment}) can't be stored by the host");
+                }
+                return id;
+            }
+        }
+
+        // T placed after a byte is padded to its alignment
+        [StructLayout(LayoutKind.Sequential)]
+        private struct AlignmentOf<T> where T : unmanaged
+        {
+            public byte padding;
+            public T value;
+        }
     }
 }
 
@@ -117,10 +342,7 @@ namespace Game
 //         public delegate void AddPlayerDel(uint e, Player p);
 
 //         public static CreateEntityDel CreateEntity = null!;
-//         public static AddTransformDel AddTransform = null!;
-//         public static AddVelocityDel AddVelocity = null!;
-//         public static AddPlayerDel AddPlayer = null!;
-
+// // // 
 //         public static void Init(Func<string, IntPtr> getProc)
 //         {
 //             CreateEntity = Marshal.GetDelegateForFunctionPointer<CreateEntityDel>(
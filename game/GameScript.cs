@@ -7,6 +7,7 @@ using System.Collections.Generic;
 using System.Linq.Expressions;
 using System.Reflection.Emit;
 using System.Numerics;
+using System.Threading;
 
 namespace Game
 {
@@ -22,10 +23,19 @@ namespace Game
     }
 
 #if GameScript
+    // marks the enemies, so the rat systems query them alone
+    [Tag]
+    public struct Rat { }
+
+    // the renderer's query and the one every rat system shares
+    [OwningGroup(typeof(Transform), typeof(Mesh), typeof(Material))]
+    [OwningGroup(typeof(Velocity), Get = new[] { typeof(Transform) })]
     public static class GameSystems
     {
         private static float _testTimer = 0;  // 用于降低日志频率
         private static StreamWriter _logWriter = null;
+        // systems log from the scheduler's worker threads
+        private static readonly object _logLock = new object();
 
         // 吸血鬼幸存者游戏变量
         private static uint _playerId = 0;  // 玩家实体ID
@@ -43,7 +53,6 @@ namespace Game
         private static int _enemyCount = 30;  // 敌人数量
         private static float _enemySpawnRadius = 30.0f;  // 敌人生成半径（10x默认）
         private static System.Diagnostics.Stopwatch _creationStopwatch = new System.Diagnostics.Stopwatch();
-        private static List<uint> _entitiesToDestroy = new List<uint>();  // 待销毁的实体列表
         
         // 摄像机控制变量
         private static float _cameraYaw = 0f;     // 水平角度（绕Y轴旋转）
@@ -69,19 +78,19 @@ namespace Game
             // === 创建玩家猴子实体 ===
             _playerId = EngineBindings.CreateEntity();
             var monkeyTransform = new Transform { position = new Vector3(0, 2, 0), scale = new Vector3(1) }; 
-            EngineBindings.AddTransform(_playerId, monkeyTransform);
+            EngineBindings.AddComponent(_playerId, monkeyTransform);
             var monkeyVelocity = new Velocity { velocity = new Vector3(0, 0, 0) };
-            EngineBindings.AddVelocity(_playerId, monkeyVelocity);
+            EngineBindings.AddComponent(_playerId, monkeyVelocity);
 
             // 添加Player组件，让猴子可以被PlayerSystem处理
             var player = new Player { isJumping = false, jumpForce = 8.0f };
-            EngineBindings.AddPlayer(_playerId, player);
+            EngineBindings.AddComponent(_playerId, player);
 
             // 添加猴子的Mesh和Material组件
             var monkeyMesh = new Mesh { modelId = 0 }; // 猴子是第一个模型
-            EngineBindings.AddMesh(_playerId, monkeyMesh);
+            EngineBindings.AddComponent(_playerId, monkeyMesh);
             var monkeyMaterial = new Material { color = new Vector3(0.8f, 0.6f, 0.4f), metallic = .1f, roughness = .9f, occlusion = .5f, emissive = new Vector3(.0f) }; // 棕色
-            EngineBindings.AddMaterial(_playerId, monkeyMaterial);
+            EngineBindings.AddComponent(_playerId, monkeyMaterial);
 
             // 初始化全局玩家位置
             _playerPosition = monkeyTransform.position;
@@ -89,16 +98,7 @@ namespace Game
             Log($"🐵 Created PLAYER monkey entity with ID {_playerId}");
 
             // === 创建大量敌人鼠实体 ===
-            for (int i = 0; i < _enemyCount; i++)
-            {
-                CreateEnemyRat(i);
-                
-                // Log progress every 1000 entities
-                if ((i + 1) % 1000 == 0)
-                {
-                    Log($"📊 Created {i + 1}/{_enemyCount} enemy rats...");
-                }
-            }
+            CreateEnemyRats();
 
             _creationStopwatch.Stop();
             Log($"✅ Enemy rat creation completed in {_creationStopwatch.ElapsedMilliseconds}ms");
@@ -107,12 +107,12 @@ namespace Game
             // === 创建场景实体 ===
             uint sceneId = EngineBindings.CreateEntity();
             var sceneTransform = new Transform { position = new Vector3(0f, -4.94f,0f), rotation = new Vector3(-3.14f/2f,0f,0f), scale = new Vector3(4f) };
-            EngineBindings.AddTransform(sceneId, sceneTransform);
+            EngineBindings.AddComponent(sceneId, sceneTransform);
             var sceneMesh = new Mesh { modelId = 2 };
-            EngineBindings.AddMesh(sceneId, sceneMesh);
+            EngineBindings.AddComponent(sceneId, sceneMesh);
             // 添加默认材质（根据需要调整）
             var sceneMaterial = new Material { color = new Vector3(1.0f, 1.0f, 1.0f)*.5f, metallic = 0.10f, roughness = 0.90f, occlusion = 1.0f, emissive = new Vector3(.0f) };
-            EngineBindings.AddMaterial(sceneId, sceneMaterial);
+            EngineBindings.AddComponent(sceneId, sceneMaterial);
             Log($"🌆 Created SCENE entity with ID {sceneId} using modelId 4");
 
             // === 创建摄像机实体 ===
@@ -165,9 +165,12 @@ namespace Game
                 string logMessage = $"[{timestamp}] {message}";
 
                 // Output to both console and log file
-                Console.WriteLine(logMessage);
-                _logWriter?.WriteLine(logMessage);
-                _logWriter?.Flush();  // Ensure immediate file write
+                lock (_logLock)
+                {
+                    Console.WriteLine(logMessage);
+                    _logWriter?.WriteLine(logMessage);
+                    _logWriter?.Flush();  // Ensure immediate file write
+                }
             }
             catch (Exception ex)
             {
@@ -235,105 +238,92 @@ namespace Game
         }
 
         // 老鼠物理系统 - 只处理老鼠的移动（不受重力影响）
-        [UpdateSystem]
-        [Query(typeof(Transform), typeof(Velocity), typeof(Mesh))]
-        public static void VampirePhysicsSystem(float dt, ref Transform transform, ref Velocity velocity, ref Mesh mesh)
+        [ChunkedUpdateSystem]
+        [Parallel]
+        [Query(typeof(Transform), typeof(Velocity), With = new[] { typeof(Rat) })]
+        public static void VampirePhysicsSystem(float dt, ComponentChunk<Transform> transforms, ComponentChunk<Velocity> velocities)
         {
-            // 通过Model ID精确区分：0=玩家猴子，3=老鼠
-            if (mesh.modelId == 0 )
+            for (int i = 0; i < transforms.Length; i++)
             {
-                return; // 跳过玩家（猴子模型）
-            }
+                ref Transform transform = ref transforms[i];
+                ref Velocity velocity = ref velocities[i];
 
-            // 只处理老鼠（模型ID为3）
-            if (mesh.modelId != 1)
-            {
-                return; // 跳过其他实体
-            }
+                // 老鼠不受重力影响，直接更新位置
+                transform.position.X += velocity.velocity.X * dt;
+                transform.position.Y += velocity.velocity.Y * dt;
+                transform.position.Z += velocity.velocity.Z * dt;
 
-            // 老鼠不受重力影响，直接更新位置
-            transform.position.X += velocity.velocity.X * dt;
-            transform.position.Y += velocity.velocity.Y * dt;
-            transform.position.Z += velocity.velocity.Z * dt;
-
-            // 保持在地面以上一定高度
-            if (transform.position.Y < 0)
-            {
-                transform.position.Y = 0;
-                velocity.velocity.Y = 0;
+                // 保持在地面以上一定高度
+                if (transform.position.Y < 0)
+                {
+                    transform.position.Y = 0;
+                    velocity.velocity.Y = 0;
+                }
             }
         }
 
         // 老鼠AI系统 - 追踪玩家（无敌玩家版本）
-        [UpdateSystem]
-        [Query(typeof(Transform), typeof(Velocity), typeof(Mesh))]
-        public static void VampireAISystem(float dt, ref Transform transform, ref Velocity velocity, ref Mesh mesh)
+        [ChunkedUpdateSystem]
+        [Parallel]
+        [Query(typeof(Transform), typeof(Velocity), ReadOnly = new[] { typeof(Entity) }, With = new[] { typeof(Rat) })]
+        public static void VampireAISystem(float dt, ComponentChunk<Transform> transforms, ComponentChunk<Velocity> velocities, ComponentChunk<Entity> entities)
         {
-            // 通过Model ID精确区分：0=玩家猴子，3=老鼠
-            if (mesh.modelId == 0)
+            for (int i = 0; i < transforms.Length; i++)
             {
-                return; // 跳过玩家（猴子模型）
-            }
+                ref Transform transform = ref transforms[i];
+                ref Velocity velocity = ref velocities[i];
 
-            // 只处理老鼠（模型ID为3）
-            if (mesh.modelId != 1)
-            {
-                return; // 跳过其他实体
-            }
+                float ratSpeed = 0.5f; // 统一的老鼠速度
 
-            float ratSpeed = 0.5f; // 统一的老鼠速度
+                // 计算到玩家的距离和方向
+                Vector3 toPlayer = _playerPosition - transform.position;
+                float distanceToPlayer = toPlayer.Length();
+                const float detectionRange = 15.0f; // 增大探测范围
 
-            // 计算到玩家的距离和方向
-            Vector3 toPlayer = _playerPosition - transform.position;
-            float distanceToPlayer = toPlayer.Length();
-            const float detectionRange = 15.0f; // 增大探测范围
-
-            // 如果在探测范围内，追踪玩家
-            if (distanceToPlayer <= detectionRange && distanceToPlayer > 0.1f) // 碰撞距离
-            {
-                // 标准化方向向量
-                Vector3 direction = Vector3.Normalize(toPlayer);
-
-                // 设置朝向玩家的速度（只在水平面移动，保持高度）
-                velocity.velocity.X = direction.X * ratSpeed;
-                velocity.velocity.Z = direction.Z * ratSpeed;
-                velocity.velocity.Y = 0; // 保持高度恒定
-
-                // 计算老鼠应该面向的角度（绕Y轴旋转，加180度让头部朝向玩家）
-                float targetYaw = MathF.Atan2(direction.X, direction.Z) + MathF.PI;
-                transform.rotation = new Vector3(0, targetYaw, 0);
-
-                // 调试日志（降低频率）
-                if (_testTimer > 3.0f)
+                // 如果在探测范围内，追踪玩家
+                if (distanceToPlayer <= detectionRange && distanceToPlayer > 0.1f) // 碰撞距离
                 {
-                    // Log($"🐭 Rat at ({transform.position.X:F2}, {transform.position.Y:F2}, {transform.position.Z:F2}) " +
-                    //     $"chasing invincible player at ({_playerPosition.X:F2}, {_playerPosition.Y:F2}, {_playerPosition.Z:F2}), distance: {distanceToPlayer:F2}");
+                    // 标准化方向向量
+                    Vector3 direction = Vector3.Normalize(toPlayer);
+
+                    // 设置朝向玩家的速度（只在水平面移动，保持高度）
+                    velocity.velocity.X = direction.X * ratSpeed;
+                    velocity.velocity.Z = direction.Z * ratSpeed;
+                    velocity.velocity.Y = 0; // 保持高度恒定
+
+                    // 计算老鼠应该面向的角度（绕Y轴旋转，加180度让头部朝向玩家）
+                    float targetYaw = MathF.Atan2(direction.X, direction.Z) + MathF.PI;
+                    transform.rotation = new Vector3(0, targetYaw, 0);
+
+                    // 调试日志（降低频率）
+                    if (_testTimer > 3.0f)
+                    {
+                        // Log($"🐭 Rat at ({transform.position.X:F2}, {transform.position.Y:F2}, {transform.position.Z:F2}) " +
+                        //     $"chasing invincible player at ({_playerPosition.X:F2}, {_playerPosition.Y:F2}, {_playerPosition.Z:F2}), distance: {distanceToPlayer:F2}");
+                    }
                 }
-            }
-            else if (distanceToPlayer <= 0.1f)
-            {
-                // 老鼠撞到无敌玩家 - 标记销毁！
-                // Log($"💥 Rat destroyed by invincible player! Distance: {distanceToPlayer:F2}");
-                // Log($"🐭 Player position: ({_playerPosition.X:F2}, {_playerPosition.Y:F2}, {_playerPosition.Z:F2})");
-                // Log($"🐭 Rat position: ({transform.position.X:F2}, {transform.position.Y:F2}, {transform.position.Z:F2})");
-                
-                // 增加击杀数
-                _killCount++;
-                
-                // 将变换移动到很远的地方，让它在下一帧被处理
-                transform.position = new Vector3(99999f, -99999f, 99999f);
-                velocity.velocity = Vector3.Zero;
+                else if (distanceToPlayer <= 0.1f)
+                {
+                    // 老鼠撞到无敌玩家 - 销毁！
+                    // Log($"💥 Rat destroyed by invincible player! Distance: {distanceToPlayer:F2}");
+                    // Log($"🐭 Player position: ({_playerPosition.X:F2}, {_playerPosition.Y:F2}, {_playerPosition.Z:F2})");
+                    // Log($"🐭 Rat position: ({transform.position.X:F2}, {transform.position.Y:F2}, {transform.position.Z:F2})");
                 
-                // 缩放为0，使其不可见
-                transform.scale = Vector3.Zero;
-            }
-            else
-            {
-                // 超出探测范围，停止移动
-                velocity.velocity = Vector3.Zero;
-                if (_testTimer > 5.0f)
+                    // 增加击杀数
+                    // GameStatsSystem reads it concurrently
+                    Interlocked.Increment(ref _killCount);
+
+                    // 在本帧结束时销毁
+                    EngineBindings.DestroyEntity(entities[i].id);
+                }
+                else
                 {
-                    Log($"🐭 Rat out of range, distance: {distanceToPlayer:F2}");
+                    // 超出探测范围，停止移动
+                    velocity.velocity = Vector3.Zero;
+                    if (_testTimer > 5.0f)
+                    {
+                        Log($"🐭 Rat out of range, distance: {distanceToPlayer:F2}");
+                    }
                 }
             }
         }
@@ -388,7 +378,7 @@ namespace Game
 
         //摄像机系统 - 鼠标自由操控的第三人称摄像机
         [UpdateSystem]
-        [Query(typeof(Transform), typeof(iCamera))]
+        [Query(typeof(Transform), ReadOnly = new[] { typeof(iCamera) })]
         public static void CameraSystem(float dt, ref Transform transform, ref iCamera camera)
         {
             // 获取鼠标移动量
@@ -459,12 +449,40 @@ namespace Game
 
 
 
-        private static void CreateEnemyRat(int index)
+        // every rat is an instance of the same prefab, only their positions and materials differ
+        private static void CreateEnemyRats()
         {
-            // Create enemy rat entity
-            uint entityId = EngineBindings.CreateEntity();
-            _vampireIds.Add(entityId);
+            // rat mesh (modelId = 1), standing still until it sees the player
+            int ratPrefab = EngineBindings.RegisterPrefab(new PrefabTemplate()
+                .With(new Transform { scale = new Vector3(0.5f) })
+                .With(new Velocity { velocity = Vector3.Zero })
+                .With(new Mesh { modelId = 1 })
+                .With(new Material()));
+
+            var positions = new Vector3[_enemyCount];
+            var materials = new Material[_enemyCount];
+            for (int i = 0; i < _enemyCount; i++)
+            {
+                positions[i] = CreateRatPosition(i);
+                materials[i] = CreateRatMaterial(i);
+            }
 
+            var ids = new uint[_enemyCount];
+            EngineBindings.Instantiate(ratPrefab, _enemyCount, new PrefabOverrides()
+                .Set<Transform, Vector3>(nameof(Transform.position), positions)
+                .Set<Material>(materials), ids);
+
+            // Record rat attributes
+            foreach (uint entityId in ids)
+            {
+                EngineBindings.AddTag<Rat>(entityId);
+                _vampireIds.Add(entityId);
+                _vampireSpeeds[entityId] = 0.5f;
+            }
+        }
+
+        private static Vector3 CreateRatPosition(int index)
+        {
             // Position entities randomly in a disk pattern
             var random = new Random(index + 42); // Use index as seed for reproducible randomness
             
@@ -479,32 +497,7 @@ namespace Game
             // Scale to desired spawn radius
             x *= _enemySpawnRadius;
             z *= _enemySpawnRadius;
-            float y = 0;
-
-            // Add Transform component
-            var transform = new Transform 
-            { 
-                position = new Vector3(x, y, z), 
-                scale = new Vector3(0.5f), 
-                rotation = new Vector3(0, 0, 0) 
-            };
-
-            EngineBindings.AddTransform(entityId, transform);
-
-            // Add Velocity component for movement
-            var velocity = new Velocity { velocity = new Vector3(0, 0, 0) };
-            EngineBindings.AddVelocity(entityId, velocity);
-
-            // Add rat mesh (modelId = 1)
-            var mesh = new Mesh { modelId = 1 };
-            EngineBindings.AddMesh(entityId, mesh);
-
-            // Add Material component with rat-like colors
-            var material = CreateRatMaterial(index);
-            EngineBindings.AddMaterial(entityId, material);
-
-            // Record rat attributes
-            _vampireSpeeds[entityId] = 0.5f;
+            return new Vector3(x, 0, z);
         }
 
         private static Material CreateRatMaterial(int index)
@@ -530,7 +523,7 @@ namespace Game
         {
             // === 创建摄像机实体 ===
             _cameraId = EngineBindings.CreateEntity();
-            EngineBindings.AddCamera(_cameraId, new iCamera 
+            EngineBindings.AddComponent(_cameraId, new iCamera 
             { 
                 fov = 60.0f, 
                 nearPlane = 0.1f, 
@@ -538,7 +531,7 @@ namespace Game
             });
             
             // 初始摄像机位置
-            EngineBindings.AddTransform(_cameraId, new Transform 
+            EngineBindings.AddComponent(_cameraId, new Transform 
             { 
                 position = new Vector3(0, 10, -15),
                 rotation = new Vector3(0, 0, 0),
@@ -560,7 +553,7 @@ namespace Game
                 gameTime = 0f
             };
             
-            EngineBindings.AddGameStats(_gameStatsId, gameStats);
+            EngineBindings.AddComponent(_gameStatsId, gameStats);
             
             // 记录游戏开始时间
             _gameStartTime = Environment.TickCount / 1000.0f;
@@ -577,26 +570,7 @@ namespace Game
             gameStats.gameTime = (Environment.TickCount / 1000.0f) - _gameStartTime;
             
             // 更新击杀数
-            gameStats.killCount = _killCount;
-        }
-
-        // 清理系统 - 清理被销毁的老鼠
-        [UpdateSystem]
-        [Query(typeof(Transform), typeof(Mesh))]
-        public static void CleanupSystem(float dt, ref Transform transform, ref Mesh mesh)
-        {
-            // 只处理老鼠（模型ID为3）
-            if (mesh.modelId != 1)
-            {
-                return;
-            }
-
-            // 如果老鼠被移动到很远的地方，说明它已经被"杀死"
-            if (transform.position.X > 99990f || transform.position.Y < -99990f)
-            {
-                // 进一步缩小缩放，确保不可见
-                transform.scale = Vector3.Zero;
-            }
+            gameStats.killCount = Volatile.Read(ref _killCount);
         }
 
         private class MeshDefinition
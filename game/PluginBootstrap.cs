@@ -10,6 +10,15 @@ namespace Game
 {
   public static unsafe class PluginBootstrap
   {
+    // how the host runs an update system, the same values as SystemFlags in RuntimeBridge.cpp
+    [Flags]
+    public enum SystemFlags
+    {
+      None = 0,
+      Exclusive = 1 << 0,
+      Parallel = 1 << 1,
+    }
+
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     public delegate void ManagedStartupDel();
 
@@ -27,7 +36,14 @@ namespace Game
       IntPtr fnPtr,
       int count,
       [MarshalAs(UnmanagedType.LPArray, ArraySubType=UnmanagedType.LPStr)]
-      string[]      names
+      string[]      names,
+      int readOnlyCount,
+      int filterCount,
+      [MarshalAs(UnmanagedType.LPArray, ArraySubType=UnmanagedType.LPStr)]
+      string[]      filterNames,
+      int excludedCount,
+      [MarshalAs(UnmanagedType.LPStr)] string systemName,
+      SystemFlags flags
     );
 
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
@@ -36,9 +52,43 @@ namespace Game
         void* componentsPtr
     );
 
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void HostRegChunkedDel(
+      IntPtr fnPtr,
+      int count,
+      [MarshalAs(UnmanagedType.LPArray, ArraySubType=UnmanagedType.LPStr)]
+      string[]      names,
+      int chunkSize,
+      int readOnlyCount,
+      int filterCount,
+      [MarshalAs(UnmanagedType.LPArray, ArraySubType=UnmanagedType.LPStr)]
+      string[]      filterNames,
+      int excludedCount,
+      [MarshalAs(UnmanagedType.LPStr)] string systemName,
+      SystemFlags flags
+    );
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void HostDeclareGroupDel(
+      int ownedCount,
+      [MarshalAs(UnmanagedType.LPArray, ArraySubType=UnmanagedType.LPStr)]
+      string[]      owned,
+      int getCount,
+      [MarshalAs(UnmanagedType.LPArray, ArraySubType=UnmanagedType.LPStr)]
+      string[]      get
+    );
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public unsafe delegate void NativeChunkDel(
+        float dt,
+        int entityCount,
+        void*** componentArrays
+    );
+
     // keep shims & pinned delegates alive
     static List<DynamicMethod> _shims = new();
     static List<NativePerEntityDel> _pinnedShims = new();
+    static List<NativeChunkDel> _pinnedChunkShims = new();
 
     public static Func<string, IntPtr> GetProc { get; private set; }
 
@@ -54,6 +104,39 @@ namespace Game
                           hostGet("HostRegisterStartup"));
       var hostPerEnt = Marshal.GetDelegateForFunctionPointer<HostRegPerEntDel>(
                           hostGet("HostRegisterPerEntityUpdate"));
+      var hostChunked = Marshal.GetDelegateForFunctionPointer<HostRegChunkedDel>(
+                          hostGet("HostRegisterChunkedUpdate"));
+      var hostDeclareGroup = Marshal.GetDelegateForFunctionPointer<HostDeclareGroupDel>(
+                          hostGet("HostDeclareGroup"));
+
+      // ---- COMPONENTS ----
+      // checked against the host's layout before anything is added or queried
+      foreach (var component in Assembly.GetExecutingAssembly()
+                                        .GetTypes()
+                                        .Where(t => t.GetCustomAttribute<ComponentAttribute>() != null))
+      {
+        EngineBindings.RegisterComponent(component);
+      }
+
+      // ---- TAGS ----
+      // registered before any system is, their queries may name them
+      foreach (var tag in Assembly.GetExecutingAssembly()
+                                  .GetTypes()
+                                  .Where(t => t.GetCustomAttribute<TagAttribute>() != null))
+      {
+        EngineBindings.RegisterTag(tag);
+      }
+
+      // ---- OWNING GROUPS ----
+      // declared before any system is registered, the first queries already walk them
+      foreach (var group in Assembly.GetExecutingAssembly()
+                                    .GetTypes()
+                                    .SelectMany(t => t.GetCustomAttributes<OwningGroupAttribute>()))
+      {
+        var owned = group.Owned.Select(c => c.Name).ToArray();
+        var get = group.Get.Select(c => c.Name).ToArray();
+        hostDeclareGroup(owned.Length, owned, get.Length, get);
+      }
 
       // scan all static methods for systems
       foreach (var m in Assembly.GetExecutingAssembly()
@@ -92,8 +175,9 @@ namespace Game
         {
           var query = m.GetCustomAttribute<QueryAttribute>()
                    ?? throw new InvalidOperationException($"{m.Name} missing [Query]");
-          var comps = query.Components;
+          var comps = query.AllComponents;
           var compNames = comps.Select(c => c.Name).ToArray();
+          var filterNames = GetFilterNames(query);
 
           // emit: void shim(float dt, void* comps)
           var shim = new DynamicMethod(
@@ -135,9 +219,73 @@ namespace Game
           var fnPtr = Marshal.GetFunctionPointerForDelegate(nativeDel);
 
           // 注册系统，传入所有组件名称
-          hostPerEnt(fnPtr, comps.Length, compNames);
+          hostPerEnt(fnPtr, comps.Length, compNames, query.ReadOnly.Length,
+                     filterNames.Length, filterNames, query.Without.Length,
+                     $"{m.DeclaringType.Name}.{m.Name}", GetSystemFlags(m, query));
+        }
+
+        // ---- CHUNKED UPDATE ----
+        var chunked = m.GetCustomAttribute<ChunkedUpdateSystemAttribute>();
+        if (chunked != null)
+        {
+          var query = m.GetCustomAttribute<QueryAttribute>()
+                   ?? throw new InvalidOperationException($"{m.Name} missing [Query]");
+          var comps = query.AllComponents;
+          var compNames = comps.Select(c => c.Name).ToArray();
+          var filterNames = GetFilterNames(query);
+
+          // emit: void shim(float dt, int count, void*** arrays)
+          //   => m(dt, new ComponentChunk<T0>(arrays[0], count), ...)
+          var shim = new DynamicMethod(
+            "chunk_shim_" + m.Name,
+            typeof(void),
+            new[] { typeof(float), typeof(int), typeof(void***) },
+            typeof(PluginBootstrap),
+            skipVisibility: true
+          );
+          var il = shim.GetILGenerator();
+
+          il.Emit(OpCodes.Ldarg_0);
+          for (int i = 0; i < comps.Length; i++)
+          {
+            var ctor = typeof(ComponentChunk<>).MakeGenericType(comps[i])
+                         .GetConstructor(new[] { typeof(void**), typeof(int) });
+
+            // arrays[i]
+            il.Emit(OpCodes.Ldarg_2);
+            il.Emit(OpCodes.Ldc_I4, i * IntPtr.Size);
+            il.Emit(OpCodes.Conv_I);
+            il.Emit(OpCodes.Add);
+            il.Emit(OpCodes.Ldind_I);
+            il.Emit(OpCodes.Ldarg_1);
+            il.Emit(OpCodes.Newobj, ctor);
+          }
+          il.EmitCall(OpCodes.Call, m, null);
+          il.Emit(OpCodes.Ret);
+
+          _shims.Add(shim);
+
+          var nativeDel = (NativeChunkDel)shim.CreateDelegate(typeof(NativeChunkDel));
+          _pinnedChunkShims.Add(nativeDel);
+
+          var fnPtr = Marshal.GetFunctionPointerForDelegate(nativeDel);
+          hostChunked(fnPtr, comps.Length, compNames, chunked.ChunkSize, query.ReadOnly.Length,
+                      filterNames.Length, filterNames, query.Without.Length,
+                      $"{m.DeclaringType.Name}.{m.Name}", GetSystemFlags(m, query));
         }
       }
     }
+
+    // the required names, then the excluded ones
+    static string[] GetFilterNames(QueryAttribute query) =>
+      query.With.Concat(query.Without).Select(t => t.Name).ToArray();
+
+    static SystemFlags GetSystemFlags(MethodInfo m, QueryAttribute query)
+    {
+      var flags = SystemFlags.None;
+      if (query.Exclusive) flags |= SystemFlags.Exclusive;
+      if (m.GetCustomAttribute<ParallelAttribute>() != null) flags |= SystemFlags.Parallel;
+      return flags;
+    }
   }
 }
@@ -0,0 +1,80 @@
+using System;
+using System.Collections.Generic;
+using System.Reflection;
+using System.Runtime.InteropServices;
+
+namespace Game
+{
+    // the components of a prefab, e.g.
+    // new PrefabTemplate().With(new Mesh { modelId = 1 }).With(new Velocity()), registered once with
+    // EngineBindings.RegisterPrefab and copied by the host into every instance
+    public sealed class PrefabTemplate
+    {
+        internal readonly List<int> TypeIds = new List<int>();
+        // the values, one after another
+        internal readonly List<byte> Values = new List<byte>();
+        internal readonly List<int> Offsets = new List<int>();
+
+        public PrefabTemplate With<T>(T component) where T : unmanaged
+        {
+            TypeIds.Add(EngineBindings.ComponentTypeId<T>.Value);
+            Offsets.Add(Values.Count);
+            Values.AddRange(MemoryMarshal.AsBytes(MemoryMarshal.CreateReadOnlySpan(ref component, 1)).ToArray());
+            return this;
+        }
+    }
+
+    // the values, one per instance, that override a field of one of the prefab's components in
+    // each instance, e.g. new PrefabOverrides().Set<Transform, Vector3>(nameof(Transform.position),
+    // positions), or Set<Material>(materials) for the whole component, applied in the order they
+    // are set by EngineBindings.Instantiate
+    public sealed class PrefabOverrides
+    {
+        internal readonly List<int> TypeIds = new List<int>();
+        internal readonly List<int> FieldOffsets = new List<int>();
+        internal readonly List<int> Sizes = new List<int>();
+        internal readonly List<int> Counts = new List<int>();
+        // the values of every override, one after another
+        internal readonly List<byte> Values = new List<byte>();
+        internal readonly List<int> Offsets = new List<int>();
+
+        public PrefabOverrides Set<T, TField>(string field, ReadOnlySpan<TField> values)
+            where T : unmanaged where TField : unmanaged
+        {
+            FieldInfo info = typeof(T).GetField(field, BindingFlags.Instance | BindingFlags.Public | BindingFlags.NonPublic);
+            if (info == null || info.FieldType != typeof(TField))
+            {
+                throw new ArgumentException($"{typeof(T).Name} has no {typeof(TField).Name} field {field}", nameof(field));
+            }
+            return Add(EngineBindings.ComponentTypeId<T>.Value, (int)Marshal.OffsetOf<T>(field), values);
+        }
+
+        public PrefabOverrides Set<T>(ReadOnlySpan<T> values) where T : unmanaged
+        {
+            return Add(EngineBindings.ComponentTypeId<T>.Value, 0, values);
+        }
+
+        private unsafe PrefabOverrides Add<TValue>(int typeId, int fieldOffset, ReadOnlySpan<TValue> values)
+            where TValue : unmanaged
+        {
+            TypeIds.Add(typeId);
+            FieldOffsets.Add(fieldOffset);
+            Sizes.Add(sizeof(TValue));
+            Counts.Add(values.Length);
+            Offsets.Add(Values.Count);
+            Values.AddRange(MemoryMarshal.AsBytes(values).ToArray());
+            return this;
+        }
+    }
+
+    // an override as the host takes it, the i-th instance's value at Data + i * Stride
+    [StructLayout(LayoutKind.Sequential)]
+    internal unsafe struct NativePrefabOverride
+    {
+        public int TypeId;
+        public int Offset;
+        public int Size;
+        public int Stride;
+        public void* Data;
+    }
+}
@@ -16,6 +16,13 @@ const float RECIPROCAL_PI = 1.0 / PI;
 
 #include "include/sharedVariables.glsl"
 
+// material features, selected per pipeline variant (see MaterialFeature in Renderer.hpp), the
+// disabled texture fetches are removed entirely when the pipeline is specialized
+layout(constant_id = 0) const bool kHasBaseColorTex      = false;
+layout(constant_id = 1) const bool kHasNormalTex         = false;
+layout(constant_id = 2) const bool kHasMetalRoughnessTex = false;
+layout(constant_id = 3) const bool kHasEmissiveTex       = false;
+
 // 纹理绑定
 layout(set = 0, binding = 0) uniform U_RenderInfo { S_RenderInfo data; } renderInfo;
 layout(set = 0, binding = 1) uniform sampler2D baseColorSampler;
@@ -96,24 +103,27 @@ void main() {
     vec2 flippedTexCoord = vec2(fragTexCoord.x, 1.0 - fragTexCoord.y);
 
     // 纹理采样
-    if (materialInfo.data.hasBaseColorTex == 1) {
+    if (kHasBaseColorTex) {
         baseColor = texture(baseColorSampler, flippedTexCoord);
     }
 
-    if (materialInfo.data.hasMetalRoughnessTex == 1) {
+    if (kHasMetalRoughnessTex) {
         vec3 mr = texture(metalRoughnessSampler, flippedTexCoord).rgb;
         roughness = mr.g;
         metallic = mr.b;
     }
 
-    if (materialInfo.data.hasEmissiveTex == 1) {
+    if (kHasEmissiveTex) {
         emissive = texture(emissiveSampler, flippedTexCoord).rgb;
     }
 
     // 法线计算
     vec3 normal = normalize(fragNormal);
-    if (materialInfo.data.hasNormalTex == 1) {
-        vec3 tangentNormal = texture(normalSampler, flippedTexCoord).xyz * 2.0 - 1.0;
+    if (kHasNormalTex) {
+        // bc5 normal maps only store xy, z is rebuilt from the unit length for every map alike
+        vec2 tangentXy = texture(normalSampler, flippedTexCoord).xy * 2.0 - 1.0;
+        vec3 tangentNormal =
+            vec3(tangentXy, sqrt(max(1.0 - dot(tangentXy, tangentXy), 0.0)));
         vec3 T = normalize(fragTangent.xyz);
         vec3 B = normalize(cross(normal, T) * fragTangent.w);
         mat3 TBN = mat3(T, B, normal);
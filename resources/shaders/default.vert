@@ -1,9 +1,11 @@
 #version 450
 #extension GL_GOOGLE_include_directive : enable
 
-layout(location = 0) in vec3 inPos;
+// fp32 vertices (Vertex) fill the missing components with 0 and 1, quantized vertices
+// (QuantizedVertex) carry the tangent handedness in inPos.w and octahedral normal and tangent in xy
+layout(location = 0) in vec4 inPos;
 layout(location = 1) in vec2 inTexCoord;
-layout(location = 2) in vec3 inNormal;
+layout(location = 2) in vec4 inNormal;
 layout(location = 3) in vec4 inTangent;
 
 // Instance data (model matrix)
@@ -19,14 +21,45 @@ layout(location = 4) out vec4 fragTangent;
 
 layout(set = 0, binding = 0) uniform U_RenderInfo { S_RenderInfo data; } renderInfo;
 
+// selected per pipeline variant (see GeometryFeature in Renderer.hpp), constant ids 0 to 3 are the
+// material features of default.frag
+layout(constant_id = 4) const bool kQuantizedVertices = false;
+
+// the bounds of the mesh, quantized positions are normalized within them (VertexDequantization)
+layout(push_constant) uniform PC_Mesh {
+    vec4 offset;
+    vec4 scale;
+} meshDequantization;
+
+vec3 octDecode(vec2 e) {
+    vec3 n  = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main() {
-    vec4 worldPos = instanceModelMatrix * vec4(inPos, 1.0);
+    vec3 pos;
+    vec3 normal;
+    vec4 tangent;
+    if (kQuantizedVertices) {
+        pos     = meshDequantization.offset.xyz + inPos.xyz * meshDequantization.scale.xyz;
+        normal  = octDecode(inNormal.xy);
+        tangent = vec4(octDecode(inTangent.xy), inPos.w * 2.0 - 1.0);
+    } else {
+        pos     = inPos.xyz;
+        normal  = inNormal.xyz;
+        tangent = inTangent;
+    }
+
+    vec4 worldPos = instanceModelMatrix * vec4(pos, 1.0);
     float dist = length(worldPos);
 
     gl_Position = renderInfo.data.proj * renderInfo.data.view * worldPos;
     fragPos = worldPos.xyz;
     fragTexCoord = inTexCoord;
-    fragNormal = normalize(mat3(transpose(inverse(instanceModelMatrix))) * inNormal);
+    fragNormal = normalize(mat3(transpose(inverse(instanceModelMatrix))) * normal);
     viewPos = renderInfo.data.viewPos;
-    fragTangent = inTangent;
+    fragTangent = tangent;
 }
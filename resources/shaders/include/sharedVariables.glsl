@@ -16,10 +16,8 @@ struct S_MaterialInfo {
     float occlusion;      // offset 20, size 4
     vec3 emissive;   // offset 24, size 12
     float padding;        // offset 36, size 4 (填充到 16 字节对齐)
-    int hasBaseColorTex;
-    int hasNormalTex;
-    int hasMetalRoughnessTex;
-    int hasEmissiveTex;
+    // texture presence is baked into the pipeline variant, see the specialization constants in
+    // default.frag
 };
 
 #endif // SHARED_VARIABLES_GLSL
@@ -0,0 +1,380 @@
+#include "AsyncUploader.hpp"
+
+#include "utils/logger/Logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+// staging memory of a task grows in chunks of this size, larger uploads get a chunk of their own
+constexpr VkDeviceSize kStagingChunkSize = 8ULL * 1024 * 1024;
+constexpr VkDeviceSize kBufferCopyAlignment = 16;
+
+// stages on the graphics queue that may consume streamed data
+constexpr VkPipelineStageFlags kConsumerStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                                 VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+constexpr VkAccessFlags kBufferConsumerAccess =
+    VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+    VK_ACCESS_SHADER_READ_BIT;
+
+VkDeviceSize _alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+AsyncUploader::Recorder::Recorder(AsyncUploader *uploader, VkCommandBuffer commandBuffer)
+    : _uploader(uploader), _commandBuffer(commandBuffer) {}
+
+AsyncUploader::Recorder::StagingChunk &
+AsyncUploader::Recorder::_allocateStaging(VkDeviceSize size, VkDeviceSize alignment,
+                                          VkDeviceSize &offset) {
+    if (!_stagingChunks.empty()) {
+        auto &chunk = _stagingChunks.back();
+        offset      = _alignUp(chunk.used, alignment);
+        if (offset + size <= chunk.size) {
+            chunk.used = offset + size;
+            return chunk;
+        }
+    }
+
+    StagingChunk chunk{};
+    chunk.size = std::max(size, kStagingChunkSize);
+
+    VkBufferCreateInfo bufferCreateInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCreateInfo.size        = chunk.size;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocCreateInfo{};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocCreateInfo.flags =
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocInfo{};
+    vmaCreateBuffer(_uploader->_allocator, &bufferCreateInfo, &allocCreateInfo, &chunk.vkBuffer,
+                    &chunk.allocation, &allocInfo);
+    chunk.mappedAddr = static_cast<unsigned char *>(allocInfo.pMappedData);
+    chunk.used       = size;
+
+    offset = 0;
+    _stagingChunks.push_back(chunk);
+    return _stagingChunks.back();
+}
+
+void AsyncUploader::Recorder::uploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset,
+                                             void const *data, VkDeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+
+    VkDeviceSize stagingOffset = 0;
+    auto &chunk = _allocateStaging(size, kBufferCopyAlignment, stagingOffset);
+    memcpy(chunk.mappedAddr + stagingOffset, data, size);
+    vmaFlushAllocation(_uploader->_allocator, chunk.allocation, stagingOffset, size);
+
+    VkBufferCopy bufCopy = {
+        stagingOffset, // srcOffset
+        dstOffset,     // dstOffset
+        size,          // size
+    };
+    vkCmdCopyBuffer(_commandBuffer, chunk.vkBuffer, dstBuffer, 1, &bufCopy);
+
+    VkBufferMemoryBarrier releaseBarrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    releaseBarrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    releaseBarrier.srcQueueFamilyIndex = _uploader->_transferQueueFamily;
+    releaseBarrier.dstQueueFamilyIndex = _uploader->_graphicsQueueFamily;
+    releaseBarrier.buffer              = dstBuffer;
+    releaseBarrier.offset              = dstOffset;
+    releaseBarrier.size                = size;
+    _releaseBufferBarriers.push_back(releaseBarrier);
+}
+
+void AsyncUploader::Recorder::uploadToImage(VkImage dstImage, VkBufferImageCopy region,
+                                            void const *data, VkDeviceSize size,
+                                            VkDeviceSize texelBlockSize,
+                                            VkImageLayout finalLayout) {
+    VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                           = dstImage;
+    barrier.subresourceRange.aspectMask     = region.imageSubresource.aspectMask;
+    barrier.subresourceRange.baseMipLevel   = region.imageSubresource.mipLevel;
+    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.baseArrayLayer = region.imageSubresource.baseArrayLayer;
+    barrier.subresourceRange.layerCount     = region.imageSubresource.layerCount;
+    barrier.srcAccessMask                   = 0;
+    barrier.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    // a failed decode still goes through the transitions, so the image ends up in the layout
+    // everybody expects
+    if (data != nullptr && size != 0) {
+        VkDeviceSize stagingOffset = 0;
+        auto &chunk =
+            _allocateStaging(size, std::lcm(texelBlockSize, VkDeviceSize{4}), stagingOffset);
+        memcpy(chunk.mappedAddr + stagingOffset, data, size);
+        vmaFlushAllocation(_uploader->_allocator, chunk.allocation, stagingOffset, size);
+
+        region.bufferOffset = stagingOffset;
+        vkCmdCopyBufferToImage(_commandBuffer, chunk.vkBuffer, dstImage,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    // the layout transition is part of the ownership transfer, both halves use the same layouts
+    barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout           = finalLayout;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = 0;
+    barrier.srcQueueFamilyIndex = _uploader->_transferQueueFamily;
+    barrier.dstQueueFamilyIndex = _uploader->_graphicsQueueFamily;
+    _releaseImageBarriers.push_back(barrier);
+}
+
+AsyncUploader::AsyncUploader(Logger *logger, VkDevice device, VmaAllocator allocator,
+                             VkQueue transferQueue, uint32_t transferQueueFamily,
+                             uint32_t graphicsQueueFamily)
+    : _logger(logger), _device(device), _allocator(allocator), _transferQueue(transferQueue),
+      _transferQueueFamily(transferQueueFamily), _graphicsQueueFamily(graphicsQueueFamily) {
+    VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{
+        VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeCreateInfo.initialValue  = 0;
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+    vkCreateSemaphore(_device, &semaphoreCreateInfo, nullptr, &_timelineSemaphore);
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    commandPoolCreateInfo.queueFamilyIndex = _transferQueueFamily;
+    commandPoolCreateInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    vkCreateCommandPool(_device, &commandPoolCreateInfo, nullptr, &_commandPool);
+
+    _logger->info("Async uploader streams through queue family {} ({} ownership transfer)",
+                  _transferQueueFamily, _isOwnershipTransferNeeded() ? "with" : "without");
+
+    _loaderThread = std::thread([this] { _loaderLoop(); });
+}
+
+AsyncUploader::~AsyncUploader() {
+    {
+        std::lock_guard lock(_taskMutex);
+        _stopRequested = true;
+    }
+    _taskCondition.notify_all();
+    // the loader drains the queue and waits for its submissions before leaving
+    _loaderThread.join();
+
+    vkDestroyCommandPool(_device, _commandPool, nullptr);
+    vkDestroySemaphore(_device, _timelineSemaphore, nullptr);
+}
+
+uint64_t AsyncUploader::enqueue(Task task) {
+    uint64_t ticket = 0;
+    {
+        std::lock_guard lock(_taskMutex);
+        ticket = ++_lastTicket;
+        _tasks.emplace_back(ticket, std::move(task));
+    }
+    _taskCondition.notify_one();
+    return ticket;
+}
+
+void AsyncUploader::recordAcquireBarriers(VkCommandBuffer commandBuffer) {
+    // tasks are pushed before they are submitted, so everything up to this value is listed
+    uint64_t const completedTicket = _getCompletedTicket();
+    if (completedTicket <= _acquiredTicket) {
+        return;
+    }
+
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    {
+        std::lock_guard lock(_submittedMutex);
+        while (!_submittedTasks.empty() && _submittedTasks.front().ticket <= completedTicket) {
+            auto &submittedTask = _submittedTasks.front();
+            bufferBarriers.insert(bufferBarriers.end(), submittedTask.acquireBufferBarriers.begin(),
+                                  submittedTask.acquireBufferBarriers.end());
+            imageBarriers.insert(imageBarriers.end(), submittedTask.acquireImageBarriers.begin(),
+                                 submittedTask.acquireImageBarriers.end());
+            _submittedTasks.pop_front();
+        }
+    }
+    _acquiredTicket = completedTicket;
+
+    if (bufferBarriers.empty() && imageBarriers.empty()) {
+        return;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, kConsumerStages, 0, 0,
+                         nullptr, static_cast<uint32_t>(bufferBarriers.size()),
+                         bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()),
+                         imageBarriers.data());
+}
+
+void AsyncUploader::cancel(uint64_t ticket) {
+    if (ticket == 0 || ticket <= _acquiredTicket) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(_taskMutex);
+        auto it = std::find_if(_tasks.begin(), _tasks.end(),
+                               [ticket](auto const &task) { return task.first == ticket; });
+        // not started yet, the later tickets keep the timeline moving past it
+        if (it != _tasks.end()) {
+            _tasks.erase(it);
+            return;
+        }
+    }
+
+    VkSemaphoreWaitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores    = &_timelineSemaphore;
+    waitInfo.pValues        = &ticket;
+    vkWaitSemaphores(_device, &waitInfo, UINT64_MAX);
+
+    std::lock_guard lock(_submittedMutex);
+    auto it = std::find_if(_submittedTasks.begin(), _submittedTasks.end(),
+                           [ticket](auto const &task) { return task.ticket == ticket; });
+    if (it != _submittedTasks.end()) {
+        _submittedTasks.erase(it);
+    }
+}
+
+void AsyncUploader::_loaderLoop() {
+    while (true) {
+        std::pair<uint64_t, Task> task;
+        {
+            std::unique_lock lock(_taskMutex);
+            _taskCondition.wait(lock, [this] { return _stopRequested || !_tasks.empty(); });
+            if (_tasks.empty()) {
+                break;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        _reclaimCompletedTasks(false);
+        _runTask(task.first, task.second);
+    }
+
+    _reclaimCompletedTasks(true);
+}
+
+void AsyncUploader::_runTask(uint64_t ticket, Task const &task) {
+    InFlightTask inFlightTask{};
+    inFlightTask.ticket = ticket;
+
+    VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool        = _commandPool;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    vkAllocateCommandBuffers(_device, &allocInfo, &inFlightTask.commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(inFlightTask.commandBuffer, &beginInfo);
+
+    Recorder recorder(this, inFlightTask.commandBuffer);
+    task(recorder);
+
+    SubmittedTask submittedTask{};
+    submittedTask.ticket = ticket;
+    if (_isOwnershipTransferNeeded()) {
+        // the acquire half is recorded by the render thread with the same barriers
+        submittedTask.acquireBufferBarriers = recorder._releaseBufferBarriers;
+        submittedTask.acquireImageBarriers  = recorder._releaseImageBarriers;
+        for (auto &barrier : submittedTask.acquireBufferBarriers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = kBufferConsumerAccess;
+        }
+        for (auto &barrier : submittedTask.acquireImageBarriers) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        }
+    } else {
+        // a spare queue of the graphics family, a regular barrier is all it takes and the
+        // semaphore wait of the frame orders it with the consumers
+        for (auto &barrier : recorder._releaseBufferBarriers) {
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstAccessMask       = kBufferConsumerAccess;
+        }
+        for (auto &barrier : recorder._releaseImageBarriers) {
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        }
+    }
+
+    if (!recorder._releaseBufferBarriers.empty() || !recorder._releaseImageBarriers.empty()) {
+        // the destination stage of a release is ignored, a queue of the graphics family has to
+        // block the consumers itself
+        VkPipelineStageFlags const dstStage = _isOwnershipTransferNeeded()
+                                                  ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+                                                  : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        vkCmdPipelineBarrier(inFlightTask.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+                             0, 0, nullptr,
+                             static_cast<uint32_t>(recorder._releaseBufferBarriers.size()),
+                             recorder._releaseBufferBarriers.data(),
+                             static_cast<uint32_t>(recorder._releaseImageBarriers.size()),
+                             recorder._releaseImageBarriers.data());
+    }
+    vkEndCommandBuffer(inFlightTask.commandBuffer);
+
+    {
+        std::lock_guard lock(_submittedMutex);
+        _submittedTasks.push_back(std::move(submittedTask));
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{
+        VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timelineSubmitInfo.signalSemaphoreValueCount = 1;
+    timelineSubmitInfo.pSignalSemaphoreValues    = &ticket;
+
+    VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.pNext                = &timelineSubmitInfo;
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &inFlightTask.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &_timelineSemaphore;
+    vkQueueSubmit(_transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+
+    inFlightTask.stagingChunks = std::move(recorder._stagingChunks);
+    _inFlightTasks.push_back(std::move(inFlightTask));
+}
+
+void AsyncUploader::_reclaimCompletedTasks(bool waitForAll) {
+    if (_inFlightTasks.empty()) {
+        return;
+    }
+
+    if (waitForAll) {
+        uint64_t const lastTicket = _inFlightTasks.back().ticket;
+        VkSemaphoreWaitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores    = &_timelineSemaphore;
+        waitInfo.pValues        = &lastTicket;
+        vkWaitSemaphores(_device, &waitInfo, UINT64_MAX);
+    }
+
+    uint64_t const completedTicket = _getCompletedTicket();
+    while (!_inFlightTasks.empty() && _inFlightTasks.front().ticket <= completedTicket) {
+        auto &inFlightTask = _inFlightTasks.front();
+        vkFreeCommandBuffers(_device, _commandPool, 1, &inFlightTask.commandBuffer);
+        for (auto &chunk : inFlightTask.stagingChunks) {
+            vmaDestroyBuffer(_allocator, chunk.vkBuffer, chunk.allocation);
+        }
+        _inFlightTasks.pop_front();
+    }
+}
+
+uint64_t AsyncUploader::_getCompletedTicket() const {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(_device, _timelineSemaphore, &value);
+    return value;
+}
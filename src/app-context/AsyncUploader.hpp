@@ -0,0 +1,147 @@
+#pragma once
+
+#include "volk.h"
+
+#ifdef __APPLE__
+#include "vk_mem_alloc.h"
+#else
+#include "vma/vk_mem_alloc.h"
+#endif
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Logger;
+
+// streams uploads through the transfer queue from a loader thread, so assets can arrive while the
+// game is running without stalling the frame or taking graphics queue time
+//
+// every enqueued task gets a ticket, the task runs on the loader thread, records its copies
+// through a Recorder and is submitted on its own, signalling a timeline semaphore with its ticket
+// the resources are released from the transfer family at the end of the task, and acquired by
+// the graphics family once recordAcquireBarriers sees the ticket completed
+//
+// only created when the transfer queue is a different VkQueue than the graphics queue
+class AsyncUploader {
+  public:
+    // records the copies of one task, only valid inside the task
+    class Recorder {
+      public:
+        // data must stay valid until the call returns
+        void uploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, void const *data,
+                            VkDeviceSize size);
+
+        // the image is expected to be unused so far, it is written from VK_IMAGE_LAYOUT_UNDEFINED
+        // and ends up in finalLayout once acquired by the graphics queue, the bufferOffset of the
+        // region is overwritten
+        void uploadToImage(VkImage dstImage, VkBufferImageCopy region, void const *data,
+                           VkDeviceSize size, VkDeviceSize texelBlockSize,
+                           VkImageLayout finalLayout);
+
+      private:
+        friend class AsyncUploader;
+        struct StagingChunk {
+            VkBuffer vkBuffer         = VK_NULL_HANDLE;
+            VmaAllocation allocation  = VK_NULL_HANDLE;
+            unsigned char *mappedAddr = nullptr;
+            VkDeviceSize size         = 0;
+            VkDeviceSize used         = 0;
+        };
+
+        Recorder(AsyncUploader *uploader, VkCommandBuffer commandBuffer);
+
+        AsyncUploader *_uploader;
+        VkCommandBuffer _commandBuffer;
+        std::vector<StagingChunk> _stagingChunks;
+        std::vector<VkBufferMemoryBarrier> _releaseBufferBarriers;
+        std::vector<VkImageMemoryBarrier> _releaseImageBarriers;
+
+        StagingChunk &_allocateStaging(VkDeviceSize size, VkDeviceSize alignment,
+                                       VkDeviceSize &offset);
+    };
+
+    using Task = std::function<void(Recorder &recorder)>;
+
+    AsyncUploader(Logger *logger, VkDevice device, VmaAllocator allocator, VkQueue transferQueue,
+                  uint32_t transferQueueFamily, uint32_t graphicsQueueFamily);
+    ~AsyncUploader();
+
+    // disable move and copy
+    AsyncUploader(const AsyncUploader &)            = delete;
+    AsyncUploader &operator=(const AsyncUploader &) = delete;
+    AsyncUploader(AsyncUploader &&)                 = delete;
+    AsyncUploader &operator=(AsyncUploader &&)      = delete;
+
+    // thread safe, tickets are never 0
+    uint64_t enqueue(Task task);
+
+    // render thread, records the ownership acquisition of every completed task into a command
+    // buffer that is submitted to the graphics queue this frame
+    void recordAcquireBarriers(VkCommandBuffer commandBuffer);
+
+    // render thread, whether the resources written by the task can be used by this frame
+    [[nodiscard]] bool isReady(uint64_t ticket) const { return ticket <= _acquiredTicket; }
+
+    // the graphics submission that contains the acquire barriers has to wait on this semaphore
+    // with getAcquiredTicket() as the value, it has already been reached so it never stalls
+    [[nodiscard]] VkSemaphore getTimelineSemaphore() const { return _timelineSemaphore; }
+    [[nodiscard]] uint64_t getAcquiredTicket() const { return _acquiredTicket; }
+
+    // render thread, blocks until the task has completed and forgets its pending acquisition,
+    // must be called before destroying resources that a task may still write to
+    void cancel(uint64_t ticket);
+
+  private:
+    struct SubmittedTask {
+        uint64_t ticket = 0;
+        std::vector<VkBufferMemoryBarrier> acquireBufferBarriers;
+        std::vector<VkImageMemoryBarrier> acquireImageBarriers;
+    };
+
+    struct InFlightTask {
+        uint64_t ticket               = 0;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        std::vector<Recorder::StagingChunk> stagingChunks;
+    };
+
+    Logger *_logger;
+    VkDevice _device;
+    VmaAllocator _allocator;
+    VkQueue _transferQueue;
+    uint32_t _transferQueueFamily;
+    uint32_t _graphicsQueueFamily;
+
+    VkSemaphore _timelineSemaphore = VK_NULL_HANDLE;
+
+    std::mutex _taskMutex;
+    std::condition_variable _taskCondition;
+    std::deque<std::pair<uint64_t, Task>> _tasks;
+    uint64_t _lastTicket = 0;
+    bool _stopRequested  = false;
+
+    // waiting for their acquisition on the graphics queue
+    std::mutex _submittedMutex;
+    std::deque<SubmittedTask> _submittedTasks;
+
+    // only touched by the loader thread
+    VkCommandPool _commandPool = VK_NULL_HANDLE;
+    std::deque<InFlightTask> _inFlightTasks;
+
+    // only touched by the render thread
+    uint64_t _acquiredTicket = 0;
+
+    std::thread _loaderThread;
+
+    void _loaderLoop();
+    void _runTask(uint64_t ticket, Task const &task);
+    void _reclaimCompletedTasks(bool waitForAll);
+    [[nodiscard]] uint64_t _getCompletedTicket() const;
+    [[nodiscard]] bool _isOwnershipTransferNeeded() const {
+        return _transferQueueFamily != _graphicsQueueFamily;
+    }
+};
@@ -0,0 +1,197 @@
+#include "Defragmenter.hpp"
+
+#include "UploadManager.hpp"
+
+#include "utils/logger/Logger.hpp"
+
+#include <chrono>
+
+namespace {
+constexpr MemoryClass kDefragmentedClass = MemoryClass::kStaticGeometry;
+} // namespace
+
+Defragmenter::Defragmenter(Logger *logger, VkDevice device, VmaAllocator allocator,
+                           MemoryPools *memoryPools, UploadManager *uploadManager)
+    : _logger(logger), _device(device), _allocator(allocator), _memoryPools(memoryPools),
+      _uploadManager(uploadManager) {}
+
+Defragmenter::~Defragmenter() {
+    // the device is idle, so the open pass doesn't have to wait for its frames
+    if (_isPassOpen) {
+        _endPass();
+    }
+    if (_context != VK_NULL_HANDLE) {
+        _end();
+    }
+}
+
+Defragmenter::Stats Defragmenter::getStats() const {
+    Stats stats     = _stats;
+    stats.isRunning = _context != VK_NULL_HANDLE;
+    return stats;
+}
+
+bool Defragmenter::_isFragmented() const {
+    VmaPool pool = _memoryPools->getPool(kDefragmentedClass);
+    if (pool == VK_NULL_HANDLE) {
+        return false;
+    }
+    VmaDetailedStatistics poolStatistics{};
+    vmaCalculatePoolStatistics(_allocator, pool, &poolStatistics);
+
+    // a single block can't give any memory back
+    auto const &statistics = poolStatistics.statistics;
+    if (statistics.blockCount < 2 || statistics.blockBytes == 0) {
+        return false;
+    }
+    VkDeviceSize const unusedBytes = statistics.blockBytes - statistics.allocationBytes;
+    return static_cast<float>(unusedBytes) / static_cast<float>(statistics.blockBytes) >
+           _settings.fragmentationThreshold;
+}
+
+void Defragmenter::update() {
+    if (_isPassOpen) {
+        if (--_framesUntilPassEnd > 0) {
+            return;
+        }
+        _endPass();
+        return;
+    }
+
+    if (_context == VK_NULL_HANDLE) {
+        if (!_settings.isEnabled && !_isRequested) {
+            return;
+        }
+        if (!_isRequested && --_framesUntilCheck > 0) {
+            return;
+        }
+        _framesUntilCheck = kCheckInterval;
+        if (!_isRequested && !_isFragmented()) {
+            return;
+        }
+        _isRequested = false;
+        _begin();
+        if (_context == VK_NULL_HANDLE) {
+            return;
+        }
+    }
+
+    _beginPass();
+}
+
+void Defragmenter::_begin() {
+    VmaPool pool = _memoryPools->getPool(kDefragmentedClass);
+    if (pool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    VmaDefragmentationInfo defragmentationInfo{};
+    defragmentationInfo.flags                 = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+    defragmentationInfo.pool                  = pool;
+    defragmentationInfo.maxBytesPerPass       = kMaxBytesPerPass;
+    defragmentationInfo.maxAllocationsPerPass = kMaxMovesPerPass;
+    if (vmaBeginDefragmentation(_allocator, &defragmentationInfo, &_context) != VK_SUCCESS) {
+        _logger->warn("Defragmenter: failed to begin a defragmentation of {}",
+                      MemoryPools::getName(kDefragmentedClass));
+        _context = VK_NULL_HANDLE;
+        return;
+    }
+    // new resources of the class go around the pool until the defragmentation ends
+    _memoryPools->setPoolLocked(kDefragmentedClass, true);
+    _passCount = 0;
+    _stats.defragmentationCount++;
+}
+
+void Defragmenter::_beginPass() {
+    _passInfo = {};
+    if (_passCount >= kMaxPassCount ||
+        vmaBeginDefragmentationPass(_allocator, _context, &_passInfo) == VK_SUCCESS) {
+        // nothing (more) to move
+        _end();
+        return;
+    }
+    _passCount++;
+    _stats.passCount++;
+
+    auto const startTime  = std::chrono::steady_clock::now();
+    auto const timeBudget = std::chrono::duration<float, std::milli>(_settings.timeBudgetMs);
+
+    // earlier uploads to the sources have to be ordered before the copies, the batch barrier at the
+    // end of the flushed batch does that
+    _uploadManager->flush();
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    for (uint32_t i = 0; i < _passInfo.moveCount; i++) {
+        auto &move = _passInfo.pMoves[i];
+
+        VmaAllocationInfo srcInfo{};
+        vmaGetAllocationInfo(_allocator, move.srcAllocation, &srcInfo);
+        auto *relocatable = static_cast<RelocatableBuffer *>(srcInfo.pUserData);
+
+        bool const isOverBudget = std::chrono::steady_clock::now() - startTime > timeBudget;
+        if (relocatable == nullptr || !relocatable->isRelocatable() || isOverBudget) {
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+
+        VkBufferCreateInfo const bufferCreateInfo = relocatable->getRelocatableCreateInfo();
+        VkBuffer newBuffer                        = VK_NULL_HANDLE;
+        if (vkCreateBuffer(_device, &bufferCreateInfo, nullptr, &newBuffer) != VK_SUCCESS ||
+            vmaBindBufferMemory(_allocator, move.dstTmpAllocation, newBuffer) != VK_SUCCESS) {
+            vkDestroyBuffer(_device, newBuffer, nullptr);
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+
+        if (commandBuffer == VK_NULL_HANDLE) {
+            commandBuffer = _uploadManager->getCommandBuffer();
+        }
+        VkBufferCopy region{};
+        region.size = bufferCreateInfo.size;
+        vkCmdCopyBuffer(commandBuffer, relocatable->getRelocatableBuffer(), newBuffer, 1, &region);
+
+        _retiredBuffers.push_back(relocatable->getRelocatableBuffer());
+        relocatable->onRelocated(newBuffer);
+
+        _stats.movedAllocationCount++;
+        _stats.movedBytes += srcInfo.size;
+    }
+
+    _isPassOpen = true;
+    if (commandBuffer == VK_NULL_HANDLE) {
+        // nothing was copied, no frame can be using anything of the pass
+        _endPass();
+        return;
+    }
+    // the frames in flight may still read the old buffers, the copies themselves run ahead of the
+    // next frame
+    _framesUntilPassEnd = _settings.framesInFlight + 1;
+}
+
+void Defragmenter::_endPass() {
+    for (auto buffer : _retiredBuffers) {
+        vkDestroyBuffer(_device, buffer, nullptr);
+    }
+    _retiredBuffers.clear();
+
+    _isPassOpen = false;
+    if (vmaEndDefragmentationPass(_allocator, _context, &_passInfo) == VK_SUCCESS) {
+        _end();
+    }
+}
+
+void Defragmenter::_end() {
+    VmaDefragmentationStats defragmentationStats{};
+    vmaEndDefragmentation(_allocator, _context, &defragmentationStats);
+    _context = VK_NULL_HANDLE;
+    // frees what was destroyed in the meantime
+    _memoryPools->setPoolLocked(kDefragmentedClass, false);
+
+    _stats.freedBytes += defragmentationStats.bytesFreed;
+    _logger->info("Defragmenter: {} moved {} allocations ({:.2f} MB) in {} passes, {} blocks "
+                  "({:.2f} MB) freed",
+                  MemoryPools::getName(kDefragmentedClass), defragmentationStats.allocationsMoved,
+                  static_cast<double>(defragmentationStats.bytesMoved) / (1024.0 * 1024.0),
+                  _passCount, defragmentationStats.deviceMemoryBlocksFreed,
+                  static_cast<double>(defragmentationStats.bytesFreed) / (1024.0 * 1024.0));
+}
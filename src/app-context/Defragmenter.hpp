@@ -0,0 +1,114 @@
+#pragma once
+
+#include "MemoryPools.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class Logger;
+class UploadManager;
+
+// a buffer the defragmenter may move to other memory, it registers itself as the user data of
+// its vma allocation to opt in, allocations without user data are never moved
+class RelocatableBuffer {
+  public:
+    virtual ~RelocatableBuffer() = default;
+
+    // false while the content may still change behind the render thread's back, e.g. a streamed
+    // upload that hasn't been acquired yet
+    [[nodiscard]] virtual bool isRelocatable() const = 0;
+    [[nodiscard]] virtual VkBuffer getRelocatableBuffer() const = 0;
+    // to create the buffer that takes the place of the current one
+    [[nodiscard]] virtual VkBufferCreateInfo getRelocatableCreateInfo() const = 0;
+
+    // the content has been copied into newBuffer, which must be used from now on, the old buffer
+    // is destroyed by the defragmenter once the frames in flight are done with it
+    virtual void onRelocated(VkBuffer newBuffer) = 0;
+};
+
+// compacts the static geometry pool incrementally while the application runs
+//
+// a defragmentation starts when the unused share of the pool's blocks crosses the threshold, each
+// frame at most one vma pass is worked on: its moves are recorded into the upload manager's batch
+// (which precedes the frame on the graphics queue) until the time budget runs out, the remaining
+// moves are skipped, and the pass is ended once the frames that may still read the old buffers
+// have completed
+// the pool is locked while a defragmentation runs, see MemoryPools::setPoolLocked
+// images are not moved, their views are baked into descriptor sets that would all need rewriting
+// not thread safe, must be driven from the render thread
+class Defragmenter {
+  public:
+    struct Settings {
+        bool isEnabled = true;
+        // unused bytes over block bytes of the pool
+        float fragmentationThreshold = 0.25F;
+        // host time spent recording moves per frame
+        float timeBudgetMs      = 1.0F;
+        uint32_t framesInFlight = 2;
+    };
+
+    struct Stats {
+        uint64_t defragmentationCount = 0;
+        uint64_t passCount            = 0;
+        uint64_t movedAllocationCount = 0;
+        uint64_t movedBytes           = 0;
+        uint64_t freedBytes           = 0;
+        bool isRunning                = false;
+    };
+
+    Defragmenter(Logger *logger, VkDevice device, VmaAllocator allocator, MemoryPools *memoryPools,
+                 UploadManager *uploadManager);
+    // the device must be idle
+    ~Defragmenter();
+
+    // disable move and copy
+    Defragmenter(const Defragmenter &)            = delete;
+    Defragmenter &operator=(const Defragmenter &) = delete;
+    Defragmenter(Defragmenter &&)                 = delete;
+    Defragmenter &operator=(Defragmenter &&)      = delete;
+
+    void setSettings(Settings const &settings) { _settings = settings; }
+    [[nodiscard]] Settings const &getSettings() const { return _settings; }
+
+    // once per frame, before the frame is recorded
+    void update();
+
+    // starts a defragmentation on the next update regardless of the threshold
+    void request() { _isRequested = true; }
+
+    [[nodiscard]] Stats getStats() const;
+
+  private:
+    // frames between two looks at the pool statistics
+    static constexpr uint32_t kCheckInterval = 120;
+    // a defragmentation that keeps getting its moves skipped is given up after this many passes
+    static constexpr uint32_t kMaxPassCount        = 64;
+    static constexpr VkDeviceSize kMaxBytesPerPass = 16 * 1024 * 1024;
+    static constexpr uint32_t kMaxMovesPerPass     = 64;
+
+    Logger *_logger;
+    VkDevice _device;
+    VmaAllocator _allocator;
+    MemoryPools *_memoryPools;
+    UploadManager *_uploadManager;
+
+    Settings _settings{};
+    Stats _stats{};
+
+    VmaDefragmentationContext _context = VK_NULL_HANDLE;
+    VmaDefragmentationPassMoveInfo _passInfo{};
+    bool _isPassOpen             = false;
+    bool _isRequested            = false;
+    uint32_t _passCount          = 0;
+    uint32_t _framesUntilCheck   = kCheckInterval;
+    uint32_t _framesUntilPassEnd = 0;
+
+    // the buffers replaced in the open pass, destroyed when it ends
+    std::vector<VkBuffer> _retiredBuffers;
+
+    [[nodiscard]] bool _isFragmented() const;
+    void _begin();
+    void _beginPass();
+    void _endPass();
+    void _end();
+};
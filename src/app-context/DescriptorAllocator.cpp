@@ -0,0 +1,94 @@
+#include "DescriptorAllocator.hpp"
+
+#include "utils/logger/Logger.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+// the pool can't hold the sets, another pool has to be tried
+bool _isPoolExhausted(VkResult result) {
+    return result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL;
+}
+} // namespace
+
+DescriptorAllocator::DescriptorAllocator(Logger *logger, VkDevice device)
+    : _logger(logger), _device(device) {}
+
+DescriptorAllocator::~DescriptorAllocator() {
+    for (auto pool : _persistentPools) {
+        vkDestroyDescriptorPool(_device, pool, nullptr);
+    }
+}
+
+VkDescriptorPool DescriptorAllocator::_createPool(uint32_t maxSets,
+                                                  VkDescriptorPoolCreateFlags flags) {
+    std::array<VkDescriptorPoolSize, 4> const poolSizes{{
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxSets * kUniformBuffersPerSet},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, maxSets * kStorageImagesPerSet},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets * kCombinedImageSamplersPerSet},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxSets * kStorageBuffersPerSet},
+    }};
+
+    VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    poolInfo.flags         = flags;
+    poolInfo.maxSets       = maxSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        _logger->error("DescriptorAllocator: failed to create a pool of {} sets", maxSets);
+        return VK_NULL_HANDLE;
+    }
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::allocate(VkDescriptorSetLayout const *layouts,
+                                               uint32_t setCount, VkDescriptorSet *sets) {
+    VkDescriptorSetAllocateInfo allocInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocInfo.descriptorSetCount = setCount;
+    allocInfo.pSetLayouts        = layouts;
+
+    // the newest pool is the emptiest one, older pools may have room again after frees
+    for (auto it = _persistentPools.rbegin(); it != _persistentPools.rend(); ++it) {
+        allocInfo.descriptorPool = *it;
+        VkResult const result    = vkAllocateDescriptorSets(_device, &allocInfo, sets);
+        if (result == VK_SUCCESS) {
+            return *it;
+        }
+        if (!_isPoolExhausted(result)) {
+            _logger->error("DescriptorAllocator: failed to allocate {} sets", setCount);
+            return VK_NULL_HANDLE;
+        }
+    }
+
+    // a request larger than the grown pool size still gets a pool that fits it
+    uint32_t const maxSets = std::max(_nextPersistentPoolSets, setCount);
+    VkDescriptorPool pool =
+        _createPool(maxSets, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+    if (pool == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+    _persistentPools.push_back(pool);
+    _nextPersistentPoolSets = std::min(_nextPersistentPoolSets * 2, kMaxSetsPerPool);
+
+    allocInfo.descriptorPool = pool;
+    if (vkAllocateDescriptorSets(_device, &allocInfo, sets) != VK_SUCCESS) {
+        _logger->error("DescriptorAllocator: a fresh pool can't hold {} sets", setCount);
+        return VK_NULL_HANDLE;
+    }
+    return pool;
+}
+
+void DescriptorAllocator::free(VkDescriptorPool pool, VkDescriptorSet const *sets,
+                               uint32_t setCount) {
+    if (pool == VK_NULL_HANDLE || setCount == 0) {
+        return;
+    }
+    vkFreeDescriptorSets(_device, pool, setCount, sets);
+}
+
+size_t DescriptorAllocator::getPoolCount() const {
+    return _persistentPools.size();
+}
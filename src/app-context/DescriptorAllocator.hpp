@@ -0,0 +1,52 @@
+#pragma once
+
+#include "volk.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Logger;
+
+// hands out descriptor sets from a few shared pools instead of a pool per owner
+//
+// the sets come from pools created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+// every pool is tried before a new (twice as large) one is added, so the pool count stays
+// logarithmic in the number of sets
+// not thread safe, sets must be allocated from the render thread
+class DescriptorAllocator {
+  public:
+    DescriptorAllocator(Logger *logger, VkDevice device);
+    ~DescriptorAllocator();
+
+    // disable move and copy
+    DescriptorAllocator(const DescriptorAllocator &)            = delete;
+    DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+    DescriptorAllocator(DescriptorAllocator &&)                 = delete;
+    DescriptorAllocator &operator=(DescriptorAllocator &&)      = delete;
+
+    // allocates one set per layout, returns the pool they came from, which is needed to free them,
+    // or VK_NULL_HANDLE if even a fresh pool can't hold them
+    VkDescriptorPool allocate(VkDescriptorSetLayout const *layouts, uint32_t setCount,
+                              VkDescriptorSet *sets);
+    void free(VkDescriptorPool pool, VkDescriptorSet const *sets, uint32_t setCount);
+
+    [[nodiscard]] size_t getPoolCount() const;
+
+  private:
+    // the descriptors of each type a pool holds per set it can hold
+    static constexpr uint32_t kUniformBuffersPerSet        = 2;
+    static constexpr uint32_t kStorageImagesPerSet         = 2;
+    static constexpr uint32_t kCombinedImageSamplersPerSet = 4;
+    static constexpr uint32_t kStorageBuffersPerSet        = 2;
+    static constexpr uint32_t kInitialSetsPerPool          = 64;
+    static constexpr uint32_t kMaxSetsPerPool              = 4096;
+
+    Logger *_logger;
+    VkDevice _device;
+
+    std::vector<VkDescriptorPool> _persistentPools{};
+    uint32_t _nextPersistentPoolSets = kInitialSetsPerPool;
+
+    VkDescriptorPool _createPool(uint32_t maxSets, VkDescriptorPoolCreateFlags flags);
+};
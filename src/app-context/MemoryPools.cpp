@@ -0,0 +1,197 @@
+#include "MemoryPools.hpp"
+
+#include "utils/logger/Logger.hpp"
+
+namespace {
+constexpr VkDeviceSize kMiB = 1024 * 1024;
+
+// tuned to the pattern of each class: geometry and textures come in many medium sized pieces,
+// the dynamic and readback buffers are few and small
+VkDeviceSize _getBlockSize(MemoryClass memoryClass) {
+    switch (memoryClass) {
+    case MemoryClass::kStaticGeometry:
+        return 64 * kMiB;
+    case MemoryClass::kStaticTexture:
+        return 128 * kMiB;
+    case MemoryClass::kPerFrameDynamic:
+        return 16 * kMiB;
+    case MemoryClass::kReadback:
+        return 8 * kMiB;
+    case MemoryClass::kDedicated:
+    case MemoryClass::kCount:
+        break;
+    }
+    return 0;
+}
+} // namespace
+
+MemoryPools::MemoryPools(Logger *logger, VmaAllocator allocator)
+    : _logger(logger), _allocator(allocator) {}
+
+MemoryPools::~MemoryPools() {
+    for (size_t i = 0; i < kClassCount; i++) {
+        setPoolLocked(static_cast<MemoryClass>(i), false);
+        if (_allocationCounts[i].load() != 0) {
+            _logger->warn("MemoryPools: {} allocations of {} are still alive",
+                          _allocationCounts[i].load(), getName(static_cast<MemoryClass>(i)));
+        }
+        if (_pools[i] != VK_NULL_HANDLE) {
+            vmaDestroyPool(_allocator, _pools[i]);
+        }
+    }
+}
+
+char const *MemoryPools::getName(MemoryClass memoryClass) {
+    switch (memoryClass) {
+    case MemoryClass::kStaticGeometry:
+        return "static geometry";
+    case MemoryClass::kStaticTexture:
+        return "static textures";
+    case MemoryClass::kPerFrameDynamic:
+        return "per frame dynamic";
+    case MemoryClass::kReadback:
+        return "readback";
+    case MemoryClass::kDedicated:
+        return "dedicated";
+    case MemoryClass::kCount:
+        break;
+    }
+    return "unknown";
+}
+
+template <typename FindMemoryTypeIndex>
+VmaPool MemoryPools::_getPool(MemoryClass memoryClass, VkDeviceSize size,
+                              FindMemoryTypeIndex const &findMemoryTypeIndex) {
+    auto const classIndex        = static_cast<size_t>(memoryClass);
+    VkDeviceSize const blockSize = _getBlockSize(memoryClass);
+    // a pool with explicit blocks can't hold anything larger, and a few allocations filling most of
+    // a block would waste the rest of it, a locked pool must not change
+    if (blockSize == 0 || size > blockSize / 2 || _isPoolUnavailable[classIndex] ||
+        _isPoolLocked[classIndex]) {
+        return VK_NULL_HANDLE;
+    }
+    if (_pools[classIndex] != VK_NULL_HANDLE) {
+        return _pools[classIndex];
+    }
+
+    VmaPoolCreateInfo poolCreateInfo{};
+    poolCreateInfo.blockSize = blockSize;
+    if (findMemoryTypeIndex(&poolCreateInfo.memoryTypeIndex) != VK_SUCCESS ||
+        vmaCreatePool(_allocator, &poolCreateInfo, &_pools[classIndex]) != VK_SUCCESS) {
+        _logger->warn("MemoryPools: no pool for {}, using default allocations",
+                      getName(memoryClass));
+        _isPoolUnavailable[classIndex] = true;
+        _pools[classIndex]             = VK_NULL_HANDLE;
+        return VK_NULL_HANDLE;
+    }
+    vmaSetPoolName(_allocator, _pools[classIndex], getName(memoryClass));
+    return _pools[classIndex];
+}
+
+VkResult MemoryPools::createBuffer(MemoryClass memoryClass,
+                                   VkBufferCreateInfo const &bufferCreateInfo,
+                                   VmaAllocationCreateInfo allocCreateInfo, VkBuffer *buffer,
+                                   VmaAllocation *allocation, VmaAllocationInfo *allocationInfo) {
+    VmaPool pool = _getPool(memoryClass, bufferCreateInfo.size, [&](uint32_t *memoryTypeIndex) {
+        return vmaFindMemoryTypeIndexForBufferInfo(_allocator, &bufferCreateInfo,
+                                                   &allocCreateInfo, memoryTypeIndex);
+    });
+
+    VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    if (pool != VK_NULL_HANDLE) {
+        VmaAllocationCreateInfo poolAllocCreateInfo = allocCreateInfo;
+        poolAllocCreateInfo.pool                    = pool;
+        result = vmaCreateBuffer(_allocator, &bufferCreateInfo, &poolAllocCreateInfo, buffer,
+                                 allocation, allocationInfo);
+    }
+    if (result != VK_SUCCESS) {
+        if (memoryClass == MemoryClass::kDedicated) {
+            allocCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        }
+        result = vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, buffer,
+                                 allocation, allocationInfo);
+    }
+    if (result == VK_SUCCESS) {
+        _allocationCounts[static_cast<size_t>(memoryClass)]++;
+    }
+    return result;
+}
+
+VkResult MemoryPools::createImage(MemoryClass memoryClass, VkImageCreateInfo const &imageCreateInfo,
+                                  VmaAllocationCreateInfo allocCreateInfo, VkImage *image,
+                                  VmaAllocation *allocation) {
+    // the size is only known from the memory requirements, the texel count is close enough to
+    // keep huge images out of the pool
+    VkDeviceSize const estimatedSize = static_cast<VkDeviceSize>(imageCreateInfo.extent.width) *
+                                       imageCreateInfo.extent.height *
+                                       imageCreateInfo.extent.depth *
+                                       imageCreateInfo.arrayLayers * 4;
+    VmaPool pool = _getPool(memoryClass, estimatedSize, [&](uint32_t *memoryTypeIndex) {
+        return vmaFindMemoryTypeIndexForImageInfo(_allocator, &imageCreateInfo, &allocCreateInfo,
+                                                  memoryTypeIndex);
+    });
+
+    VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    if (pool != VK_NULL_HANDLE) {
+        VmaAllocationCreateInfo poolAllocCreateInfo = allocCreateInfo;
+        poolAllocCreateInfo.pool                    = pool;
+        result = vmaCreateImage(_allocator, &imageCreateInfo, &poolAllocCreateInfo, image,
+                                allocation, nullptr);
+    }
+    if (result != VK_SUCCESS) {
+        if (memoryClass == MemoryClass::kDedicated) {
+            allocCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        }
+        result = vmaCreateImage(_allocator, &imageCreateInfo, &allocCreateInfo, image, allocation,
+                                nullptr);
+    }
+    if (result == VK_SUCCESS) {
+        _allocationCounts[static_cast<size_t>(memoryClass)]++;
+    }
+    return result;
+}
+
+void MemoryPools::destroyBuffer(MemoryClass memoryClass, VkBuffer buffer,
+                                VmaAllocation allocation) {
+    if (buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    auto const classIndex = static_cast<size_t>(memoryClass);
+    _allocationCounts[classIndex]--;
+    if (_isPoolLocked[classIndex]) {
+        vmaSetAllocationUserData(_allocator, allocation, nullptr);
+        _deferredDestroys[classIndex].push_back({buffer, VK_NULL_HANDLE, allocation});
+        return;
+    }
+    vmaDestroyBuffer(_allocator, buffer, allocation);
+}
+
+void MemoryPools::destroyImage(MemoryClass memoryClass, VkImage image, VmaAllocation allocation) {
+    if (image == VK_NULL_HANDLE) {
+        return;
+    }
+    auto const classIndex = static_cast<size_t>(memoryClass);
+    _allocationCounts[classIndex]--;
+    if (_isPoolLocked[classIndex]) {
+        vmaSetAllocationUserData(_allocator, allocation, nullptr);
+        _deferredDestroys[classIndex].push_back({VK_NULL_HANDLE, image, allocation});
+        return;
+    }
+    vmaDestroyImage(_allocator, image, allocation);
+}
+
+void MemoryPools::setPoolLocked(MemoryClass memoryClass, bool isLocked) {
+    auto const classIndex     = static_cast<size_t>(memoryClass);
+    _isPoolLocked[classIndex] = isLocked;
+    if (isLocked) {
+        return;
+    }
+    for (auto const &deferredDestroy : _deferredDestroys[classIndex]) {
+        if (deferredDestroy.buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(_allocator, deferredDestroy.buffer, deferredDestroy.allocation);
+        } else {
+            vmaDestroyImage(_allocator, deferredDestroy.image, deferredDestroy.allocation);
+        }
+    }
+    _deferredDestroys[classIndex].clear();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "volk.h"
+
+#ifdef __APPLE__
+#include "vk_mem_alloc.h"
+#else
+#include "vma/vk_mem_alloc.h"
+#endif
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Logger;
+
+// what an allocation is used for, each class is sub-allocated from a pool of its own so resources
+// with the same lifetime and access pattern share large memory blocks instead of paying for a
+// vkAllocateMemory each
+enum class MemoryClass : uint32_t {
+    // device local vertex and index buffers, written once
+    kStaticGeometry,
+    // sampled images loaded from files, written once
+    kStaticTexture,
+    // host visible buffers rewritten every frame, persistently mapped
+    kPerFrameDynamic,
+    // host visible buffers the device writes and the host reads, persistently mapped and cached
+    kReadback,
+    // render targets and storage images, large and recreated on resize, so they keep their own
+    // vkAllocateMemory
+    kDedicated,
+
+    kCount,
+};
+
+// the vma pools of the memory classes, created on first use from the memory type the first
+// allocation of the class asks for
+//
+// allocations that don't fit a pool (too large for its blocks or an incompatible memory type)
+// fall back to the default vma allocation, the per class allocation counts include those
+// not thread safe apart from the counts, resources must be created on the render thread
+class MemoryPools {
+  public:
+    MemoryPools(Logger *logger, VmaAllocator allocator);
+    // every allocation must be destroyed by now
+    ~MemoryPools();
+
+    // disable move and copy
+    MemoryPools(const MemoryPools &)            = delete;
+    MemoryPools &operator=(const MemoryPools &) = delete;
+    MemoryPools(MemoryPools &&)                 = delete;
+    MemoryPools &operator=(MemoryPools &&)      = delete;
+
+    // allocCreateInfo describes the access pattern as for vmaCreateBuffer, the pool is filled in
+    VkResult createBuffer(MemoryClass memoryClass, VkBufferCreateInfo const &bufferCreateInfo,
+                          VmaAllocationCreateInfo allocCreateInfo, VkBuffer *buffer,
+                          VmaAllocation *allocation, VmaAllocationInfo *allocationInfo);
+    VkResult createImage(MemoryClass memoryClass, VkImageCreateInfo const &imageCreateInfo,
+                         VmaAllocationCreateInfo allocCreateInfo, VkImage *image,
+                         VmaAllocation *allocation);
+
+    void destroyBuffer(MemoryClass memoryClass, VkBuffer buffer, VmaAllocation allocation);
+    void destroyImage(MemoryClass memoryClass, VkImage image, VmaAllocation allocation);
+
+    // while the pool of a class is locked (it is being defragmented), new allocations of the class
+    // go around it and destroyed ones are only freed once it is unlocked, their user data is
+    // cleared right away
+    void setPoolLocked(MemoryClass memoryClass, bool isLocked);
+
+    // live allocations of the class, thread safe
+    [[nodiscard]] size_t getAllocationCount(MemoryClass memoryClass) const {
+        return _allocationCounts[static_cast<size_t>(memoryClass)].load(std::memory_order_relaxed);
+    }
+    // VK_NULL_HANDLE until the first allocation of the class, and always for kDedicated
+    [[nodiscard]] VmaPool getPool(MemoryClass memoryClass) const {
+        return _pools[static_cast<size_t>(memoryClass)];
+    }
+
+    static char const *getName(MemoryClass memoryClass);
+
+  private:
+    static constexpr size_t kClassCount = static_cast<size_t>(MemoryClass::kCount);
+
+    Logger *_logger;
+    VmaAllocator _allocator;
+
+    std::array<VmaPool, kClassCount> _pools{};
+    // a class whose pool couldn't be created isn't tried again
+    std::array<bool, kClassCount> _isPoolUnavailable{};
+    std::array<std::atomic<size_t>, kClassCount> _allocationCounts{};
+    std::array<bool, kClassCount> _isPoolLocked{};
+
+    struct DeferredDestroy {
+        VkBuffer buffer          = VK_NULL_HANDLE;
+        VkImage image            = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+    };
+    std::array<std::vector<DeferredDestroy>, kClassCount> _deferredDestroys{};
+
+    // nullptr when the allocation should not come from a pool
+    template <typename FindMemoryTypeIndex>
+    VmaPool _getPool(MemoryClass memoryClass, VkDeviceSize size,
+                     FindMemoryTypeIndex const &findMemoryTypeIndex);
+};
@@ -0,0 +1,126 @@
+#include "MemoryTelemetry.hpp"
+
+#include "VulkanApplicationContext.hpp"
+
+#include "utils/logger/Logger.hpp"
+
+#include <fstream>
+
+MemoryReport MemoryTelemetry::collect(VulkanApplicationContext const *appContext) {
+    VmaAllocator allocator = appContext->getAllocator();
+
+    MemoryReport report{};
+    report.isBudgetExact = appContext->isMemoryBudgetEnabled();
+
+    VkPhysicalDeviceMemoryProperties const *memoryProperties = nullptr;
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(allocator, budgets.data());
+
+    VmaTotalStatistics totalStatistics{};
+    vmaCalculateStatistics(allocator, &totalStatistics);
+
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+        auto const &heapStatistics = totalStatistics.memoryHeap[i].statistics;
+        auto const &memoryHeap     = memoryProperties->memoryHeaps[i];
+
+        MemoryReport::Heap heap{};
+        heap.index           = i;
+        heap.isDeviceLocal   = (memoryHeap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heap.size            = memoryHeap.size;
+        heap.budget          = budgets[i].budget;
+        heap.usage           = budgets[i].usage;
+        heap.blockCount      = heapStatistics.blockCount;
+        heap.allocationCount = heapStatistics.allocationCount;
+        heap.blockBytes      = heapStatistics.blockBytes;
+        heap.allocationBytes = heapStatistics.allocationBytes;
+        report.heaps.push_back(heap);
+    }
+
+    report.largestFreeBlock     = totalStatistics.total.unusedRangeSizeMax;
+    report.totalBlockCount      = totalStatistics.total.statistics.blockCount;
+    report.totalAllocationCount = totalStatistics.total.statistics.allocationCount;
+
+    auto const *memoryPools = appContext->getMemoryPools();
+    for (size_t i = 0; i < report.classes.size(); i++) {
+        auto const memoryClass = static_cast<MemoryClass>(i);
+
+        auto &classReport           = report.classes[i];
+        classReport.memoryClass     = memoryClass;
+        classReport.allocationCount = memoryPools->getAllocationCount(memoryClass);
+
+        VmaPool pool = memoryPools->getPool(memoryClass);
+        if (pool == VK_NULL_HANDLE) {
+            continue;
+        }
+        VmaDetailedStatistics poolStatistics{};
+        vmaCalculatePoolStatistics(allocator, pool, &poolStatistics);
+        classReport.blockCount      = poolStatistics.statistics.blockCount;
+        classReport.blockBytes      = poolStatistics.statistics.blockBytes;
+        classReport.allocationBytes = poolStatistics.statistics.allocationBytes;
+        // vma reports VK_WHOLE_SIZE as the maximum when there is no free range at all
+        classReport.largestFreeBlock =
+            poolStatistics.unusedRangeCount == 0 ? 0 : poolStatistics.unusedRangeSizeMax;
+    }
+    if (totalStatistics.total.unusedRangeCount == 0) {
+        report.largestFreeBlock = 0;
+    }
+    return report;
+}
+
+std::string MemoryTelemetry::toJson(VulkanApplicationContext const *appContext,
+                                    MemoryReport const &report) {
+    std::string json = "{\n";
+    json += fmt::format("  \"budgetExact\": {},\n", report.isBudgetExact);
+    json += fmt::format("  \"totalBlockCount\": {},\n", report.totalBlockCount);
+    json += fmt::format("  \"totalAllocationCount\": {},\n", report.totalAllocationCount);
+    json += fmt::format("  \"largestFreeBlock\": {},\n", report.largestFreeBlock);
+
+    json += "  \"heaps\": [\n";
+    for (size_t i = 0; i < report.heaps.size(); i++) {
+        auto const &heap = report.heaps[i];
+        json += fmt::format("    {{\"index\": {}, \"deviceLocal\": {}, \"size\": {}, "
+                            "\"budget\": {}, \"usage\": {}, \"blockCount\": {}, "
+                            "\"allocationCount\": {}, "
+                            "\"blockBytes\": {}, \"allocationBytes\": {}}}{}\n",
+                            heap.index, heap.isDeviceLocal, heap.size, heap.budget, heap.usage,
+                            heap.blockCount, heap.allocationCount, heap.blockBytes,
+                            heap.allocationBytes, i + 1 < report.heaps.size() ? "," : "");
+    }
+    json += "  ],\n";
+
+    json += "  \"memoryClasses\": [\n";
+    for (size_t i = 0; i < report.classes.size(); i++) {
+        auto const &classReport = report.classes[i];
+        json += fmt::format("    {{\"name\": \"{}\", \"allocationCount\": {}, "
+                            "\"blockCount\": {}, \"blockBytes\": {}, \"allocationBytes\": {}, "
+                            "\"largestFreeBlock\": {}}}{}\n",
+                            MemoryPools::getName(classReport.memoryClass),
+                            classReport.allocationCount, classReport.blockCount,
+                            classReport.blockBytes, classReport.allocationBytes,
+                            classReport.largestFreeBlock,
+                            i + 1 < report.classes.size() ? "," : "");
+    }
+    json += "  ],\n";
+
+    char *vmaStats = nullptr;
+    vmaBuildStatsString(appContext->getAllocator(), &vmaStats, VK_TRUE);
+    json += "  \"vma\": ";
+    json += vmaStats != nullptr ? vmaStats : "null";
+    json += "\n}\n";
+    vmaFreeStatsString(appContext->getAllocator(), vmaStats);
+    return json;
+}
+
+bool MemoryTelemetry::dumpJson(VulkanApplicationContext const *appContext,
+                               std::string const &path) {
+    std::string const json = toJson(appContext, collect(appContext));
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << json;
+    return static_cast<bool>(file);
+}
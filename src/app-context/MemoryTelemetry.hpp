@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MemoryPools.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class VulkanApplicationContext;
+
+// a snapshot of the device memory, taken on demand since walking every block isn't free
+struct MemoryReport {
+    struct Heap {
+        uint32_t index     = 0;
+        bool isDeviceLocal = false;
+        VkDeviceSize size  = 0;
+        // what the process may use and uses of the heap, from VK_EXT_memory_budget when it is
+        // enabled, otherwise estimated by vma from its own allocations
+        VkDeviceSize budget = 0;
+        VkDeviceSize usage  = 0;
+        // vkAllocateMemory blocks of the heap, and the part of them handed out to resources
+        uint32_t blockCount          = 0;
+        uint32_t allocationCount     = 0;
+        VkDeviceSize blockBytes      = 0;
+        VkDeviceSize allocationBytes = 0;
+    };
+
+    struct Class {
+        MemoryClass memoryClass = MemoryClass::kStaticGeometry;
+        // includes the allocations that didn't fit the pool
+        size_t allocationCount = 0;
+        // the pool's own blocks only
+        uint32_t blockCount           = 0;
+        VkDeviceSize blockBytes       = 0;
+        VkDeviceSize allocationBytes  = 0;
+        VkDeviceSize largestFreeBlock = 0;
+    };
+
+    bool isBudgetExact = false;
+    std::vector<Heap> heaps;
+    std::array<Class, static_cast<size_t>(MemoryClass::kCount)> classes{};
+    // the largest range any existing block could still hand out without a new vkAllocateMemory
+    VkDeviceSize largestFreeBlock = 0;
+    uint32_t totalBlockCount      = 0;
+    uint32_t totalAllocationCount = 0;
+};
+
+namespace MemoryTelemetry {
+MemoryReport collect(VulkanApplicationContext const *appContext);
+
+// the report, followed by vma's detailed map of every block under "vma"
+std::string toJson(VulkanApplicationContext const *appContext, MemoryReport const &report);
+
+// returns whether the file could be written
+bool dumpJson(VulkanApplicationContext const *appContext, std::string const &path);
+}; // namespace MemoryTelemetry
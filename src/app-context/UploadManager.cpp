@@ -0,0 +1,236 @@
+#include "UploadManager.hpp"
+
+#include "utils/logger/Logger.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+namespace {
+// total size of the staging ring, shared evenly by the batches
+constexpr VkDeviceSize kStagingRingSize = 64ULL * 1024 * 1024;
+// keeps buffer copies friendly to memcpy and to the copy engine
+constexpr VkDeviceSize kBufferCopyAlignment = 16;
+
+VkDeviceSize _alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void _createMappedStagingBuffer(VmaAllocator allocator, VkDeviceSize size, VkBuffer &vkBuffer,
+                                VmaAllocation &allocation, void *&mappedAddr) {
+    VkBufferCreateInfo bufferCreateInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCreateInfo.size        = size;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocCreateInfo{};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocCreateInfo.flags =
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocInfo{};
+    vmaCreateBuffer(allocator, &bufferCreateInfo, &allocCreateInfo, &vkBuffer, &allocation,
+                    &allocInfo);
+    mappedAddr = allocInfo.pMappedData;
+}
+} // namespace
+
+UploadManager::UploadManager(Logger *logger, VkDevice device, VmaAllocator allocator,
+                             VkQueue queue, uint32_t queueFamilyIndex)
+    : _logger(logger), _device(device), _allocator(allocator), _queue(queue) {
+    VkCommandPoolCreateInfo commandPoolCreateInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+    // every batch resets and re-records its own command buffer
+    commandPoolCreateInfo.flags =
+        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    vkCreateCommandPool(_device, &commandPoolCreateInfo, nullptr, &_commandPool);
+
+    std::array<VkCommandBuffer, kBatchCount> commandBuffers{};
+    VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocInfo.commandPool        = _commandPool;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(kBatchCount);
+    vkAllocateCommandBuffers(_device, &allocInfo, commandBuffers.data());
+
+    VkFenceCreateInfo fenceCreateInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    for (size_t i = 0; i < kBatchCount; i++) {
+        _batches[i].commandBuffer = commandBuffers[i];
+        vkCreateFence(_device, &fenceCreateInfo, nullptr, &_batches[i].fence);
+    }
+
+    void *ringMappedAddr = nullptr;
+    _createMappedStagingBuffer(_allocator, kStagingRingSize, _ringBuffer, _ringAllocation,
+                               ringMappedAddr);
+    _ringMappedAddr  = static_cast<unsigned char *>(ringMappedAddr);
+    _ringSegmentSize = kStagingRingSize / kBatchCount;
+
+    _logger->info("Upload manager created with a {} MB staging ring in {} segments",
+                  kStagingRingSize / (1024 * 1024), kBatchCount);
+}
+
+UploadManager::~UploadManager() {
+    flushAndWait();
+
+    for (auto &batch : _batches) {
+        vkDestroyFence(_device, batch.fence, nullptr);
+    }
+    // frees the command buffers of the batches as well
+    vkDestroyCommandPool(_device, _commandPool, nullptr);
+    vmaDestroyBuffer(_allocator, _ringBuffer, _ringAllocation);
+}
+
+void UploadManager::uploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, void const *data,
+                                   VkDeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+
+    auto const stagingAllocation = _allocateStaging(size, kBufferCopyAlignment);
+    _writeStaging(stagingAllocation, data, size);
+
+    VkBufferCopy bufCopy = {
+        stagingAllocation.offset, // srcOffset
+        dstOffset,                // dstOffset
+        size,                     // size
+    };
+    vkCmdCopyBuffer(_batches[_currentBatch].commandBuffer, stagingAllocation.vkBuffer, dstBuffer,
+                    1, &bufCopy);
+}
+
+void UploadManager::uploadToImage(VkImage dstImage, VkBufferImageCopy region, void const *data,
+                                  VkDeviceSize size, VkDeviceSize texelBlockSize) {
+    if (size == 0) {
+        return;
+    }
+
+    // bufferOffset must be a multiple of both the texel block size and 4
+    auto const alignment         = std::lcm(texelBlockSize, VkDeviceSize{4});
+    auto const stagingAllocation = _allocateStaging(size, alignment);
+    _writeStaging(stagingAllocation, data, size);
+
+    region.bufferOffset = stagingAllocation.offset;
+    vkCmdCopyBufferToImage(_batches[_currentBatch].commandBuffer, stagingAllocation.vkBuffer,
+                           dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
+VkCommandBuffer UploadManager::getCommandBuffer() { return _openBatch().commandBuffer; }
+
+void UploadManager::flush() {
+    Batch &batch = _batches[_currentBatch];
+    if (!batch.isRecording) {
+        return;
+    }
+
+    // make the copies visible to everything submitted after this batch
+    VkMemoryBarrier memoryBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0,
+                         nullptr);
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &batch.commandBuffer;
+    vkQueueSubmit(_queue, 1, &submitInfo, batch.fence);
+
+    batch.isRecording = false;
+    batch.isInFlight  = true;
+    _submittedBatchCount++;
+
+    _currentBatch = (_currentBatch + 1) % kBatchCount;
+}
+
+void UploadManager::flushAndWait() {
+    flush();
+    for (auto &batch : _batches) {
+        if (batch.isInFlight) {
+            _waitForBatch(batch);
+        }
+    }
+}
+
+UploadManager::Batch &UploadManager::_openBatch() {
+    Batch &batch = _batches[_currentBatch];
+    if (batch.isRecording) {
+        return batch;
+    }
+
+    // the ring has wrapped around, the segment can only be reused once the gpu is done with it
+    if (batch.isInFlight) {
+        _waitForBatch(batch);
+    }
+
+    vkResetCommandBuffer(batch.commandBuffer, 0);
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    batch.segmentUsed = 0;
+    batch.isRecording = true;
+    return batch;
+}
+
+void UploadManager::_waitForBatch(Batch &batch) {
+    assert(batch.isInFlight && "the batch has not been submitted");
+
+    vkWaitForFences(_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(_device, 1, &batch.fence);
+
+    for (auto &temporaryStagingBuffer : batch.temporaryStagingBuffers) {
+        vmaDestroyBuffer(_allocator, temporaryStagingBuffer.vkBuffer,
+                         temporaryStagingBuffer.allocation);
+    }
+    batch.temporaryStagingBuffers.clear();
+    batch.isInFlight = false;
+}
+
+UploadManager::StagingAllocation UploadManager::_allocateStaging(VkDeviceSize size,
+                                                                 VkDeviceSize alignment) {
+    StagingAllocation stagingAllocation{};
+
+    // too large for the ring, fall back to a staging buffer of its own
+    if (size > _ringSegmentSize) {
+        Batch &batch = _openBatch();
+
+        TemporaryStagingBuffer temporaryStagingBuffer{};
+        _createMappedStagingBuffer(_allocator, size, temporaryStagingBuffer.vkBuffer,
+                                   temporaryStagingBuffer.allocation,
+                                   stagingAllocation.mappedAddr);
+        batch.temporaryStagingBuffers.push_back(temporaryStagingBuffer);
+
+        stagingAllocation.vkBuffer   = temporaryStagingBuffer.vkBuffer;
+        stagingAllocation.allocation = temporaryStagingBuffer.allocation;
+        stagingAllocation.offset     = 0;
+        return stagingAllocation;
+    }
+
+    Batch *batch        = &_openBatch();
+    VkDeviceSize offset = _alignUp(batch->segmentUsed, alignment);
+    if (offset + size > _ringSegmentSize) {
+        // the segment is full, hand it to the gpu and continue in the next one
+        flush();
+        batch  = &_openBatch();
+        offset = 0;
+    }
+    batch->segmentUsed = offset + size;
+
+    VkDeviceSize const ringOffset = _currentBatch * _ringSegmentSize + offset;
+    stagingAllocation.vkBuffer    = _ringBuffer;
+    stagingAllocation.allocation  = _ringAllocation;
+    stagingAllocation.offset      = ringOffset;
+    stagingAllocation.mappedAddr  = _ringMappedAddr + ringOffset;
+    return stagingAllocation;
+}
+
+void UploadManager::_writeStaging(StagingAllocation const &stagingAllocation, void const *data,
+                                  VkDeviceSize size) {
+    if (data != nullptr) {
+        memcpy(stagingAllocation.mappedAddr, data, size);
+    } else {
+        memset(stagingAllocation.mappedAddr, 0, size);
+    }
+    // no-op on host coherent memory
+    vmaFlushAllocation(_allocator, stagingAllocation.allocation, stagingAllocation.offset, size);
+}
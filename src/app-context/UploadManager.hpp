@@ -0,0 +1,117 @@
+#pragma once
+
+#include "volk.h"
+
+#ifdef __APPLE__
+#include "vk_mem_alloc.h"
+#else
+#include "vma/vk_mem_alloc.h"
+#endif
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class Logger;
+
+// batches host to device copies into a few large submissions instead of one blocking submission
+// per resource
+//
+// the staging memory is a single persistently mapped buffer, split into one segment per batch and
+// used as a ring: a batch fills its segment linearly, is submitted with a fence when the segment
+// runs out (or when flushed explicitly), and the segment is only reused after that fence signals
+// uploads larger than a whole segment get a temporary staging buffer that lives as long as the
+// batch
+//
+// batches are submitted to the graphics queue and end with a global memory barrier, so any work
+// submitted to that queue afterwards observes the uploaded data without waiting on the host
+// not thread safe, uploads must come from the render thread
+class UploadManager {
+  public:
+    UploadManager(Logger *logger, VkDevice device, VmaAllocator allocator, VkQueue queue,
+                  uint32_t queueFamilyIndex);
+    ~UploadManager();
+
+    // disable move and copy
+    UploadManager(const UploadManager &)            = delete;
+    UploadManager &operator=(const UploadManager &) = delete;
+    UploadManager(UploadManager &&)                 = delete;
+    UploadManager &operator=(UploadManager &&)      = delete;
+
+    // the data is copied into staging memory before returning, the destination is written when the
+    // batch executes, data can be nullptr to zero-fill the range
+    void uploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, void const *data,
+                        VkDeviceSize size);
+
+    // the image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the copy executes, the
+    // bufferOffset of the region is overwritten, texelBlockSize is the byte size of one texel (or
+    // compressed block) of the image format
+    void uploadToImage(VkImage dstImage, VkBufferImageCopy region, void const *data,
+                       VkDeviceSize size, VkDeviceSize texelBlockSize);
+
+    // the command buffer of the open batch, for recording layout transitions that have to be
+    // ordered with the uploads, do not keep it across upload calls since those may submit the batch
+    VkCommandBuffer getCommandBuffer();
+
+    // submits the open batch without waiting, this is all that is needed before submitting work
+    // that consumes the uploads to the same queue
+    void flush();
+
+    // submits the open batch and blocks until every submitted batch has completed, only needed
+    // when the host itself depends on the uploads
+    void flushAndWait();
+
+    [[nodiscard]] uint64_t getSubmittedBatchCount() const { return _submittedBatchCount; }
+
+  private:
+    static constexpr size_t kBatchCount = 4;
+
+    struct TemporaryStagingBuffer {
+        VkBuffer vkBuffer        = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+    };
+
+    struct Batch {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence                 = VK_NULL_HANDLE;
+        // bytes of this batch's ring segment in use
+        VkDeviceSize segmentUsed = 0;
+        bool isRecording         = false;
+        bool isInFlight          = false;
+        std::vector<TemporaryStagingBuffer> temporaryStagingBuffers;
+    };
+
+    struct StagingAllocation {
+        VkBuffer vkBuffer        = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkDeviceSize offset      = 0;
+        void *mappedAddr         = nullptr;
+    };
+
+    Logger *_logger;
+    VkDevice _device;
+    VmaAllocator _allocator;
+    VkQueue _queue;
+
+    VkCommandPool _commandPool = VK_NULL_HANDLE;
+
+    VkBuffer _ringBuffer           = VK_NULL_HANDLE;
+    VmaAllocation _ringAllocation  = VK_NULL_HANDLE;
+    unsigned char *_ringMappedAddr = nullptr;
+    VkDeviceSize _ringSegmentSize  = 0;
+
+    std::array<Batch, kBatchCount> _batches{};
+    size_t _currentBatch = 0;
+
+    uint64_t _submittedBatchCount = 0;
+
+    // makes sure the current batch is recording, waiting for its previous submission if needed
+    Batch &_openBatch();
+    void _waitForBatch(Batch &batch);
+
+    // returns staging memory that belongs to the open batch, the data should be written to
+    // mappedAddr and then copied from vkBuffer at offset
+    StagingAllocation _allocateStaging(VkDeviceSize size, VkDeviceSize alignment);
+    void _writeStaging(StagingAllocation const &stagingAllocation, void const *data,
+                       VkDeviceSize size);
+};
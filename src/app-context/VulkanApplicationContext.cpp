@@ -3,9 +3,16 @@
 #define VMA_DYNAMIC_VULKAN_FUNCTIONS 0
 
 #include "VulkanApplicationContext.hpp"
+#include "AsyncUploader.hpp"
+#include "Defragmenter.hpp"
+#include "DescriptorAllocator.hpp"
+#include "MemoryPools.hpp"
+#include "UploadManager.hpp"
 
 #include "utils/logger/Logger.hpp"
 
+#include <string>
+
 static const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
 
 #ifdef __APPLE__
@@ -15,9 +22,20 @@ static const std::vector<const char *> requiredDeviceExtensions = {VK_KHR_SWAPCH
 static const std::vector<const char *> requiredDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 #endif
 
+// enabled when the device has them, the context works without
+static const std::vector<const char *> optionalDeviceExtensions = {
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME};
+
 VulkanApplicationContext::VulkanApplicationContext() = default;
 
 VulkanApplicationContext::~VulkanApplicationContext() {
+    // frees what the open defragmentation holds on to, must go before the pools
+    _defragmenter.reset();
+    // waits for the pending uploads, must go before the allocator and the device
+    _asyncUploader.reset();
+    _uploadManager.reset();
+    _descriptorAllocator.reset();
+
     vkDestroyCommandPool(_device, _commandPool, nullptr);
     vkDestroyCommandPool(_device, _guiCommandPool, nullptr);
 
@@ -29,6 +47,9 @@ VulkanApplicationContext::~VulkanApplicationContext() {
 
     vkDestroySurfaceKHR(_vkInstance, _surface, nullptr);
 
+    // the pools must be empty and gone before the allocator
+    _memoryPools.reset();
+
     // this step destroys allocated VkDestroyMemory allocated by VMA when creating
     // buffers and images, by destroying the global allocator
     vmaDestroyAllocator(_allocator);
@@ -43,6 +64,11 @@ VulkanApplicationContext::~VulkanApplicationContext() {
 
 void VulkanApplicationContext::init(Logger *logger, GLFWwindow *window,
                                     GraphicsSettings *settings) {
+    initInstance(logger);
+    initDevice(window, settings);
+}
+
+void VulkanApplicationContext::initInstance(Logger *logger) {
     _logger = logger;
     _logger->info("Initiating VulkanApplicationContext");
 #ifndef NVALIDATIONLAYERS
@@ -51,7 +77,6 @@ void VulkanApplicationContext::init(Logger *logger, GLFWwindow *window,
     _logger->info("Validation layers are disabled");
 #endif // NVLIDATIONLAYERS
 
-    _glWindow = window;
     volkInitialize();
 
     VkApplicationInfo appInfo{VK_STRUCTURE_TYPE_APPLICATION_INFO};
@@ -61,14 +86,24 @@ void VulkanApplicationContext::init(Logger *logger, GLFWwindow *window,
     appInfo.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
     appInfo.apiVersion         = VK_API_VERSION_1_2;
     ContextCreator::createInstance(_logger, _vkInstance, _debugMessager, appInfo, validationLayers);
+}
 
+void VulkanApplicationContext::initDevice(GLFWwindow *window, GraphicsSettings *settings) {
+    _glWindow = window;
     ContextCreator::createSurface(_logger, _vkInstance, _surface, _glWindow);
 
     // selects physical device, creates logical device from that, decides queues,
     // loads device-related functions too
     ContextCreator::QueueSelection queueSelection{};
+    std::vector<const char *> enabledOptionalExtensions{};
     ContextCreator::createDevice(_logger, _physicalDevice, _device, _queueFamilyIndices,
-                                 queueSelection, _vkInstance, _surface, requiredDeviceExtensions);
+                                 queueSelection, _vkInstance, _surface, requiredDeviceExtensions,
+                                 optionalDeviceExtensions, enabledOptionalExtensions);
+    for (auto const *extension : enabledOptionalExtensions) {
+        if (std::string(extension) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) {
+            _isMemoryBudgetEnabled = true;
+        }
+    }
     _graphicsQueueIndex = queueSelection.graphicsQueueIndex;
     _presentQueueIndex  = queueSelection.presentQueueIndex;
     _computeQueueIndex  = queueSelection.computeQueueIndex;
@@ -99,6 +134,25 @@ void VulkanApplicationContext::init(Logger *logger, GLFWwindow *window,
     _createSwapchain(settings->isFramerateLimited);
     _createAllocator();
     _createCommandPool();
+
+    _memoryPools = std::make_unique<MemoryPools>(_logger, _allocator);
+
+    _descriptorAllocator = std::make_unique<DescriptorAllocator>(_logger, _device);
+
+    _uploadManager = std::make_unique<UploadManager>(_logger, _device, _allocator, _graphicsQueue,
+                                                     _queueFamilyIndices.graphicsFamily);
+
+    _defragmenter = std::make_unique<Defragmenter>(_logger, _device, _allocator,
+                                                   _memoryPools.get(), _uploadManager.get());
+
+    if (_transferQueue != _graphicsQueue) {
+        _asyncUploader = std::make_unique<AsyncUploader>(
+            _logger, _device, _allocator, _transferQueue, _queueFamilyIndices.transferFamily,
+            _queueFamilyIndices.graphicsFamily);
+    } else {
+        _logger->warn("No separate transfer queue, streamed uploads fall back to the graphics "
+                      "queue");
+    }
 }
 
 void VulkanApplicationContext::onSwapchainResize(bool isFramerateLimited) {
@@ -149,6 +203,10 @@ void VulkanApplicationContext::_createAllocator() {
     allocatorInfo.device                 = _device;
     allocatorInfo.instance               = _vkInstance;
     allocatorInfo.pVulkanFunctions       = &vmaVulkanFunc;
+    // lets vma query the real budget and usage of every heap instead of estimating them
+    if (_isMemoryBudgetEnabled) {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
 
     vmaCreateAllocator(&allocatorInfo, &_allocator);
 }
@@ -14,9 +14,15 @@
 #include "vma/vk_mem_alloc.h"
 #endif
 
+#include <memory>
 #include <vector>
 
 class Logger;
+class AsyncUploader;
+class Defragmenter;
+class DescriptorAllocator;
+class MemoryPools;
+class UploadManager;
 // also, this class should be configed out of class
 class VulkanApplicationContext {
   public:
@@ -27,6 +33,10 @@ class VulkanApplicationContext {
   public:
     // use glwindow to init the instance, can be only called once
     void init(Logger *logger, GLFWwindow *glWindow, GraphicsSettings *settings);
+    // the two halves of init, the instance only needs glfw to be initialized, not a window, so it
+    // can be created on another thread while the window is, the rest follows on the window's thread
+    void initInstance(Logger *logger);
+    void initDevice(GLFWwindow *glWindow, GraphicsSettings *settings);
 
     VulkanApplicationContext();
     ~VulkanApplicationContext();
@@ -79,6 +89,28 @@ class VulkanApplicationContext {
     [[nodiscard]] const VkSampleCountFlagBits &getMsaaSample() const { return _msaaSamples; }
     [[nodiscard]] const VkFormat &getDepthFormat() const { return _depthFormat; }
 
+    // batches staging uploads to the graphics queue, prefer it over single time commands for
+    // anything that does not need to be read back immediately
+    [[nodiscard]] UploadManager *getUploadManager() const { return _uploadManager.get(); }
+
+    // streams uploads through the transfer queue, nullptr when the device can't give the transfer
+    // queue a VkQueue of its own, the upload manager has to be used instead in that case
+    [[nodiscard]] AsyncUploader *getAsyncUploader() const { return _asyncUploader.get(); }
+
+    // the vma pools of the memory classes, buffers and images allocate through it
+    [[nodiscard]] MemoryPools *getMemoryPools() const { return _memoryPools.get(); }
+
+    // compacts the static geometry pool, driven once per frame by the application
+    [[nodiscard]] Defragmenter *getDefragmenter() const { return _defragmenter.get(); }
+
+    // whether VK_EXT_memory_budget is enabled, the heap budgets are estimates otherwise
+    [[nodiscard]] bool isMemoryBudgetEnabled() const { return _isMemoryBudgetEnabled; }
+
+    // shared descriptor pools, descriptor sets should come from here rather than private pools
+    [[nodiscard]] DescriptorAllocator *getDescriptorAllocator() const {
+        return _descriptorAllocator.get();
+    }
+
     [[nodiscard]] VkCommandBuffer beginSingleTimeCommands() const;
     void endSingleTimeCommands(VkCommandBuffer commandBuffer) const;
 
@@ -110,6 +142,14 @@ class VulkanApplicationContext {
     VkCommandPool _commandPool    = VK_NULL_HANDLE;
     VkCommandPool _guiCommandPool = VK_NULL_HANDLE;
 
+    std::unique_ptr<UploadManager> _uploadManager             = nullptr;
+    std::unique_ptr<AsyncUploader> _asyncUploader             = nullptr;
+    std::unique_ptr<DescriptorAllocator> _descriptorAllocator = nullptr;
+    std::unique_ptr<MemoryPools> _memoryPools                 = nullptr;
+    std::unique_ptr<Defragmenter> _defragmenter               = nullptr;
+
+    bool _isMemoryBudgetEnabled = false;
+
     VkDebugUtilsMessengerEXT _debugMessager = VK_NULL_HANDLE;
 
     VkSwapchainKHR _swapchain = VK_NULL_HANDLE;
@@ -3,7 +3,9 @@
 #include "Common.hpp"
 #include "utils/logger/Logger.hpp"
 
+#include <array>
 #include <set>
+#include <string>
 namespace {
 bool _queueIndicesAreFilled(const ContextCreator::QueueFamilyIndices &indices) {
     return indices.computeFamily != -1 && indices.transferFamily != -1 &&
@@ -51,6 +53,26 @@ bool _findQueueFamilies(ContextCreator::QueueFamilyIndices &indices,
     return false;
 }
 
+// a transfer-only family is usually backed by the dma engines, uploads submitted there run
+// alongside graphics work instead of competing with it
+void _preferDedicatedTransferFamily(ContextCreator::QueueFamilyIndices &indices,
+                                    const VkPhysicalDevice &physicalDevice) {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount,
+                                             queueFamilies.data());
+
+    for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+        auto const queueFlags = queueFamilies[i].queueFlags;
+        if ((queueFlags & VK_QUEUE_TRANSFER_BIT) != 0 &&
+            (queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) {
+            indices.transferFamily = i;
+            return;
+        }
+    }
+}
+
 bool _checkDeviceExtensionSupport(Logger *logger, const VkPhysicalDevice &physicalDevice,
                                   const std::vector<const char *> &requiredDeviceExtensions) {
     uint32_t extensionCount = 0;
@@ -237,7 +259,9 @@ void ContextCreator::createDevice(Logger *logger, VkPhysicalDevice &physicalDevi
                                   VkDevice &device, QueueFamilyIndices &indices,
                                   QueueSelection &queueSelection, const VkInstance &instance,
                                   VkSurfaceKHR surface,
-                                  const std::vector<const char *> &requiredDeviceExtensions) {
+                                  const std::vector<const char *> &requiredDeviceExtensions,
+                                  const std::vector<const char *> &optionalDeviceExtensions,
+                                  std::vector<const char *> &enabledOptionalExtensions) {
     // pick the physical device with the best performance
     {
         physicalDevice = VK_NULL_HANDLE;
@@ -270,17 +294,34 @@ void ContextCreator::createDevice(Logger *logger, VkPhysicalDevice &physicalDevi
     // create logical device from the physical device we've picked
     {
         _findQueueFamilies(indices, physicalDevice, surface);
+        _preferDedicatedTransferFamily(indices, physicalDevice);
+
+        // without a transfer-only family, streaming uploads still get a queue of their own if the
+        // graphics family has a spare one, so the loader thread never shares a VkQueue with the
+        // render thread
+        uint32_t transferQueueInFamily = 0;
+        if (indices.transferFamily == indices.graphicsFamily) {
+            uint32_t queueFamilyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount,
+                                                     queueFamilies.data());
+            if (queueFamilies[indices.graphicsFamily].queueCount >= 2) {
+                transferQueueInFamily = 1;
+            }
+        }
 
         std::set<uint32_t> queueFamilyIndicesSet = {indices.graphicsFamily, indices.presentFamily,
                                                     indices.computeFamily, indices.transferFamily};
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        float queuePriority = 1.F; // ranges from 0 - 1.;
+        std::array<float, 2> queuePriorities = {1.F, 1.F}; // ranges from 0 - 1.;
         for (uint32_t queueFamilyIndex : queueFamilyIndicesSet) {
             VkDeviceQueueCreateInfo queueCreateInfo{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
             queueCreateInfo.queueFamilyIndex = queueFamilyIndex;
-            queueCreateInfo.queueCount       = 1;
-            queueCreateInfo.pQueuePriorities = &queuePriority;
+            queueCreateInfo.queueCount =
+                queueFamilyIndex == indices.transferFamily ? transferQueueInFamily + 1 : 1;
+            queueCreateInfo.pQueuePriorities = queuePriorities.data();
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
@@ -306,7 +347,12 @@ void ContextCreator::createDevice(Logger *logger, VkPhysicalDevice &physicalDevi
         // descriptorIndexing.pNext = &rayTracingStructure; // uncomment this to
         // enable the features above
 
-        physicalDeviceFeatures.pNext = &descriptorIndexing;
+        // core in 1.2, signals completion of the streaming uploads to the render thread
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore = {
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+        timelineSemaphore.pNext = &descriptorIndexing;
+
+        physicalDeviceFeatures.pNext = &timelineSemaphore;
 
         vkGetPhysicalDeviceFeatures2(
             physicalDevice,
@@ -319,10 +365,37 @@ void ContextCreator::createDevice(Logger *logger, VkPhysicalDevice &physicalDevi
         // createInfo.pEnabledFeatures = &deviceFeatures;
         deviceCreateInfo.pEnabledFeatures = nullptr;
 
-        // enabling device extensions
+        // enabling device extensions, the optional ones only when the picked device has them
+        enabledOptionalExtensions.clear();
+        {
+            uint32_t extensionCount = 0;
+            vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount,
+                                                 nullptr);
+            std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+            vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount,
+                                                 availableExtensions.data());
+
+            std::set<std::string> availableExtensionsSet{};
+            for (const auto &extension : availableExtensions) {
+                availableExtensionsSet.insert(static_cast<const char *>(extension.extensionName));
+            }
+            for (const auto &optionalExtension : optionalDeviceExtensions) {
+                if (availableExtensionsSet.find(optionalExtension) !=
+                    availableExtensionsSet.end()) {
+                    enabledOptionalExtensions.push_back(optionalExtension);
+                    logger->info("using optional device extension: {}", optionalExtension);
+                } else {
+                    logger->info("optional device extension not available: {}",
+                                 optionalExtension);
+                }
+            }
+        }
+        std::vector<const char *> enabledExtensions = requiredDeviceExtensions;
+        enabledExtensions.insert(enabledExtensions.end(), enabledOptionalExtensions.begin(),
+                                 enabledOptionalExtensions.end());
         deviceCreateInfo.enabledExtensionCount =
-            static_cast<uint32_t>(requiredDeviceExtensions.size());
-        deviceCreateInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
+            static_cast<uint32_t>(enabledExtensions.size());
+        deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // The enabledLayerCount and ppEnabledLayerNames fields of
         // VkDeviceCreateInfo are ignored by up-to-date implementations.
@@ -345,7 +418,8 @@ void ContextCreator::createDevice(Logger *logger, VkPhysicalDevice &physicalDevi
         vkGetDeviceQueue(device, indices.graphicsFamily, 0, &queueSelection.graphicsQueue);
         vkGetDeviceQueue(device, indices.presentFamily, 0, &queueSelection.presentQueue);
         vkGetDeviceQueue(device, indices.computeFamily, 0, &queueSelection.computeQueue);
-        vkGetDeviceQueue(device, indices.transferFamily, 0, &queueSelection.transferQueue);
+        vkGetDeviceQueue(device, indices.transferFamily, transferQueueInFamily,
+                         &queueSelection.transferQueue);
 
         // // if raytracing support requested - let's get raytracing properties to
         // // know shader header size and max recursion
@@ -25,5 +25,7 @@ struct QueueSelection {
 void createDevice(Logger *logger, VkPhysicalDevice &physicalDevice, VkDevice &device,
                   QueueFamilyIndices &indices, QueueSelection &queueSelection,
                   const VkInstance &instance, VkSurfaceKHR surface,
-                  const std::vector<const char *> &requiredDeviceExtensions);
+                  const std::vector<const char *> &requiredDeviceExtensions,
+                  const std::vector<const char *> &optionalDeviceExtensions,
+                  std::vector<const char *> &enabledOptionalExtensions);
 } // namespace ContextCreator
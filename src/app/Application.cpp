@@ -1,7 +1,13 @@
 #include "Application.hpp"
 #include "BlockState.hpp"
+#include "StartupGraph.hpp"
+#include "app-context/AsyncUploader.hpp"
+#include "app-context/Defragmenter.hpp"
+#include "app-context/UploadManager.hpp"
 #include "config-container/ConfigContainer.hpp"
 #include "config-container/sub-config/ApplicationInfo.hpp"
+#include "config-container/sub-config/RendererInfo.hpp"
+#include "config/RootDir.h"
 #include "dotnet/Components.hpp"
 #include "dotnet/RuntimeApplication.hpp"
 #include "dotnet/RuntimeBridge.hpp"
@@ -12,42 +18,115 @@
 #include "utils/fps-sink/FpsSink.hpp"
 #include "utils/logger/Logger.hpp"
 #include "utils/shader-compiler/ShaderCompiler.hpp"
+#include "utils/shader-compiler/ShaderHotReloader.hpp"
+#include "utils/thread-pool/ThreadPool.hpp"
 #include "window/Window.hpp"
 
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <string>
 
-Application::Application(Logger *logger) : _logger(logger) {
-    // bootstrap the runtime application, to be ready to connect with the managed code
-    RuntimeBridge::bootstrap(logger);
-
-    _appContext      = std::make_unique<VulkanApplicationContext>();
+Application::Application(Logger *logger)
+    : _logger(logger), _constructionTime(std::chrono::steady_clock::now()) {
     _configContainer = std::make_unique<ConfigContainer>(_logger);
+    _appContext      = std::make_unique<VulkanApplicationContext>();
 
-    _shaderCompiler = std::make_unique<ShaderCompiler>(
-        logger, [this](std::string const &fullPathToIncludedShaderFile) {});
-
-    _window = std::make_unique<Window>(WindowStyle::kMaximized, logger);
-
-    // Set window reference for runtime application to access keyboard input
-    RuntimeBridge::getRuntimeApplication().setWindow(_window.get());
-
-    VulkanApplicationContext::GraphicsSettings settings{};
-    settings.isFramerateLimited = _configContainer->applicationInfo->isFramerateLimited;
-    _appContext->init(_logger, _window->getGlWindow(), &settings);
-
-    _imguiManager = std::make_unique<ImguiManager>(_appContext.get(), _window.get(), _logger,
-                                                   _configContainer.get());
-
-    _fpsSink = std::make_unique<FpsSink>();
-
-    _init();
+    // the include graph used by hot reload is built by the reloader's own compilers
+    _shaderCompiler = std::make_unique<ShaderCompiler>(logger);
+
+    // runs the worker steps of the startup, then the model loads and texture decodes
+    _assetLoaderPool = std::make_unique<ThreadPool>(
+        _configContainer->applicationInfo->assetLoaderWorkerCount);
+    _startupGraph =
+        std::make_unique<StartupGraph>(_logger, _assetLoaderPool.get(), _constructionTime);
+
+    // the instance extensions can be queried from any thread once glfw is initialized, which has
+    // to happen on this one
+    glfwInit();
+
+    // the managed side declares its groups while it is bootstrapped
+    RuntimeBridge::getRuntimeApplication().setOwningGroupsEnabled(
+        _configContainer->applicationInfo->useOwningGroups);
+
+    // 0 would pick one worker per hardware thread, here it means none
+    if (_configContainer->applicationInfo->systemWorkerCount > 0) {
+        _systemPool =
+            std::make_unique<ThreadPool>(_configContainer->applicationInfo->systemWorkerCount);
+        RuntimeBridge::getRuntimeApplication().setSystemThreadPool(_systemPool.get());
+        // the scaling benchmark starts with a warm up on a single thread
+        if (_configContainer->applicationInfo->systemScalingFrames > 0) {
+            RuntimeBridge::getRuntimeApplication().setSystemThreadLimit(1);
+        }
+    }
 
-    // call every startup system to register meshes BEFORE creating the renderer
-    RuntimeBridge::getRuntimeApplication().start();
+    using Affinity = StartupGraph::Affinity;
+    std::vector<Renderer::PendingModel> pendingModels;
 
-    _renderer = std::make_unique<Renderer>(
-        _appContext.get(), _logger, _configContainer->applicationInfo->framesInFlight,
-        _shaderCompiler.get(), _window.get(), _configContainer.get());
+    // bootstrap the runtime application, to be ready to connect with the managed code
+    _startupGraph->addStep("clr-bootstrap", Affinity::kWorker, {},
+                           [this] { RuntimeBridge::bootstrap(_logger); });
+    _startupGraph->addStep("vulkan-instance", Affinity::kWorker, {},
+                           [this] { _appContext->initInstance(_logger); });
+    _startupGraph->addStep("shader-compilation", Affinity::kWorker, {},
+                           [this] { Renderer::precompileShaders(_shaderCompiler.get(), _logger); });
+
+    _startupGraph->addStep("window", Affinity::kMainThread, {}, [this] {
+        _window = std::make_unique<Window>(WindowStyle::kMaximized, _logger);
+        // Set window reference for runtime application to access keyboard input
+        RuntimeBridge::getRuntimeApplication().setWindow(_window.get());
+    });
+
+    _startupGraph->addStep(
+        "vulkan-device", Affinity::kMainThread, {"vulkan-instance", "window"}, [this] {
+            VulkanApplicationContext::GraphicsSettings settings{};
+            settings.isFramerateLimited = _configContainer->applicationInfo->isFramerateLimited;
+            _appContext->initDevice(_window->getGlWindow(), &settings);
+
+            auto const &rendererInfo = *_configContainer->rendererInfo;
+            Defragmenter::Settings defragmenterSettings{};
+            defragmenterSettings.isEnabled              = rendererInfo.memoryDefragmentation;
+            defragmenterSettings.fragmentationThreshold = rendererInfo.defragmentationThreshold;
+            defragmenterSettings.timeBudgetMs           = rendererInfo.defragmentationTimeBudgetMs;
+            defragmenterSettings.framesInFlight =
+                static_cast<uint32_t>(_configContainer->applicationInfo->framesInFlight);
+            _appContext->getDefragmenter()->setSettings(defragmenterSettings);
+        });
+
+    _startupGraph->addStep("imgui", Affinity::kMainThread, {"vulkan-device"}, [this] {
+        _imguiManager = std::make_unique<ImguiManager>(_appContext.get(), _window.get(), _logger,
+                                                       _configContainer.get());
+        _fpsSink      = std::make_unique<FpsSink>();
+        _init();
+    });
+
+    // call every startup system to register meshes BEFORE creating the renderer, the models
+    // start loading right after, while the device may still be being created
+    _startupGraph->addStep("startup-systems", Affinity::kWorker, {"clr-bootstrap", "window"},
+                           [] { RuntimeBridge::getRuntimeApplication().start(); });
+    _startupGraph->addStep("model-loading", Affinity::kWorker, {"startup-systems"},
+                           [this, &pendingModels] {
+                               pendingModels = Renderer::loadRegisteredModels(
+                                   _assetLoaderPool.get(), _configContainer.get(), _logger);
+                           });
+
+    _startupGraph->addStep(
+        "renderer", Affinity::kMainThread,
+        {"vulkan-device", "shader-compilation", "model-loading"}, [this, &pendingModels] {
+            _renderer = std::make_unique<Renderer>(
+                _appContext.get(), _logger, _configContainer->applicationInfo->framesInFlight,
+                _shaderCompiler.get(), _window.get(), _configContainer.get(),
+                _assetLoaderPool.get(), std::move(pendingModels));
+        });
+
+    _startupGraph->run();
+
+    if (_configContainer->applicationInfo->enableShaderHotReload) {
+        _shaderHotReloader = std::make_unique<ShaderHotReloader>(
+            _logger, _configContainer->applicationInfo->shaderHotReloadWorkerCount);
+        _shaderHotReloader->watch(_renderer->getPipeline()->getFullPathToShaderSourceCode(),
+                                  {ShaderStage::kVert, ShaderStage::kFrag});
+    }
 
     GlobalEventDispatcher::get()
         .sink<E_RenderLoopBlockRequest>()
@@ -58,7 +137,11 @@ void Application::_onRenderLoopBlockRequest(E_RenderLoopBlockRequest const &even
     _blockStateBits |= event.blockStateBits;
 }
 
-Application::~Application() { _cleanup(); }
+Application::~Application() {
+    // the runtime application outlives the pool
+    RuntimeBridge::getRuntimeApplication().setSystemThreadPool(nullptr);
+    _cleanup();
+}
 
 void Application::run() { _mainLoop(); }
 
@@ -146,11 +229,6 @@ void Application::_mainLoop() {
         if (_blockStateBits != 0) {
             vkDeviceWaitIdle(_appContext->getDevice());
 
-            if (_blockStateBits & BlockState::kShaderChanged) {
-                GlobalEventDispatcher::get().trigger<E_RenderLoopBlocked>();
-                // then some rebuilding will happen
-            }
-
             if (_blockStateBits & BlockState::kWindowResized) {
                 _waitForTheWindowToBeResumed();
                 _onSwapchainResize();
@@ -162,6 +240,12 @@ void Application::_mainLoop() {
             continue;
         }
 
+        // shaders are recompiled in the background, pipelines are swapped here at the frame
+        // boundary, the ones they replace are released once their frames have been retired
+        if (_shaderHotReloader != nullptr) {
+            _shaderHotReloader->dispatchReadyResults();
+        }
+
         auto currentTime  = std::chrono::steady_clock::now();
         auto deltaTime    = currentTime - fpsRecordLastTime;
         fpsRecordLastTime = currentTime;
@@ -180,6 +264,7 @@ void Application::_mainLoop() {
         auto runtimeUpdateStart = std::chrono::steady_clock::now();
         RuntimeBridge::getRuntimeApplication().update(dt);
         auto runtimeUpdateEnd = std::chrono::steady_clock::now();
+        _stepScalingBenchmark();
         if (_configContainer->applicationInfo->enableFrameTiming) {
             currentFrameTimings.runtimeUpdate = _getTimeInMilliseconds(runtimeUpdateStart, runtimeUpdateEnd);
         }
@@ -223,6 +308,7 @@ void Application::_mainLoop() {
             currentFrameTimings.rendererTimings.gpuCommandRecording = rendererTimings.gpuCommandRecording;
             currentFrameTimings.rendererTimings.commandBufferFinish = rendererTimings.commandBufferFinish;
             currentFrameTimings.rendererTimings.totalDrawFrame = rendererTimings.totalDrawFrame;
+            currentFrameTimings.rendererTimings.gpuRenderPass = rendererTimings.gpuRenderPass;
             
             // Collect detailed draw frame breakdown
             currentFrameTimings.drawFrameBreakdown = _lastDrawFrameBreakdown;
@@ -291,28 +377,64 @@ void Application::_drawFrame() {
 
     // Entity data collection timing
     auto entityDataStart = std::chrono::steady_clock::now();
-    auto const &reg        = RuntimeBridge::getRuntimeApplication().registry;
-    
-    // 改为基于ECS实体的渲染系统
-    // 遍历所有有Transform和Mesh组件的实体
-    auto renderableEntities = reg.view<Transform, Mesh, Material>();
+    auto &runtimeApplication = RuntimeBridge::getRuntimeApplication();
+    auto const &reg          = runtimeApplication.registry;
+    // disabled entities are neither drawn nor looked through
+    auto const &disabled = runtimeApplication.getTagStorage(RuntimeApplication::kDisabledTag);
     
     std::vector<std::unique_ptr<Components>> entityRenderData;
-    
-    for (auto entity : renderableEntities) {
-        auto& transform = renderableEntities.get<Transform>(entity);
-        auto& mesh = renderableEntities.get<Mesh>(entity);
-        auto& material = renderableEntities.get<Material>(entity);
-
-        // 为每个实体创建模型矩阵
-        glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), transform.position);
-        
+    auto const addRenderData = [&entityRenderData](Transform const &transform, Mesh const &mesh,
+                                                   Material const &material) {
         // 存储实体的渲染数据（变换矩阵 + 模型ID）
         Components* comp = new Components();
         comp->transform = transform;
         comp->mesh = mesh;
         comp->material = material;
         entityRenderData.emplace_back(comp);
+    };
+
+    // 改为基于ECS实体的渲染系统
+    // 遍历所有有Transform和Mesh组件的实体
+    // a declared group of exactly these components is walked in its packed order instead
+    std::vector<std::string> const renderableNames = {"Transform", "Mesh", "Material"};
+    auto *renderableGroup = runtimeApplication.isOwningGroupsEnabled()
+                                ? runtimeApplication.findGroup(renderableNames)
+                                : nullptr;
+    if (renderableGroup != nullptr &&
+        renderableGroup->getComponentNames().size() == renderableNames.size()) {
+        constexpr size_t kChunkSize = 256;
+        std::array<entt::entity, kChunkSize> entities{};
+        std::array<void *, 3 * kChunkSize> components{};
+
+        // the slot of each of Transform, Mesh and Material within the group
+        auto const &groupNames = renderableGroup->getComponentNames();
+        std::array<size_t, 3> slots{};
+        for (size_t i = 0; i < slots.size(); i++) {
+            slots[i] = std::find(groupNames.begin(), groupNames.end(), renderableNames[i]) -
+                       groupNames.begin();
+        }
+        auto const onChunk = [&](size_t entityCount) {
+            for (size_t n = 0; n < entityCount; n++) {
+                if (disabled.contains(entities[n])) {
+                    continue;
+                }
+                void **entityComponents = components.data() + n;
+                addRenderData(*static_cast<Transform *>(entityComponents[slots[0] * kChunkSize]),
+                              *static_cast<Mesh *>(entityComponents[slots[1] * kChunkSize]),
+                              *static_cast<Material *>(entityComponents[slots[2] * kChunkSize]));
+            }
+        };
+        renderableGroup->eachChunk(kChunkSize, entities.data(), components.data(), onChunk);
+    } else {
+        auto renderableEntities = reg.view<Transform, Mesh, Material>();
+        for (auto entity : renderableEntities) {
+            if (disabled.contains(entity)) {
+                continue;
+            }
+            addRenderData(renderableEntities.get<Transform>(entity),
+                          renderableEntities.get<Mesh>(entity),
+                          renderableEntities.get<Material>(entity));
+        }
     }
     auto entityDataEnd = std::chrono::steady_clock::now();
     
@@ -326,6 +448,9 @@ void Application::_drawFrame() {
     auto camEntities = reg.view<Transform, iCamera>();
     
     for (auto entity : camEntities) {
+        if (disabled.contains(entity)) {
+            continue;
+        }
         auto &transform = camEntities.get<Transform>(entity);
         auto &camera = camEntities.get<iCamera>(entity);
 
@@ -339,6 +464,9 @@ void Application::_drawFrame() {
         cameraUpdateTime = _getTimeInMilliseconds(cameraUpdateStart, cameraUpdateEnd);
     }
     
+    // moves vertex and index buffers ahead of this frame, the frame binds them afterwards
+    _appContext->getDefragmenter()->update();
+
     // Renderer draw frame timing
     auto rendererDrawStart = std::chrono::steady_clock::now();
     // 传递实体渲染数据给渲染器
@@ -365,20 +493,40 @@ void Application::_drawFrame() {
         _imguiManager->getCommandBuffer(currentFrame),
     };
 
+    // wait until the image is ready, the acquire barriers of streamed uploads recorded by the
+    // renderer additionally wait for the uploads themselves, which have completed already
+    std::vector<VkSemaphore> waitSemaphores = {_imageAvailableSemaphores[currentFrame]};
+    std::vector<VkPipelineStageFlags> waitStages{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+    // ignored for binary semaphores
+    std::vector<uint64_t> waitValues = {0};
+    auto *asyncUploader              = _appContext->getAsyncUploader();
+    if (asyncUploader != nullptr && asyncUploader->getAcquiredTicket() != 0) {
+        waitSemaphores.push_back(asyncUploader->getTimelineSemaphore());
+        waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        waitValues.push_back(asyncUploader->getAcquiredTicket());
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{
+        VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineSubmitInfo.pWaitSemaphoreValues    = waitValues.data();
+
     VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
-    // wait until the image is ready
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores    = &_imageAvailableSemaphores[currentFrame];
+    submitInfo.pNext              = &timelineSubmitInfo;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores    = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask  = waitStages.data();
     // signal a semaphore after render finished
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores    = &_renderFinishedSemaphores[currentFrame];
-    // wait for no stage
-    VkPipelineStageFlags waitStages{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
-    submitInfo.pWaitDstStageMask = &waitStages;
 
     submitInfo.commandBufferCount = static_cast<uint32_t>(submitCommandBuffers.size());
     submitInfo.pCommandBuffers    = submitCommandBuffers.data();
 
+    // uploads recorded since the last frame (e.g. resources recreated on resize) are submitted ahead
+    // of the frame on the same queue, which is enough for the frame to see them
+    _appContext->getUploadManager()->flush();
+
     // Queue submit timing
     auto queueSubmitStart = std::chrono::steady_clock::now();
     vkQueueSubmit(_appContext->getGraphicsQueue(), 1, &submitInfo,
@@ -403,6 +551,22 @@ void Application::_drawFrame() {
     auto queuePresentStart = std::chrono::steady_clock::now();
     vkQueuePresentKHR(_appContext->getPresentQueue(), &presentInfo);
     auto queuePresentEnd = std::chrono::steady_clock::now();
+
+    if (_startupGraph != nullptr) {
+        _logger->info("First frame presented {:.1f} ms after the application was constructed",
+                      _getTimeInMilliseconds(_constructionTime, queuePresentEnd));
+        _startupGraph->recordSpan("first-frame", fenceWaitStart, queuePresentEnd);
+        _startupGraph->logTimeline();
+
+        std::string const tracePath = kRootDir + "startup-trace.json";
+        if (_startupGraph->writeTrace(tracePath)) {
+            _logger->info("Startup trace written to {}", tracePath);
+        } else {
+            _logger->warn("Failed to write the startup trace to {}", tracePath);
+        }
+        _startupGraph.reset();
+        _assetLoaderPool.reset();
+    }
     
     double queuePresentTime = 0.0;
     if (_configContainer->applicationInfo->enableFrameTiming) {
@@ -445,7 +609,7 @@ void Application::_printTimingResults() {
     // Detailed renderer timing averages
     double avgCmdBufferSetup = 0.0, avgEntityGrouping = 0.0, avgInstanceDataPrep = 0.0;
     double avgBufferUpdates = 0.0, avgGpuCommandRecording = 0.0, avgCmdBufferFinish = 0.0;
-    double avgRendererTotal = 0.0;
+    double avgRendererTotal = 0.0, avgGpuRenderPass = 0.0;
     
     // Draw frame breakdown averages
     double avgFenceWait = 0.0, avgAcquireImage = 0.0, avgEntityData = 0.0, avgCameraUpdate = 0.0;
@@ -468,6 +632,7 @@ void Application::_printTimingResults() {
         avgGpuCommandRecording += timing.rendererTimings.gpuCommandRecording;
         avgCmdBufferFinish += timing.rendererTimings.commandBufferFinish;
         avgRendererTotal += timing.rendererTimings.totalDrawFrame;
+        avgGpuRenderPass += timing.rendererTimings.gpuRenderPass;
         
         // Draw frame breakdown averages
         avgFenceWait += timing.drawFrameBreakdown.fenceWait;
@@ -497,6 +662,7 @@ void Application::_printTimingResults() {
     avgGpuCommandRecording /= frameCount;
     avgCmdBufferFinish /= frameCount;
     avgRendererTotal /= frameCount;
+    avgGpuRenderPass /= frameCount;
     
     // Draw frame breakdown averages
     avgFenceWait /= frameCount;
@@ -526,6 +692,7 @@ void Application::_printTimingResults() {
     _logger->info("GPU Command Recording:   {:.3f} ms", avgGpuCommandRecording);
     _logger->info("Command Buffer Finish:   {:.3f} ms", avgCmdBufferFinish);
     _logger->info("Renderer Total:          {:.3f} ms", avgRendererTotal);
+    _logger->info("GPU Render Pass:         {:.3f} ms", avgGpuRenderPass);
     _logger->info("");
     _logger->info("=== Application _drawFrame() Breakdown ===");
     _logger->info("Fence Wait:              {:.3f} ms", avgFenceWait);
@@ -538,5 +705,38 @@ void Application::_printTimingResults() {
     _logger->info("Queue Present:           {:.3f} ms", avgQueuePresent);
     _logger->info("");
     _logger->info("Draw Frame Total (sum):  {:.3f} ms", avgFenceWait + avgAcquireImage + avgEntityData + avgCameraUpdate + avgRendererDraw + avgImguiCmd + avgQueueSubmit + avgQueuePresent);
+    _logger->info("");
+    // systems that don't conflict overlap, so these add up to more than the runtime update
+    _logger->info("=== Update System Timing (average / max over every frame) ===");
+    for (auto const &timing : RuntimeBridge::getRuntimeApplication().getSystemTimings()) {
+        _logger->info("{:<28} {:.3f} ms / {:.3f} ms", timing.name, timing.averageMs, timing.maxMs);
+    }
     _logger->info("===============================================");
 }
+
+// runs systemScalingFrames frames with every thread count from 1 to the system workers and the
+// main thread, logs the update system timings of each and closes the window after the last
+void Application::_stepScalingBenchmark() {
+    uint32_t const framesPerStep = _configContainer->applicationInfo->systemScalingFrames;
+    if (framesPerStep == 0 || _systemPool == nullptr || ++_scalingFrameCount < framesPerStep) {
+        return;
+    }
+    _scalingFrameCount = 0;
+
+    auto &runtimeApplication = RuntimeBridge::getRuntimeApplication();
+    if (_scalingThreadCount > 0) {
+        _logger->info("=== Update System Timing with {} threads (average / max over {} frames) ===",
+                      _scalingThreadCount, framesPerStep);
+        for (auto const &timing : runtimeApplication.getSystemTimings()) {
+            _logger->info("{:<28} {:.3f} ms / {:.3f} ms", timing.name, timing.averageMs,
+                          timing.maxMs);
+        }
+    }
+    runtimeApplication.resetSystemTimings();
+
+    if (_scalingThreadCount == _systemPool->getWorkerCount() + 1) {
+        glfwSetWindowShouldClose(_window->getGlWindow(), 1);
+        return;
+    }
+    runtimeApplication.setSystemThreadLimit(++_scalingThreadCount);
+}
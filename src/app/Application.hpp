@@ -18,7 +18,10 @@ class Window;
 class FpsSink;
 class Renderer;
 class ShaderCompiler;
+class ShaderHotReloader;
 class ImguiManager;
+class StartupGraph;
+class ThreadPool;
 
 class Application {
   public:
@@ -39,11 +42,18 @@ class Application {
     std::unique_ptr<VulkanApplicationContext> _appContext = nullptr;
     std::unique_ptr<ConfigContainer> _configContainer     = nullptr;
     std::unique_ptr<ShaderCompiler> _shaderCompiler       = nullptr;
+    std::unique_ptr<ShaderHotReloader> _shaderHotReloader = nullptr;
     std::unique_ptr<Window> _window                       = nullptr;
     std::unique_ptr<Renderer> _renderer                   = nullptr;
     std::unique_ptr<ImguiManager> _imguiManager           = nullptr;
     std::unique_ptr<FpsSink> _fpsSink                     = nullptr;
 
+    // both are kept until the first frame, the graph's timeline ends with it
+    std::unique_ptr<ThreadPool> _assetLoaderPool = nullptr;
+    std::unique_ptr<StartupGraph> _startupGraph  = nullptr;
+    // runs the update systems that don't conflict, nullptr when they all run on the main thread
+    std::unique_ptr<ThreadPool> _systemPool = nullptr;
+
     // semaphores and fences for synchronization
     std::vector<VkSemaphore> _imageAvailableSemaphores{};
     std::vector<VkSemaphore> _renderFinishedSemaphores{};
@@ -51,6 +61,9 @@ class Application {
 
     uint32_t _blockStateBits = 0;
 
+    // startup is measured from the start of the constructor to the first present
+    std::chrono::steady_clock::time_point _constructionTime;
+
     // Frame timing variables
     struct FrameTimings {
         double pollEvents = 0.0;
@@ -70,6 +83,7 @@ class Application {
             double gpuCommandRecording = 0.0;
             double commandBufferFinish = 0.0;
             double totalDrawFrame = 0.0;
+            double gpuRenderPass = 0.0;
         } rendererTimings;
         
         // Detailed _drawFrame timing breakdown
@@ -92,6 +106,10 @@ class Application {
     // Store last draw frame breakdown for access from main loop
     FrameTimings::DrawFrameBreakdown _lastDrawFrameBreakdown;
 
+    // the thread count the scaling benchmark measures, 0 for its warm up
+    size_t _scalingThreadCount  = 0;
+    uint32_t _scalingFrameCount = 0;
+
     void _applicationKeyboardCallback(KeyboardInfo const &keyboardInfo);
 
     void _createSemaphoresAndFences();
@@ -107,5 +125,6 @@ class Application {
     
     // Timing measurement helpers
     void _printTimingResults();
+    void _stepScalingBenchmark();
     double _getTimeInMilliseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
 };
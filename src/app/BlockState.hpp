@@ -3,6 +3,5 @@
 #include <cstdint>
 
 enum BlockState : uint32_t {
-    kShaderChanged = 1U,
     kWindowResized = 2U,
 };
@@ -0,0 +1,183 @@
+#include "StartupGraph.hpp"
+
+#include "utils/logger/Logger.hpp"
+#include "utils/thread-pool/ThreadPool.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+
+StartupGraph::StartupGraph(Logger *logger, ThreadPool *threadPool,
+                           std::chrono::steady_clock::time_point origin)
+    : _logger(logger), _threadPool(threadPool), _origin(origin) {
+    _threadIndices[std::this_thread::get_id()] = 0;
+}
+
+void StartupGraph::addStep(std::string name, Affinity affinity,
+                           std::vector<std::string> const &dependencies,
+                           std::function<void()> work) {
+    size_t const stepIndex = _steps.size();
+    for (auto const &dependency : dependencies) {
+        auto it = _stepIndices.find(dependency);
+        if (it == _stepIndices.end()) {
+            throw std::runtime_error("Startup step " + name + " depends on unknown step " +
+                                     dependency);
+        }
+        _steps[it->second].dependents.push_back(stepIndex);
+    }
+    _stepIndices[name] = stepIndex;
+    _steps.push_back({std::move(name), affinity, {}, dependencies.size(), std::move(work)});
+}
+
+void StartupGraph::run() {
+    std::vector<size_t> remainingDependencies(_steps.size());
+    std::deque<size_t> readyMainThreadSteps;
+    size_t runningWorkerSteps = 0;
+
+    auto const schedule = [&](size_t stepIndex) {
+        if (_steps[stepIndex].affinity == Affinity::kMainThread) {
+            readyMainThreadSteps.push_back(stepIndex);
+            return;
+        }
+        runningWorkerSteps++;
+        _threadPool->submit([this, stepIndex] {
+            _runStep(stepIndex);
+            {
+                std::lock_guard lock(_mutex);
+                _finishedWorkerSteps.push_back(stepIndex);
+            }
+            _finishedCondition.notify_one();
+        });
+    };
+    auto const hasFailed = [this] {
+        std::lock_guard lock(_mutex);
+        return _exception != nullptr;
+    };
+    // nothing depending on a failed step is started
+    auto const release = [&](size_t stepIndex) {
+        if (hasFailed()) {
+            readyMainThreadSteps.clear();
+            return;
+        }
+        for (size_t dependent : _steps[stepIndex].dependents) {
+            if (--remainingDependencies[dependent] == 0) {
+                schedule(dependent);
+            }
+        }
+    };
+
+    for (size_t i = 0; i < _steps.size(); i++) {
+        remainingDependencies[i] = _steps[i].dependencyCount;
+        if (remainingDependencies[i] == 0) {
+            schedule(i);
+        }
+    }
+
+    while (!readyMainThreadSteps.empty() || runningWorkerSteps > 0) {
+        if (!readyMainThreadSteps.empty()) {
+            size_t const stepIndex = readyMainThreadSteps.front();
+            readyMainThreadSteps.pop_front();
+            _runStep(stepIndex);
+            release(stepIndex);
+            continue;
+        }
+
+        std::vector<size_t> finishedWorkerSteps;
+        {
+            std::unique_lock lock(_mutex);
+            _finishedCondition.wait(lock, [this] { return !_finishedWorkerSteps.empty(); });
+            finishedWorkerSteps.swap(_finishedWorkerSteps);
+        }
+        runningWorkerSteps -= finishedWorkerSteps.size();
+        for (size_t stepIndex : finishedWorkerSteps) {
+            release(stepIndex);
+        }
+    }
+
+    std::lock_guard lock(_mutex);
+    if (_exception) {
+        std::rethrow_exception(_exception);
+    }
+}
+
+void StartupGraph::_runStep(size_t stepIndex) {
+    auto &step = _steps[stepIndex];
+
+    auto const start = std::chrono::steady_clock::now();
+    std::exception_ptr exception;
+    try {
+        step.work();
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    std::lock_guard lock(_mutex);
+    if (exception && !_exception) {
+        _logger->error("Startup step {} failed", step.name);
+        _exception = exception;
+    }
+    auto const threadId = std::this_thread::get_id();
+    auto it             = _threadIndices.find(threadId);
+    if (it == _threadIndices.end()) {
+        it = _threadIndices.emplace(threadId, static_cast<uint32_t>(_threadIndices.size())).first;
+    }
+    _spans.push_back({step.name, it->second, start, end});
+}
+
+void StartupGraph::recordSpan(std::string name, std::chrono::steady_clock::time_point start,
+                              std::chrono::steady_clock::time_point end) {
+    std::lock_guard lock(_mutex);
+    _spans.push_back({std::move(name), 0, start, end});
+}
+
+double StartupGraph::_toMilliseconds(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration<double, std::milli>(time - _origin).count();
+}
+
+void StartupGraph::logTimeline() const {
+    std::lock_guard lock(_mutex);
+    auto spans = _spans;
+    std::sort(spans.begin(), spans.end(),
+              [](Span const &a, Span const &b) { return a.start < b.start; });
+
+    _logger->info("Startup timeline, in ms since the application was constructed:");
+    for (auto const &span : spans) {
+        std::string const thread =
+            span.threadIndex == 0 ? "main" : "worker " + std::to_string(span.threadIndex);
+        _logger->info("  {:<20} {:>8.1f} - {:>8.1f} ({:>7.1f}) on {}", span.name,
+                      _toMilliseconds(span.start), _toMilliseconds(span.end),
+                      _toMilliseconds(span.end) - _toMilliseconds(span.start), thread);
+    }
+}
+
+bool StartupGraph::writeTrace(std::string const &path) const {
+    std::lock_guard lock(_mutex);
+
+    // complete events of the trace event format, in microseconds
+    std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (uint32_t threadIndex = 0; threadIndex < _threadIndices.size(); threadIndex++) {
+        std::string const thread =
+            threadIndex == 0 ? "main" : "worker " + std::to_string(threadIndex);
+        json += fmt::format("  {{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                            "\"tid\": {}, \"args\": {{\"name\": \"{}\"}}}},\n",
+                            threadIndex, thread);
+    }
+    for (size_t i = 0; i < _spans.size(); i++) {
+        auto const &span = _spans[i];
+        json += fmt::format("  {{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, "
+                            "\"ts\": {:.1f}, \"dur\": {:.1f}}}{}\n",
+                            span.name, span.threadIndex, _toMilliseconds(span.start) * 1000.0,
+                            (_toMilliseconds(span.end) - _toMilliseconds(span.start)) * 1000.0,
+                            i + 1 < _spans.size() ? "," : "");
+    }
+    json += "]}\n";
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << json;
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Logger;
+class ThreadPool;
+
+// runs the steps of the application startup as a dependency graph, so independent steps overlap,
+// and records when each one ran on which thread, the timeline is logged and can be written as a
+// chrome trace (chrome://tracing or ui.perfetto.dev)
+class StartupGraph {
+  public:
+    enum class Affinity {
+        // glfw, and with it everything that touches the window, is bound to the main thread
+        kMainThread,
+        kWorker,
+    };
+
+    // the timeline starts at origin, worker steps run on the pool
+    StartupGraph(Logger *logger, ThreadPool *threadPool,
+                 std::chrono::steady_clock::time_point origin);
+    ~StartupGraph() = default;
+
+    // disable move and copy
+    StartupGraph(const StartupGraph &)            = delete;
+    StartupGraph &operator=(const StartupGraph &) = delete;
+    StartupGraph(StartupGraph &&)                 = delete;
+    StartupGraph &operator=(StartupGraph &&)      = delete;
+
+    // the dependencies have to be added first, which keeps the graph acyclic
+    void addStep(std::string name, Affinity affinity, std::vector<std::string> const &dependencies,
+                 std::function<void()> work);
+
+    // must be called from the main thread, runs the main thread steps in place as soon as they
+    // are ready and returns when every step is done, the first exception a step throws is
+    // rethrown once the steps that are already running have finished
+    void run();
+
+    // adds a span that didn't run as a step, e.g. the first frame, from the main thread
+    void recordSpan(std::string name, std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end);
+
+    void logTimeline() const;
+    bool writeTrace(std::string const &path) const;
+
+  private:
+    struct Step {
+        std::string name;
+        Affinity affinity;
+        std::vector<size_t> dependents;
+        size_t dependencyCount;
+        std::function<void()> work;
+    };
+
+    struct Span {
+        std::string name;
+        // 0 is the main thread, the workers are numbered in the order they first ran a step
+        uint32_t threadIndex;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    Logger *_logger;
+    ThreadPool *_threadPool;
+    std::chrono::steady_clock::time_point _origin;
+
+    std::vector<Step> _steps;
+    std::unordered_map<std::string, size_t> _stepIndices;
+
+    // guards everything below, the workers report finished steps through it
+    mutable std::mutex _mutex;
+    std::condition_variable _finishedCondition;
+    std::vector<size_t> _finishedWorkerSteps;
+    std::exception_ptr _exception;
+    std::vector<Span> _spans;
+    std::unordered_map<std::thread::id, uint32_t> _threadIndices;
+
+    void _runStep(size_t stepIndex);
+    [[nodiscard]] double _toMilliseconds(std::chrono::steady_clock::time_point time) const;
+};
@@ -13,6 +13,7 @@ ConfigContainer::ConfigContainer(Logger *logger) : _logger(logger) {
     cameraInfo       = std::make_unique<CameraInfo>();
     debugInfo        = std::make_unique<DebugInfo>();
     imguiManagerInfo = std::make_unique<ImguiManagerInfo>();
+    rendererInfo     = std::make_unique<RendererInfo>();
 
     _loadConfig();
 }
@@ -26,5 +27,5 @@ void ConfigContainer::_loadConfig() {
     cameraInfo->loadConfig(&tomlConfigReader);
     debugInfo->loadConfig(&tomlConfigReader);
     imguiManagerInfo->loadConfig(&tomlConfigReader);
-    RendererInfo->loadConfig(&tomlConfigReader);
+    rendererInfo->loadConfig(&tomlConfigReader);
 }
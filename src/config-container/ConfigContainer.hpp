@@ -30,7 +30,7 @@ struct ConfigContainer {
     std::unique_ptr<CameraInfo> cameraInfo             = nullptr;
     std::unique_ptr<DebugInfo> debugInfo               = nullptr;
     std::unique_ptr<ImguiManagerInfo> imguiManagerInfo = nullptr;
-    std::unique_ptr<RendererInfo> RendererInfo         = nullptr;
+    std::unique_ptr<RendererInfo> rendererInfo         = nullptr;
 
   private:
     Logger *_logger;
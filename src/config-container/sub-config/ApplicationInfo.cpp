@@ -6,4 +6,14 @@ void ApplicationInfo::loadConfig(TomlConfigReader *tomlConfigReader) {
     framesInFlight     = tomlConfigReader->getConfig<uint32_t>("Application.framesInFlight");
     isFramerateLimited = tomlConfigReader->getConfig<bool>("Application.isFramerateLimited");
     enableFrameTiming  = tomlConfigReader->getConfig<bool>("Application.enableFrameTiming");
+    enableShaderHotReload =
+        tomlConfigReader->getConfig<bool>("Application.enableShaderHotReload");
+    shaderHotReloadWorkerCount =
+        tomlConfigReader->getConfig<uint32_t>("Application.shaderHotReloadWorkerCount");
+    assetLoaderWorkerCount =
+        tomlConfigReader->getConfig<uint32_t>("Application.assetLoaderWorkerCount");
+    useOwningGroups   = tomlConfigReader->getConfig<bool>("Application.useOwningGroups");
+    systemWorkerCount = tomlConfigReader->getConfig<uint32_t>("Application.systemWorkerCount");
+    systemScalingFrames =
+        tomlConfigReader->getConfig<uint32_t>("Application.systemScalingFrames");
 }
@@ -1,11 +1,19 @@
 #pragma once
 
+#include <cstdint>
+
 class TomlConfigReader;
 
 struct ApplicationInfo {
     int framesInFlight{};
     bool isFramerateLimited{};
     bool enableFrameTiming{};
+    bool enableShaderHotReload{};
+    uint32_t shaderHotReloadWorkerCount{};
+    uint32_t assetLoaderWorkerCount{};
+    bool useOwningGroups{};
+    uint32_t systemWorkerCount{};
+    uint32_t systemScalingFrames{};
 
     void loadConfig(TomlConfigReader *tomlConfigReader);
 };
@@ -3,10 +3,13 @@
 #include "utils/toml-config/TomlConfigReader.hpp"
 
 void RendererInfo::loadConfig(TomlConfigReader *tomlConfigReader) {
-    // aTrousSizeMax         = tomlConfigReader->getConfig<uint32_t>("SvoTracer.aTrousSizeMax");
-    // beamResolution        = tomlConfigReader->getConfig<uint32_t>("SvoTracer.beamResolution");
-    // taaSamplingOffsetSize =
-    // tomlConfigReader->getConfig<uint32_t>("SvoTracer.taaSamplingOffsetSize"); shadowMapResolution
-    // = tomlConfigReader->getConfig<uint32_t>("SvoTracer.shadowMapResolution"); upscaleRatio =
-    // tomlConfigReader->getConfig<float>("SvoTracer.upscaleRatio");
+    textureMipmaps        = tomlConfigReader->getConfig<bool>("Renderer.textureMipmaps");
+    maxAnisotropy         = tomlConfigReader->getConfig<float>("Renderer.maxAnisotropy");
+    textureCompression    = tomlConfigReader->getConfig<bool>("Renderer.textureCompression");
+    vertexQuantization    = tomlConfigReader->getConfig<bool>("Renderer.vertexQuantization");
+    memoryDefragmentation = tomlConfigReader->getConfig<bool>("Renderer.memoryDefragmentation");
+    defragmentationThreshold =
+        tomlConfigReader->getConfig<float>("Renderer.defragmentationThreshold");
+    defragmentationTimeBudgetMs =
+        tomlConfigReader->getConfig<float>("Renderer.defragmentationTimeBudgetMs");
 }
@@ -3,6 +3,13 @@
 class TomlConfigReader;
 
 struct RendererInfo {
+    bool textureMipmaps{};
+    float maxAnisotropy{};
+    bool textureCompression{};
+    bool vertexQuantization{};
+    bool memoryDefragmentation{};
+    float defragmentationThreshold{};
+    float defragmentationTimeBudgetMs{};
 
     void loadConfig(TomlConfigReader *tomlConfigReader);
 };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// an owning group, declared for a combination of components that is queried every frame, the
+// registry keeps the storages of its owned components packed in the same order so walking the
+// group is linear, the components it only gets are still looked up per entity
+// a component can be owned by one group only, and is added and removed through the registry, not
+// its storage, so the registry keeps the group packed
+class ComponentGroup {
+  public:
+    ComponentGroup(std::vector<std::string> ownedNames, std::vector<std::string> getNames)
+        : _ownedNames(std::move(ownedNames)), _componentNames(_ownedNames) {
+        _componentNames.insert(_componentNames.end(), getNames.begin(), getNames.end());
+    }
+    virtual ~ComponentGroup() = default;
+
+    // disable move and copy
+    ComponentGroup(const ComponentGroup &)            = delete;
+    ComponentGroup &operator=(const ComponentGroup &) = delete;
+    ComponentGroup(ComponentGroup &&)                 = delete;
+    ComponentGroup &operator=(ComponentGroup &&)      = delete;
+
+    [[nodiscard]] std::vector<std::string> const &getOwnedNames() const { return _ownedNames; }
+    // the owned components, then the ones the group only gets
+    [[nodiscard]] std::vector<std::string> const &getComponentNames() const {
+        return _componentNames;
+    }
+
+    [[nodiscard]] virtual size_t size() const = 0;
+
+    // walks the group in its packed order, chunkSize entities at a time: entities[n] is the n-th
+    // entity of the chunk and components[k * chunkSize + n] the address of its k-th component,
+    // onChunk gets the number of entities in the chunk
+    // components of the group must not be added or removed during the walk
+    virtual void eachChunk(size_t chunkSize, entt::entity *entities, void **components,
+                           std::function<void(size_t)> const &onChunk) = 0;
+
+  private:
+    std::vector<std::string> _ownedNames;
+    std::vector<std::string> _componentNames;
+};
+
+template <typename Owned, typename Get> class TypedComponentGroup;
+
+template <typename... Owned, typename... Get>
+class TypedComponentGroup<entt::type_list<Owned...>, entt::type_list<Get...>>
+    : public ComponentGroup {
+  public:
+    TypedComponentGroup(entt::registry &registry, std::vector<std::string> ownedNames,
+                        std::vector<std::string> getNames)
+        : ComponentGroup(std::move(ownedNames), std::move(getNames)),
+          _group(registry.group<Owned...>(entt::get<Get...>)) {}
+
+    [[nodiscard]] size_t size() const override { return _group.size(); }
+
+    void eachChunk(size_t chunkSize, entt::entity *entities, void **components,
+                   std::function<void(size_t)> const &onChunk) override {
+        size_t count = 0;
+        _group.each([&](entt::entity entity, Owned &...owned, Get &...get) {
+            entities[count] = entity;
+            size_t k        = 0;
+            ((components[k++ * chunkSize + count] = &owned), ...);
+            ((components[k++ * chunkSize + count] = &get), ...);
+            if (++count == chunkSize) {
+                onChunk(count);
+                count = 0;
+            }
+        });
+        if (count > 0) {
+            onChunk(count);
+        }
+    }
+
+  private:
+    decltype(std::declval<entt::registry &>().group<Owned...>(entt::get<Get...>)) _group;
+};
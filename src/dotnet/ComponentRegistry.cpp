@@ -0,0 +1,164 @@
+#include "ComponentRegistry.hpp"
+#include "Components.hpp"
+#include "EntityCommandBuffer.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace {
+constexpr size_t kComponentCount = std::tuple_size_v<ManagedComponents>;
+
+template <typename T> using StorageOf =
+    std::remove_reference_t<decltype(std::declval<entt::registry &>().storage<T>())>;
+
+// managed memory gives no alignment guarantee, e.g. a value inside a byte array
+template <typename T> T _load(void const *value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T component;
+    std::memcpy(&component, value, sizeof(T));
+    return component;
+}
+
+template <typename T>
+void _assign(entt::registry &registry, entt::entity entity, void const *value) {
+    registry.emplace_or_replace<T>(entity, _load<T>(value));
+}
+
+template <typename T>
+void _recordAssign(EntityCommandBuffer &buffer, entt::entity entity, void const *value) {
+    buffer.add(entity, _load<T>(value));
+}
+
+template <typename T> void _recordRemove(EntityCommandBuffer &buffer, entt::entity entity) {
+    buffer.remove<T>(entity);
+}
+
+// through the registry, see ComponentGroup
+template <typename T>
+void _insert(entt::registry &registry, entt::entity const *entities, size_t count,
+             void const *values) {
+    registry.insert<T>(entities, entities + count, static_cast<T const *>(values));
+}
+
+template <typename T> void *_getComponent(entt::sparse_set &storage, entt::entity entity) {
+    return &static_cast<StorageOf<T> &>(storage).get(entity);
+}
+
+template <typename T> void *const *_getPages(entt::sparse_set &storage) {
+    return reinterpret_cast<void *const *>(static_cast<StorageOf<T> &>(storage).raw());
+}
+
+template <typename T> entt::sparse_set &_getStorage(entt::registry &registry) {
+    return registry.storage<T>();
+}
+
+template <size_t I> constexpr ComponentRegistry::ComponentInfo _makeInfo() {
+    using T = std::tuple_element_t<I, ManagedComponents>;
+    return {kManagedComponentNames[I],
+            sizeof(T),
+            alignof(T),
+            &_assign<T>,
+            &_recordAssign<T>,
+            &_recordRemove<T>,
+            &_insert<T>,
+            &_getComponent<T>,
+            entt::component_traits<T>::page_size,
+            &_getPages<T>};
+}
+
+template <size_t... Is> constexpr auto _makeInfos(std::index_sequence<Is...>) {
+    return std::array<ComponentRegistry::ComponentInfo, kComponentCount>{_makeInfo<Is>()...};
+}
+
+template <size_t... Is> constexpr auto _makeStorageGetters(std::index_sequence<Is...>) {
+    return std::array<entt::sparse_set &(*)(entt::registry &), kComponentCount>{
+        &_getStorage<std::tuple_element_t<Is, ManagedComponents>>...};
+}
+
+// indexed by the type id
+constexpr auto kInfos          = _makeInfos(std::make_index_sequence<kComponentCount>{});
+constexpr auto kStorageGetters = _makeStorageGetters(std::make_index_sequence<kComponentCount>{});
+} // namespace
+
+size_t ComponentRegistry::getComponentCount() { return kComponentCount; }
+
+int ComponentRegistry::getTypeId(std::string_view name) {
+    for (size_t i = 0; i < kComponentCount; i++) {
+        if (kInfos[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+ComponentRegistry::ComponentInfo const &ComponentRegistry::getInfo(int typeId) {
+    assert(typeId >= 0 && static_cast<size_t>(typeId) < kComponentCount && "Unknown component");
+    return kInfos[typeId];
+}
+
+entt::sparse_set &ComponentRegistry::getStorage(entt::registry &registry, int typeId) {
+    assert(typeId >= 0 && static_cast<size_t>(typeId) < kComponentCount && "Unknown component");
+    return kStorageGetters[typeId](registry);
+}
+
+bool RuntimeComponentStorage::isLayoutSupported(size_t size, size_t alignment) {
+    bool const isPowerOfTwo = alignment != 0 && (alignment & (alignment - 1)) == 0;
+    return size != 0 && isPowerOfTwo && alignment <= alignof(std::max_align_t) &&
+           size % alignment == 0;
+}
+
+RuntimeComponentStorage::RuntimeComponentStorage(entt::registry &registry, std::string name,
+                                                 size_t size, size_t alignment)
+    : _registry(&registry), _id(entt::hashed_string::value(name.c_str(), name.size())),
+      _name(std::move(name)), _size(size), _alignment(alignment),
+      _entities(&registry.storage<RuntimeComponent>(_id)) {
+    assert(isLayoutSupported(size, alignment) && "Unsupported runtime component layout");
+    _registry->on_destroy<RuntimeComponent>(_id)
+        .connect<&RuntimeComponentStorage::_onDestroy>(*this);
+}
+
+RuntimeComponentStorage::~RuntimeComponentStorage() {
+    _registry->on_destroy<RuntimeComponent>(_id).disconnect(this);
+}
+
+std::byte *RuntimeComponentStorage::_at(size_t index) {
+    return reinterpret_cast<std::byte *>(_values.data()) + index * _size;
+}
+
+void RuntimeComponentStorage::assign(entt::entity entity, void const *value) {
+    if (_entities->contains(entity)) {
+        std::memcpy(_at(_entities->index(entity)), value, _size);
+        return;
+    }
+
+    // appended, its value goes last
+    _entities->emplace(entity);
+    assert(_entities->index(entity) == _count && "Runtime component storage out of step");
+    size_t const byteCount = (_count + 1) * _size;
+    _values.resize((byteCount + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t));
+    _page = _values.data();
+    std::memcpy(_at(_count), value, _size);
+    _count++;
+}
+
+void *RuntimeComponentStorage::get(entt::entity entity) {
+    return _entities->contains(entity) ? _at(_entities->index(entity)) : nullptr;
+}
+
+// called before the entity leaves its storage, which swaps the last one into its place, when the
+// storage is cleared all at once every entity is announced from the last to the first, so the last
+// value is the one counted here rather than the one of the storage's size
+void RuntimeComponentStorage::_onDestroy(entt::registry & /*registry*/, entt::entity entity) {
+    assert(_count > 0 && "Runtime component storage out of step");
+    size_t const index = _entities->index(entity);
+    size_t const last  = _count - 1;
+    if (index != last) {
+        std::memcpy(_at(index), _at(last), _size);
+    }
+    _count--;
+}
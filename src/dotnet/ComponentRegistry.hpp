@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <entt/entt.hpp>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class EntityCommandBuffer;
+
+// the layout and the type-erased operations of every managed component, generated from
+// ManagedComponents, so the host calls that add, remove and query components take a type id
+// instead of there being one per type, the type id is the position in that list
+// the components the host has no type for are registered at runtime, their ids follow these, see
+// RuntimeComponentStorage
+namespace ComponentRegistry {
+
+// the address of a component through the storage of its type
+using GetterFn = void *(*)(entt::sparse_set &storage, entt::entity entity);
+
+struct ComponentInfo {
+    std::string_view name;
+    size_t size;
+    size_t alignment;
+
+    // copies value, which needs no alignment, into the entity's component, added if it's missing
+    void (*assign)(entt::registry &registry, entt::entity entity, void const *value);
+    // the same, to be played back at the next sync point
+    void (*recordAssign)(EntityCommandBuffer &buffer, entt::entity entity, void const *value);
+    void (*recordRemove)(EntityCommandBuffer &buffer, entt::entity entity);
+    // one insert of count values, laid out contiguously and aligned, for count entities that
+    // don't have the component yet
+    void (*insert)(entt::registry &registry, entt::entity const *entities, size_t count,
+                   void const *values);
+    GetterFn getComponent;
+    // the storage splits the components into pages of pageSize, getPages returns its page table,
+    // the i-th component, the one of storage.data()[i], is at pages[i / pageSize][i % pageSize]
+    size_t pageSize;
+    void *const *(*getPages)(entt::sparse_set &storage);
+};
+
+// the number of the host's types, the first runtime type id
+size_t getComponentCount();
+// -1 for a name the managed side can't use, the names are the ones of the managed structs
+int getTypeId(std::string_view name);
+ComponentInfo const &getInfo(int typeId);
+
+// made by the registry the first time it's asked for, components are removed through it with no
+// knowledge of their type
+entt::sparse_set &getStorage(entt::registry &registry, int typeId);
+}; // namespace ComponentRegistry
+
+// the values of a component the managed side registers from its size and alignment alone, one the
+// host has no type for, see RuntimeApplication::registerRuntimeComponent
+// the registry holds which entities have it, as a storage of its own without data keyed by the
+// name, so it filters queries and goes away with its entity, the values are packed next to it in
+// the order of that storage's entities, its destroy signal keeps them in step
+// systems don't get it handed over, no kernel knows it, the managed side walks getPages instead
+class RuntimeComponentStorage {
+  public:
+    using EntityStorage = std::remove_reference_t<
+        decltype(std::declval<entt::registry &>().storage<RuntimeComponent>())>;
+
+    // the alignment is a power of two no larger than the one of std::max_align_t, and the size a
+    // multiple of it, like the size of a managed struct
+    static bool isLayoutSupported(size_t size, size_t alignment);
+
+    RuntimeComponentStorage(entt::registry &registry, std::string name, size_t size,
+                            size_t alignment);
+    ~RuntimeComponentStorage();
+
+    // disable move and copy, the registry's signal holds on to it
+    RuntimeComponentStorage(const RuntimeComponentStorage &)            = delete;
+    RuntimeComponentStorage &operator=(const RuntimeComponentStorage &) = delete;
+    RuntimeComponentStorage(RuntimeComponentStorage &&)                 = delete;
+    RuntimeComponentStorage &operator=(RuntimeComponentStorage &&)      = delete;
+
+    [[nodiscard]] std::string const &getName() const { return _name; }
+    [[nodiscard]] size_t getSize() const { return _size; }
+    [[nodiscard]] size_t getAlignment() const { return _alignment; }
+    // removing an entity from it removes its value
+    [[nodiscard]] EntityStorage &getEntities() const { return *_entities; }
+
+    // copies value, which needs no alignment, into the entity's component, added if it's missing
+    void assign(entt::entity entity, void const *value);
+    // nullptr if the entity has none
+    [[nodiscard]] void *get(entt::entity entity);
+
+    // a table of a single page, of the getCount values, the i-th is the one of
+    // getEntities().data()[i], like ComponentInfo::getPages, valid until the next structural change
+    // to the component
+    [[nodiscard]] void *const *getPages() const { return &_page; }
+    [[nodiscard]] size_t getCount() const { return _count; }
+
+  private:
+    entt::registry *_registry;
+    entt::id_type _id;
+    std::string _name;
+    size_t _size;
+    size_t _alignment;
+    EntityStorage *_entities;
+
+    // in units of max_align_t, so any supported alignment holds
+    std::vector<std::max_align_t> _values{};
+    size_t _count = 0;
+    // _values.data(), set when they move rather than when asked for, so concurrent systems only
+    // read it
+    void *_page = nullptr;
+
+    [[nodiscard]] std::byte *_at(size_t index);
+    // moves the last value into the place of the entity's, as its storage does with the entity
+    void _onDestroy(entt::registry &registry, entt::entity entity);
+};
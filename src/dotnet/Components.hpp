@@ -2,7 +2,10 @@
 
 #include "utils/incl/GlmIncl.hpp" // IWYU pragma: export
 
+#include <array>
 #include <string>
+#include <string_view>
+#include <tuple>
 
 struct Transform {
     glm::vec3 position;
@@ -46,6 +49,23 @@ struct GameStats {
     float gameTime;      // 游戏时间（秒）
 };
 
+// a component without data, only whether an entity has it counts, every tag the managed side
+// registers is a storage of its own of this type, see RuntimeApplication::registerTag
+struct Tag {};
+
+// the same for the entities of a component the host has no type for, its values are kept apart,
+// see RuntimeComponentStorage
+struct RuntimeComponent {};
+
+// every component the managed side can add, remove and query, in the order of their type id, a
+// new one is appended here and to kManagedComponentNames, see ComponentRegistry
+using ManagedComponents =
+    std::tuple<Transform, iCamera, Velocity, Player, Mesh, Material, GameStats>;
+// the names of the managed structs
+constexpr std::array<std::string_view, 7> kManagedComponentNames = {
+    "Transform", "iCamera", "Velocity", "Player", "Mesh", "Material", "GameStats"};
+static_assert(kManagedComponentNames.size() == std::tuple_size_v<ManagedComponents>);
+
 class Components {
   public:
     Transform transform;
@@ -0,0 +1,209 @@
+#include "EntityCommandBuffer.hpp"
+#include "ComponentRegistry.hpp"
+#include "SystemScheduler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+// the buffer this thread records into, and whose it is
+thread_local EntityCommands const *_threadOwner = nullptr;
+thread_local EntityCommandBuffer *_threadBuffer = nullptr;
+
+template <typename Fn, typename... Ts> void _forEachType(std::tuple<Ts...> const *, Fn &&fn) {
+    (fn(std::type_identity<Ts>{}), ...);
+}
+} // namespace
+
+void EntityCommandBuffer::addRuntimeComponent(RuntimeComponentStorage &component,
+                                              entt::entity entity, void const *value) {
+    size_t const valueOffset = _runtimeComponentValues.size();
+    _runtimeComponentValues.resize(valueOffset + component.getSize());
+    std::memcpy(_runtimeComponentValues.data() + valueOffset, value, component.getSize());
+    _runtimeComponents.push_back({entity, _nextSequence(), &component, valueOffset});
+}
+
+// a buffer that hands one out has a command to play back
+uint64_t EntityCommandBuffer::_nextSequence() {
+    _isEmpty = false;
+    return uint64_t{SystemScheduler::getSystemOrder()} << 32 | _commandCount++;
+}
+
+EntityCommandBuffer &EntityCommands::getThreadBuffer() {
+    if (_threadOwner != this) {
+        std::lock_guard lock(_mutex);
+        _buffers.push_back(std::make_unique<EntityCommandBuffer>());
+        _threadOwner  = this;
+        _threadBuffer = _buffers.back().get();
+    }
+    return *_threadBuffer;
+}
+
+entt::entity EntityCommands::create(entt::registry &registry) {
+    auto const nextId = static_cast<uint32_t>(registry.storage<entt::entity>().size());
+    return entt::entity{nextId + _reservedCount.fetch_add(1, std::memory_order_relaxed)};
+}
+
+void EntityCommands::create(entt::registry &registry, entt::entity *first, entt::entity *last) {
+    auto const nextId = static_cast<uint32_t>(registry.storage<entt::entity>().size());
+    auto const count  = static_cast<uint32_t>(last - first);
+    uint32_t const id = nextId + _reservedCount.fetch_add(count, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        first[i] = entt::entity{id + i};
+    }
+}
+
+void EntityCommands::playback(entt::registry &registry) {
+    std::lock_guard lock(_mutex);
+    // before any command, so the ones recorded for them apply
+    _createReserved(registry);
+    bool const hasCommands =
+        std::any_of(_buffers.begin(), _buffers.end(),
+                    [](std::unique_ptr<EntityCommandBuffer> const &b) { return !b->isEmpty(); });
+    if (!hasCommands) {
+        return;
+    }
+
+    auto const *types = static_cast<ManagedComponents const *>(nullptr);
+    _forEachType(types, [&](auto type) {
+        _playbackComponents<typename decltype(type)::type>(registry);
+    });
+    _playbackTags(registry);
+    _playbackRuntimeComponents(registry);
+    _playbackDestroyed(registry);
+
+    for (auto &buffer : _buffers) {
+        buffer->_commandCount = 0;
+        buffer->_isEmpty      = true;
+    }
+}
+
+// in the order of their ids, each is then the next one the entity storage makes
+void EntityCommands::_createReserved(entt::registry &registry) {
+    uint32_t const reservedCount = _reservedCount.exchange(0, std::memory_order_relaxed);
+    auto const nextId            = static_cast<uint32_t>(registry.storage<entt::entity>().size());
+    for (uint32_t i = 0; i < reservedCount; ++i) {
+        [[maybe_unused]] entt::entity const entity = registry.create(entt::entity{nextId + i});
+        assert(entity == entt::entity{nextId + i} && "Entity made outside the reserved ids");
+    }
+}
+
+// the commands of every buffer, each in the order it recorded them, merged by their sequence,
+// apply gets the buffer that recorded a command along with it
+template <typename GetFn, typename ApplyFn>
+void EntityCommands::_inRecordOrder(GetFn &&getCommands, ApplyFn &&apply) {
+    _cursors.clear();
+    for (auto &buffer : _buffers) {
+        if (!getCommands(*buffer).empty()) {
+            _cursors.emplace_back(buffer.get(), 0);
+        }
+    }
+    // most often a single thread recorded them
+    if (_cursors.size() == 1) {
+        auto &buffer = *_cursors.front().first;
+        for (auto const &command : getCommands(buffer)) {
+            apply(buffer, command);
+        }
+        return;
+    }
+    auto const sequenceAt = [&getCommands](auto const &cursor) {
+        return getCommands(*cursor.first)[cursor.second].sequence;
+    };
+    while (!_cursors.empty()) {
+        auto next = _cursors.begin();
+        for (auto cursor = next + 1; cursor != _cursors.end(); ++cursor) {
+            if (sequenceAt(*cursor) < sequenceAt(*next)) {
+                next = cursor;
+            }
+        }
+        auto const &commands = getCommands(*next->first);
+        apply(*next->first, commands[next->second]);
+        if (++next->second == commands.size()) {
+            _cursors.erase(next);
+        }
+    }
+}
+
+template <typename T> void EntityCommands::_playbackComponents(entt::registry &registry) {
+    auto const getCommands = [](EntityCommandBuffer &buffer) -> auto & {
+        return std::get<EntityCommandBuffer::Queue<T>>(buffer._queues);
+    };
+    size_t commandCount = 0;
+    for (auto const &buffer : _buffers) {
+        commandCount += getCommands(*buffer).size();
+    }
+    if (commandCount == 0) {
+        return;
+    }
+
+    // through the registry, see ComponentGroup
+    auto &storage = registry.storage<T>();
+    storage.reserve(storage.size() + commandCount);
+    _inRecordOrder(getCommands, [&registry](EntityCommandBuffer &, auto const &command) {
+        if (!registry.valid(command.entity)) {
+            return;
+        }
+        if (command.component) {
+            registry.emplace_or_replace<T>(command.entity, *command.component);
+        } else {
+            registry.remove<T>(command.entity);
+        }
+    });
+    for (auto &buffer : _buffers) {
+        getCommands(*buffer).clear();
+    }
+}
+
+void EntityCommands::_playbackTags(entt::registry &registry) {
+    auto const getCommands = [](EntityCommandBuffer &buffer) -> auto & { return buffer._tags; };
+    _inRecordOrder(getCommands, [&registry](EntityCommandBuffer &, auto const &command) {
+        if (!command.isAdded) {
+            command.tag->remove(command.entity);
+        } else if (registry.valid(command.entity) && !command.tag->contains(command.entity)) {
+            command.tag->emplace(command.entity);
+        }
+    });
+    for (auto &buffer : _buffers) {
+        buffer->_tags.clear();
+    }
+}
+
+// one value at a time, they have no type to batch
+void EntityCommands::_playbackRuntimeComponents(entt::registry &registry) {
+    auto const getCommands = [](EntityCommandBuffer &buffer) -> auto & {
+        return buffer._runtimeComponents;
+    };
+    _inRecordOrder(getCommands, [&registry](EntityCommandBuffer &buffer, auto const &command) {
+        if (command.valueOffset == EntityCommandBuffer::kRemoved) {
+            command.component->getEntities().remove(command.entity);
+        } else if (registry.valid(command.entity)) {
+            command.component->assign(command.entity,
+                                      buffer._runtimeComponentValues.data() + command.valueOffset);
+        }
+    });
+    for (auto &buffer : _buffers) {
+        buffer->_runtimeComponents.clear();
+        buffer->_runtimeComponentValues.clear();
+    }
+}
+
+void EntityCommands::_playbackDestroyed(entt::registry &registry) {
+    _entities.clear();
+    for (auto &buffer : _buffers) {
+        _entities.insert(_entities.end(), buffer->_destroyed.begin(), buffer->_destroyed.end());
+        buffer->_destroyed.clear();
+    }
+    // an entity destroyed twice, by two systems or two threads, is destroyed once
+    std::sort(_entities.begin(), _entities.end());
+    _entities.erase(std::unique(_entities.begin(), _entities.end()), _entities.end());
+    _entities.erase(std::remove_if(_entities.begin(), _entities.end(),
+                                   [&registry](entt::entity entity) {
+                                       return !registry.valid(entity);
+                                   }),
+                    _entities.end());
+    if (!_entities.empty()) {
+        registry.destroy(_entities.begin(), _entities.end());
+    }
+}
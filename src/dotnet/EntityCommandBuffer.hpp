@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <entt/entt.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class RuntimeComponentStorage;
+
+// the storage of a tag, see RuntimeApplication::registerTag
+using TagStorage =
+    std::remove_reference_t<decltype(std::declval<entt::registry &>().storage<Tag>())>;
+
+// the entities and components an update system adds, removes and destroys, recorded while the
+// registry may be walked and played back at the next sync point
+class EntityCommandBuffer {
+  public:
+    EntityCommandBuffer()  = default;
+    ~EntityCommandBuffer() = default;
+
+    // disable move and copy
+    EntityCommandBuffer(const EntityCommandBuffer &)            = delete;
+    EntityCommandBuffer &operator=(const EntityCommandBuffer &) = delete;
+    EntityCommandBuffer(EntityCommandBuffer &&)                 = delete;
+    EntityCommandBuffer &operator=(EntityCommandBuffer &&)      = delete;
+
+    template <typename T> void add(entt::entity entity, T const &component) {
+        std::get<Queue<T>>(_queues).push_back({entity, _nextSequence(), component});
+    }
+    template <typename T> void remove(entt::entity entity) {
+        std::get<Queue<T>>(_queues).push_back({entity, _nextSequence(), std::nullopt});
+    }
+    void addTag(TagStorage &tag, entt::entity entity) {
+        _tags.push_back({entity, _nextSequence(), &tag, true});
+    }
+    void removeTag(TagStorage &tag, entt::entity entity) {
+        _tags.push_back({entity, _nextSequence(), &tag, false});
+    }
+    // a component the host has no type for, value needs no alignment and is copied
+    void addRuntimeComponent(RuntimeComponentStorage &component, entt::entity entity,
+                             void const *value);
+    void removeRuntimeComponent(RuntimeComponentStorage &component, entt::entity entity) {
+        _runtimeComponents.push_back({entity, _nextSequence(), &component, kRemoved});
+    }
+    void destroy(entt::entity entity) {
+        _destroyed.push_back(entity);
+        _isEmpty = false;
+    }
+
+    [[nodiscard]] bool isEmpty() const { return _isEmpty; }
+
+  private:
+    // the order commands are recorded in, by the system that records them and then by when, see
+    // SystemScheduler::getSystemOrder
+    struct Command {
+        entt::entity entity;
+        uint64_t sequence;
+    };
+    // an added component, or nullopt for a removed one
+    template <typename T> struct ComponentCommand : Command {
+        std::optional<T> component;
+    };
+    template <typename T> using Queue = std::vector<ComponentCommand<T>>;
+    template <typename Types> struct Queues;
+    template <typename... Ts> struct Queues<std::tuple<Ts...>> {
+        using Type = std::tuple<Queue<Ts>...>;
+    };
+    struct TagCommand : Command {
+        TagStorage *tag;
+        bool isAdded;
+    };
+    static constexpr size_t kRemoved = SIZE_MAX;
+    struct RuntimeComponentCommand : Command {
+        RuntimeComponentStorage *component;
+        // where its value starts in _runtimeComponentValues, kRemoved for a removed one
+        size_t valueOffset;
+    };
+
+    Queues<ManagedComponents>::Type _queues;
+    std::vector<TagCommand> _tags;
+    std::vector<RuntimeComponentCommand> _runtimeComponents;
+    std::vector<std::byte> _runtimeComponentValues;
+    std::vector<entt::entity> _destroyed;
+    // of the commands recorded since the last playback
+    uint32_t _commandCount = 0;
+    bool _isEmpty          = true;
+
+    uint64_t _nextSequence();
+
+    friend class EntityCommands;
+};
+
+// one command buffer per thread that records into it, so the threads of a parallel system never
+// contend, all of them are played back together
+// the playback adds and removes the components and tags in the order they were recorded in, the
+// host's components one type after the other, then destroys the entities: a component removed and
+// added again between two sync points ends up added, and a destroyed entity ends up with nothing
+// what the threads of one parallel system record for the same entity and component has no order
+class EntityCommands {
+  public:
+    EntityCommands()  = default;
+    ~EntityCommands() = default;
+
+    // disable move and copy
+    EntityCommands(const EntityCommands &)            = delete;
+    EntityCommands &operator=(const EntityCommands &) = delete;
+    EntityCommands(EntityCommands &&)                 = delete;
+    EntityCommands &operator=(EntityCommands &&)      = delete;
+
+    // the calling thread's buffer, made on its first use
+    EntityCommandBuffer &getThreadBuffer();
+
+    // the id of an entity is handed out right away, so the system can record components for it,
+    // the entity itself is made at the next playback: the other systems check entities against
+    // the entity storage while this one runs
+    entt::entity create(entt::registry &registry);
+    void create(entt::registry &registry, entt::entity *first, entt::entity *last);
+
+    // must not be called while a system runs, the commands recorded for entities destroyed since
+    // are dropped
+    void playback(entt::registry &registry);
+
+  private:
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<EntityCommandBuffer>> _buffers;
+    // the ids handed out since the last playback, the ones following the last the entity storage
+    // made, which nothing else makes while systems run
+    std::atomic<uint32_t> _reservedCount{0};
+    // reused by every playback
+    std::vector<entt::entity> _entities;
+    std::vector<std::pair<EntityCommandBuffer *, size_t>> _cursors;
+
+    template <typename GetFn, typename ApplyFn>
+    void _inRecordOrder(GetFn &&getCommands, ApplyFn &&apply);
+    void _createReserved(entt::registry &registry);
+    template <typename T> void _playbackComponents(entt::registry &registry);
+    void _playbackTags(entt::registry &registry);
+    void _playbackRuntimeComponents(entt::registry &registry);
+    void _playbackDestroyed(entt::registry &registry);
+};
@@ -0,0 +1,144 @@
+#include "Prefab.hpp"
+#include "ComponentRegistry.hpp"
+#include "EntityCommandBuffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr size_t kComponentCount = std::tuple_size_v<ManagedComponents>;
+
+// fn(typeId, value) for the value of every type, set or not
+template <typename Values, typename Fn, size_t... Is>
+void _forEachValue(Values &values, Fn &&fn, std::index_sequence<Is...>) {
+    (fn(static_cast<int>(Is), std::get<Is>(values)), ...);
+}
+
+template <typename Values, typename Fn> void _forEachValue(Values &values, Fn &&fn) {
+    _forEachValue(values, std::forward<Fn>(fn), std::make_index_sequence<kComponentCount>{});
+}
+
+template <typename Value> using ValueType = typename std::remove_cvref_t<Value>::value_type;
+
+bool _isOverridden(int typeId, PrefabOverride const *overrides, size_t overrideCount) {
+    return std::any_of(overrides, overrides + overrideCount,
+                       [typeId](PrefabOverride const &o) { return o.typeId == typeId; });
+}
+
+// the overrides of its type for the index-th instance, into its copy of the value
+void _applyOverrides(std::byte *instance, size_t index, int typeId,
+                     PrefabOverride const *overrides, size_t overrideCount) {
+    for (size_t k = 0; k < overrideCount; ++k) {
+        auto const &valueOverride = overrides[k];
+        if (valueOverride.typeId == typeId) {
+            std::memcpy(instance + valueOverride.offset,
+                        static_cast<std::byte const *>(valueOverride.data) +
+                            index * valueOverride.stride,
+                        valueOverride.size);
+        }
+    }
+}
+} // namespace
+
+void Prefab::setComponent(int typeId, void const *component) {
+    assert(typeId >= 0 && static_cast<size_t>(typeId) < kComponentCount && "Unknown component");
+    _forEachValue(_values, [typeId, component](int valueTypeId, auto &value) {
+        if (valueTypeId == typeId) {
+            using T = ValueType<decltype(value)>;
+            static_assert(std::is_trivially_copyable_v<T>);
+            std::memcpy(&value.emplace(), component, sizeof(T));
+        }
+    });
+}
+
+void Prefab::setRuntimeComponent(int typeId, RuntimeComponentStorage &storage,
+                                 void const *component) {
+    auto const *bytes = static_cast<std::byte const *>(component);
+    std::vector<std::byte> value(bytes, bytes + storage.getSize());
+    for (auto &runtimeValue : _runtimeValues) {
+        if (runtimeValue.typeId == typeId) {
+            runtimeValue.value = std::move(value);
+            return;
+        }
+    }
+    _runtimeValues.push_back({typeId, &storage, std::move(value)});
+}
+
+bool Prefab::isOverridable(PrefabOverride const &valueOverride) const {
+    size_t size = 0;
+    _forEachValue(_values, [&valueOverride, &size](int typeId, auto const &value) {
+        if (typeId == valueOverride.typeId && value) {
+            size = sizeof(ValueType<decltype(value)>);
+        }
+    });
+    for (auto const &runtimeValue : _runtimeValues) {
+        if (runtimeValue.typeId == valueOverride.typeId) {
+            size = runtimeValue.value.size();
+        }
+    }
+    return size > 0 && valueOverride.offset >= 0 && valueOverride.size > 0 &&
+           valueOverride.stride >= 0 && valueOverride.data != nullptr &&
+           static_cast<size_t>(valueOverride.offset) + valueOverride.size <= size;
+}
+
+void Prefab::instantiate(entt::registry &registry, entt::entity const *entities, size_t count,
+                         PrefabOverride const *overrides, size_t overrideCount) const {
+    _forEachValue(_values, [&](int typeId, auto const &value) {
+        if (!value) {
+            return;
+        }
+        using T = ValueType<decltype(value)>;
+        if (!_isOverridden(typeId, overrides, overrideCount)) {
+            // the same value for every entity
+            registry.insert<T>(entities, entities + count, *value);
+            return;
+        }
+        std::vector<T> values(count, *value);
+        for (size_t i = 0; i < count; ++i) {
+            _applyOverrides(reinterpret_cast<std::byte *>(&values[i]), i, typeId, overrides,
+                            overrideCount);
+        }
+        registry.insert<T>(entities, entities + count, values.begin());
+    });
+
+    // one value at a time, they have no type to batch
+    for (auto const &[typeId, storage, value] : _runtimeValues) {
+        std::vector<std::byte> instance(value.size());
+        for (size_t i = 0; i < count; ++i) {
+            std::copy(value.begin(), value.end(), instance.begin());
+            _applyOverrides(instance.data(), i, typeId, overrides, overrideCount);
+            storage->assign(entities[i], instance.data());
+        }
+    }
+}
+
+void Prefab::record(EntityCommandBuffer &buffer, entt::entity const *entities, size_t count,
+                    PrefabOverride const *overrides, size_t overrideCount) const {
+    _forEachValue(_values, [&](int typeId, auto const &value) {
+        if (!value) {
+            return;
+        }
+        bool const isOverridden = _isOverridden(typeId, overrides, overrideCount);
+        for (size_t i = 0; i < count; ++i) {
+            auto instance = *value;
+            if (isOverridden) {
+                _applyOverrides(reinterpret_cast<std::byte *>(&instance), i, typeId, overrides,
+                                overrideCount);
+            }
+            buffer.add(entities[i], instance);
+        }
+    });
+
+    for (auto const &[typeId, storage, value] : _runtimeValues) {
+        std::vector<std::byte> instance(value.size());
+        for (size_t i = 0; i < count; ++i) {
+            std::copy(value.begin(), value.end(), instance.begin());
+            _applyOverrides(instance.data(), i, typeId, overrides, overrideCount);
+            buffer.addRuntimeComponent(*storage, entities[i], instance.data());
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <entt/entt.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+class EntityCommandBuffer;
+class RuntimeComponentStorage;
+
+// size bytes at offset into the component of type typeId of every instance, the i-th one's taken
+// from data + i * stride, which needs no alignment, laid out as the managed side passes it
+struct PrefabOverride {
+    int32_t typeId;
+    int32_t offset;
+    int32_t size;
+    int32_t stride;
+    void const *data;
+};
+
+// the component values of an entity, registered once and copied into every instance, storage by
+// storage, so spawning many identical entities is a single call
+class Prefab {
+  public:
+    Prefab()  = default;
+    ~Prefab() = default;
+
+    // disable move and copy
+    Prefab(const Prefab &)            = delete;
+    Prefab &operator=(const Prefab &) = delete;
+    Prefab(Prefab &&)                 = delete;
+    Prefab &operator=(Prefab &&)      = delete;
+
+    // the type id is the one of ComponentRegistry, its value is copied from component,
+    // which needs no alignment
+    void setComponent(int typeId, void const *component);
+    // the same for a component the host has no type for, of that type id
+    void setRuntimeComponent(int typeId, RuntimeComponentStorage &storage, void const *component);
+
+    // overrides a component of the prefab, and bytes within it
+    [[nodiscard]] bool isOverridable(PrefabOverride const &valueOverride) const;
+
+    // gives each entity every component of the prefab, the entities must have none of them yet,
+    // each entity's copies are then overridden, in the order of the overrides
+    void instantiate(entt::registry &registry, entt::entity const *entities, size_t count,
+                     PrefabOverride const *overrides, size_t overrideCount) const;
+    // the same, to be played back at the next sync point
+    void record(EntityCommandBuffer &buffer, entt::entity const *entities, size_t count,
+                PrefabOverride const *overrides, size_t overrideCount) const;
+
+  private:
+    template <typename Types> struct Values;
+    template <typename... Ts> struct Values<std::tuple<Ts...>> {
+        using Type = std::tuple<std::optional<Ts>...>;
+    };
+
+    Values<ManagedComponents>::Type _values;
+    struct RuntimeValue {
+        int typeId;
+        RuntimeComponentStorage *storage;
+        std::vector<std::byte> value;
+    };
+    std::vector<RuntimeValue> _runtimeValues;
+};
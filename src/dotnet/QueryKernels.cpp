@@ -0,0 +1,73 @@
+#include "QueryKernels.hpp"
+#include "Components.hpp"
+
+#include <array>
+#include <bit>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace {
+// in the order of ManagedComponents
+using QueryableComponents = ManagedComponents;
+
+constexpr size_t kComponentCount = std::tuple_size_v<QueryableComponents>;
+
+template <typename... Ts> void _walk(entt::registry &registry, QueryKernels::Chunk const &chunk) {
+    size_t count = 0;
+    registry.view<Ts...>().each([&](entt::entity entity, Ts &...components) {
+        if (chunk.filter != nullptr && !chunk.filter->isPassing(entity)) {
+            return;
+        }
+        if (chunk.entities != nullptr) {
+            chunk.entities[count] = entity;
+        }
+        size_t k = 0;
+        ((chunk.components[chunk.slots[k++] * chunk.size + count] = &components), ...);
+        if (++count == chunk.size) {
+            chunk.onChunk(chunk.context, count);
+            count = 0;
+        }
+    });
+    if (count > 0) {
+        chunk.onChunk(chunk.context, count);
+    }
+}
+
+template <typename Types> struct Kernel;
+template <typename... Ts> struct Kernel<std::tuple<Ts...>> {
+    static constexpr QueryKernels::KernelFn kFn = &_walk<Ts...>;
+};
+
+// the components of the mask in the order of the queryable list
+template <uint32_t Mask, size_t... Is>
+auto _selectComponents(std::index_sequence<Is...>)
+    -> decltype(std::tuple_cat(
+        std::declval<std::conditional_t<((Mask >> Is) & 1U) != 0,
+                                        std::tuple<std::tuple_element_t<Is, QueryableComponents>>,
+                                        std::tuple<>>>()...));
+
+template <uint32_t Mask> constexpr QueryKernels::KernelFn _makeKernel() {
+    if constexpr (Mask == 0 || static_cast<size_t>(std::popcount(Mask)) > QueryKernels::kMaxArity) {
+        return nullptr;
+    } else {
+        using Types =
+            decltype(_selectComponents<Mask>(std::make_index_sequence<kComponentCount>{}));
+        return Kernel<Types>::kFn;
+    }
+}
+
+template <uint32_t... Masks>
+constexpr std::array<QueryKernels::KernelFn, sizeof...(Masks)>
+_makeKernelTable(std::integer_sequence<uint32_t, Masks...>) {
+    return {_makeKernel<Masks>()...};
+}
+
+// indexed by the component mask
+constexpr auto kKernels =
+    _makeKernelTable(std::make_integer_sequence<uint32_t, 1U << kComponentCount>{});
+} // namespace
+
+QueryKernels::KernelFn QueryKernels::getKernel(uint32_t componentMask) {
+    return componentMask < kKernels.size() ? kKernels[componentMask] : nullptr;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// typed iteration kernels for the component queries of managed systems, generated at compile time
+// for every set of up to kMaxArity queryable components, so a query resolves its names to a
+// kernel once and the kernel walks the storages with no hashing or type erasure per entity
+namespace QueryKernels {
+
+constexpr size_t kMaxArity = 4;
+
+// the storages, of components or tags, an entity must be in and must not be in, checked per
+// entity on top of the kernel's components
+struct Filter {
+    std::vector<entt::sparse_set const *> required;
+    std::vector<entt::sparse_set const *> excluded;
+
+    [[nodiscard]] bool isPassing(entt::entity entity) const {
+        auto const contains = [entity](entt::sparse_set const *set) {
+            return set->contains(entity);
+        };
+        return std::all_of(required.begin(), required.end(), contains) &&
+               std::none_of(excluded.begin(), excluded.end(), contains);
+    }
+};
+
+// where a kernel gathers the components of the entities it walks, and who it hands them to
+struct Chunk {
+    // entities per chunk
+    size_t size = 1;
+    // the k-th component of the kernel (in the order of the queryable list) of the n-th entity is
+    // written to components[slots[k] * size + n]
+    void **components   = nullptr;
+    size_t const *slots = nullptr;
+    // when set, the n-th entity of the chunk is written to entities[n]
+    entt::entity *entities = nullptr;
+    // when set, the entities it doesn't pass are skipped
+    Filter const *filter = nullptr;
+    // called with the number of entities of every full chunk, and of the last one
+    void (*onChunk)(void *context, size_t entityCount) = nullptr;
+    void *context                                      = nullptr;
+};
+
+// a kernel walks the entities that have every component of its set
+using KernelFn = void (*)(entt::registry &registry, Chunk const &chunk);
+
+// bit i of the mask is the component of type id i, see ComponentRegistry, nullptr for an empty
+// mask or one above kMaxArity
+KernelFn getKernel(uint32_t componentMask);
+}; // namespace QueryKernels
@@ -2,8 +2,17 @@
 #include "Components.hpp"
 #include "window/Window.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <entt/entt.hpp>
 #include <functional>
+#include <string>
+#include <utility>
+
+RuntimeApplication::RuntimeApplication() {
+    _systemScheduler.setSyncPoint([this] { _entityCommands.playback(registry); });
+    registerTag("Disabled");
+}
 
 void RuntimeApplication::print_reg() {
     auto transforms = registry.view<Transform>();
@@ -44,11 +53,19 @@ void RuntimeApplication::start() {
     }
 }
 
+void RuntimeApplication::add_update_system(UpdateSystem sys) {
+    add_update_system("update-system-" + std::to_string(_unnamedSystemCount++),
+                      SystemScheduler::Access{}, std::move(sys));
+}
+
+void RuntimeApplication::add_update_system(std::string name, SystemScheduler::Access access,
+                                           UpdateSystem sys) {
+    _systemScheduler.addSystem(std::move(name), access, std::move(sys));
+}
+
 void RuntimeApplication::update(float dt) {
     // printf("RuntimeApplication::update(dt=%f)\n", dt);
-    for (auto &s : updateSystems) {
-        s(dt);
-    }
+    _systemScheduler.run(dt);
 }
 
 bool RuntimeApplication::isKeyPressed(int keyCode) const {
@@ -107,3 +124,105 @@ std::vector<std::pair<int, std::string>> RuntimeApplication::getAllMeshes() cons
     }
     return meshes;
 }
+
+bool RuntimeApplication::addGroup(std::unique_ptr<ComponentGroup> group) {
+    for (auto const &existing : _groups) {
+        for (auto const &name : group->getOwnedNames()) {
+            auto const &ownedNames = existing->getOwnedNames();
+            if (std::find(ownedNames.begin(), ownedNames.end(), name) != ownedNames.end()) {
+                return false;
+            }
+        }
+    }
+    _groups.push_back(std::move(group));
+    return true;
+}
+
+ComponentGroup *
+RuntimeApplication::findGroup(std::vector<std::string> const &componentNames) const {
+    ComponentGroup *bestGroup = nullptr;
+    for (auto const &group : _groups) {
+        auto const &groupNames = group->getComponentNames();
+        bool const isCovered =
+            std::all_of(groupNames.begin(), groupNames.end(), [&](std::string const &name) {
+                return std::find(componentNames.begin(), componentNames.end(), name) !=
+                       componentNames.end();
+            });
+        if (isCovered && (bestGroup == nullptr ||
+                          groupNames.size() > bestGroup->getComponentNames().size())) {
+            bestGroup = group.get();
+        }
+    }
+    return bestGroup;
+}
+
+int RuntimeApplication::addPrefab(std::unique_ptr<Prefab> prefab) {
+    _prefabs.push_back(std::move(prefab));
+    return static_cast<int>(_prefabs.size() - 1);
+}
+
+Prefab const *RuntimeApplication::getPrefab(int prefabId) const {
+    if (prefabId < 0 || static_cast<size_t>(prefabId) >= _prefabs.size()) {
+        return nullptr;
+    }
+    return _prefabs[prefabId].get();
+}
+
+int RuntimeApplication::registerTag(std::string const &name) {
+    int const existingTag = findTag(name);
+    if (existingTag >= 0) {
+        return existingTag;
+    }
+    assert(findRuntimeComponent(name) < 0 && "Tag named like a runtime component");
+    // a storage of its own, keyed by the name next to the ones keyed by a component type
+    _tagNames.push_back(name);
+    auto const id = entt::hashed_string::value(name.c_str(), name.size());
+    _tagStorages.push_back(&registry.storage<Tag>(id));
+    return static_cast<int>(_tagNames.size() - 1);
+}
+
+int RuntimeApplication::findTag(std::string_view name) const {
+    auto it = std::find(_tagNames.begin(), _tagNames.end(), name);
+    return it == _tagNames.end() ? -1 : static_cast<int>(it - _tagNames.begin());
+}
+
+int RuntimeApplication::registerRuntimeComponent(std::string const &name, size_t size,
+                                                 size_t alignment) {
+    assert(!SystemScheduler::isInSystem() && "Component registered from an update system");
+    if (int const existingTypeId = findRuntimeComponent(name); existingTypeId >= 0) {
+        auto const *existing = getRuntimeComponent(existingTypeId);
+        bool const isMatching =
+            existing->getSize() == size && existing->getAlignment() == alignment;
+        return isMatching ? existingTypeId : -1;
+    }
+    // its storage is keyed by the name, like a tag's
+    if (findTag(name) >= 0 || ComponentRegistry::getTypeId(name) >= 0 ||
+        !RuntimeComponentStorage::isLayoutSupported(size, alignment)) {
+        return -1;
+    }
+    size_t const index = _runtimeComponents.size();
+    _runtimeComponents.push_back(
+        std::make_unique<RuntimeComponentStorage>(registry, name, size, alignment));
+    return static_cast<int>(ComponentRegistry::getComponentCount() + index);
+}
+
+int RuntimeApplication::findRuntimeComponent(std::string_view name) const {
+    auto it = std::find_if(
+        _runtimeComponents.begin(), _runtimeComponents.end(),
+        [name](std::unique_ptr<RuntimeComponentStorage> const &c) { return c->getName() == name; });
+    if (it == _runtimeComponents.end()) {
+        return -1;
+    }
+    return static_cast<int>(ComponentRegistry::getComponentCount() +
+                            (it - _runtimeComponents.begin()));
+}
+
+RuntimeComponentStorage *RuntimeApplication::getRuntimeComponent(int typeId) const {
+    size_t const hostTypeCount = ComponentRegistry::getComponentCount();
+    if (typeId < 0 || static_cast<size_t>(typeId) < hostTypeCount) {
+        return nullptr;
+    }
+    size_t const index = static_cast<size_t>(typeId) - hostTypeCount;
+    assert(index < _runtimeComponents.size() && "Unknown component");
+    return _runtimeComponents[index].get();
+}
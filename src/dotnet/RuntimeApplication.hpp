@@ -1,16 +1,27 @@
 #pragma once
 
+#include "ComponentGroup.hpp"
+#include "ComponentRegistry.hpp"
+#include "EntityCommandBuffer.hpp"
+#include "Prefab.hpp"
+#include "SystemScheduler.hpp"
+
 #include <entt/entt.hpp>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 
+class ThreadPool;
 class Window;
 
 class RuntimeApplication {
   public:
     entt::registry registry;
+
+    RuntimeApplication();
     
     // Mesh registry: maps mesh ID to mesh path
     std::unordered_map<int, std::string> meshRegistry;
@@ -21,7 +32,9 @@ class RuntimeApplication {
     using UpdateSystem = std::function<void(float)>;
 
     inline void add_startup_system(StartupSystem sys) { startSystems.push_back(sys); }
-    inline void add_update_system(UpdateSystem sys) { updateSystems.push_back(sys); }
+    // runs alone, it declares nothing about the components it touches
+    void add_update_system(UpdateSystem sys);
+    void add_update_system(std::string name, SystemScheduler::Access access, UpdateSystem sys);
 
     void print_reg();
 
@@ -31,6 +44,27 @@ class RuntimeApplication {
     // Should be called every frame, timing should be namaged by the main application
     void update(float dt);
 
+    // the update systems that don't conflict run concurrently on the pool, nullptr runs them one
+    // after another on the calling thread
+    void setSystemThreadPool(ThreadPool *threadPool) {
+        _systemScheduler.setThreadPool(threadPool);
+    }
+    void setSystemThreadLimit(size_t threadLimit) { _systemScheduler.setThreadLimit(threadLimit); }
+    size_t getSystemThreadCount() const { return _systemScheduler.getThreadCount(); }
+    // for an update system that splits its entities into batches, see SystemScheduler
+    void parallelFor(size_t count, std::function<void(size_t)> const &work) {
+        _systemScheduler.parallelFor(count, work);
+    }
+
+    std::vector<SystemScheduler::Timing> getSystemTimings() const {
+        return _systemScheduler.getTimings();
+    }
+    void resetSystemTimings() { _systemScheduler.resetTimings(); }
+
+    // where update systems record the entities and components they add, remove and destroy,
+    // played back at the scheduler's sync points
+    EntityCommands &getEntityCommands() { return _entityCommands; }
+
     // Set the window reference for keyboard input access
     void setWindow(Window* window) { _window = window; }
 
@@ -47,10 +81,61 @@ class RuntimeApplication {
     void registerMesh(int meshId, const std::string& meshPath);
     std::vector<std::pair<int, std::string>> getAllMeshes() const;
 
+    // turned off, declared groups are ignored and every query walks its smallest storage, for
+    // comparing the two
+    void setOwningGroupsEnabled(bool isEnabled) { _isOwningGroupsEnabled = isEnabled; }
+    bool isOwningGroupsEnabled() const { return _isOwningGroupsEnabled; }
+
+    // false if it owns a component another group already owns
+    bool addGroup(std::unique_ptr<ComponentGroup> group);
+    // the group with the most components that are all part of the query, nullptr if none is
+    ComponentGroup *findGroup(std::vector<std::string> const &componentNames) const;
+
+    // the engine's tag, every query and the renderer skip the entities that have it
+    static constexpr int kDisabledTag = 0;
+    // a tag of that name, the same id for the same name, registered before the queries that
+    // name it and not from within an update system
+    int registerTag(std::string const &name);
+    // -1 for a name that is no tag
+    int findTag(std::string_view name) const;
+    TagStorage &getTagStorage(int tagId) const { return *_tagStorages[tagId]; }
+
+    // a component the host has no type for, kept from its layout alone, the same type id for the
+    // same name, following the ids of the host's types, -1 for the name of a tag or a host type,
+    // or for a layout RuntimeComponentStorage can't keep or that differs from the registered one
+    // registered before the queries that name it and not from within an update system
+    int registerRuntimeComponent(std::string const &name, size_t size, size_t alignment);
+    // -1 for a name that is no runtime component
+    int findRuntimeComponent(std::string_view name) const;
+    // nullptr for the type id of a host type
+    RuntimeComponentStorage *getRuntimeComponent(int typeId) const;
+    // of a host type or a registered runtime component
+    bool isComponentTypeId(int typeId) const {
+        return typeId >= 0 && static_cast<size_t>(typeId) < ComponentRegistry::getComponentCount() +
+                                                                 _runtimeComponents.size();
+    }
+
+    // returns the id of the prefab, not to be called from within an update system
+    int addPrefab(std::unique_ptr<Prefab> prefab);
+    // nullptr for an unknown id
+    Prefab const *getPrefab(int prefabId) const;
+
   private:
     uint32_t _updateCount = 0;
     Window* _window = nullptr;
 
+    bool _isOwningGroupsEnabled = true;
+    std::vector<std::unique_ptr<ComponentGroup>> _groups;
+    // indexed by the prefab id
+    std::vector<std::unique_ptr<Prefab>> _prefabs;
+    // indexed by the tag id
+    std::vector<std::string> _tagNames;
+    std::vector<TagStorage *> _tagStorages;
+    // indexed by the type id less the number of host types, after the registry they signal to
+    std::vector<std::unique_ptr<RuntimeComponentStorage>> _runtimeComponents;
+
     std::vector<StartupSystem> startSystems;
-    std::vector<UpdateSystem> updateSystems;
+    SystemScheduler _systemScheduler;
+    EntityCommands _entityCommands;
+    size_t _unnamedSystemCount = 0;
 };
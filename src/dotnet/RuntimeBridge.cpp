@@ -1,6 +1,10 @@
 #include "RuntimeBridge.hpp"
+#include "ComponentRegistry.hpp"
 #include "Components.hpp"
+#include "Prefab.hpp"
+#include "QueryKernels.hpp"
 #include "RuntimeApplication.hpp"
+#include "SystemScheduler.hpp"
 #include "config/RootDir.h"
 #include "coreclr_delegates.h"
 #include "hostfxr.h"
@@ -8,10 +12,17 @@
 #include "utils/logger/Logger.hpp"
 
 #include <Windows.h>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstddef>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <string>
+#include <string_view>
+#include <utility>
 
 using string_t = std::basic_string<char_t>;
 namespace fs   = std::filesystem;
@@ -97,59 +108,380 @@ RuntimeApplication &RuntimeBridge::getRuntimeApplication() {
 
 using RegisterAllFn = void(__cdecl *)(void *);
 
+// the application's logger, set by bootstrap before the managed side calls back into the host
+static Logger *g_logger = nullptr;
+
 // signature of your managed callback:
 using ManagedPerEntityFn = void (*)(float dt, void **components);
 
-// A getter that, given (registry,entity), returns pointer to that component:
-using GetterFn = void *(*)(entt::registry &, entt::entity);
-
-// A storage‐iterator that, given a runtime_view&, calls .iterate(storage<T>())
-using IteratorFn = std::function<void(entt::runtime_view &)>;
-
-// when you add a new T component, insert here in BOTH maps.
-static const std::unordered_map<std::string, GetterFn> g_getters = {
-    {"Transform",
-     +[](entt::registry &r, entt::entity e) -> void * { return &r.get<Transform>(e); }},
-    {"iCamera",
-     +[](entt::registry &r, entt::entity e) -> void * { return &r.get<iCamera>(e); }},
-    {"Velocity", +[](entt::registry &r, entt::entity e) -> void * { return &r.get<Velocity>(e); }},
-    {"Player", +[](entt::registry &r, entt::entity e) -> void * { return &r.get<Player>(e); }},
-    {"Mesh", +[](entt::registry &r, entt::entity e) -> void * { return &r.get<Mesh>(e); }},
-    {"Material", +[](entt::registry &r, entt::entity e) -> void * { return &r.get<Material>(e); }},
-    {"GameStats", +[](entt::registry &r, entt::entity e) -> void * { return &r.get<GameStats>(e); }},
+// a chunked managed callback gets, for every queried component, an array of entityCount pointers
+using ManagedChunkFn = void (*)(float dt, int entityCount, void ***componentArrays);
+
+// how a managed update system is run, the same values as SystemFlags in PluginBootstrap.cs
+enum SystemFlags : int {
+    // runs alone, after the structural changes recorded before it are played back
+    kSystemExclusive = 1 << 0,
+    // its entities are split into batches that are handed to the managed system from several
+    // threads at once
+    kSystemParallel = 1 << 1,
+};
+
+// A factory of an owning group over the registry
+using GroupFactoryFn = std::unique_ptr<ComponentGroup> (*)(entt::registry &,
+                                                           std::vector<std::string>,
+                                                           std::vector<std::string>);
+
+template <typename Owned, typename Get>
+std::unique_ptr<ComponentGroup> makeGroup(entt::registry &registry,
+                                          std::vector<std::string> ownedNames,
+                                          std::vector<std::string> getNames) {
+    return std::make_unique<TypedComponentGroup<Owned, Get>>(registry, std::move(ownedNames),
+                                                             std::move(getNames));
+}
+
+// the owning group layouts the managed side can declare, keyed by the owned and then the get
+// component names, each sorted, the names within the type lists have to follow the same order
+// a layout needs its own instantiation, so add it here before declaring it
+static const std::unordered_map<std::string, GroupFactoryFn> g_group_factories = {
+    {"Material,Mesh,Transform|",
+     &makeGroup<entt::type_list<Material, Mesh, Transform>, entt::type_list<>>},
+    {"Velocity|Transform", &makeGroup<entt::type_list<Velocity>, entt::type_list<Transform>>},
+    {"Transform,Velocity|", &makeGroup<entt::type_list<Transform, Velocity>, entt::type_list<>>},
+    {"Mesh,Transform,Velocity|",
+     &makeGroup<entt::type_list<Mesh, Transform, Velocity>, entt::type_list<>>},
 };
 
-static const std::unordered_map<std::string, IteratorFn> g_storage_iterators = {
-    {"Transform",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<Transform>());
-     }},
-     {"iCamera",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<iCamera>());
-     }},
-    {"Velocity",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<Velocity>());
-     }},
-    {"Player",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<Player>());
-     }},
-    {"Mesh",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<Mesh>());
-     }},
-    {"Material",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<Material>());
-     }},
-    {"GameStats",
-     [](entt::runtime_view &view) {
-         view.iterate(RuntimeBridge::getRuntimeApplication().registry.storage<GameStats>());
-     }},
+namespace {
+// the chunk size a group is walked in, independent of the chunk size of the system
+constexpr size_t kGroupChunkSize = 256;
+// the entities of a parallel per-entity system are split into batches of this many, a parallel
+// chunked system's batches are its chunks
+constexpr size_t kParallelBatchSize = 1024;
+// the entity itself, handed over like a component (the managed Entity holds its id) but no
+// component of the registry, so it takes no part in the kernel, the groups or the access
+constexpr std::string_view kEntityName = "Entity";
+// the components of a kernel, and the entity
+constexpr size_t kMaxQuerySize = QueryKernels::kMaxArity + 1;
+
+using ChunkFn = void (*)(void *context, size_t entityCount);
+
+// a system's query, resolved once at registration, with the buffers its dispatch reuses every
+// frame
+struct SystemQuery {
+    std::vector<std::string> names;
+    // the type id of every component, in the order of the query, -1 for the entity
+    std::vector<int> componentIndices;
+    // the query position of the entity, -1 if it isn't queried
+    int entityPosition = -1;
+    QueryKernels::KernelFn kernel = nullptr;
+    QueryKernels::Filter filter;
+    // the kernel gets the components in the queryable order, this is the query position of each
+    std::vector<size_t> kernelSlots;
+    size_t chunkSize = 1;
+
+    // component i of the n-th entity of a chunk is at pointers[i * chunkSize + n]
+    std::vector<void *> pointers;
+    std::vector<void **> componentArrays;
+    // the entities of a chunk, the entity's pointers always point into it
+    std::vector<entt::entity> entities;
+
+    // a chunk of the group the query walks, when it matches one
+    std::vector<entt::entity> groupEntities;
+    std::vector<void *> groupPointers;
+    // the slot of every queried component within the group, -1 for the ones it doesn't cover
+    std::vector<int> groupSlots;
+    struct RestComponent {
+        size_t position;
+        entt::sparse_set *storage;
+        ComponentRegistry::GetterFn get;
+    };
+    std::vector<RestComponent> restComponents;
+
+    // every entity of the query, one array per component, for the systems split into batches
+    std::vector<std::vector<void *>> gatheredComponents;
+    std::vector<entt::entity> gatheredEntities;
 };
 
+// the names come from the managed side, a system it registers with a query the host can't walk
+// is logged and left out instead of being run
+void _refuseSystem(const char *systemName, std::string_view reason) {
+    g_logger->error("The system {} is not registered, {}", systemName, reason);
+}
+
+// nullptr, refused, for a query the host has no kernel for
+std::shared_ptr<SystemQuery> _resolveQuery(const char *systemName, int count,
+                                           const char *const *names, size_t chunkSize) {
+    if (count <= 0 || static_cast<size_t>(count) > kMaxQuerySize) {
+        _refuseSystem(systemName, "its query has no or too many components");
+        return nullptr;
+    }
+
+    auto &app        = RuntimeBridge::getRuntimeApplication();
+    auto query       = std::make_shared<SystemQuery>();
+    query->chunkSize = chunkSize;
+    uint32_t mask    = 0;
+    for (int i = 0; i < count; ++i) {
+        query->names.emplace_back(names[i]);
+        if (query->names.back() == kEntityName) {
+            if (query->entityPosition >= 0) {
+                _refuseSystem(systemName, "its query names the entity twice");
+                return nullptr;
+            }
+            query->entityPosition = i;
+            query->componentIndices.push_back(-1);
+            continue;
+        }
+
+        int const componentIndex = ComponentRegistry::getTypeId(names[i]);
+        if (componentIndex < 0) {
+            _refuseSystem(systemName, app.findRuntimeComponent(names[i]) >= 0
+                                          ? "a runtime component can only filter its query"
+                                          : "its query names an unknown component");
+            return nullptr;
+        }
+        if ((mask & (1U << componentIndex)) != 0) {
+            _refuseSystem(systemName, "its query names a component twice");
+            return nullptr;
+        }
+        query->componentIndices.push_back(componentIndex);
+        mask |= 1U << componentIndex;
+        // the registry creates a storage the first time it's asked for, which must not happen
+        // while other systems look theirs up concurrently
+        ComponentRegistry::getStorage(app.registry, componentIndex);
+    }
+    // e.g. a query of the entity alone
+    query->kernel = QueryKernels::getKernel(mask);
+    if (query->kernel == nullptr) {
+        _refuseSystem(systemName, "no kernel walks the components of its query");
+        return nullptr;
+    }
+
+    query->kernelSlots.resize(count);
+    std::iota(query->kernelSlots.begin(), query->kernelSlots.end(), 0);
+    std::sort(query->kernelSlots.begin(), query->kernelSlots.end(), [&](size_t a, size_t b) {
+        return query->componentIndices[a] < query->componentIndices[b];
+    });
+    // the entity sorts first
+    if (query->entityPosition >= 0) {
+        query->kernelSlots.erase(query->kernelSlots.begin());
+    }
+
+    query->pointers.resize(count * chunkSize);
+    query->componentArrays.resize(count);
+    for (int i = 0; i < count; ++i) {
+        query->componentArrays[i] = query->pointers.data() + i * chunkSize;
+    }
+    if (query->entityPosition >= 0) {
+        query->entities.resize(chunkSize);
+        for (size_t n = 0; n < chunkSize; ++n) {
+            query->componentArrays[query->entityPosition][n] = &query->entities[n];
+        }
+    }
+    return query;
+}
+
+// the first of the filterCount names are required, the last excludedCount excluded, each a tag or
+// a component, they are neither handed over nor part of the access: which entities have them
+// only changes at sync points
+// every query skips disabled entities, unless it requires them to be
+// returns false, the system refused, for a name that is neither a tag nor a component
+bool _resolveFilter(const char *systemName, SystemQuery &query, int filterCount,
+                    const char *const *filterNames, int excludedCount) {
+    if (filterCount < 0 || excludedCount < 0 || excludedCount > filterCount ||
+        (filterCount > 0 && filterNames == nullptr)) {
+        _refuseSystem(systemName, "its filter counts don't add up");
+        return false;
+    }
+    auto &app = RuntimeBridge::getRuntimeApplication();
+
+    for (int i = 0; i < filterCount; ++i) {
+        entt::sparse_set const *storage = nullptr;
+        if (int const tagId = app.findTag(filterNames[i]); tagId >= 0) {
+            storage = &app.getTagStorage(tagId);
+        } else if (int const typeId = app.findRuntimeComponent(filterNames[i]); typeId >= 0) {
+            storage = &app.getRuntimeComponent(typeId)->getEntities();
+        } else {
+            int const componentIndex = ComponentRegistry::getTypeId(filterNames[i]);
+            if (componentIndex < 0) {
+                _refuseSystem(systemName, "its filter names an unknown tag or component");
+                return false;
+            }
+            storage = &ComponentRegistry::getStorage(app.registry, componentIndex);
+        }
+        (i < filterCount - excludedCount ? query.filter.required : query.filter.excluded)
+            .push_back(storage);
+    }
+
+    entt::sparse_set const *disabled = &app.getTagStorage(RuntimeApplication::kDisabledTag);
+    auto const &required             = query.filter.required;
+    if (std::find(required.begin(), required.end(), disabled) == required.end()) {
+        query.filter.excluded.push_back(disabled);
+    }
+    return true;
+}
+
+// walks the group for the components it covers, the rest are checked and fetched per entity,
+// false without walking when one of those is in fewer entities than the group
+bool _walkGroup(SystemQuery &query, ComponentGroup &group, ChunkFn onChunk, void *context) {
+    auto &registry         = RuntimeBridge::getRuntimeApplication().registry;
+    auto const &groupNames = group.getComponentNames();
+    size_t const count     = query.names.size();
+
+    query.groupSlots.assign(count, -1);
+    query.restComponents.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (static_cast<int>(i) == query.entityPosition) {
+            continue;
+        }
+        auto it = std::find(groupNames.begin(), groupNames.end(), query.names[i]);
+        if (it != groupNames.end()) {
+            query.groupSlots[i] = static_cast<int>(it - groupNames.begin());
+            continue;
+        }
+        int const componentIndex = query.componentIndices[i];
+        auto &storage            = ComponentRegistry::getStorage(registry, componentIndex);
+        // e.g. the single player among all the entities with a velocity
+        if (storage.size() < group.size()) {
+            return false;
+        }
+        query.restComponents.push_back(
+            {i, &storage, ComponentRegistry::getInfo(componentIndex).getComponent});
+    }
+
+    size_t const chunk = query.chunkSize;
+    size_t entityCount = 0;
+    query.groupEntities.resize(kGroupChunkSize);
+    query.groupPointers.resize(groupNames.size() * kGroupChunkSize);
+    auto const onGroupChunk = [&](size_t groupCount) {
+        for (size_t n = 0; n < groupCount; ++n) {
+            entt::entity const e = query.groupEntities[n];
+            bool const hasRest   = std::all_of(
+                query.restComponents.begin(), query.restComponents.end(),
+                [e](SystemQuery::RestComponent const &rest) { return rest.storage->contains(e); });
+            if (!hasRest || !query.filter.isPassing(e)) {
+                continue;
+            }
+            if (query.entityPosition >= 0) {
+                query.entities[entityCount] = e;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                if (query.groupSlots[i] >= 0) {
+                    query.pointers[i * chunk + entityCount] =
+                        query.groupPointers[query.groupSlots[i] * kGroupChunkSize + n];
+                }
+            }
+            for (auto const &rest : query.restComponents) {
+                query.pointers[rest.position * chunk + entityCount] = rest.get(*rest.storage, e);
+            }
+            if (++entityCount == chunk) {
+                onChunk(context, entityCount);
+                entityCount = 0;
+            }
+        }
+    };
+    group.eachChunk(kGroupChunkSize, query.groupEntities.data(), query.groupPointers.data(),
+                    onGroupChunk);
+    if (entityCount > 0) {
+        onChunk(context, entityCount);
+    }
+    return true;
+}
+
+// gathers the query's entities chunk by chunk into query.pointers and calls onChunk with the
+// number of entities in each
+// a declared group covering the query (or part of it) is walked in its packed order, otherwise
+// the query's kernel walks the smallest of its storages
+void _dispatch(SystemQuery &query, ChunkFn onChunk, void *context) {
+    auto &app = RuntimeBridge::getRuntimeApplication();
+
+    ComponentGroup *group = app.isOwningGroupsEnabled() ? app.findGroup(query.names) : nullptr;
+    if (group != nullptr && _walkGroup(query, *group, onChunk, context)) {
+        return;
+    }
+
+    QueryKernels::Chunk chunk{};
+    chunk.size       = query.chunkSize;
+    chunk.components = query.pointers.data();
+    chunk.slots      = query.kernelSlots.data();
+    chunk.entities   = query.entityPosition >= 0 ? query.entities.data() : nullptr;
+    chunk.filter     = &query.filter;
+    chunk.onChunk    = onChunk;
+    chunk.context    = context;
+    query.kernel(app.registry, chunk);
+}
+
+// collects every entity of the query into query.gatheredComponents and returns their number
+// the order is the one _dispatch walks them in, so the batches of a parallel system are the same
+// for every thread count
+size_t _gather(SystemQuery &query) {
+    query.gatheredComponents.resize(query.names.size());
+    for (auto &componentPointers : query.gatheredComponents) {
+        componentPointers.clear();
+    }
+    query.gatheredEntities.clear();
+    _dispatch(
+        query,
+        [](void *context, size_t entityCount) {
+            auto &query = *static_cast<SystemQuery *>(context);
+            if (query.entityPosition >= 0) {
+                query.gatheredEntities.insert(query.gatheredEntities.end(), query.entities.begin(),
+                                              query.entities.begin() + entityCount);
+            }
+            for (size_t i = 0; i < query.gatheredComponents.size(); ++i) {
+                if (static_cast<int>(i) == query.entityPosition) {
+                    continue;
+                }
+                auto const *chunkPointers = query.pointers.data() + i * query.chunkSize;
+                query.gatheredComponents[i].insert(query.gatheredComponents[i].end(),
+                                                   chunkPointers, chunkPointers + entityCount);
+            }
+        },
+        &query);
+
+    // once every entity is in, so they no longer move
+    if (query.entityPosition >= 0) {
+        auto &entityPointers = query.gatheredComponents[query.entityPosition];
+        for (auto &entity : query.gatheredEntities) {
+            entityPointers.push_back(&entity);
+        }
+        return query.gatheredEntities.size();
+    }
+    // _resolveQuery refuses a query without a kernel, so one of the entity alone, every query
+    // gathered here has a component slot
+    return query.gatheredComponents[query.kernelSlots.front()].size();
+}
+
+// the components before the last readOnlyCount ones of the query are written, readOnlyCount is
+// checked by _isReadOnlyCountValid
+SystemScheduler::Access _resolveAccess(SystemQuery const &query, int readOnlyCount,
+                                       bool isExclusive) {
+
+    SystemScheduler::Access access{};
+    size_t const writtenCount = query.names.size() - static_cast<size_t>(readOnlyCount);
+    for (size_t i = 0; i < query.componentIndices.size(); ++i) {
+        if (query.componentIndices[i] < 0) {
+            continue;
+        }
+        uint32_t const bit = 1U << query.componentIndices[i];
+        (i < writtenCount ? access.writeMask : access.readMask) |= bit;
+    }
+    access.isExclusive = isExclusive;
+    return access;
+}
+
+bool _isReadOnlyCountValid(const char *systemName, SystemQuery const &query, int readOnlyCount) {
+    if (readOnlyCount < 0 || static_cast<size_t>(readOnlyCount) > query.names.size()) {
+        _refuseSystem(systemName, "it reads more components than it queries");
+        return false;
+    }
+    return true;
+}
+
+// managed entity ids are the registry's, as they are
+static_assert(sizeof(entt::entity) == sizeof(uint32_t));
+} // namespace
+
 void HostRegisterStartup(void (*sys)()) {
     RuntimeBridge::getRuntimeApplication().add_startup_system(sys);
 }
@@ -159,61 +491,275 @@ void HostRegisterUpdate(void (*sys)(float)) {
 }
 
 uint32_t CreateEntity() {
-    return (uint32_t)RuntimeBridge::getRuntimeApplication().registry.create();
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    if (SystemScheduler::isInSystem()) {
+        return static_cast<uint32_t>(app.getEntityCommands().create(app.registry));
+    }
+    return static_cast<uint32_t>(app.registry.create());
 }
 
-void AddTransform(uint32_t e, Transform t) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<Transform>(entt::entity{e},
-                                                                                  t);
-}
-void AddCamera(uint32_t e, iCamera c) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<iCamera>(entt::entity{e},
-                                                                                  c);
-}
-void AddVelocity(uint32_t e, Velocity v) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<Velocity>(entt::entity{e},
-                                                                                 v);
+// fills outIds with count new entities, in one call
+void HostCreateEntities(int count, uint32_t *outIds) {
+    assert(count >= 0 && (count == 0 || outIds != nullptr));
+    auto &app   = RuntimeBridge::getRuntimeApplication();
+    auto *first = reinterpret_cast<entt::entity *>(outIds);
+    if (SystemScheduler::isInSystem()) {
+        app.getEntityCommands().create(app.registry, first, first + count);
+    } else {
+        app.registry.create(first, first + count);
+    }
 }
-void AddPlayer(uint32_t e, Player p) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<Player>(entt::entity{e}, p);
+
+// the type id of the managed struct of that name, -1 when its size and alignment differ from the
+// ones of the host's type of that name, the layout is all the host knows of it
+// a struct the host has no type for gets a storage of its own made from that layout, see
+// RuntimeComponentStorage, registered before the queries that filter by it
+int HostRegisterComponent(const char *name, int size, int alignment) {
+    assert(size > 0 && alignment > 0);
+    // queried like a component, but none
+    if (name == kEntityName) {
+        return -1;
+    }
+    int const typeId = ComponentRegistry::getTypeId(name);
+    if (typeId < 0) {
+        return RuntimeBridge::getRuntimeApplication().registerRuntimeComponent(
+            name, static_cast<size_t>(size), static_cast<size_t>(alignment));
+    }
+    auto const &info = ComponentRegistry::getInfo(typeId);
+    bool const isMatching =
+        info.size == static_cast<size_t>(size) && info.alignment == static_cast<size_t>(alignment);
+    return isMatching ? typeId : -1;
 }
-void AddMesh(uint32_t e, Mesh m) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<Mesh>(entt::entity{e}, m);
+
+// applied right away outside of the update systems, e.g. from a startup system, recorded into
+// the calling thread's command buffer from within one, where the registry may be walked
+// the entity gets a copy of component, replacing the one it has
+void HostAddComponent(int typeId, uint32_t entityId, const void *component) {
+    auto &app    = RuntimeBridge::getRuntimeApplication();
+    auto *buffer = SystemScheduler::isInSystem() ? &app.getEntityCommands().getThreadBuffer()
+                                                 : nullptr;
+    if (auto *runtimeComponent = app.getRuntimeComponent(typeId)) {
+        if (buffer != nullptr) {
+            buffer->addRuntimeComponent(*runtimeComponent, entt::entity{entityId}, component);
+        } else {
+            runtimeComponent->assign(entt::entity{entityId}, component);
+        }
+        return;
+    }
+
+    auto const &info = ComponentRegistry::getInfo(typeId);
+    if (buffer != nullptr) {
+        info.recordAssign(*buffer, entt::entity{entityId}, component);
+    } else {
+        info.assign(app.registry, entt::entity{entityId}, component);
+    }
 }
-void AddMaterial(uint32_t e, Material m) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<Material>(entt::entity{e},
-                                                                                 m);
+
+void HostRemoveComponent(int typeId, uint32_t entityId) {
+    auto &app              = RuntimeBridge::getRuntimeApplication();
+    auto *runtimeComponent = app.getRuntimeComponent(typeId);
+    if (SystemScheduler::isInSystem()) {
+        auto &buffer = app.getEntityCommands().getThreadBuffer();
+        if (runtimeComponent != nullptr) {
+            buffer.removeRuntimeComponent(*runtimeComponent, entt::entity{entityId});
+        } else {
+            ComponentRegistry::getInfo(typeId).recordRemove(buffer, entt::entity{entityId});
+        }
+    } else if (runtimeComponent != nullptr) {
+        runtimeComponent->getEntities().remove(entt::entity{entityId});
+    } else {
+        ComponentRegistry::getStorage(app.registry, typeId).remove(entt::entity{entityId});
+    }
 }
-void AddGameStats(uint32_t e, GameStats g) {
-    RuntimeBridge::getRuntimeApplication().registry.emplace_or_replace<GameStats>(entt::entity{e},
-                                                                                 g);
+
+// the entity's component, nullptr if it has none, valid until the next structural change to the
+// storage, from an update system only for a component its query accesses
+void *HostGetComponent(int typeId, uint32_t entityId) {
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    if (auto *runtimeComponent = app.getRuntimeComponent(typeId)) {
+        return runtimeComponent->get(entt::entity{entityId});
+    }
+    auto &storage = ComponentRegistry::getStorage(app.registry, typeId);
+    if (!storage.contains(entt::entity{entityId})) {
+        return nullptr;
+    }
+    return ComponentRegistry::getInfo(typeId).getComponent(storage, entt::entity{entityId});
 }
 
-void HostRemoveComponentTransform(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<Transform>(entt::entity{entityId});
+// the type-erased storage of a component: returns the table of its pages and sets count, pageSize
+// and entities, the i-th of the count components, the one of entities[i], is at
+// pages[i / pageSize][i % pageSize]
+// the registry splits the host's types into pages, the values of a component the host has no type
+// for are packed into a single one
+// valid until the next structural change to the component, which from an update system is the
+// next sync point
+void *const *HostGetStorage(int typeId, int *count, int *pageSize, const uint32_t **entities) {
+    assert(count != nullptr && pageSize != nullptr && entities != nullptr);
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    *count    = 0;
+    *pageSize = 1;
+    *entities = nullptr;
+    if (!app.isComponentTypeId(typeId)) {
+        g_logger->error("There's no storage of the unknown component type {}", typeId);
+        return nullptr;
+    }
+
+    if (auto *runtimeComponent = app.getRuntimeComponent(typeId)) {
+        *count    = static_cast<int>(runtimeComponent->getCount());
+        *pageSize = std::max(*count, 1);
+        *entities = reinterpret_cast<const uint32_t *>(runtimeComponent->getEntities().data());
+        return runtimeComponent->getPages();
+    }
+    auto &storage    = ComponentRegistry::getStorage(app.registry, typeId);
+    auto const &info = ComponentRegistry::getInfo(typeId);
+    *count           = static_cast<int>(storage.size());
+    *pageSize        = static_cast<int>(info.pageSize);
+    *entities        = reinterpret_cast<const uint32_t *>(storage.data());
+    return info.getPages(storage);
 }
 
-void HostRemoveComponentCamera(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<iCamera>(entt::entity{entityId});
+// entityIds[i] gets the i-th of the count components laid out contiguously at components, the
+// entities must not have the component yet, e.g. just created ones, one insert of the whole range
+// into the storage instead of an emplace per entity
+void HostAddComponentsBulk(int typeId, const uint32_t *entityIds, const void *components,
+                           int count) {
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    if (!app.isComponentTypeId(typeId) || count < 0) {
+        g_logger->error("A bulk add of {} components of the type {} is ignored", count, typeId);
+        return;
+    }
+    auto const *entities = reinterpret_cast<entt::entity const *>(entityIds);
+    auto const *values   = static_cast<std::byte const *>(components);
+    // its values go one by one, there's no typed range to insert
+    if (auto *runtimeComponent = app.getRuntimeComponent(typeId)) {
+        size_t const size = runtimeComponent->getSize();
+        auto *buffer = SystemScheduler::isInSystem() ? &app.getEntityCommands().getThreadBuffer()
+                                                     : nullptr;
+        for (int i = 0; i < count; ++i) {
+            if (buffer != nullptr) {
+                buffer->addRuntimeComponent(*runtimeComponent, entities[i], values + i * size);
+            } else {
+                runtimeComponent->assign(entities[i], values + i * size);
+            }
+        }
+        return;
+    }
+
+    auto const &info = ComponentRegistry::getInfo(typeId);
+    if (SystemScheduler::isInSystem()) {
+        auto &buffer = app.getEntityCommands().getThreadBuffer();
+        for (int i = 0; i < count; ++i) {
+            info.recordAssign(buffer, entities[i], values + i * info.size);
+        }
+        return;
+    }
+
+    auto &storage = ComponentRegistry::getStorage(app.registry, typeId);
+    assert(std::none_of(entities, entities + count,
+                        [&storage](entt::entity e) { return storage.contains(e); }) &&
+           "Bulk add of a component an entity already has");
+    info.insert(app.registry, entities, static_cast<size_t>(count), components);
 }
 
-void HostRemoveComponentVelocity(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<Velocity>(entt::entity{entityId});
+// components[k] is the value of the component of type typeIds[k], returns the id of the prefab,
+// -1 when it names a type the host doesn't know
+// prefabs are registered up front, e.g. from a startup system, not from update systems
+int HostRegisterPrefab(int count, const int *typeIds, const void *const *components) {
+    assert(!SystemScheduler::isInSystem() && "Prefab registered from an update system");
+    if (count <= 0 || typeIds == nullptr || components == nullptr) {
+        g_logger->error("A prefab without components is not registered");
+        return -1;
+    }
+    auto &app   = RuntimeBridge::getRuntimeApplication();
+    auto prefab = std::make_unique<Prefab>();
+    for (int k = 0; k < count; ++k) {
+        if (!app.isComponentTypeId(typeIds[k])) {
+            g_logger->error("A prefab of the unknown component type {} is not registered",
+                            typeIds[k]);
+            return -1;
+        }
+        if (auto *runtimeComponent = app.getRuntimeComponent(typeIds[k])) {
+            prefab->setRuntimeComponent(typeIds[k], *runtimeComponent, components[k]);
+        } else {
+            prefab->setComponent(typeIds[k], components[k]);
+        }
+    }
+    return app.addPrefab(std::move(prefab));
 }
-void HostRemoveComponentPlayer(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<Player>(entt::entity{entityId});
+
+// count new entities with the components of the prefab, overridden by the overrideCount
+// overrides, their ids go to outIds unless it's nullptr
+void HostInstantiatePrefab(int prefabId, int count, const PrefabOverride *overrides,
+                           int overrideCount, uint32_t *outIds) {
+    auto &app            = RuntimeBridge::getRuntimeApplication();
+    Prefab const *prefab = app.getPrefab(prefabId);
+    if (prefab == nullptr || count < 0) {
+        g_logger->error("{} instances of the unknown prefab {} not made", count, prefabId);
+        return;
+    }
+    if (overrideCount < 0 || (overrideCount > 0 && overrides == nullptr)) {
+        g_logger->error("Instances of the prefab {} not made, its overrides are missing", prefabId);
+        return;
+    }
+    for (int k = 0; k < overrideCount; ++k) {
+        if (!prefab->isOverridable(overrides[k])) {
+            g_logger->error("Instances of the prefab {} not made, it has no component of the type "
+                            "{} to override at the offset {}",
+                            prefabId, overrides[k].typeId, overrides[k].offset);
+            return;
+        }
+    }
+
+    std::vector<entt::entity> ownEntities;
+    auto *entities = reinterpret_cast<entt::entity *>(outIds);
+    if (entities == nullptr) {
+        ownEntities.resize(count);
+        entities = ownEntities.data();
+    }
+
+    if (SystemScheduler::isInSystem()) {
+        auto &commands = app.getEntityCommands();
+        commands.create(app.registry, entities, entities + count);
+        prefab->record(commands.getThreadBuffer(), entities, count, overrides, overrideCount);
+    } else {
+        app.registry.create(entities, entities + count);
+        prefab->instantiate(app.registry, entities, count, overrides, overrideCount);
+    }
 }
-void HostRemoveComponentMesh(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<Mesh>(entt::entity{entityId});
+
+void HostDestroyEntity(uint32_t entityId) {
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    if (SystemScheduler::isInSystem()) {
+        app.getEntityCommands().getThreadBuffer().destroy(entt::entity{entityId});
+    } else {
+        app.registry.destroy(entt::entity{entityId});
+    }
 }
-void HostRemoveComponentMaterial(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<Material>(entt::entity{entityId});
+
+// registered before the systems whose queries name it, the same id for the same name
+int HostRegisterTag(const char *name) {
+    assert(!SystemScheduler::isInSystem() && "Tag registered from an update system");
+    return RuntimeBridge::getRuntimeApplication().registerTag(name);
 }
-void HostRemoveComponentGameStats(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.remove<GameStats>(entt::entity{entityId});
+
+void HostAddTag(int tagId, uint32_t entityId) {
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    auto &tag = app.getTagStorage(tagId);
+    if (SystemScheduler::isInSystem()) {
+        app.getEntityCommands().getThreadBuffer().addTag(tag, entt::entity{entityId});
+    } else if (!tag.contains(entt::entity{entityId})) {
+        tag.emplace(entt::entity{entityId});
+    }
 }
-void HostDestroyEntity(uint32_t entityId) {
-    RuntimeBridge::getRuntimeApplication().registry.destroy(entt::entity{entityId});
+
+void HostRemoveTag(int tagId, uint32_t entityId) {
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    auto &tag = app.getTagStorage(tagId);
+    if (SystemScheduler::isInSystem()) {
+        app.getEntityCommands().getThreadBuffer().removeTag(tag, entt::entity{entityId});
+    } else {
+        tag.remove(entt::entity{entityId});
+    }
 }
 
 // Add keyboard input function
@@ -246,74 +792,197 @@ void GetMouseDelta(float* dx, float* dy) {
     *dy = mouseDelta.second;
 }
 
-void HostRegisterPerEntityUpdate(ManagedPerEntityFn fn, int count, const char *const *names) {
-    assert(fn && count > 0);
+// the last readOnlyCount components of the query are only read, the system runs concurrently with
+// the others that don't write them and don't write or read the ones it writes, flags are
+// SystemFlags
+// only the entities that have every one of the first filterCount - excludedCount filter names and
+// none of the rest are handed over, see _resolveFilter
+// a parallel system is called from several threads at once, with disjoint entities
+void HostRegisterPerEntityUpdate(ManagedPerEntityFn fn, int count, const char *const *names,
+                                 int readOnlyCount, int filterCount,
+                                 const char *const *filterNames, int excludedCount,
+                                 const char *systemName, int flags) {
+    assert(fn);
+    auto &app = RuntimeBridge::getRuntimeApplication();
+
+    if ((flags & kSystemParallel) != 0) {
+        auto query = _resolveQuery(systemName, count, names, kParallelBatchSize);
+        if (query == nullptr ||
+            !_resolveFilter(systemName, *query, filterCount, filterNames, excludedCount) ||
+            !_isReadOnlyCountValid(systemName, *query, readOnlyCount)) {
+            return;
+        }
+        auto access = _resolveAccess(*query, readOnlyCount, (flags & kSystemExclusive) != 0);
 
-    // build per‐system vectors of getters + storage‐iterators:
-    std::vector<GetterFn> getters;
-    getters.reserve(count);
-    std::vector<IteratorFn> iters;
-    iters.reserve(count);
+        app.add_update_system(systemName, access, [=](float dt) {
+            size_t const entityCount = _gather(*query);
+            size_t const batchCount  = (entityCount + kParallelBatchSize - 1) / kParallelBatchSize;
+            RuntimeBridge::getRuntimeApplication().parallelFor(batchCount, [&](size_t batch) {
+                size_t const end = std::min(entityCount, (batch + 1) * kParallelBatchSize);
+                std::array<void *, kMaxQuerySize> components{};
+                for (size_t e = batch * kParallelBatchSize; e < end; ++e) {
+                    for (int i = 0; i < count; ++i) {
+                        components[i] = query->gatheredComponents[i][e];
+                    }
+                    fn(dt, components.data());
+                }
+            });
+        });
+        return;
+    }
 
-    for (int i = 0; i < count; ++i) {
-        auto &nm = names[i];
-        auto git = g_getters.find(nm);
-        auto iit = g_storage_iterators.find(nm);
-        assert(git != g_getters.end() && "Unknown component for getter");
-        assert(iit != g_storage_iterators.end() && "Unknown component for iterator");
-        getters.push_back(git->second);
-        iters.push_back(iit->second);
+    // a chunk of one entity is laid out as one pointer per component
+    auto query = _resolveQuery(systemName, count, names, 1);
+    if (query == nullptr ||
+        !_resolveFilter(systemName, *query, filterCount, filterNames, excludedCount) ||
+        !_isReadOnlyCountValid(systemName, *query, readOnlyCount)) {
+        return;
     }
+    auto access = _resolveAccess(*query, readOnlyCount, (flags & kSystemExclusive) != 0);
+
+    struct Call {
+        ManagedPerEntityFn fn;
+        float dt;
+        void **components;
+    };
 
     // register one native update‐system lambda
-    RuntimeBridge::getRuntimeApplication().add_update_system([=](float dt) {
-        // 1) build the dynamic view
-        entt::runtime_view view{};
-        for (auto &iter : iters) {
-            iter(view);
-        }
+    app.add_update_system(systemName, access, [=](float dt) {
+        Call call{fn, dt, query->pointers.data()};
+        // single P/Invoke per entity
+        _dispatch(
+            *query,
+            [](void *context, size_t) {
+                auto const *call = static_cast<Call const *>(context);
+                call->fn(call->dt, call->components);
+            },
+            &call);
+    });
+}
 
-        // 2) per‐entity call
-        std::vector<void *> ptrs(count);
-        for (auto e : view) {
-            for (int i = 0; i < count; ++i) {
-                ptrs[i] = getters[i](RuntimeBridge::getRuntimeApplication().registry, e);
-            }
-            // single P/Invoke for this entity
-            fn(dt, ptrs.data());
-        }
+// the same query as HostRegisterPerEntityUpdate, but the managed system is called once per chunk of
+// up to chunkSize entities instead of once per entity, which is one unmanaged-to-managed
+// transition per chunk
+// the pointers of a chunk are gathered before the call, which is one reason the entities and
+// components a system adds or removes only take effect at the next sync point, their storage is
+// packed and would move the ones it is handed
+void HostRegisterChunkedUpdate(ManagedChunkFn fn, int count, const char *const *names,
+                               int chunkSize, int readOnlyCount, int filterCount,
+                               const char *const *filterNames, int excludedCount,
+                               const char *systemName, int flags) {
+    assert(fn);
+    auto &app = RuntimeBridge::getRuntimeApplication();
+    if (chunkSize <= 0) {
+        _refuseSystem(systemName, "its chunk size isn't positive");
+        return;
+    }
+
+    auto query = _resolveQuery(systemName, count, names, static_cast<size_t>(chunkSize));
+    if (query == nullptr ||
+        !_resolveFilter(systemName, *query, filterCount, filterNames, excludedCount) ||
+        !_isReadOnlyCountValid(systemName, *query, readOnlyCount)) {
+        return;
+    }
+    auto access = _resolveAccess(*query, readOnlyCount, (flags & kSystemExclusive) != 0);
+
+    if ((flags & kSystemParallel) != 0) {
+        app.add_update_system(systemName, access, [=](float dt) {
+            size_t const entityCount = _gather(*query);
+            size_t const size        = query->chunkSize;
+            RuntimeBridge::getRuntimeApplication().parallelFor(
+                (entityCount + size - 1) / size, [&](size_t chunk) {
+                    size_t const begin = chunk * size;
+                    size_t const end   = std::min(entityCount, begin + size);
+                    std::array<void **, kMaxQuerySize> componentArrays{};
+                    for (int i = 0; i < count; ++i) {
+                        componentArrays[i] = query->gatheredComponents[i].data() + begin;
+                    }
+                    fn(dt, static_cast<int>(end - begin), componentArrays.data());
+                });
+        });
+        return;
+    }
+
+    struct Call {
+        ManagedChunkFn fn;
+        float dt;
+        void ***componentArrays;
+    };
+
+    app.add_update_system(systemName, access, [=](float dt) {
+        Call call{fn, dt, query->componentArrays.data()};
+        _dispatch(
+            *query,
+            [](void *context, size_t entityCount) {
+                auto const *call = static_cast<Call const *>(context);
+                call->fn(call->dt, static_cast<int>(entityCount), call->componentArrays);
+            },
+            &call);
     });
 }
 
+namespace {
+std::string _joinSorted(int count, const char *const *names) {
+    std::vector<std::string> sortedNames(names, names + count);
+    std::sort(sortedNames.begin(), sortedNames.end());
+    std::string joined;
+    for (auto const &name : sortedNames) {
+        joined += (joined.empty() ? "" : ",") + name;
+    }
+    return joined;
+}
+} // namespace
+
+// declares an owning group, before the systems querying it run for the first time
+void HostDeclareGroup(int ownedCount, const char *const *owned, int getCount,
+                      const char *const *get) {
+    auto &app             = RuntimeBridge::getRuntimeApplication();
+    std::string const key = _joinSorted(ownedCount, owned) + "|" + _joinSorted(getCount, get);
+    if (!app.isOwningGroupsEnabled()) {
+        g_logger->warn("Owning groups are disabled, ignored the group {}", key);
+        return;
+    }
+
+    auto it = g_group_factories.find(key);
+    if (it == g_group_factories.end()) {
+        g_logger->error("No owning group layout {}, add it to g_group_factories", key);
+        return;
+    }
+
+    // the factory's type lists are sorted like the key
+    std::vector<std::string> ownedNames(owned, owned + ownedCount);
+    std::vector<std::string> getNames(get, get + getCount);
+    std::sort(ownedNames.begin(), ownedNames.end());
+    std::sort(getNames.begin(), getNames.end());
+    if (!app.addGroup(it->second(app.registry, std::move(ownedNames), std::move(getNames)))) {
+        g_logger->error("The owning group {} owns a component another group already owns, ignored",
+                        key);
+    }
+}
+
 extern "C" {
 __declspec(dllexport) __declspec(dllexport) void *__cdecl HostGetProcAddress(char const *name) {
     if (std::strcmp(name, "CreateEntity") == 0) return (void *)&CreateEntity;
-    if (std::strcmp(name, "AddTransform") == 0) return (void *)&AddTransform;
     if (std::strcmp(name, "HostRegisterStartup") == 0) return (void *)&HostRegisterStartup;
     if (std::strcmp(name, "HostRegisterUpdate") == 0) return (void *)&HostRegisterUpdate;
-    if (std::strcmp(name, "AddTransform") == 0) return (void *)&AddTransform;
-    if (std::strcmp(name, "AddCamera") == 0) return (void *)&AddCamera;
-    if (std::strcmp(name, "AddVelocity") == 0) return (void *)&AddVelocity;
-    if (std::strcmp(name, "AddPlayer") == 0) return (void *)&AddPlayer;
-    if (std::strcmp(name, "AddMesh") == 0) return (void *)&AddMesh;
-    if (std::strcmp(name, "AddMaterial") == 0) return (void *)&AddMaterial;
-    if (std::strcmp(name, "AddGameStats") == 0) return (void *)&AddGameStats;
-    if (std::strcmp(name, "HostRemoveComponentTransform") == 0)
-        return (void *)&HostRemoveComponentTransform;
-    if (std::strcmp(name, "HostRemoveComponentCamera") == 0)
-        return (void *)&HostRemoveComponentCamera;
-    if (std::strcmp(name, "HostRemoveComponentVelocity") == 0)
-        return (void *)&HostRemoveComponentVelocity;
-    if (std::strcmp(name, "HostRemoveComponentPlayer") == 0)
-        return (void *)&HostRemoveComponentPlayer;
-    if (std::strcmp(name, "HostRemoveComponentMesh") == 0) return (void *)&HostRemoveComponentMesh;
-    if (std::strcmp(name, "HostRemoveComponentMaterial") == 0)
-        return (void *)&HostRemoveComponentMaterial;
-    if (std::strcmp(name, "HostRemoveComponentGameStats") == 0)
-        return (void *)&HostRemoveComponentGameStats;
+    if (std::strcmp(name, "HostRegisterComponent") == 0) return (void *)&HostRegisterComponent;
+    if (std::strcmp(name, "HostAddComponent") == 0) return (void *)&HostAddComponent;
+    if (std::strcmp(name, "HostRemoveComponent") == 0) return (void *)&HostRemoveComponent;
+    if (std::strcmp(name, "HostGetComponent") == 0) return (void *)&HostGetComponent;
+    if (std::strcmp(name, "HostGetStorage") == 0) return (void *)&HostGetStorage;
     if (std::strcmp(name, "HostDestroyEntity") == 0) return (void *)&HostDestroyEntity;
+    if (std::strcmp(name, "HostCreateEntities") == 0) return (void *)&HostCreateEntities;
+    if (std::strcmp(name, "HostAddComponentsBulk") == 0) return (void *)&HostAddComponentsBulk;
+    if (std::strcmp(name, "HostRegisterPrefab") == 0) return (void *)&HostRegisterPrefab;
+    if (std::strcmp(name, "HostRegisterTag") == 0) return (void *)&HostRegisterTag;
+    if (std::strcmp(name, "HostAddTag") == 0) return (void *)&HostAddTag;
+    if (std::strcmp(name, "HostRemoveTag") == 0) return (void *)&HostRemoveTag;
+    if (std::strcmp(name, "HostInstantiatePrefab") == 0) return (void *)&HostInstantiatePrefab;
     if (std::strcmp(name, "HostRegisterPerEntityUpdate") == 0)
         return (void *)&HostRegisterPerEntityUpdate;
+    if (std::strcmp(name, "HostRegisterChunkedUpdate") == 0)
+        return (void *)&HostRegisterChunkedUpdate;
+    if (std::strcmp(name, "HostDeclareGroup") == 0) return (void *)&HostDeclareGroup;
     if (std::strcmp(name, "IsKeyPressed") == 0) return (void *)&IsKeyPressed;
     if (std::strcmp(name, "IsKeyJustPressed") == 0) return (void *)&IsKeyJustPressed;
     if (std::strcmp(name, "IsKeyJustReleased") == 0) return (void *)&IsKeyJustReleased;
@@ -325,6 +994,7 @@ __declspec(dllexport) __declspec(dllexport) void *__cdecl HostGetProcAddress(cha
 }
 
 void RuntimeBridge::bootstrap(Logger *logger) {
+    g_logger = logger;
     if (!load_hostfxr()) {
         logger->error("Failed to load hostfxr");
         return;
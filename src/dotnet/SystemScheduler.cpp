@@ -0,0 +1,261 @@
+#include "SystemScheduler.hpp"
+
+#include "utils/thread-pool/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <utility>
+
+namespace {
+// set while a system, or a batch of one, runs on this thread
+thread_local bool _isInSystem = false;
+// of the system running on this thread, see getSystemOrder
+thread_local uint32_t _systemOrder = 0;
+
+// the indices of a parallelFor, taken by whichever thread is free next
+struct ParallelBatch {
+    std::function<void(size_t)> const *work = nullptr;
+    size_t count                            = 0;
+    // of the system that split it
+    uint32_t systemOrder = 0;
+    std::atomic<size_t> nextIndex{0};
+
+    std::mutex mutex;
+    std::condition_variable finishedCondition;
+    size_t finishedCount = 0;
+    std::exception_ptr exception;
+};
+
+// late helpers find nothing left and never touch work, which may be gone by then
+void _drainBatch(ParallelBatch &batch) {
+    // a helper runs batches outside of any system of its own
+    bool const wasInSystem         = _isInSystem;
+    uint32_t const prevSystemOrder = _systemOrder;
+    _isInSystem                    = true;
+    _systemOrder                   = batch.systemOrder;
+
+    size_t finishedCount = 0;
+    for (size_t i = batch.nextIndex++; i < batch.count; i = batch.nextIndex++) {
+        try {
+            (*batch.work)(i);
+        } catch (...) {
+            std::lock_guard lock(batch.mutex);
+            if (!batch.exception) {
+                batch.exception = std::current_exception();
+            }
+        }
+        finishedCount++;
+    }
+    _isInSystem  = wasInSystem;
+    _systemOrder = prevSystemOrder;
+
+    if (finishedCount > 0) {
+        std::lock_guard lock(batch.mutex);
+        batch.finishedCount += finishedCount;
+        if (batch.finishedCount == batch.count) {
+            batch.finishedCondition.notify_all();
+        }
+    }
+}
+
+bool _isConflicting(SystemScheduler::Access const &a, SystemScheduler::Access const &b) {
+    return a.isExclusive || b.isExclusive || (a.writeMask & (b.readMask | b.writeMask)) != 0 ||
+           (b.writeMask & a.readMask) != 0;
+}
+} // namespace
+
+void SystemScheduler::addSystem(std::string name, Access access,
+                                std::function<void(float)> system) {
+    System newSystem{};
+    newSystem.name   = std::move(name);
+    newSystem.access = access;
+    newSystem.run    = std::move(system);
+    _systems.push_back(std::move(newSystem));
+    _isGraphBuilt = false;
+}
+
+void SystemScheduler::_buildGraph() {
+    for (auto &system : _systems) {
+        system.dependents.clear();
+        system.dependencyCount = 0;
+    }
+    // every earlier conflicting system is a dependency, which keeps the order they were added in
+    for (size_t later = 0; later < _systems.size(); later++) {
+        for (size_t earlier = 0; earlier < later; earlier++) {
+            if (_isConflicting(_systems[earlier].access, _systems[later].access)) {
+                _systems[earlier].dependents.push_back(later);
+                _systems[later].dependencyCount++;
+            }
+        }
+    }
+    _isGraphBuilt = true;
+}
+
+void SystemScheduler::run(float dt) {
+    if (!_isGraphBuilt) {
+        _buildGraph();
+    }
+
+    if (_threadPool == nullptr) {
+        for (size_t i = 0; i < _systems.size(); i++) {
+            _runSystem(i, dt);
+        }
+    } else {
+        std::vector<size_t> remainingDependencies(_systems.size());
+        std::deque<size_t> readySystems;
+        size_t runningWorkerSystems = 0;
+
+        auto const release = [&](size_t systemIndex) {
+            for (size_t dependent : _systems[systemIndex].dependents) {
+                if (--remainingDependencies[dependent] == 0) {
+                    readySystems.push_back(dependent);
+                }
+            }
+        };
+
+        for (size_t i = 0; i < _systems.size(); i++) {
+            remainingDependencies[i] = _systems[i].dependencyCount;
+            if (remainingDependencies[i] == 0) {
+                readySystems.push_back(i);
+            }
+        }
+
+        std::vector<size_t> finishedSystems;
+        while (true) {
+            {
+                std::unique_lock lock(_mutex);
+                if (readySystems.empty() && runningWorkerSystems > 0) {
+                    _finishedCondition.wait(lock, [this] { return !_finishedSystems.empty(); });
+                }
+                finishedSystems.swap(_finishedSystems);
+            }
+            runningWorkerSystems -= finishedSystems.size();
+            for (size_t systemIndex : finishedSystems) {
+                release(systemIndex);
+            }
+            finishedSystems.clear();
+
+            if (readySystems.empty()) {
+                if (runningWorkerSystems == 0) {
+                    break;
+                }
+                continue;
+            }
+
+            // all but one go to the workers, this thread runs the last one itself
+            while (readySystems.size() > 1 && runningWorkerSystems + 1 < getThreadCount()) {
+                size_t const systemIndex = readySystems.front();
+                readySystems.pop_front();
+                runningWorkerSystems++;
+                _threadPool->submit([this, systemIndex, dt] {
+                    _runSystem(systemIndex, dt);
+                    {
+                        std::lock_guard lock(_mutex);
+                        _finishedSystems.push_back(systemIndex);
+                    }
+                    _finishedCondition.notify_one();
+                });
+            }
+            size_t const systemIndex = readySystems.front();
+            readySystems.pop_front();
+            _runSystem(systemIndex, dt);
+            release(systemIndex);
+        }
+    }
+
+    if (_syncPoint) {
+        _syncPoint();
+    }
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard lock(_mutex);
+        exception = std::exchange(_exception, nullptr);
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void SystemScheduler::_runSystem(size_t systemIndex, float dt) {
+    auto &system = _systems[systemIndex];
+
+    // an exclusive system only becomes ready once every earlier one is done, and every later one
+    // waits for it, so it runs alone on the calling thread
+    if (system.access.isExclusive && _syncPoint) {
+        _syncPoint();
+    }
+
+    _isInSystem      = true;
+    _systemOrder     = static_cast<uint32_t>(systemIndex);
+    auto const start = std::chrono::steady_clock::now();
+    try {
+        system.run(dt);
+    } catch (...) {
+        std::lock_guard lock(_mutex);
+        if (!_exception) {
+            _exception = std::current_exception();
+        }
+    }
+    auto const time = std::chrono::steady_clock::now() - start;
+    _isInSystem     = false;
+
+    system.totalTime += time;
+    system.maxTime = std::max<std::chrono::nanoseconds>(system.maxTime, time);
+    system.runCount++;
+}
+
+size_t SystemScheduler::getThreadCount() const {
+    size_t const threadCount = _threadPool == nullptr ? 1 : _threadPool->getWorkerCount() + 1;
+    return _threadLimit == 0 ? threadCount : std::min(threadCount, _threadLimit);
+}
+
+void SystemScheduler::parallelFor(size_t count, std::function<void(size_t)> const &work) {
+    if (count == 0) {
+        return;
+    }
+
+    auto batch         = std::make_shared<ParallelBatch>();
+    batch->work        = &work;
+    batch->count       = count;
+    batch->systemOrder = _systemOrder;
+
+    size_t const helperCount = std::min(count, getThreadCount()) - 1;
+    for (size_t i = 0; i < helperCount; i++) {
+        _threadPool->submit([batch] { _drainBatch(*batch); });
+    }
+    // the helpers may still be queued behind other work, this thread never waits for an index
+    // nobody has taken
+    _drainBatch(*batch);
+
+    std::unique_lock lock(batch->mutex);
+    batch->finishedCondition.wait(lock, [&batch] { return batch->finishedCount == batch->count; });
+    if (batch->exception) {
+        std::rethrow_exception(batch->exception);
+    }
+}
+
+std::vector<SystemScheduler::Timing> SystemScheduler::getTimings() const {
+    std::vector<Timing> timings;
+    timings.reserve(_systems.size());
+    for (auto const &system : _systems) {
+        double const totalMs = std::chrono::duration<double, std::milli>(system.totalTime).count();
+        double const maxMs   = std::chrono::duration<double, std::milli>(system.maxTime).count();
+        timings.push_back(
+            {system.name, system.runCount > 0 ? totalMs / system.runCount : 0.0, maxMs});
+    }
+    return timings;
+}
+
+void SystemScheduler::resetTimings() {
+    for (auto &system : _systems) {
+        system.totalTime = std::chrono::nanoseconds{0};
+        system.maxTime   = std::chrono::nanoseconds{0};
+        system.runCount  = 0;
+    }
+}
+
+bool SystemScheduler::isInSystem() { return _isInSystem; }
+
+uint32_t SystemScheduler::getSystemOrder() { return _systemOrder; }
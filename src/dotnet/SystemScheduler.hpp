@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// runs the update systems of a frame as a dependency graph built from the components each one
+// reads and writes, so systems that don't conflict run concurrently on the pool
+// two systems conflict when one writes a component the other reads or writes, or when either is
+// exclusive, conflicting systems keep the order they were added in
+class SystemScheduler {
+  public:
+    // bit i of a mask is the component of type id i, see ComponentRegistry
+    struct Access {
+        uint32_t readMask  = 0;
+        uint32_t writeMask = 0;
+        // runs alone, for systems that don't declare what they touch and for the ones that must
+        // see the entities and components recorded before them, see setSyncPoint
+        bool isExclusive = true;
+    };
+
+    struct Timing {
+        std::string name;
+        // over every frame the system ran in
+        double averageMs;
+        double maxMs;
+    };
+
+    SystemScheduler()  = default;
+    ~SystemScheduler() = default;
+
+    // disable move and copy
+    SystemScheduler(const SystemScheduler &)            = delete;
+    SystemScheduler &operator=(const SystemScheduler &) = delete;
+    SystemScheduler(SystemScheduler &&)                 = delete;
+    SystemScheduler &operator=(SystemScheduler &&)      = delete;
+
+    void addSystem(std::string name, Access access, std::function<void(float)> system);
+
+    // nullptr runs the systems one after another on the calling thread, in the order they were
+    // added
+    // the workers need no explicit attach to the runtime: the systems enter managed code through
+    // [UnmanagedCallersOnly] function pointers, whose reverse P/Invoke stub attaches a native
+    // thread the first time it runs on it, and hostfxr has no attach call of its own to make; a
+    // worker stays attached until it exits, and the workers are kept for as long as the pool
+    // lives, so each of them pays for the attach once, within the first system it runs
+    void setThreadPool(ThreadPool *threadPool) { _threadPool = threadPool; }
+    // the most threads, the calling one included, that run systems at once and that a parallel
+    // system is split across, 0 for the calling thread and every worker
+    void setThreadLimit(size_t threadLimit) { _threadLimit = threadLimit; }
+    [[nodiscard]] size_t getThreadCount() const;
+    // called on the calling thread while no system runs: before every exclusive system and once
+    // all the systems of a run are done, where the runtime plays back the structural changes the
+    // systems recorded
+    void setSyncPoint(std::function<void()> syncPoint) { _syncPoint = std::move(syncPoint); }
+
+    // runs every system once and returns when all are done, the calling thread runs systems too,
+    // the first exception a system throws is rethrown once the others have finished
+    void run(float dt);
+
+    // runs work(i) for every i below count on up to getThreadCount() threads, the calling one
+    // included, and returns when all are done, for a system splitting its entities into batches
+    // which thread runs an index varies, the indices themselves don't
+    void parallelFor(size_t count, std::function<void(size_t)> const &work);
+
+    // in the order the systems were added
+    [[nodiscard]] std::vector<Timing> getTimings() const;
+    void resetTimings();
+
+    // true on a thread running a system or a batch of one, where the registry may be walked, so
+    // entities and components are only added or removed at the next sync point
+    static bool isInSystem();
+    // the index of the system running on this thread, or whose batch does, in the order the
+    // systems were added: a system that conflicts with an earlier one runs after it, so what they
+    // record is played back in this order
+    static uint32_t getSystemOrder();
+
+  private:
+    struct System {
+        std::string name;
+        Access access;
+        std::function<void(float)> run;
+        std::vector<size_t> dependents;
+        size_t dependencyCount = 0;
+
+        // only touched by the thread running the system, read between frames
+        std::chrono::nanoseconds totalTime{0};
+        std::chrono::nanoseconds maxTime{0};
+        uint32_t runCount = 0;
+    };
+
+    ThreadPool *_threadPool = nullptr;
+    size_t _threadLimit     = 0;
+    std::function<void()> _syncPoint;
+    std::vector<System> _systems;
+    // rebuilt on the next run after a system is added
+    bool _isGraphBuilt = false;
+
+    // guards everything below, the workers report finished systems through it
+    std::mutex _mutex;
+    std::condition_variable _finishedCondition;
+    std::vector<size_t> _finishedSystems;
+    std::exception_ptr _exception;
+
+    void _buildGraph();
+    void _runSystem(size_t systemIndex, float dt);
+};
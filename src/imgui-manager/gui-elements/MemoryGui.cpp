@@ -0,0 +1,87 @@
+#include "MemoryGui.hpp"
+
+#include "app-context/Defragmenter.hpp"
+#include "app-context/VulkanApplicationContext.hpp"
+#include "config-container/ConfigContainer.hpp"
+#include "utils/logger/Logger.hpp"
+#include "window/Window.hpp"
+
+#include "imgui.h"
+
+#include <string>
+
+namespace {
+float _toMiB(VkDeviceSize bytes) { return static_cast<float>(bytes) / (1024.F * 1024.F); }
+} // namespace
+
+MemoryGui::MemoryGui(Logger *logger, ConfigContainer *configContainer, Window *window)
+    : _logger(logger), _configContainer(configContainer), _window(window) {}
+
+void MemoryGui::update(VulkanApplicationContext *appContext) {
+    auto constexpr kRefreshInterval = std::chrono::milliseconds(500);
+    auto const now                  = std::chrono::steady_clock::now();
+    if (now - _lastRefreshTime > kRefreshInterval) {
+        _report          = MemoryTelemetry::collect(appContext);
+        _lastRefreshTime = now;
+    }
+
+    float constexpr kPadding = 10.F;
+    ImGui::SetNextWindowPos(ImVec2(kPadding, kPadding + 30), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Memory", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::SeparatorText(_report.isBudgetExact ? "Heaps" : "Heaps (estimated budget)");
+    for (auto const &heap : _report.heaps) {
+        float const budget   = _toMiB(heap.budget);
+        float const usage    = _toMiB(heap.usage);
+        float const fraction = budget > 0.F ? usage / budget : 0.F;
+        ImGui::Text("Heap %u%s", heap.index, heap.isDeviceLocal ? " (device local)" : "");
+        std::string const overlay = fmt::format("{:.1f} / {:.1f} MB", usage, budget);
+        ImGui::ProgressBar(fraction, ImVec2(-1.F, 0.F), overlay.c_str());
+        ImGui::Text("  %u blocks %.1f MB, %u allocations %.1f MB", heap.blockCount,
+                    _toMiB(heap.blockBytes), heap.allocationCount, _toMiB(heap.allocationBytes));
+    }
+
+    ImGui::SeparatorText("Memory classes");
+    if (ImGui::BeginTable("##MemoryClasses", 5, ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("Class");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableSetupColumn("Blocks");
+        ImGui::TableSetupColumn("Used / MB");
+        ImGui::TableSetupColumn("Largest free / MB");
+        ImGui::TableHeadersRow();
+        for (auto const &classReport : _report.classes) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(MemoryPools::getName(classReport.memoryClass));
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", classReport.allocationCount);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", classReport.blockCount);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f / %.1f", _toMiB(classReport.allocationBytes),
+                        _toMiB(classReport.blockBytes));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", _toMiB(classReport.largestFreeBlock));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Largest free block: %.1f MB", _toMiB(_report.largestFreeBlock));
+
+    ImGui::SeparatorText("Defragmentation");
+    auto *defragmenter = appContext->getDefragmenter();
+    auto const stats   = defragmenter->getStats();
+    ImGui::Text("%s, %llu runs, %llu passes", stats.isRunning ? "running" : "idle",
+                static_cast<unsigned long long>(stats.defragmentationCount),
+                static_cast<unsigned long long>(stats.passCount));
+    ImGui::Text("%llu moves %.1f MB, %.1f MB freed",
+                static_cast<unsigned long long>(stats.movedAllocationCount),
+                _toMiB(stats.movedBytes), _toMiB(stats.freedBytes));
+    if (ImGui::Button("Defragment now")) {
+        defragmenter->request();
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "app-context/MemoryTelemetry.hpp"
+
+#include <chrono>
+
+struct ConfigContainer;
+
+class VulkanApplicationContext;
+class Logger;
+class Window;
+
+// per heap budget and usage, per memory class allocations and the defragmenter's progress
+class MemoryGui {
+  public:
+    MemoryGui(Logger *logger, ConfigContainer *configContainer, Window *window);
+    void update(VulkanApplicationContext *appContext);
+
+  private:
+    Logger *_logger;
+    ConfigContainer *_configContainer;
+    Window *_window;
+
+    // the statistics walk every block, so they are refreshed a few times a second only
+    MemoryReport _report{};
+    std::chrono::steady_clock::time_point _lastRefreshTime{};
+};
@@ -5,8 +5,10 @@
 
 #include "../gui-elements/FpsGui.hpp"
 #include "../gui-elements/GameStatsGui.hpp"
+#include "../gui-elements/MemoryGui.hpp"
 #include "../imgui-backends/imgui_impl_glfw.h"
 #include "../imgui-backends/imgui_impl_vulkan.h"
+#include "app-context/MemoryTelemetry.hpp"
 #include "app-context/VulkanApplicationContext.hpp"
 #include "config/RootDir.h"
 #include "utils/fps-sink/FpsSink.hpp"
@@ -56,6 +58,7 @@ void ImguiManager::onSwapchainResize() {
 void ImguiManager::init() {
     _fpsGui = std::make_unique<FpsGui>(_logger, _configContainer, _window);
     _gameStatsGui = std::make_unique<GameStatsGui>(_logger, _configContainer, _window);
+    _memoryGui = std::make_unique<MemoryGui>(_logger, _configContainer, _window);
 
     _createGuiCommandBuffers();
     _createGuiRenderPass();
@@ -264,6 +267,21 @@ void ImguiManager::_drawConfigMenuItem() {
     }
 }
 
+void ImguiManager::_drawMemoryMenuItem() {
+    if (ImGui::BeginMenu("Memory")) {
+        ImGui::Checkbox("Show Memory", &_showMemoryStats);
+        if (ImGui::MenuItem("Dump Memory Report")) {
+            std::string const path = kRootDir + "memory-report.json";
+            if (MemoryTelemetry::dumpJson(_appContext, path)) {
+                _logger->info("Memory report written to {}", path);
+            } else {
+                _logger->warn("Failed to write the memory report to {}", path);
+            }
+        }
+        ImGui::EndMenu();
+    }
+}
+
 void ImguiManager::_drawFpsMenuItem(double fpsInTimeBucket) {
     std::string const kFpsString = std::to_string(static_cast<int>(fpsInTimeBucket)) + " FPS";
 
@@ -308,6 +326,7 @@ void ImguiManager::draw(FpsSink *fpsSink) {
 
     ImGui::BeginMainMenuBar();
     _drawConfigMenuItem();
+    _drawMemoryMenuItem();
     _drawFpsMenuItem(fpsInTimeBucket);
     ImGui::EndMainMenuBar();
 
@@ -315,6 +334,10 @@ void ImguiManager::draw(FpsSink *fpsSink) {
         _fpsGui->update(_appContext, filteredFps);
     }
 
+    if (_showMemoryStats) {
+        _memoryGui->update(_appContext);
+    }
+
     // 总是显示游戏统计信息
     _gameStatsGui->update(_appContext);
 
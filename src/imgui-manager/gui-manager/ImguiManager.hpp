@@ -10,6 +10,7 @@ struct ConfigContainer;
 
 class FpsGui;
 class GameStatsGui;
+class MemoryGui;
 class VulkanApplicationContext;
 class Window;
 class Logger;
@@ -46,10 +47,12 @@ class ImguiManager {
     ConfigContainer *_configContainer;
 
     int _framesInFlight;
-    bool _showFpsGraph = false;
+    bool _showFpsGraph    = false;
+    bool _showMemoryStats = false;
 
     std::unique_ptr<FpsGui> _fpsGui;
     std::unique_ptr<GameStatsGui> _gameStatsGui;
+    std::unique_ptr<MemoryGui> _memoryGui;
 
     VkDescriptorPool _guiDescriptorPool = VK_NULL_HANDLE;
     VkRenderPass _guiPass               = VK_NULL_HANDLE;
@@ -66,5 +69,6 @@ class ImguiManager {
     void _syncMousePosition();
 
     void _drawConfigMenuItem();
+    void _drawMemoryMenuItem();
     void _drawFpsMenuItem(double fpsInTimeBucket);
 };
@@ -1,27 +1,78 @@
 #include "Renderer.hpp"
 #include "ShaderSharedVariables.hpp"
+#include "app-context/AsyncUploader.hpp"
+#include "app-context/DescriptorAllocator.hpp"
+#include "app-context/MemoryPools.hpp"
+#include "app-context/UploadManager.hpp"
 #include "app-context/VulkanApplicationContext.hpp"
 #include "camera/Camera.hpp"
 #include "config-container/ConfigContainer.hpp"
+#include "config-container/sub-config/RendererInfo.hpp"
 #include "config/RootDir.h"
 #include "dotnet/Components.hpp"
 #include "dotnet/RuntimeApplication.hpp"
 #include "dotnet/RuntimeBridge.hpp"
+#include "utils/event-dispatcher/GlobalEventDispatcher.hpp"
+#include "utils/event-types/EventType.hpp"
 #include "utils/logger/Logger.hpp"
 #include "utils/shader-compiler/ShaderCompiler.hpp"
+#include "utils/thread-pool/ThreadPool.hpp"
 #include "utils/vulkan-wrapper/descriptor-set/DescriptorSetBundle.hpp"
 #include "utils/vulkan-wrapper/memory/Buffer.hpp"
 #include "utils/vulkan-wrapper/memory/BufferBundle.hpp"
 #include "utils/vulkan-wrapper/memory/Image.hpp"
 #include "utils/vulkan-wrapper/memory/Model.hpp"
+#include "utils/vulkan-wrapper/memory/TextureCache.hpp"
 #include "utils/vulkan-wrapper/pipeline/GfxPipeline.hpp"
 #include "utils/vulkan-wrapper/sampler/Sampler.hpp"
+#include "utils/vulkan-wrapper/sampler/SamplerCache.hpp"
 #include "window/Window.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <map>
 
+namespace {
+std::string _getDefaultShaderPath() { return kPathToResourceFolder + "shaders/default"; }
+} // namespace
+
+std::vector<Renderer::PendingModel>
+Renderer::loadRegisteredModels(ThreadPool *assetLoaderPool, ConfigContainer *configContainer,
+                               Logger *logger) {
+    // Load models from RuntimeApplication mesh registry
+    auto meshes = RuntimeBridge::getRuntimeApplication().getAllMeshes();
+    logger->info("Loading {} meshes from C# registry", meshes.size());
+
+    if (meshes.empty()) {
+        logger->warn("No meshes registered! Renderer will be created with empty mesh list.");
+        logger->warn("This may cause rendering issues. Ensure mesh registration happens before "
+                     "Renderer creation.");
+        return {};
+    }
+
+    auto const vertexFormat = configContainer->rendererInfo->vertexQuantization
+                                  ? VertexFormat::kQuantized
+                                  : VertexFormat::kFloat;
+    std::vector<PendingModel> pendingModels;
+    pendingModels.reserve(meshes.size());
+    for (const auto &[meshId, meshPath] : meshes) {
+        pendingModels.push_back(
+            {meshId, assetLoaderPool->submit(
+                         [logger, fullPath = kPathToResourceFolder + meshPath, vertexFormat] {
+                             return Model::Source::load(fullPath, vertexFormat, logger);
+                         })});
+    }
+    return pendingModels;
+}
+
+void Renderer::precompileShaders(ShaderCompiler *shaderCompiler, Logger *logger) {
+    GfxPipeline::precompileShaders(shaderCompiler, logger, _getDefaultShaderPath());
+}
+
 Renderer::Renderer(VulkanApplicationContext *appContext, Logger *logger, size_t framesInFlight,
-                   ShaderCompiler *shaderCompiler, Window *window, ConfigContainer *configContainer)
+                   ShaderCompiler *shaderCompiler, Window *window, ConfigContainer *configContainer,
+                   ThreadPool *assetLoaderPool, std::vector<PendingModel> pendingModels)
     : _appContext(appContext), _logger(logger), _framesInFlight(framesInFlight),
       _shaderCompiler(shaderCompiler), _window(window), _configContainer(configContainer) {
     _camera = std::make_unique<Camera>(_window, logger, configContainer);
@@ -38,24 +89,20 @@ Renderer::Renderer(VulkanApplicationContext *appContext, Logger *logger, size_t
         VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
             VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 
-    // Load models from RuntimeApplication mesh registry
-    auto meshes = RuntimeBridge::getRuntimeApplication().getAllMeshes();
-    _logger->info("Loading {} meshes from C# registry", meshes.size());
-
-    if (meshes.empty()) {
-        _logger->warn("No meshes registered! Renderer will be created with empty mesh list.");
-        _logger->warn("This may cause rendering issues. Ensure mesh registration happens before "
-                      "Renderer creation.");
-    } else {
-        for (const auto &[meshId, meshPath] : meshes) {
-            std::string fullPath = kPathToResourceFolder + meshPath;
-            _models.push_back(std::make_unique<Model>(_appContext, _logger, fullPath));
-            _logger->info("Loaded mesh ID {}: {}", meshId, fullPath);
-        }
-    }
+    // the model loads and the texture decodes run on the pool, only the vulkan objects are
+    // created on this thread
+    auto const assetLoadStart = std::chrono::steady_clock::now();
+    _createModels(std::move(pendingModels));
 
+    _samplerCache = std::make_unique<SamplerCache>(_appContext);
+    _textureCache = std::make_unique<TextureCache>(_appContext, _logger);
     _createDefaultTextures();
-    _createModelImages();
+    _createModelImages(assetLoaderPool);
+    auto const assetLoadEnd = std::chrono::steady_clock::now();
+    _logger->info("Renderer assets created in {:.1f} ms on {} workers",
+                  std::chrono::duration<double, std::milli>(assetLoadEnd - assetLoadStart).count(),
+                  assetLoaderPool->getWorkerCount());
+
     _createBuffersAndBufferBundles();
     _createDescriptorSetBundles();
     _createRenderPass();
@@ -66,13 +113,96 @@ Renderer::Renderer(VulkanApplicationContext *appContext, Logger *logger, size_t
     _createFrameBuffers();
     _recordDrawingCommandBuffers();
     _recordDeliveryCommandBuffers();
+    _createTimestampQueryPool();
+
+    // all mesh and texture uploads above went into a few batches, get them to the gpu now so they
+    // overlap with the rest of the startup
+    _appContext->getUploadManager()->flush();
+    _logger->info("Renderer resources uploaded in {} batches",
+                  _appContext->getUploadManager()->getSubmittedBatchCount());
+    _logger->info("Renderer uses {} samplers and {} descriptor pools",
+                  _samplerCache->getSamplerCount(),
+                  _appContext->getDescriptorAllocator()->getPoolCount());
+    auto const *memoryPools = _appContext->getMemoryPools();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryClass::kCount); i++) {
+        auto const memoryClass = static_cast<MemoryClass>(i);
+        _logger->info("Memory class {}: {} allocations", MemoryPools::getName(memoryClass),
+                      memoryPools->getAllocationCount(memoryClass));
+    }
 
     // attach camera's mouse handler to the window mouse callback
     _window->addCursorMoveCallback(
         [this](CursorMoveInfo const &mouseInfo) { _camera->handleMouseMovement(mouseInfo); });
+
+    GlobalEventDispatcher::get().sink<E_ShaderReloaded>().connect<&Renderer::_onShaderReloaded>(
+        this);
+}
+
+void Renderer::_createModels(std::vector<PendingModel> pendingModels) {
+    for (auto &pendingModel : pendingModels) {
+        auto source = pendingModel.source.get();
+        _logger->info("Loaded mesh ID {}: {}", pendingModel.meshId, source.filePath);
+        _models.push_back(std::make_unique<Model>(_appContext, _logger, std::move(source)));
+    }
+}
+
+void Renderer::_onShaderReloaded(E_ShaderReloaded const &event) {
+    if (event.fullPathToShaderSourceCode != _pipeline->getFullPathToShaderSourceCode()) {
+        return;
+    }
+    if (_pipeline->hotSwap(event.vertCode, event.fragCode, _framesInFlight)) {
+        _logger->info("Hot reloaded pipeline: {}", event.fullPathToShaderSourceCode);
+    }
+}
+
+uint32_t Renderer::_getReadyVariantKey(ModelImages const &images) const {
+    auto *asyncUploader = _appContext->getAsyncUploader();
+    if (asyncUploader == nullptr) {
+        return images.variantKey;
+    }
+
+    // textures that are still streaming in are left out, the variant falls back to the material
+    // factors until they arrive
+    uint32_t variantKey = images.variantKey;
+    auto const dropIfNotReady = [&](Image const *image, MaterialFeature feature) {
+        if ((variantKey & feature) != 0 && !asyncUploader->isReady(image->getUploadTicket())) {
+            variantKey &= ~static_cast<uint32_t>(feature);
+        }
+    };
+    dropIfNotReady(images.baseColor.get(), MaterialFeature::kBaseColorTex);
+    dropIfNotReady(images.normalMap.get(), MaterialFeature::kNormalTex);
+    dropIfNotReady(images.metalRoughness.get(), MaterialFeature::kMetalRoughnessTex);
+    dropIfNotReady(images.emissive.get(), MaterialFeature::kEmissiveTex);
+    return variantKey;
+}
+
+uint32_t Renderer::_bindReadyTextures(size_t currentFrame, size_t modelIndex, size_t meshIndex) {
+    auto &images            = _modelImages[modelIndex][meshIndex];
+    uint32_t const readyKey = _getReadyVariantKey(images);
+    uint32_t &boundKey      = images.boundVariantKeys[currentFrame];
+    if (readyKey == boundKey) {
+        return boundKey;
+    }
+
+    // a texture never goes back to streaming, so the ready bits only grow
+    auto &descBundle  = *_descriptorSetBundles[modelIndex][meshIndex];
+    auto const rebind = [&](uint32_t bindingSlot, Image *image, MaterialFeature feature) {
+        if ((readyKey & ~boundKey & feature) != 0) {
+            descBundle.rebindImageSampler(currentFrame, bindingSlot, image);
+        }
+    };
+    rebind(1, images.baseColor.get(), MaterialFeature::kBaseColorTex);
+    rebind(3, images.normalMap.get(), MaterialFeature::kNormalTex);
+    rebind(4, images.metalRoughness.get(), MaterialFeature::kMetalRoughnessTex);
+    rebind(5, images.emissive.get(), MaterialFeature::kEmissiveTex);
+    boundKey = readyKey;
+    return boundKey;
 }
 
-void Renderer::_createModelImages() {
+void Renderer::_createModelImages(ThreadPool *threadPool) {
+    // the previous handles stay alive until the new ones are acquired, so a recreation hits the
+    // cache instead of loading every texture again
+    auto const previousModelImages = std::move(_modelImages);
     _modelImages.clear();
 
     if (_models.empty()) {
@@ -80,133 +210,105 @@ void Renderer::_createModelImages() {
         return;
     }
 
-    auto samplerSettings = Sampler::Settings{
+    auto const &rendererInfo = *_configContainer->rendererInfo;
+    auto samplerSettings     = Sampler::Settings{
         Sampler::AddressMode::kClampToEdge, // U
         Sampler::AddressMode::kClampToEdge, // V
         Sampler::AddressMode::kClampToEdge  // W
     };
+    // trilinear, plus anisotropic for surfaces seen at grazing angles
+    samplerSettings.mipmapMode    = Sampler::MipmapMode::kLinear;
+    samplerSettings.maxAnisotropy = rendererInfo.maxAnisotropy;
+    // the cached images are shared across meshes and keep the sampler they were created with,
+    // the sampler cache returns the same one for the same settings
+    VkSampler const modelSampler = _samplerCache->get(samplerSettings)->getVkSampler();
+
+    auto const textureMipmaps =
+        rendererInfo.textureMipmaps ? ImageMipmaps::kFullChain : ImageMipmaps::kSingleLevel;
+    // each slot gets the block format that suits its content
+    auto const textureCompression = [&rendererInfo](ImageCompression compression) {
+        return rendererInfo.textureCompression ? compression : ImageCompression::kNone;
+    };
 
-    for (size_t i = 0; i < _models.size(); ++i) {
-        std::vector<ModelImages> modelMeshesImages;
-        auto &model = *_models[i];
-
-        for (size_t j = 0; j < model.baseColorTexturePaths.size(); ++j) {
-            ModelImages images;
-            images.sharedSampler = std::make_unique<Sampler>(_appContext, samplerSettings);
+    VkImageUsageFlags const textureUsage =
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-            // baseColor
-            const std::string &path = model.baseColorTexturePaths[j];
+    // every texture of every model is decoded at once, the acquires below then only create and
+    // upload the images
+    if (threadPool != nullptr) {
+        std::vector<TextureCache::Request> requests;
+        auto const request = [&](std::string const &path, ImageCompression compression) {
             if (!path.empty()) {
-                auto tempImage = std::make_unique<Image>(_appContext, _logger, path,
-                                                         VK_IMAGE_USAGE_SAMPLED_BIT |
-                                                             VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                                         images.sharedSampler->getVkSampler());
-                if (tempImage->getVkImage() != VK_NULL_HANDLE) {
-                    images.baseColor = std::move(tempImage);
-                } else {
-                    _logger->warn("Failed to load baseColor texture: {}, using default", path);
-                    images.baseColor = std::make_unique<Image>(
-                        _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_SRGB,
-                        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                        images.sharedSampler->getVkSampler());
-                    std::array<uint8_t, 4> pixel = {255, 255, 255, 255};
-                    _uploadTextureData(images.baseColor.get(), pixel.data());
-                }
-            } else {
-                images.baseColor = std::make_unique<Image>(
-                    _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_SRGB,
-                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                    images.sharedSampler->getVkSampler());
-                std::array<uint8_t, 4> pixel = {255, 255, 255, 255};
-                _uploadTextureData(images.baseColor.get(), pixel.data());
+                requests.push_back(
+                    {path, textureUsage, textureMipmaps, textureCompression(compression)});
             }
-
-            // normalMap
-            const std::string &normalPath = model.normalTexturePaths[j];
-            if (!normalPath.empty()) {
-                auto tempImage = std::make_unique<Image>(_appContext, _logger, normalPath,
-                                                         VK_IMAGE_USAGE_SAMPLED_BIT |
-                                                             VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                                         images.sharedSampler->getVkSampler());
-                if (tempImage->getVkImage() != VK_NULL_HANDLE) {
-                    images.normalMap = std::move(tempImage);
-                } else {
-                    _logger->warn("Failed to load normal texture: {}, using default", normalPath);
-                    images.normalMap = std::make_unique<Image>(
-                        _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM,
-                        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                        images.sharedSampler->getVkSampler());
-                    std::array<uint8_t, 4> pixel = {128, 128, 255, 255};
-                    _uploadTextureData(images.normalMap.get(), pixel.data());
-                }
-            } else {
-                images.normalMap = std::make_unique<Image>(
-                    _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM,
-                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                    images.sharedSampler->getVkSampler());
-                std::array<uint8_t, 4> pixel = {128, 128, 255, 255};
-                _uploadTextureData(images.normalMap.get(), pixel.data());
+        };
+        for (auto const &model : _models) {
+            for (size_t j = 0; j < model->baseColorTexturePaths.size(); ++j) {
+                request(model->baseColorTexturePaths[j], ImageCompression::kColor);
+                request(model->normalTexturePaths[j], ImageCompression::kNormal);
+                request(model->metallicRoughnessTexturePaths[j], ImageCompression::kMask);
+                request(model->emissiveTexturePaths[j], ImageCompression::kColor);
             }
+        }
+        _textureCache->preload(requests, threadPool);
+    }
 
-            // metalRoughness
-            const std::string &mrPath = model.metallicRoughnessTexturePaths[j];
-            if (!mrPath.empty()) {
-                auto tempImage = std::make_unique<Image>(_appContext, _logger, mrPath,
-                                                         VK_IMAGE_USAGE_SAMPLED_BIT |
-                                                             VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                                         images.sharedSampler->getVkSampler());
-                if (tempImage->getVkImage() != VK_NULL_HANDLE) {
-                    images.metalRoughness = std::move(tempImage);
-                } else {
-                    _logger->warn("Failed to load metalRoughness texture: {}, using default",
-                                  mrPath);
-                    images.metalRoughness = std::make_unique<Image>(
-                        _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM,
-                        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                        images.sharedSampler->getVkSampler());
-                    std::array<uint8_t, 4> pixel = {0, 255, 0, 255};
-                    _uploadTextureData(images.metalRoughness.get(), pixel.data());
-                }
-            } else {
-                images.metalRoughness = std::make_unique<Image>(
-                    _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM,
-                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                    images.sharedSampler->getVkSampler());
-                std::array<uint8_t, 4> pixel = {0, 255, 0, 255};
-                _uploadTextureData(images.metalRoughness.get(), pixel.data());
-            }
+    // missing or broken textures fall back to the shared default of the slot
+    auto const loadTexture = [&](ModelImages &images, std::string const &path, char const *slotName,
+                                 ImageCompression compression,
+                                 std::shared_ptr<Image> const &defaultTexture,
+                                 MaterialFeature feature) -> std::shared_ptr<Image> {
+        if (path.empty()) {
+            return defaultTexture;
+        }
+        auto image = _textureCache->acquire(path, textureUsage, modelSampler,
+                                            ImageLoading::kStreamed, textureMipmaps,
+                                            textureCompression(compression));
+        if (image == nullptr) {
+            _logger->warn("Failed to load {} texture: {}, using default", slotName, path);
+            return defaultTexture;
+        }
+        images.variantKey |= feature;
+        return image;
+    };
 
-            // emissive
-            const std::string &emPath = model.emissiveTexturePaths[j];
-            if (!emPath.empty()) {
-                auto tempImage = std::make_unique<Image>(_appContext, _logger, emPath,
-                                                         VK_IMAGE_USAGE_SAMPLED_BIT |
-                                                             VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                                         images.sharedSampler->getVkSampler());
-                if (tempImage->getVkImage() != VK_NULL_HANDLE) {
-                    images.emissive = std::move(tempImage);
-                } else {
-                    _logger->warn("Failed to load emissive texture: {}, using default", emPath);
-                    images.emissive = std::make_unique<Image>(
-                        _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_SRGB,
-                        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                        images.sharedSampler->getVkSampler());
-                    std::array<uint8_t, 4> pixel = {0, 0, 0, 255};
-                    _uploadTextureData(images.emissive.get(), pixel.data());
-                }
-            } else {
-                images.emissive = std::make_unique<Image>(
-                    _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_SRGB,
-                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                    images.sharedSampler->getVkSampler());
-                std::array<uint8_t, 4> pixel = {0, 0, 0, 255};
-                _uploadTextureData(images.emissive.get(), pixel.data());
-            }
+    for (size_t i = 0; i < _models.size(); ++i) {
+        std::vector<ModelImages> modelMeshesImages;
+        auto &model = *_models[i];
 
+        for (size_t j = 0; j < model.baseColorTexturePaths.size(); ++j) {
+            ModelImages images;
+            images.baseColor =
+                loadTexture(images, model.baseColorTexturePaths[j], "baseColor",
+                            ImageCompression::kColor, _defaultBaseColorTexture,
+                            MaterialFeature::kBaseColorTex);
+            images.normalMap =
+                loadTexture(images, model.normalTexturePaths[j], "normal",
+                            ImageCompression::kNormal, _defaultNormalTexture,
+                            MaterialFeature::kNormalTex);
+            images.metalRoughness =
+                loadTexture(images, model.metallicRoughnessTexturePaths[j], "metalRoughness",
+                            ImageCompression::kMask, _defaultMetalRoughnessTexture,
+                            MaterialFeature::kMetalRoughnessTex);
+            images.emissive =
+                loadTexture(images, model.emissiveTexturePaths[j], "emissive",
+                            ImageCompression::kColor, _defaultEmissiveTexture,
+                            MaterialFeature::kEmissiveTex);
             modelMeshesImages.push_back(std::move(images));
         }
         _modelImages.push_back(std::move(modelMeshesImages));
     }
+
+    // compare against a run with textureMipmaps or textureCompression off, together with the gpu
+    // render pass time
+    auto const stats = _textureCache->getStats();
+    _logger->info("Model textures: {} hits, {} misses, {} images, {:.2f} MB resident, mipmaps {}, "
+                  "compression {}",
+                  stats.hits, stats.misses, stats.residentCount,
+                  static_cast<double>(stats.residentBytes) / (1024.0 * 1024.0),
+                  rendererInfo.textureMipmaps ? "on" : "off",
+                  rendererInfo.textureCompression ? "on" : "off");
 }
 
 void Renderer::_createBuffersAndBufferBundles() {
@@ -260,12 +362,28 @@ void Renderer::_createDescriptorSetBundles() {
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
             descBundle->bindUniformBufferBundle(0, _renderInfoBufferBundles[i].get());
             descBundle->bindUniformBufferBundle(2, _materialBufferBundles[i][j].get());
-            
-           
-            descBundle->bindImageSampler(1, _modelImages[i][j].baseColor.get());
-            descBundle->bindImageSampler(3, _modelImages[i][j].normalMap.get());
-            descBundle->bindImageSampler(4, _modelImages[i][j].metalRoughness.get());
-            descBundle->bindImageSampler(5, _modelImages[i][j].emissive.get());
+
+            auto &images            = _modelImages[i][j];
+            uint32_t const readyKey = _getReadyVariantKey(images);
+            // a texture that is still streaming in has no contents nor layout to sample yet, its
+            // slot holds the default until _bindReadyTextures swaps it in
+            auto const readyOrDefault = [readyKey](std::shared_ptr<Image> const &image,
+                                                   std::shared_ptr<Image> const &defaultTexture,
+                                                   MaterialFeature feature) {
+                return (readyKey & feature) != 0 ? image.get() : defaultTexture.get();
+            };
+            descBundle->bindImageSampler(1, readyOrDefault(images.baseColor,
+                                                           _defaultBaseColorTexture,
+                                                           MaterialFeature::kBaseColorTex));
+            descBundle->bindImageSampler(3, readyOrDefault(images.normalMap, _defaultNormalTexture,
+                                                           MaterialFeature::kNormalTex));
+            descBundle->bindImageSampler(4, readyOrDefault(images.metalRoughness,
+                                                           _defaultMetalRoughnessTexture,
+                                                           MaterialFeature::kMetalRoughnessTex));
+            descBundle->bindImageSampler(5, readyOrDefault(images.emissive,
+                                                           _defaultEmissiveTexture,
+                                                           MaterialFeature::kEmissiveTex));
+            images.boundVariantKeys.assign(_framesInFlight, readyKey);
 
             descBundle->create();
             modelDescBundles.push_back(std::move(descBundle));
@@ -358,9 +476,9 @@ void Renderer::_createGraphicsPipeline() {
             "No descriptor sets available, creating pipeline without descriptor reference");
     }
 
-    _pipeline = std::make_unique<GfxPipeline>(_appContext, _logger,
-                                              kPathToResourceFolder + "shaders/default",
-                                              referenceDescriptorSet, _shaderCompiler, _renderPass);
+    _pipeline = std::make_unique<GfxPipeline>(
+        _appContext, _logger, _getDefaultShaderPath(), referenceDescriptorSet, _shaderCompiler,
+        _renderPass, kVariantFeatureCount, GeometryFeature::kQuantizedVertices);
 }
 
 void Renderer::_createDepthStencil() {
@@ -418,6 +536,9 @@ void Renderer::_createFrameBuffers() {
 }
 
 Renderer::~Renderer() {
+    GlobalEventDispatcher::get().sink<E_ShaderReloaded>().disconnect<&Renderer::_onShaderReloaded>(
+        this);
+
     for (auto framebuffer : _frameBuffers) {
         vkDestroyFramebuffer(_appContext->getDevice(), framebuffer, nullptr);
     }
@@ -433,6 +554,61 @@ Renderer::~Renderer() {
     }
     _pipeline.reset();
     vkDestroyRenderPass(_appContext->getDevice(), _renderPass, nullptr);
+    if (_timestampQueryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(_appContext->getDevice(), _timestampQueryPool, nullptr);
+    }
+}
+
+void Renderer::_createTimestampQueryPool() {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(_appContext->getPhysicalDevice(), &properties);
+    if (properties.limits.timestampComputeAndGraphics == VK_FALSE) {
+        _logger->warn("Timestamps are not supported, the gpu render pass time won't be measured");
+        return;
+    }
+    _timestampPeriod = properties.limits.timestampPeriod;
+
+    // a begin and an end timestamp per frame in flight
+    VkQueryPoolCreateInfo queryPoolCreateInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    queryPoolCreateInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = static_cast<uint32_t>(_framesInFlight * 2);
+    vkCreateQueryPool(_appContext->getDevice(), &queryPoolCreateInfo, nullptr,
+                      &_timestampQueryPool);
+    _timestampsWritten.assign(_framesInFlight, false);
+}
+
+double Renderer::_beginGpuTiming(VkCommandBuffer cmdBuffer, size_t currentFrame) {
+    if (_timestampQueryPool == VK_NULL_HANDLE) {
+        return 0.0;
+    }
+    auto const firstQuery = static_cast<uint32_t>(currentFrame * 2);
+
+    // the fence of this frame has been waited on, so the timestamps written the last time this
+    // command buffer ran are available without blocking
+    double gpuTime = 0.0;
+    if (_timestampsWritten[currentFrame]) {
+        std::array<uint64_t, 2> timestamps{};
+        VkResult result = vkGetQueryPoolResults(
+            _appContext->getDevice(), _timestampQueryPool, firstQuery, 2, sizeof(timestamps),
+            timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS) {
+            gpuTime = static_cast<double>(timestamps[1] - timestamps[0]) * _timestampPeriod / 1e6;
+        }
+    }
+
+    vkCmdResetQueryPool(cmdBuffer, _timestampQueryPool, firstQuery, 2);
+    vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _timestampQueryPool,
+                        firstQuery);
+    return gpuTime;
+}
+
+void Renderer::_endGpuTiming(VkCommandBuffer cmdBuffer, size_t currentFrame) {
+    if (_timestampQueryPool == VK_NULL_HANDLE) {
+        return;
+    }
+    vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _timestampQueryPool,
+                        static_cast<uint32_t>(currentFrame * 2 + 1));
+    _timestampsWritten[currentFrame] = true;
 }
 
 void Renderer::onSwapchainResize() {
@@ -522,13 +698,6 @@ void Renderer::_updateMaterialData(uint32_t currentFrame, size_t modelIndex, siz
     materialInfo.emissive  = emissive;
     materialInfo.padding   = 0.0f; // 填充对齐
 
-    auto &model                  = *_models[modelIndex];
-    materialInfo.hasBaseColorTex = !model.baseColorTexturePaths[meshIndex].empty() ? 1 : 0;
-    materialInfo.hasNormalTex    = !model.normalTexturePaths[meshIndex].empty() ? 1 : 0;
-    materialInfo.hasMetalRoughnessTex =
-        !model.metallicRoughnessTexturePaths[meshIndex].empty() ? 1 : 0;
-    materialInfo.hasEmissiveTex = !model.emissiveTexturePaths[meshIndex].empty() ? 1 : 0;
-
     _materialBufferBundles[modelIndex][meshIndex]->getBuffer(currentFrame)->fillData(&materialInfo);
 }
 
@@ -555,6 +724,9 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
     auto setupStart = std::chrono::steady_clock::now();
     auto &cmdBuffer = _drawingCommandBuffers[currentFrame];
 
+    // the fence of this frame has been waited on, pipelines replaced by hot reload can go now
+    _pipeline->releaseRetiredPipelines();
+
     VkExtent2D currentSwapchainExtent = _appContext->getSwapchainExtent();
 
     VkCommandBufferBeginInfo cmdBufferBeginInfo{};
@@ -577,6 +749,18 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
     rdrPassBeginInfo.framebuffer = _frameBuffers[imageIndex];
 
     vkBeginCommandBuffer(cmdBuffer, &cmdBufferBeginInfo);
+
+    // streamed meshes and textures that finished uploading become usable from this frame on, the
+    // ownership has to be taken over outside of the render pass
+    auto *asyncUploader = _appContext->getAsyncUploader();
+    if (asyncUploader != nullptr) {
+        asyncUploader->recordAcquireBarriers(cmdBuffer);
+        for (auto &model : _models) {
+            model->releaseUploadedData();
+        }
+    }
+
+    timings.gpuRenderPass = _beginGpuTiming(cmdBuffer, currentFrame);
     vkCmdBeginRenderPass(cmdBuffer, &rdrPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
     VkViewport viewport{};
@@ -593,8 +777,6 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
     scissor.extent = currentSwapchainExtent;
     vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
 
-    vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline->getPipeline());
-
     auto setupEnd              = std::chrono::steady_clock::now();
     timings.commandBufferSetup = _getTimeInMilliseconds(setupStart, setupEnd);
 
@@ -602,6 +784,7 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
     if (_models.empty()) {
         // No models loaded, skip rendering
         vkCmdEndRenderPass(cmdBuffer);
+        _endGpuTiming(cmdBuffer, currentFrame);
         vkEndCommandBuffer(cmdBuffer);
         _lastFrameTimings = timings;
         return;
@@ -626,11 +809,26 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
     auto bufferUpdateTime = 0.0;
     auto gpuCommandTime   = 0.0;
 
+    // draws are collected first and recorded sorted by material variant, so every pipeline is
+    // bound once per frame
+    struct MeshDraw {
+        uint32_t variantKey;
+        size_t modelIndex;
+        size_t meshIndex;
+        uint32_t instanceCount;
+    };
+    std::vector<MeshDraw> meshDraws;
+
     for (const auto &[modelId, entities] : entitiesByModel) {
         size_t modelIndex          = static_cast<size_t>(modelId);
         const size_t instanceCount = entities.size();
 
         if (instanceCount == 0) continue;
+        // still streaming in
+        if (asyncUploader != nullptr &&
+            !asyncUploader->isReady(_models[modelIndex]->uploadTicket)) {
+            continue;
+        }
 
         // Instance data preparation timing
         auto instancePrepStart = std::chrono::steady_clock::now();
@@ -684,38 +882,65 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
         auto bufferUpdateEnd = std::chrono::steady_clock::now();
         bufferUpdateTime += _getTimeInMilliseconds(bufferUpdateStart, bufferUpdateEnd);
 
-        auto gpuCommandStart = std::chrono::steady_clock::now();
-        // Bind descriptor sets - but since per mesh, moved inside mesh loop
+        bool const isQuantized     = model.vertexFormat == VertexFormat::kQuantized;
+        uint32_t const geometryKey = isQuantized ? GeometryFeature::kQuantizedVertices : 0U;
+        for (size_t meshIdx = 0; meshIdx < model.idxCnts.size(); ++meshIdx) {
+            meshDraws.push_back(
+                {_bindReadyTextures(currentFrame, modelIndex, meshIdx) | geometryKey, modelIndex,
+                 meshIdx, static_cast<uint32_t>(instanceCount)});
+        }
+    }
+
+    auto gpuCommandStart = std::chrono::steady_clock::now();
+
+    // stable, so meshes of the same model stay together within a variant
+    std::stable_sort(meshDraws.begin(), meshDraws.end(), [](MeshDraw const &a, MeshDraw const &b) {
+        return a.variantKey < b.variantKey;
+    });
+
+    VkDeviceSize offsets[]   = {0};
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    size_t boundModelIndex   = SIZE_MAX;
+    for (auto const &draw : meshDraws) {
+        VkPipeline pipeline = _pipeline->getPipelineVariant(draw.variantKey);
+        if (pipeline != boundPipeline) {
+            vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            boundPipeline = pipeline;
+        }
 
         // Bind instance buffer (binding 1 for instance data)
-        VkBuffer instanceBuffers[] = {
-            _instanceBufferBundles[modelIndex]->getBuffer(currentFrame)->getVkBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(cmdBuffer, 1, 1, instanceBuffers, offsets);
+        if (draw.modelIndex != boundModelIndex) {
+            VkBuffer instanceBuffers[] = {
+                _instanceBufferBundles[draw.modelIndex]->getBuffer(currentFrame)->getVkBuffer()};
+            vkCmdBindVertexBuffers(cmdBuffer, 1, 1, instanceBuffers, offsets);
+            boundModelIndex = draw.modelIndex;
+        }
 
-        // Loop over meshes in the model
-        for (size_t meshIdx = 0; meshIdx < model.idxCnts.size(); ++meshIdx) {
-            // Bind per mesh descriptor set
-            vkCmdBindDescriptorSets(
-                cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline->getPipelineLayout(), 0, 1,
-                &_descriptorSetBundles[modelIndex][meshIdx]->getDescriptorSet(currentFrame), 0,
-                nullptr);
+        auto &model = *_models[draw.modelIndex];
 
-            // Bind vertex buffer (binding 0 for vertex data)
-            VkBuffer vertexBuffers[] = {model.vertexBuffers[meshIdx]->getVkBuffer()};
-            vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
+        // Bind per mesh descriptor set
+        vkCmdBindDescriptorSets(
+            cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline->getPipelineLayout(), 0, 1,
+            &_descriptorSetBundles[draw.modelIndex][draw.meshIndex]->getDescriptorSet(currentFrame),
+            0, nullptr);
 
-            vkCmdBindIndexBuffer(cmdBuffer, model.indexBuffers[meshIdx]->getVkBuffer(), 0,
-                                 VK_INDEX_TYPE_UINT32);
+        // identity for fp32 vertices
+        vkCmdPushConstants(cmdBuffer, _pipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0,
+                           sizeof(VertexDequantization), &model.dequantizations[draw.meshIndex]);
 
-            vkCmdDrawIndexed(cmdBuffer, model.idxCnts[meshIdx],
-                             static_cast<uint32_t>(instanceCount), 0, 0, 0);
-        }
+        // Bind vertex buffer (binding 0 for vertex data)
+        VkBuffer vertexBuffers[] = {model.vertexBuffers[draw.meshIndex]->getVkBuffer()};
+        vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
+
+        vkCmdBindIndexBuffer(cmdBuffer, model.indexBuffers[draw.meshIndex]->getVkBuffer(), 0,
+                             model.indexTypes[draw.meshIndex]);
 
-        auto gpuCommandEnd = std::chrono::steady_clock::now();
-        gpuCommandTime += _getTimeInMilliseconds(gpuCommandStart, gpuCommandEnd);
+        vkCmdDrawIndexed(cmdBuffer, model.idxCnts[draw.meshIndex], draw.instanceCount, 0, 0, 0);
     }
 
+    auto gpuCommandEnd = std::chrono::steady_clock::now();
+    gpuCommandTime += _getTimeInMilliseconds(gpuCommandStart, gpuCommandEnd);
+
     // Store accumulated timing data
     timings.instanceDataPrep    = instancePrepTime;
     timings.bufferUpdates       = bufferUpdateTime;
@@ -724,6 +949,7 @@ void Renderer::drawFrame(size_t currentFrame, size_t imageIndex,
     // Command buffer finish timing
     auto finishStart = std::chrono::steady_clock::now();
     vkCmdEndRenderPass(cmdBuffer);
+    _endGpuTiming(cmdBuffer, currentFrame);
     vkEndCommandBuffer(cmdBuffer);
     auto finishEnd = std::chrono::steady_clock::now();
 
@@ -811,53 +1037,46 @@ void Renderer::_createDefaultTextures() {
         Sampler::AddressMode::kClampToEdge, // V
         Sampler::AddressMode::kClampToEdge  // W
     };
-    _defaultSampler = std::make_unique<Sampler>(_appContext, samplerSettings);
+    VkSampler const defaultSampler = _samplerCache->get(samplerSettings)->getVkSampler();
 
     // 默认baseColor: 白色
-    _defaultBaseColorTexture = std::make_unique<Image>(
+    _defaultBaseColorTexture = std::make_shared<Image>(
         _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_SRGB,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        _defaultSampler->getVkSampler());
+        defaultSampler);
     std::array<uint8_t, 4> whitePixel = {255, 255, 255, 255};
     _uploadTextureData(_defaultBaseColorTexture.get(), whitePixel.data());
 
     // 默认normal: (0.5, 0.5, 1.0)
-    _defaultNormalTexture = std::make_unique<Image>(
+    _defaultNormalTexture = std::make_shared<Image>(
         _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        _defaultSampler->getVkSampler());
+        defaultSampler);
     std::array<uint8_t, 4> normalPixel = {128, 128, 255, 255};
     _uploadTextureData(_defaultNormalTexture.get(), normalPixel.data());
 
     // 默认metalRoughness: (0, 1, 0, 1) - 非金属、粗糙
-    _defaultMetalRoughnessTexture = std::make_unique<Image>(
+    _defaultMetalRoughnessTexture = std::make_shared<Image>(
         _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        _defaultSampler->getVkSampler());
+        defaultSampler);
     std::array<uint8_t, 4> mrPixel = {0, 255, 0, 255};
     _uploadTextureData(_defaultMetalRoughnessTexture.get(), mrPixel.data());
 
     // 默认emissive: 黑色
-    _defaultEmissiveTexture = std::make_unique<Image>(
+    _defaultEmissiveTexture = std::make_shared<Image>(
         _appContext, _logger, ImageDimensions{1, 1, 1}, VK_FORMAT_R8G8B8A8_SRGB,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        _defaultSampler->getVkSampler());
+        defaultSampler);
     std::array<uint8_t, 4> blackPixel = {0, 0, 0, 255};
     _uploadTextureData(_defaultEmissiveTexture.get(), blackPixel.data());
 }
 
 void Renderer::_uploadTextureData(Image *image, const void *pixelData) {
     if (image->getVkImage() == VK_NULL_HANDLE) return;
-    // 创建staging buffer
-    Buffer stagingBuffer(_appContext, 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                         MemoryStyle::kHostVisible);
-    stagingBuffer.fillData(pixelData);
-
-    // 用命令缓冲区复制到image（假设用单次命令缓冲区）
-    VkCommandBuffer cmd = _appContext->beginSingleTimeCommands();
+    auto *uploadManager = _appContext->getUploadManager();
 
     VkBufferImageCopy copyRegion{};
-    copyRegion.bufferOffset                    = 0;
     copyRegion.bufferRowLength                 = 0;
     copyRegion.bufferImageHeight               = 0;
     copyRegion.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -882,19 +1101,19 @@ void Renderer::_uploadTextureData(Image *image, const void *pixelData) {
     barrier.srcAccessMask                   = 0;
     barrier.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
 
-    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                         0, nullptr, 0, nullptr, 1, &barrier);
+    // 录制到上传批次里，和其他纹理一起提交，不再每张纹理等待一次队列
+    vkCmdPipelineBarrier(uploadManager->getCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
-    vkCmdCopyBufferToImage(cmd, stagingBuffer.getVkBuffer(), image->getVkImage(),
-                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+    uploadManager->uploadToImage(image->getVkImage(), copyRegion, pixelData, 4, 4);
 
     barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    _appContext->endSingleTimeCommands(cmd);
+    // the upload may have submitted the batch and opened a new one, fetch the command buffer again
+    vkCmdPipelineBarrier(uploadManager->getCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                         &barrier);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define VK_NO_PROTOTYPES
 
 #include "dotnet/Components.hpp"
+#include "utils/vulkan-wrapper/memory/Model.hpp"
 #include "utils/vulkan-wrapper/pipeline/GfxPipeline.hpp"
 #include "vma/vk_mem_alloc.h"
 #include "volk.h"
@@ -9,6 +10,8 @@
 
 #include "utils/incl/GlmIncl.hpp" // IWYU pragma: keep
 #include <chrono>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -20,13 +23,35 @@ class Logger;
 class ShaderCompiler;
 class Window;
 class ConfigContainer;
-class Model;
 class Image;
 class ImageForwardingPair;
 class BufferBundle;
 class DescriptorSetBundle;
 class Camera;
 class Sampler;
+class SamplerCache;
+class TextureCache;
+class ThreadPool;
+struct E_ShaderReloaded;
+
+// bits of a material variant key, bit i maps to the specialization constant with constant_id i in
+// default.frag
+enum MaterialFeature : uint32_t {
+    kBaseColorTex      = 1U << 0,
+    kNormalTex         = 1U << 1,
+    kMetalRoughnessTex = 1U << 2,
+    kEmissiveTex       = 1U << 3,
+};
+// the number of MaterialFeature bits, kept out of the enum so it's never taken for a flag
+constexpr uint32_t kMaterialFeatureCount = 4U;
+
+// the variant key bits after the material ones, picking the vertex layout of a mesh, the
+// constant_id of kQuantizedVertices in default.vert matches its bit
+enum GeometryFeature : uint32_t {
+    kQuantizedVertices = 1U << kMaterialFeatureCount,
+};
+// the number of bits of a variant key
+constexpr uint32_t kVariantFeatureCount = kMaterialFeatureCount + 1U;
 
 // Detailed timing measurements
 struct DrawFrameTimings {
@@ -37,12 +62,29 @@ struct DrawFrameTimings {
     double gpuCommandRecording = 0.0;
     double commandBufferFinish = 0.0;
     double totalDrawFrame      = 0.0;
+    // gpu time of the render pass, measured the last time this frame in flight was drawn
+    double gpuRenderPass = 0.0;
 };
 
 class Renderer {
   public:
+    // a registered mesh whose model is still loading on the asset loader pool
+    struct PendingModel {
+        int meshId = 0;
+        std::future<Model::Source> source;
+    };
+
+    // the steps that don't need the device, so they can run before the renderer is created
+    // starts loading the models of every mesh registered so far, in registration order
+    static std::vector<PendingModel> loadRegisteredModels(ThreadPool *assetLoaderPool,
+                                                          ConfigContainer *configContainer,
+                                                          Logger *logger);
+    static void precompileShaders(ShaderCompiler *shaderCompiler, Logger *logger);
+
+    // the models are created from the pending ones, the model textures are decoded on the pool
     Renderer(VulkanApplicationContext *appContext, Logger *logger, size_t framesInFlight,
-             ShaderCompiler *shaderCompiler, Window *window, ConfigContainer *configContainer);
+             ShaderCompiler *shaderCompiler, Window *window, ConfigContainer *configContainer,
+             ThreadPool *assetLoaderPool, std::vector<PendingModel> pendingModels);
     ~Renderer();
 
     // disable move and copy
@@ -67,6 +109,8 @@ class Renderer {
         return _deliveryCommandBuffers[imageIndex];
     }
 
+    [[nodiscard]] inline GfxPipeline *getPipeline() const { return _pipeline.get(); }
+
     // Get last frame's detailed timing results
     [[nodiscard]] inline const DrawFrameTimings &getLastFrameTimings() const {
         return _lastFrameTimings;
@@ -87,20 +131,33 @@ class Renderer {
 
     std::vector<std::unique_ptr<Model>> _models{};
 
+    // one sampler per distinct settings, shared by every image of the renderer
+    std::unique_ptr<SamplerCache> _samplerCache = nullptr;
+    // images loaded from files are shared through the texture cache, missing slots share the
+    // default textures
+    std::unique_ptr<TextureCache> _textureCache = nullptr;
     struct ModelImages {
-        std::unique_ptr<Sampler> sharedSampler;
-        std::unique_ptr<Image> baseColor;
-        std::unique_ptr<Image> normalMap;
-        std::unique_ptr<Image> metalRoughness;
-        std::unique_ptr<Image> emissive;
+        std::shared_ptr<Image> baseColor;
+        std::shared_ptr<Image> normalMap;
+        std::shared_ptr<Image> metalRoughness;
+        std::shared_ptr<Image> emissive;
+        // MaterialFeature bits of the textures that actually loaded
+        uint32_t variantKey = 0;
+        // per frame in flight, the bits of the textures its descriptor set samples, the slots of
+        // the others hold the default texture until their upload is done
+        std::vector<uint32_t> boundVariantKeys;
     };
     std::vector<std::vector<ModelImages>> _modelImages{};  // per model per mesh
+    // the variant key without the textures that are still streaming in
+    [[nodiscard]] uint32_t _getReadyVariantKey(ModelImages const &images) const;
+    // binds the textures that arrived since into the frame's descriptor set of the mesh, whose
+    // command buffer is done, and returns the variant key of the textures it samples
+    uint32_t _bindReadyTextures(size_t currentFrame, size_t modelIndex, size_t meshIndex);
 
-    std::unique_ptr<Sampler> _defaultSampler = nullptr;
-    std::unique_ptr<Image> _defaultBaseColorTexture = nullptr;
-    std::unique_ptr<Image> _defaultNormalTexture = nullptr;
-    std::unique_ptr<Image> _defaultMetalRoughnessTexture = nullptr;
-    std::unique_ptr<Image> _defaultEmissiveTexture = nullptr;
+    std::shared_ptr<Image> _defaultBaseColorTexture = nullptr;
+    std::shared_ptr<Image> _defaultNormalTexture = nullptr;
+    std::shared_ptr<Image> _defaultMetalRoughnessTexture = nullptr;
+    std::shared_ptr<Image> _defaultEmissiveTexture = nullptr;
 
     VkRenderPass _renderPass;
 
@@ -113,6 +170,7 @@ class Renderer {
     // pipeline
     std::unique_ptr<GfxPipeline> _pipeline = nullptr;
     void _createGraphicsPipeline();
+    void _onShaderReloaded(E_ShaderReloaded const &event);
 
     // buffers
     std::vector<std::unique_ptr<BufferBundle>> _renderInfoBufferBundles;
@@ -121,6 +179,15 @@ class Renderer {
     std::vector<std::unique_ptr<BufferBundle>> _instanceBufferBundles;
 
     mutable DrawFrameTimings _lastFrameTimings;
+
+    // timestamps around the render pass, a pair per frame in flight
+    VkQueryPool _timestampQueryPool = VK_NULL_HANDLE;
+    float _timestampPeriod          = 0.0F;
+    std::vector<bool> _timestampsWritten{};
+    void _createTimestampQueryPool();
+    // returns the gpu time of the previous use of this frame in flight, in milliseconds
+    double _beginGpuTiming(VkCommandBuffer cmdBuffer, size_t currentFrame);
+    void _endGpuTiming(VkCommandBuffer cmdBuffer, size_t currentFrame);
     double _getTimeInMilliseconds(std::chrono::steady_clock::time_point start,
                                   std::chrono::steady_clock::time_point end) const;
 
@@ -132,7 +199,10 @@ class Renderer {
     void _createColorResources();
 
     void _createDescriptorSetBundles();
-    void _createModelImages();
+    // each model is created as soon as its own source is loaded, while the later ones still are
+    void _createModels(std::vector<PendingModel> pendingModels);
+    // the textures are decoded on the pool first when there is one
+    void _createModelImages(ThreadPool *threadPool = nullptr);
     void _createBuffersAndBufferBundles();
     void _updateBufferData(size_t currentFrame, size_t modelIndex, glm::mat4 model_matrix);
     void _updateMaterialData(uint32_t currentFrame, size_t modelIndex, size_t meshIndex,
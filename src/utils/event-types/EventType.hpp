@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 // modules can use this event to make a quest to the caller to block the render loop
 struct E_RenderLoopBlockRequest {
@@ -9,3 +11,12 @@ struct E_RenderLoopBlockRequest {
 
 // after the caller's render loop comes to a halt, this event is triggered
 struct E_RenderLoopBlocked {};
+
+// fired at a frame boundary once the shaders of a watched pipeline have been recompiled, the
+// stages the pipeline does not use are left empty
+struct E_ShaderReloaded {
+    std::string fullPathToShaderSourceCode;
+    std::vector<uint32_t> vertCode;
+    std::vector<uint32_t> fragCode;
+    std::vector<uint32_t> compCode;
+};
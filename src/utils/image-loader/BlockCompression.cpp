@@ -0,0 +1,363 @@
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+constexpr uint32_t kBlockDim       = 4;
+constexpr uint32_t kTexelsPerBlock = kBlockDim * kBlockDim;
+
+// rgba of the 16 texels of a block
+using Block = std::array<std::array<float, 4>, kTexelsPerBlock>;
+
+// interpolation weights of the 4 bit bc7 indices, out of 64
+constexpr std::array<int, 16> kBc7Weights = {0,  4,  9,  13, 17, 21, 26, 30,
+                                             34, 38, 43, 47, 51, 55, 60, 64};
+
+// writes the fields of a block from the least significant bit on
+struct BitWriter {
+    unsigned char *dst;
+    uint32_t bitOffset = 0;
+
+    void write(uint32_t value, uint32_t bitCount) {
+        for (uint32_t i = 0; i < bitCount; i++, bitOffset++) {
+            if (((value >> i) & 1U) != 0) {
+                dst[bitOffset / 8] |= static_cast<unsigned char>(1U << (bitOffset % 8));
+            }
+        }
+    }
+};
+
+Block _fetchBlock(unsigned char const *rgba, uint32_t width, uint32_t height, uint32_t blockX,
+                  uint32_t blockY) {
+    Block block{};
+    for (uint32_t y = 0; y < kBlockDim; y++) {
+        uint32_t const texelY = std::min(blockY * kBlockDim + y, height - 1);
+        for (uint32_t x = 0; x < kBlockDim; x++) {
+            uint32_t const texelX    = std::min(blockX * kBlockDim + x, width - 1);
+            unsigned char const *src = rgba + (static_cast<size_t>(texelY) * width + texelX) * 4;
+            for (uint32_t c = 0; c < 4; c++) {
+                block[y * kBlockDim + x][c] = src[c];
+            }
+        }
+    }
+    return block;
+}
+
+// mean and principal axis of the first channelCount channels, the axis is found by power
+// iteration on the covariance matrix, endpoints are then picked along it
+void _principalAxis(Block const &block, uint32_t channelCount, std::array<float, 4> &mean,
+                    std::array<float, 4> &axis) {
+    mean = {};
+    for (auto const &texel : block) {
+        for (uint32_t c = 0; c < channelCount; c++) {
+            mean[c] += texel[c] / kTexelsPerBlock;
+        }
+    }
+
+    std::array<std::array<float, 4>, 4> covariance{};
+    for (auto const &texel : block) {
+        for (uint32_t i = 0; i < channelCount; i++) {
+            for (uint32_t j = 0; j < channelCount; j++) {
+                covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+    }
+
+    axis = {1.0F, 1.0F, 1.0F, 1.0F};
+    for (int iteration = 0; iteration < 8; iteration++) {
+        std::array<float, 4> next{};
+        for (uint32_t i = 0; i < channelCount; i++) {
+            for (uint32_t j = 0; j < channelCount; j++) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+        }
+        float length = 0.0F;
+        for (uint32_t c = 0; c < channelCount; c++) {
+            length += next[c] * next[c];
+        }
+        length = std::sqrt(length);
+        // a flat block, any axis does
+        if (length < 1e-6F) {
+            break;
+        }
+        for (uint32_t c = 0; c < channelCount; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+}
+
+// the two extremes of the block along its principal axis
+void _findEndpoints(Block const &block, uint32_t channelCount, std::array<float, 4> &low,
+                    std::array<float, 4> &high) {
+    std::array<float, 4> mean{};
+    std::array<float, 4> axis{};
+    _principalAxis(block, channelCount, mean, axis);
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for (auto const &texel : block) {
+        float projection = 0.0F;
+        for (uint32_t c = 0; c < channelCount; c++) {
+            projection += (texel[c] - mean[c]) * axis[c];
+        }
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (uint32_t c = 0; c < channelCount; c++) {
+        low[c]  = std::clamp(mean[c] + axis[c] * minProjection, 0.0F, 255.0F);
+        high[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0F, 255.0F);
+    }
+}
+
+float _distanceSquared(std::array<float, 4> const &a, std::array<float, 4> const &b,
+                       uint32_t channelCount) {
+    float distance = 0.0F;
+    for (uint32_t c = 0; c < channelCount; c++) {
+        distance += (a[c] - b[c]) * (a[c] - b[c]);
+    }
+    return distance;
+}
+
+uint16_t _toRgb565(std::array<float, 4> const &color) {
+    auto const r = static_cast<uint16_t>(std::lround(color[0] * 31.0F / 255.0F));
+    auto const g = static_cast<uint16_t>(std::lround(color[1] * 63.0F / 255.0F));
+    auto const b = static_cast<uint16_t>(std::lround(color[2] * 31.0F / 255.0F));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// expanded the way the decoder does it
+std::array<float, 4> _fromRgb565(uint16_t color) {
+    uint32_t const r = (color >> 11) & 31U;
+    uint32_t const g = (color >> 5) & 63U;
+    uint32_t const b = color & 31U;
+    return {static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)),
+            static_cast<float>((b << 3) | (b >> 2)), 255.0F};
+}
+
+void _encodeBc1(Block const &block, unsigned char *dst) {
+    std::array<float, 4> low{};
+    std::array<float, 4> high{};
+    _findEndpoints(block, 3, low, high);
+
+    // color0 > color1 selects the four color mode without punch through alpha
+    uint16_t color0 = _toRgb565(high);
+    uint16_t color1 = _toRgb565(low);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    // with equal endpoints every index would decode to color0 anyway
+    if (color0 != color1) {
+        std::array<std::array<float, 4>, 4> palette{};
+        palette[0] = _fromRgb565(color0);
+        palette[1] = _fromRgb565(color1);
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = (2.0F * palette[0][c] + palette[1][c]) / 3.0F;
+            palette[3][c] = (palette[0][c] + 2.0F * palette[1][c]) / 3.0F;
+        }
+
+        for (uint32_t i = 0; i < kTexelsPerBlock; i++) {
+            uint32_t bestIndex = 0;
+            float bestDistance = std::numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 4; p++) {
+                float const distance = _distanceSquared(block[i], palette[p], 3);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex    = p;
+                }
+            }
+            indices |= bestIndex << (2 * i);
+        }
+    }
+
+    dst[0] = static_cast<unsigned char>(color0 & 0xFFU);
+    dst[1] = static_cast<unsigned char>(color0 >> 8);
+    dst[2] = static_cast<unsigned char>(color1 & 0xFFU);
+    dst[3] = static_cast<unsigned char>(color1 >> 8);
+    for (uint32_t i = 0; i < 4; i++) {
+        dst[4 + i] = static_cast<unsigned char>((indices >> (8 * i)) & 0xFFU);
+    }
+}
+
+void _encodeBc4(Block const &block, uint32_t channel, unsigned char *dst) {
+    float minValue = 255.0F;
+    float maxValue = 0.0F;
+    for (auto const &texel : block) {
+        minValue = std::min(minValue, texel[channel]);
+        maxValue = std::max(maxValue, texel[channel]);
+    }
+
+    // red0 > red1 selects the mode with six interpolated values
+    auto const red0 = static_cast<uint32_t>(maxValue);
+    auto const red1 = static_cast<uint32_t>(minValue);
+
+    uint64_t indices = 0;
+    if (red0 != red1) {
+        std::array<float, 8> palette{};
+        palette[0] = static_cast<float>(red0);
+        palette[1] = static_cast<float>(red1);
+        for (uint32_t p = 2; p < 8; p++) {
+            palette[p] =
+                (static_cast<float>(8 - p) * palette[0] + static_cast<float>(p - 1) * palette[1]) /
+                7.0F;
+        }
+
+        for (uint32_t i = 0; i < kTexelsPerBlock; i++) {
+            uint64_t bestIndex = 0;
+            float bestDistance = std::numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 8; p++) {
+                float const distance = std::abs(block[i][channel] - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex    = p;
+                }
+            }
+            indices |= bestIndex << (3 * i);
+        }
+    }
+
+    dst[0] = static_cast<unsigned char>(red0);
+    dst[1] = static_cast<unsigned char>(red1);
+    for (uint32_t i = 0; i < 6; i++) {
+        dst[2 + i] = static_cast<unsigned char>((indices >> (8 * i)) & 0xFFU);
+    }
+}
+
+void _encodeBc7Mode6(Block const &block, unsigned char *dst) {
+    std::array<float, 4> low{};
+    std::array<float, 4> high{};
+    _findEndpoints(block, 4, low, high);
+
+    // endpoints are 7 bits per channel plus a p-bit shared by the channels of each endpoint, every
+    // p-bit combination is tried
+    std::array<std::array<uint32_t, 4>, 2> bestEndpoints{};
+    std::array<uint32_t, 2> bestPBits{};
+    std::array<uint32_t, kTexelsPerBlock> bestIndices{};
+    float bestError = std::numeric_limits<float>::max();
+    for (uint32_t pBits = 0; pBits < 4; pBits++) {
+        std::array<uint32_t, 2> const pBit = {pBits & 1U, pBits >> 1};
+
+        std::array<std::array<uint32_t, 4>, 2> endpoints{};
+        std::array<std::array<int, 4>, 2> unquantized{};
+        for (uint32_t c = 0; c < 4; c++) {
+            for (uint32_t e = 0; e < 2; e++) {
+                float const value = e == 0 ? low[c] : high[c];
+                auto const quantized =
+                    std::clamp(std::lround((value - static_cast<float>(pBit[e])) / 2.0F), 0L, 127L);
+                endpoints[e][c]   = static_cast<uint32_t>(quantized);
+                unquantized[e][c] = static_cast<int>((endpoints[e][c] << 1) | pBit[e]);
+            }
+        }
+
+        std::array<std::array<float, 4>, 16> palette{};
+        for (uint32_t p = 0; p < 16; p++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                palette[p][c] = static_cast<float>(
+                    ((64 - kBc7Weights[p]) * unquantized[0][c] +
+                     kBc7Weights[p] * unquantized[1][c] + 32) >>
+                    6);
+            }
+        }
+
+        std::array<uint32_t, kTexelsPerBlock> indices{};
+        float error = 0.0F;
+        for (uint32_t i = 0; i < kTexelsPerBlock; i++) {
+            float bestDistance = std::numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 16; p++) {
+                float const distance = _distanceSquared(block[i], palette[p], 4);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    indices[i]   = p;
+                }
+            }
+            error += bestDistance;
+        }
+
+        if (error < bestError) {
+            bestError     = error;
+            bestEndpoints = endpoints;
+            bestPBits     = pBit;
+            bestIndices   = indices;
+        }
+    }
+
+    // the most significant bit of the first index is implicitly 0, swap the endpoints otherwise
+    if (bestIndices[0] >= 8) {
+        std::swap(bestEndpoints[0], bestEndpoints[1]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for (auto &index : bestIndices) {
+            index = 15 - index;
+        }
+    }
+
+    std::memset(dst, 0, 16);
+    BitWriter writer{dst};
+    // mode 6 is a single 1 after six 0s
+    writer.write(1U << 6, 7);
+    for (uint32_t c = 0; c < 4; c++) {
+        writer.write(bestEndpoints[0][c], 7);
+        writer.write(bestEndpoints[1][c], 7);
+    }
+    writer.write(bestPBits[0], 1);
+    writer.write(bestPBits[1], 1);
+    writer.write(bestIndices[0], 3);
+    for (uint32_t i = 1; i < kTexelsPerBlock; i++) {
+        writer.write(bestIndices[i], 4);
+    }
+}
+} // namespace
+
+uint32_t BlockCompression::getBlockByteSize(BlockFormat format) {
+    switch (format) {
+    case BlockFormat::kBc1:
+    case BlockFormat::kBc4:
+        return 8;
+    case BlockFormat::kBc5:
+    case BlockFormat::kBc7:
+        return 16;
+    }
+    return 0;
+}
+
+size_t BlockCompression::getCompressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+    size_t const blockCountX = (width + kBlockDim - 1) / kBlockDim;
+    size_t const blockCountY = (height + kBlockDim - 1) / kBlockDim;
+    return blockCountX * blockCountY * getBlockByteSize(format);
+}
+
+void BlockCompression::compressImage(unsigned char const *rgba, uint32_t width, uint32_t height,
+                                     BlockFormat format, unsigned char *dst) {
+    uint32_t const blockCountX   = (width + kBlockDim - 1) / kBlockDim;
+    uint32_t const blockCountY   = (height + kBlockDim - 1) / kBlockDim;
+    uint32_t const blockByteSize = getBlockByteSize(format);
+
+    for (uint32_t blockY = 0; blockY < blockCountY; blockY++) {
+        for (uint32_t blockX = 0; blockX < blockCountX; blockX++) {
+            Block const block = _fetchBlock(rgba, width, height, blockX, blockY);
+            unsigned char *blockDst =
+                dst + (static_cast<size_t>(blockY) * blockCountX + blockX) * blockByteSize;
+
+            switch (format) {
+            case BlockFormat::kBc1:
+                _encodeBc1(block, blockDst);
+                break;
+            case BlockFormat::kBc4:
+                _encodeBc4(block, 0, blockDst);
+                break;
+            case BlockFormat::kBc5:
+                _encodeBc4(block, 0, blockDst);
+                _encodeBc4(block, 1, blockDst + 8);
+                break;
+            case BlockFormat::kBc7:
+                _encodeBc7Mode6(block, blockDst);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// cpu encoders for the block compressed formats that textures are cooked to, the input is always
+// tightly packed rgba8
+//
+// every format works on 4x4 texel blocks stored in row major order, partial blocks at the right
+// and bottom edges repeat the edge texels
+namespace BlockCompression {
+
+enum class BlockFormat {
+    // rgb endpoints with 2 bit indices, 8 bytes per block, for masks
+    kBc1,
+    // a single channel with 3 bit indices, 8 bytes per block
+    kBc4,
+    // two bc4 blocks for red and green, 16 bytes per block, for normal maps
+    kBc5,
+    // rgba, 16 bytes per block, only mode 6 (one subset, 4 bit indices) is emitted
+    kBc7,
+};
+
+uint32_t getBlockByteSize(BlockFormat format);
+size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+// dst must hold getCompressedSize bytes
+void compressImage(unsigned char const *rgba, uint32_t width, uint32_t height, BlockFormat format,
+                   unsigned char *dst);
+}; // namespace BlockCompression
@@ -0,0 +1,3 @@
+// the only translation unit that compiles stb_image, everything else just includes the header
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
@@ -0,0 +1,218 @@
+#include "Ktx2File.hpp"
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+constexpr std::array<unsigned char, 12> kIdentifier = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                                       '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+// identifier, header and index
+constexpr size_t kLevelIndexOffset    = 80;
+constexpr size_t kLevelIndexEntrySize = 24;
+
+// khr data format descriptor values, see khr_df.h
+constexpr uint32_t kDfModelBc1a       = 128;
+constexpr uint32_t kDfModelBc4        = 131;
+constexpr uint32_t kDfModelBc5        = 132;
+constexpr uint32_t kDfModelBc7        = 134;
+constexpr uint32_t kDfPrimariesBt709  = 1;
+constexpr uint32_t kDfTransferLinear  = 1;
+constexpr uint32_t kDfVersion         = 2;
+constexpr uint32_t kDfBasicHeaderSize = 24;
+constexpr uint32_t kDfSampleSize      = 16;
+
+struct FormatDescription {
+    BlockCompression::BlockFormat blockFormat;
+    uint32_t colorModel;
+    uint32_t blockByteSize;
+    // one sample per channel, each covering a part of the block
+    uint32_t sampleCount;
+};
+
+std::optional<FormatDescription> _describeFormat(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        return FormatDescription{BlockCompression::BlockFormat::kBc1, kDfModelBc1a, 8, 1};
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return FormatDescription{BlockCompression::BlockFormat::kBc4, kDfModelBc4, 8, 1};
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return FormatDescription{BlockCompression::BlockFormat::kBc5, kDfModelBc5, 16, 2};
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        return FormatDescription{BlockCompression::BlockFormat::kBc7, kDfModelBc7, 16, 1};
+    default:
+        return std::nullopt;
+    }
+}
+
+void _appendU32(std::vector<unsigned char> &bytes, uint32_t value) {
+    for (uint32_t i = 0; i < 4; i++) {
+        bytes.push_back(static_cast<unsigned char>((value >> (8 * i)) & 0xFFU));
+    }
+}
+
+void _appendU64(std::vector<unsigned char> &bytes, uint64_t value) {
+    _appendU32(bytes, static_cast<uint32_t>(value & 0xFFFFFFFFU));
+    _appendU32(bytes, static_cast<uint32_t>(value >> 32));
+}
+
+uint32_t _readU32(std::vector<unsigned char> const &bytes, size_t offset) {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        value |= static_cast<uint32_t>(bytes[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+uint64_t _readU64(std::vector<unsigned char> const &bytes, size_t offset) {
+    return static_cast<uint64_t>(_readU32(bytes, offset)) |
+           (static_cast<uint64_t>(_readU32(bytes, offset + 4)) << 32);
+}
+
+// the basic descriptor block, the loader doesn't need it but the spec requires it
+void _appendDataFormatDescriptor(std::vector<unsigned char> &bytes,
+                                 FormatDescription const &description) {
+    uint32_t const blockSize = kDfBasicHeaderSize + kDfSampleSize * description.sampleCount;
+    _appendU32(bytes, 4 + blockSize); // dfdTotalSize
+    _appendU32(bytes, 0);             // vendorId and descriptorType
+    _appendU32(bytes, kDfVersion | (blockSize << 16));
+    // no flags, so straight alpha
+    _appendU32(bytes,
+               description.colorModel | (kDfPrimariesBt709 << 8) | (kDfTransferLinear << 16));
+    _appendU32(bytes, 3 | (3 << 8));              // 4x4x1x1 texel blocks, stored minus one
+    _appendU32(bytes, description.blockByteSize); // bytesPlane0
+    _appendU32(bytes, 0);                         // bytesPlane4..7
+
+    uint32_t const sampleBitLength = description.blockByteSize * 8 / description.sampleCount;
+    for (uint32_t i = 0; i < description.sampleCount; i++) {
+        // bitOffset, bitLength minus one and the channel id, which is just the sample index for
+        // the formats written here
+        _appendU32(bytes, (i * sampleBitLength) | ((sampleBitLength - 1) << 16) | (i << 24));
+        _appendU32(bytes, 0);          // samplePosition
+        _appendU32(bytes, 0);          // sampleLower
+        _appendU32(bytes, 0xFFFFFFFF); // sampleUpper
+    }
+}
+} // namespace
+
+bool Ktx2File::write(std::string const &path, Ktx2Texture const &texture) {
+    auto const description = _describeFormat(texture.format);
+    if (!description || texture.levels.empty()) {
+        return false;
+    }
+    auto const levelCount = static_cast<uint32_t>(texture.levels.size());
+
+    std::vector<unsigned char> dataFormatDescriptor;
+    _appendDataFormatDescriptor(dataFormatDescriptor, *description);
+
+    size_t const dfdOffset = kLevelIndexOffset + kLevelIndexEntrySize * levelCount;
+
+    // the levels are stored smallest first, each aligned to the block size
+    std::vector<unsigned char> levelData;
+    std::vector<uint64_t> levelOffsets(levelCount);
+    size_t const levelDataOffset = dfdOffset + dataFormatDescriptor.size();
+    for (uint32_t i = levelCount; i-- > 0;) {
+        auto const &level = texture.levels[i];
+        while ((levelDataOffset + levelData.size()) % description->blockByteSize != 0) {
+            levelData.push_back(0);
+        }
+        levelOffsets[i] = levelDataOffset + levelData.size();
+        levelData.insert(levelData.end(), texture.data.begin() + level.offset,
+                         texture.data.begin() + level.offset + level.size);
+    }
+
+    std::vector<unsigned char> bytes(kIdentifier.begin(), kIdentifier.end());
+    _appendU32(bytes, static_cast<uint32_t>(texture.format));
+    _appendU32(bytes, 1); // typeSize, 1 for block compressed formats
+    _appendU32(bytes, texture.width);
+    _appendU32(bytes, texture.height);
+    _appendU32(bytes, 0); // pixelDepth
+    _appendU32(bytes, 0); // layerCount, not an array
+    _appendU32(bytes, 1); // faceCount
+    _appendU32(bytes, levelCount);
+    _appendU32(bytes, 0); // supercompressionScheme
+
+    _appendU32(bytes, static_cast<uint32_t>(dfdOffset));
+    _appendU32(bytes, static_cast<uint32_t>(dataFormatDescriptor.size()));
+    _appendU32(bytes, 0); // kvdByteOffset
+    _appendU32(bytes, 0); // kvdByteLength
+    _appendU64(bytes, 0); // sgdByteOffset
+    _appendU64(bytes, 0); // sgdByteLength
+
+    for (uint32_t i = 0; i < levelCount; i++) {
+        _appendU64(bytes, levelOffsets[i]);
+        _appendU64(bytes, texture.levels[i].size); // byteLength
+        _appendU64(bytes, texture.levels[i].size); // uncompressedByteLength
+    }
+    bytes.insert(bytes.end(), dataFormatDescriptor.begin(), dataFormatDescriptor.end());
+    bytes.insert(bytes.end(), levelData.begin(), levelData.end());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+std::optional<Ktx2File::Ktx2Texture> Ktx2File::read(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    Ktx2Texture texture{};
+    texture.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    auto const &bytes = texture.data;
+    if (bytes.size() < kLevelIndexOffset ||
+        std::memcmp(bytes.data(), kIdentifier.data(), kIdentifier.size()) != 0) {
+        return std::nullopt;
+    }
+
+    texture.format                  = static_cast<VkFormat>(_readU32(bytes, 12));
+    texture.width                   = _readU32(bytes, 20);
+    texture.height                  = _readU32(bytes, 24);
+    uint32_t const pixelDepth       = _readU32(bytes, 28);
+    uint32_t const layerCount       = _readU32(bytes, 32);
+    uint32_t const faceCount        = _readU32(bytes, 36);
+    uint32_t const levelCount       = std::max(_readU32(bytes, 40), 1U);
+    uint32_t const supercompression = _readU32(bytes, 44);
+    auto const description          = _describeFormat(texture.format);
+    if (!description || texture.width == 0 || texture.height == 0 || pixelDepth > 1 ||
+        layerCount > 1 || faceCount != 1 || supercompression != 0 ||
+        levelCount > MipmapGenerator::getMipLevelCount(texture.width, texture.height) ||
+        bytes.size() < kLevelIndexOffset + kLevelIndexEntrySize * levelCount) {
+        return std::nullopt;
+    }
+
+    // every level is uploaded with a copy of its full extent, so a stale or truncated file must
+    // not hold less than that, the caller cooks the texture again instead
+    uint32_t levelWidth  = texture.width;
+    uint32_t levelHeight = texture.height;
+    for (uint32_t i = 0; i < levelCount; i++) {
+        size_t const entryOffset = kLevelIndexOffset + kLevelIndexEntrySize * i;
+        uint64_t const offset    = _readU64(bytes, entryOffset);
+        uint64_t const size      = _readU64(bytes, entryOffset + 8);
+        if (size != BlockCompression::getCompressedSize(description->blockFormat, levelWidth,
+                                                        levelHeight) ||
+            offset % description->blockByteSize != 0 || offset > bytes.size() ||
+            size > bytes.size() - offset) {
+            return std::nullopt;
+        }
+
+        MipmapGenerator::MipLevel level{};
+        level.width  = levelWidth;
+        level.height = levelHeight;
+        level.offset = static_cast<size_t>(offset);
+        level.size   = static_cast<size_t>(size);
+        texture.levels.push_back(level);
+
+        levelWidth  = std::max(levelWidth / 2, 1U);
+        levelHeight = std::max(levelHeight / 2, 1U);
+    }
+    return texture;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "MipmapGenerator.hpp"
+
+#include "volk.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// minimal KTX 2.0 container support for cooked textures: a single 2d image with its mip levels,
+// no array layers, no cube faces and no supercompression
+// spec: https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+namespace Ktx2File {
+
+struct Ktx2Texture {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    // level 0 first, the offsets point into data
+    std::vector<MipmapGenerator::MipLevel> levels;
+    std::vector<unsigned char> data;
+};
+
+// only the block compressed formats the texture cooker produces can be written
+bool write(std::string const &path, Ktx2Texture const &texture);
+
+// returns nullopt if the file is missing, uses anything beyond what write produces, or its levels
+// don't hold exactly the blocks of their extent
+std::optional<Ktx2Texture> read(std::string const &path);
+}; // namespace Ktx2File
@@ -0,0 +1,73 @@
+#include "MipmapGenerator.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+void _downsample(unsigned char const *src, uint32_t srcWidth, uint32_t srcHeight,
+                 unsigned char *dst, uint32_t dstWidth, uint32_t dstHeight,
+                 uint32_t channelCount) {
+    size_t const srcRowSize = static_cast<size_t>(srcWidth) * channelCount;
+    size_t const dstRowSize = static_cast<size_t>(dstWidth) * channelCount;
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        unsigned char const *row0 = src + std::min(y * 2, srcHeight - 1) * srcRowSize;
+        unsigned char const *row1 = src + std::min(y * 2 + 1, srcHeight - 1) * srcRowSize;
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            size_t const x0 = std::min(x * 2, srcWidth - 1) * channelCount;
+            size_t const x1 = std::min(x * 2 + 1, srcWidth - 1) * channelCount;
+
+            unsigned char const *t00 = row0 + x0;
+            unsigned char const *t01 = row0 + x1;
+            unsigned char const *t10 = row1 + x0;
+            unsigned char const *t11 = row1 + x1;
+            unsigned char *out       = dst + y * dstRowSize + x * channelCount;
+            for (uint32_t c = 0; c < channelCount; c++) {
+                // +2 rounds to nearest
+                out[c] = static_cast<unsigned char>((t00[c] + t01[c] + t10[c] + t11[c] + 2) / 4);
+            }
+        }
+    }
+}
+} // namespace
+
+uint32_t MipmapGenerator::getMipLevelCount(uint32_t width, uint32_t height) {
+    return std::bit_width(std::max({width, height, 1U}));
+}
+
+MipmapGenerator::MipChain MipmapGenerator::generateMipChain(unsigned char const *baseLevel,
+                                                            uint32_t width, uint32_t height,
+                                                            uint32_t channelCount) {
+    MipChain mipChain{};
+    uint32_t const levelCount = getMipLevelCount(width, height);
+
+    // lay the levels out first, so texels is only allocated once
+    size_t totalSize     = 0;
+    uint32_t levelWidth  = width;
+    uint32_t levelHeight = height;
+    for (uint32_t i = 1; i < levelCount; i++) {
+        levelWidth  = std::max(levelWidth / 2, 1U);
+        levelHeight = std::max(levelHeight / 2, 1U);
+
+        MipLevel level{};
+        level.width  = levelWidth;
+        level.height = levelHeight;
+        level.offset = totalSize;
+        level.size   = static_cast<size_t>(levelWidth) * levelHeight * channelCount;
+        mipChain.levels.push_back(level);
+        totalSize += level.size;
+    }
+    mipChain.texels.resize(totalSize);
+
+    // every level is filtered from the previous one
+    unsigned char const *src = baseLevel;
+    uint32_t srcWidth        = width;
+    uint32_t srcHeight       = height;
+    for (auto const &level : mipChain.levels) {
+        unsigned char *dst = mipChain.texels.data() + level.offset;
+        _downsample(src, srcWidth, srcHeight, dst, level.width, level.height, channelCount);
+        src       = dst;
+        srcWidth  = level.width;
+        srcHeight = level.height;
+    }
+    return mipChain;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// cpu side mip chain generation, used where the gpu can't blit: on the transfer queue, or for
+// formats without linear blit support
+namespace MipmapGenerator {
+
+struct MipLevel {
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    // byte offset of the level in MipChain::texels
+    size_t offset = 0;
+    size_t size   = 0;
+};
+
+// every level after the base one, tightly packed one after another
+struct MipChain {
+    std::vector<MipLevel> levels;
+    std::vector<unsigned char> texels;
+};
+
+// floor(log2(max(width, height))) + 1, the base level included
+uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+// downsamples the base level with a 2x2 box filter until 1x1, odd dimensions repeat their last
+// row / column, texels are 8 bit unorm with channelCount channels each
+MipChain generateMipChain(unsigned char const *baseLevel, uint32_t width, uint32_t height,
+                          uint32_t channelCount);
+}; // namespace MipmapGenerator
@@ -0,0 +1,159 @@
+#include "TextureCooker.hpp"
+
+#include "BlockCompression.hpp"
+#include "MipmapGenerator.hpp"
+#include "utils/logger/Logger.hpp"
+
+#include "stb_image.h"
+
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+std::optional<BlockCompression::BlockFormat> _toBlockFormat(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        return BlockCompression::BlockFormat::kBc1;
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return BlockCompression::BlockFormat::kBc4;
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return BlockCompression::BlockFormat::kBc5;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        return BlockCompression::BlockFormat::kBc7;
+    default:
+        return std::nullopt;
+    }
+}
+
+char const *_getFormatTag(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        return "bc1";
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return "bc4";
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return "bc5";
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        return "bc7";
+    default:
+        return "unknown";
+    }
+}
+
+bool _isCacheFresh(std::filesystem::path const &sourcePath,
+                   std::filesystem::path const &cookedPath) {
+    std::error_code errorCode;
+    auto const cookedTime = std::filesystem::last_write_time(cookedPath, errorCode);
+    if (errorCode) {
+        return false;
+    }
+    auto const sourceTime = std::filesystem::last_write_time(sourcePath, errorCode);
+    // a shipped cache without its source is still usable
+    return errorCode || cookedTime >= sourceTime;
+}
+
+std::optional<Ktx2File::Ktx2Texture> _cook(std::string const &sourcePath, VkFormat format,
+                                           BlockCompression::BlockFormat blockFormat) {
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+    auto *rgba   = stbi_load(sourcePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (rgba == nullptr) {
+        return std::nullopt;
+    }
+
+    Ktx2File::Ktx2Texture texture{};
+    texture.format = format;
+    texture.width  = static_cast<uint32_t>(width);
+    texture.height = static_cast<uint32_t>(height);
+
+    auto const mipChain =
+        MipmapGenerator::generateMipChain(rgba, texture.width, texture.height, 4);
+
+    // the base level first, then the levels of the chain
+    MipmapGenerator::MipLevel baseLevel{};
+    baseLevel.width  = texture.width;
+    baseLevel.height = texture.height;
+    std::vector<std::pair<MipmapGenerator::MipLevel, unsigned char const *>> sourceLevels = {
+        {baseLevel, rgba}};
+    for (auto const &level : mipChain.levels) {
+        sourceLevels.emplace_back(level, mipChain.texels.data() + level.offset);
+    }
+
+    size_t totalSize = 0;
+    for (auto const &[level, texels] : sourceLevels) {
+        MipmapGenerator::MipLevel compressedLevel{};
+        compressedLevel.width  = level.width;
+        compressedLevel.height = level.height;
+        compressedLevel.offset = totalSize;
+        compressedLevel.size =
+            BlockCompression::getCompressedSize(blockFormat, level.width, level.height);
+        texture.levels.push_back(compressedLevel);
+        totalSize += compressedLevel.size;
+    }
+    texture.data.resize(totalSize);
+
+    for (size_t i = 0; i < sourceLevels.size(); i++) {
+        auto const &[level, texels] = sourceLevels[i];
+        BlockCompression::compressImage(texels, level.width, level.height, blockFormat,
+                                        texture.data.data() + texture.levels[i].offset);
+    }
+
+    stbi_image_free(rgba);
+    return texture;
+}
+} // namespace
+
+bool TextureCooker::isCookable(VkFormat format) { return _toBlockFormat(format).has_value(); }
+
+std::string TextureCooker::getCookedPath(std::string const &sourcePath, VkFormat format) {
+    std::filesystem::path cookedPath{sourcePath};
+    cookedPath.replace_extension(std::string(".") + _getFormatTag(format) + ".ktx2");
+    return cookedPath.string();
+}
+
+std::optional<Ktx2File::Ktx2Texture>
+TextureCooker::loadOrCook(std::string const &sourcePath, VkFormat format, Logger *logger) {
+    auto const blockFormat = _toBlockFormat(format);
+    if (!blockFormat) {
+        logger->error("TextureCooker: format {} can't be cooked", static_cast<int>(format));
+        return std::nullopt;
+    }
+
+    std::string const cookedPath = getCookedPath(sourcePath, format);
+    if (_isCacheFresh(sourcePath, cookedPath)) {
+        auto cachedTexture = Ktx2File::read(cookedPath);
+        if (cachedTexture && cachedTexture->format == format) {
+            return cachedTexture;
+        }
+        logger->warn("TextureCooker: {} is unreadable, cooking it again", cookedPath);
+    }
+
+    auto const cookStart = std::chrono::steady_clock::now();
+    auto texture         = _cook(sourcePath, format, *blockFormat);
+    if (!texture) {
+        logger->error("TextureCooker: failed to load image: {}", sourcePath);
+        return std::nullopt;
+    }
+    auto const cookEnd = std::chrono::steady_clock::now();
+
+    // written next to the final file and renamed, so a concurrent reader never sees half a file
+    std::string const temporaryPath = cookedPath + ".tmp";
+    std::error_code errorCode;
+    bool isCached = Ktx2File::write(temporaryPath, *texture);
+    if (isCached) {
+        std::filesystem::rename(temporaryPath, cookedPath, errorCode);
+        isCached = !errorCode;
+    }
+    if (!isCached) {
+        std::filesystem::remove(temporaryPath, errorCode);
+        logger->warn("TextureCooker: failed to cache {}, it will be cooked again next time",
+                     cookedPath);
+    }
+
+    logger->info("TextureCooker: cooked {} to {} ({} levels) in {:.1f} ms", sourcePath,
+                 _getFormatTag(format), texture->levels.size(),
+                 std::chrono::duration<double, std::milli>(cookEnd - cookStart).count());
+    return texture;
+}
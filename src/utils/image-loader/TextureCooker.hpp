@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Ktx2File.hpp"
+
+#include "volk.h"
+
+#include <optional>
+#include <string>
+
+class Logger;
+
+// turns source images (anything stb_image reads) into block compressed ktx2 files with the full
+// mip chain, cached next to the source so later loads skip decoding and encoding entirely
+namespace TextureCooker {
+
+// VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK or
+// VK_FORMAT_BC7_UNORM_BLOCK
+bool isCookable(VkFormat format);
+
+// foo/bar.png cooked to bc7 is cached at foo/bar.bc7.ktx2
+std::string getCookedPath(std::string const &sourcePath, VkFormat format);
+
+// loads the cached file if it is at least as new as the source, cooks the source and refreshes
+// the cache otherwise, thread safe, returns nullopt when neither can be read
+std::optional<Ktx2File::Ktx2Texture> loadOrCook(std::string const &sourcePath, VkFormat format,
+                                                Logger *logger);
+}; // namespace TextureCooker
@@ -0,0 +1,68 @@
+#include "TextureDecoder.hpp"
+
+#include "MipmapGenerator.hpp"
+#include "TextureCooker.hpp"
+#include "utils/logger/Logger.hpp"
+
+#include "stb_image.h"
+
+#include <algorithm>
+
+namespace {
+std::optional<Ktx2File::Ktx2Texture> _decodeRgba(std::string const &path, bool fullMipChain) {
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+    auto *rgba   = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (rgba == nullptr) {
+        return std::nullopt;
+    }
+
+    Ktx2File::Ktx2Texture texture{};
+    texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+    texture.width  = static_cast<uint32_t>(width);
+    texture.height = static_cast<uint32_t>(height);
+
+    MipmapGenerator::MipLevel baseLevel{};
+    baseLevel.width  = texture.width;
+    baseLevel.height = texture.height;
+    baseLevel.size   = size_t{texture.width} * texture.height * 4;
+
+    MipmapGenerator::MipChain mipChain{};
+    if (fullMipChain) {
+        mipChain = MipmapGenerator::generateMipChain(rgba, texture.width, texture.height, 4);
+    }
+
+    // the chain follows the base level in the same buffer
+    texture.data.resize(baseLevel.size + mipChain.texels.size());
+    std::copy_n(rgba, baseLevel.size, texture.data.begin());
+    std::copy(mipChain.texels.begin(), mipChain.texels.end(),
+              texture.data.begin() + static_cast<std::ptrdiff_t>(baseLevel.size));
+    stbi_image_free(rgba);
+
+    texture.levels.push_back(baseLevel);
+    for (auto level : mipChain.levels) {
+        level.offset += baseLevel.size;
+        texture.levels.push_back(level);
+    }
+    return texture;
+}
+} // namespace
+
+std::optional<Ktx2File::Ktx2Texture> TextureDecoder::decode(std::string const &path,
+                                                            VkFormat format, bool fullMipChain,
+                                                            Logger *logger) {
+    if (TextureCooker::isCookable(format)) {
+        return TextureCooker::loadOrCook(path, format, logger);
+    }
+    if (format != VK_FORMAT_R8G8B8A8_UNORM) {
+        logger->error("TextureDecoder: format {} can't be decoded", static_cast<int>(format));
+        return std::nullopt;
+    }
+
+    auto texture = _decodeRgba(path, fullMipChain);
+    if (!texture) {
+        logger->error("TextureDecoder: failed to load image: {}", path);
+    }
+    return texture;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Ktx2File.hpp"
+
+#include "volk.h"
+
+#include <optional>
+#include <string>
+
+class Logger;
+
+// reads a texture file into every level it is sampled with, entirely on the cpu, so textures can
+// be decoded on worker threads ahead of the image creation, the ktx2 layout doubles as the
+// in-memory form of the result whatever the format
+namespace TextureDecoder {
+
+// VK_FORMAT_R8G8B8A8_UNORM decodes through stb_image and filters the mip chain when fullMipChain
+// is set, block compressed formats go through the texture cooker, which always has the full chain
+// thread safe, returns nullopt when the file can't be read
+std::optional<Ktx2File::Ktx2Texture> decode(std::string const &path, VkFormat format,
+                                            bool fullMipChain, Logger *logger);
+}; // namespace TextureDecoder
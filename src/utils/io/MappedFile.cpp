@@ -0,0 +1,74 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(std::string const &path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    _fileHandle = file;
+
+    LARGE_INTEGER fileSize{};
+    if (GetFileSizeEx(file, &fileSize) == 0 || fileSize.QuadPart == 0) {
+        return;
+    }
+    _mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mappingHandle == nullptr) {
+        return;
+    }
+    _data = static_cast<unsigned char const *>(
+        MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (_data != nullptr) {
+        _size = static_cast<size_t>(fileSize.QuadPart);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mappingHandle != nullptr) {
+        CloseHandle(_mappingHandle);
+    }
+    if (_fileHandle != nullptr) {
+        CloseHandle(_fileHandle);
+    }
+}
+#else
+MappedFile::MappedFile(std::string const &path) {
+    int const file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return;
+    }
+    struct stat fileStat {};
+    if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0) {
+        void *data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE,
+                          file, 0);
+        if (data != MAP_FAILED) {
+            _data = static_cast<unsigned char const *>(data);
+            _size = static_cast<size_t>(fileStat.st_size);
+        }
+    }
+    // the mapping keeps its own reference to the file
+    ::close(file);
+}
+
+MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+        munmap(const_cast<unsigned char *>(_data), _size);
+    }
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// a read only view of a whole file through the os page cache, nothing is read until it is touched
+class MappedFile {
+  public:
+    explicit MappedFile(std::string const &path);
+    ~MappedFile();
+
+    // disable move and copy
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&)                 = delete;
+    MappedFile &operator=(MappedFile &&)      = delete;
+
+    // false when the file is missing, empty or can't be mapped
+    [[nodiscard]] bool isOpen() const { return _data != nullptr; }
+    [[nodiscard]] unsigned char const *getData() const { return _data; }
+    [[nodiscard]] size_t getSize() const { return _size; }
+
+  private:
+    unsigned char const *_data = nullptr;
+    size_t _size               = 0;
+
+#ifdef _WIN32
+    void *_fileHandle    = nullptr;
+    void *_mappingHandle = nullptr;
+#endif
+};
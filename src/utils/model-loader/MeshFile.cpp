@@ -0,0 +1,269 @@
+#include "MeshFile.hpp"
+
+#include "utils/io/MappedFile.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+// the same split ModelLoader uses for the texture paths it reports
+std::string _getDirectory(std::string const &path) {
+    return path.substr(0, path.find_last_of('/')) + "/";
+}
+
+char const *_getFormatTag(VertexFormat vertexFormat) {
+    return vertexFormat == VertexFormat::kQuantized ? "q16" : "f32";
+}
+
+size_t _alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template <typename T> void _appendStruct(std::vector<unsigned char> &bytes, T const &value) {
+    auto const *begin = reinterpret_cast<unsigned char const *>(&value);
+    bytes.insert(bytes.end(), begin, begin + sizeof(T));
+}
+
+void _appendBytes(std::vector<unsigned char> &bytes, void const *data, size_t size) {
+    auto const *begin = static_cast<unsigned char const *>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+}
+} // namespace
+
+std::string MeshFile::getCookedPath(std::string const &sourcePath, VertexFormat vertexFormat) {
+    std::filesystem::path cookedPath{sourcePath};
+    cookedPath.replace_extension(std::string(".") + _getFormatTag(vertexFormat) + ".mesh");
+    return cookedPath.generic_string();
+}
+
+bool MeshFile::isFresh(std::string const &sourcePath, std::string const &cookedPath) {
+    std::error_code errorCode;
+    auto const cookedTime = std::filesystem::last_write_time(cookedPath, errorCode);
+    if (errorCode) {
+        return false;
+    }
+    auto const sourceTime = std::filesystem::last_write_time(sourcePath, errorCode);
+    // a shipped cooked file without its source is still usable
+    return errorCode || cookedTime >= sourceTime;
+}
+
+bool MeshFile::write(std::string const &path, ModelAttributes const &model,
+                     VertexFormat vertexFormat) {
+    bool const isQuantized      = vertexFormat == VertexFormat::kQuantized;
+    std::string const directory = _getDirectory(path);
+
+    std::vector<char> strings;
+    auto const addString = [&](std::string const &fullPath) -> uint32_t {
+        if (fullPath.empty()) {
+            return kNoString;
+        }
+        std::string relativePath = fullPath;
+        if (relativePath.rfind(directory, 0) == 0) {
+            relativePath.erase(0, directory.size());
+        }
+        auto const offset = static_cast<uint32_t>(strings.size());
+        strings.insert(strings.end(), relativePath.begin(), relativePath.end());
+        strings.push_back('\0');
+        return offset;
+    };
+
+    std::vector<MeshRecord> meshRecords;
+    std::vector<Lod> lods;
+    for (auto const &mesh : model.meshes) {
+        size_t const vertexCount =
+            isQuantized ? mesh.quantizedVertices.size() : mesh.vertices.size();
+
+        bool const isShort  = ModelLoader::getIndexType(vertexCount) == VK_INDEX_TYPE_UINT16;
+        auto const &offset  = mesh.dequantization.offset;
+        auto const &scale   = mesh.dequantization.scale;
+
+        MeshRecord record{};
+        record.vertexCount  = static_cast<uint32_t>(vertexCount);
+        record.vertexStride = isQuantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+        record.indexCount   = static_cast<uint32_t>(mesh.indices.size());
+        record.indexSize    = isShort ? sizeof(uint16_t) : sizeof(uint32_t);
+        record.firstLod     = static_cast<uint32_t>(lods.size());
+        record.lodCount     = 1;
+        record.boundsMin    = {mesh.boundsMin.x, mesh.boundsMin.y, mesh.boundsMin.z};
+        record.boundsMax    = {mesh.boundsMax.x, mesh.boundsMax.y, mesh.boundsMax.z};
+        record.dequantizationOffset = {offset.x, offset.y, offset.z, offset.w};
+        record.dequantizationScale  = {scale.x, scale.y, scale.z, scale.w};
+
+        record.texturePaths[kBaseColor]         = addString(mesh.baseColorTexturePath);
+        record.texturePaths[kNormal]            = addString(mesh.normalTexturePath);
+        record.texturePaths[kMetallicRoughness] = addString(mesh.metallicRoughnessTexturePath);
+        record.texturePaths[kEmissive]          = addString(mesh.emissiveTexturePath);
+        meshRecords.push_back(record);
+
+        // the importer doesn't simplify, the full mesh is the only level so far
+        Lod lod{};
+        lod.indexCount = record.indexCount;
+        lods.push_back(lod);
+    }
+
+    Header header{};
+    header.identifier        = kIdentifier;
+    header.version           = kVersion;
+    header.vertexFormat      = static_cast<uint32_t>(vertexFormat);
+    header.meshCount         = static_cast<uint32_t>(meshRecords.size());
+    header.lodCount          = static_cast<uint32_t>(lods.size());
+    header.meshTableOffset   = sizeof(Header);
+    header.lodTableOffset    = header.meshTableOffset + sizeof(MeshRecord) * meshRecords.size();
+    header.stringTableOffset = header.lodTableOffset + sizeof(Lod) * lods.size();
+    header.stringTableSize   = strings.size();
+
+    // the data offsets are only known once the tables are laid out
+    size_t dataOffset = header.stringTableOffset + header.stringTableSize;
+    for (auto &record : meshRecords) {
+        record.vertexDataOffset = _alignUp(dataOffset, kDataAlignment);
+        record.indexDataOffset  = _alignUp(
+            record.vertexDataOffset + size_t{record.vertexCount} * record.vertexStride,
+            kDataAlignment);
+        dataOffset = record.indexDataOffset + size_t{record.indexCount} * record.indexSize;
+    }
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(dataOffset);
+    _appendStruct(bytes, header);
+    for (auto const &record : meshRecords) {
+        _appendStruct(bytes, record);
+    }
+    for (auto const &lod : lods) {
+        _appendStruct(bytes, lod);
+    }
+    _appendBytes(bytes, strings.data(), strings.size());
+
+    for (size_t i = 0; i < model.meshes.size(); i++) {
+        auto const &mesh   = model.meshes[i];
+        auto const &record = meshRecords[i];
+
+        bytes.resize(record.vertexDataOffset, 0);
+        if (isQuantized) {
+            _appendBytes(bytes, mesh.quantizedVertices.data(),
+                         mesh.quantizedVertices.size() * sizeof(QuantizedVertex));
+        } else {
+            _appendBytes(bytes, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+        }
+
+        bytes.resize(record.indexDataOffset, 0);
+        if (record.indexSize == sizeof(uint16_t)) {
+            std::vector<uint16_t> const shortIndices(mesh.indices.begin(), mesh.indices.end());
+            _appendBytes(bytes, shortIndices.data(), shortIndices.size() * sizeof(uint16_t));
+        } else {
+            _appendBytes(bytes, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+std::unique_ptr<MeshFile::MappedModel> MeshFile::MappedModel::open(std::string const &path) {
+    auto file = std::make_unique<MappedFile>(path);
+    if (!file->isOpen() || file->getSize() < sizeof(Header)) {
+        return nullptr;
+    }
+    // the constructor is private
+    std::unique_ptr<MappedModel> mappedModel(
+        new MappedModel(std::move(file), _getDirectory(path)));
+    if (!mappedModel->_mapTables()) {
+        return nullptr;
+    }
+    return mappedModel;
+}
+
+MeshFile::MappedModel::MappedModel(std::unique_ptr<MappedFile> file, std::string directory)
+    : _file(std::move(file)), _directory(std::move(directory)) {
+    // the mapping is page aligned, the tables within it are aligned by the layout
+    _header = reinterpret_cast<Header const *>(_file->getData());
+}
+
+MeshFile::MappedModel::~MappedModel() = default;
+
+bool MeshFile::MappedModel::_mapTables() {
+    size_t const fileSize = _file->getSize();
+    if (_header->identifier != kIdentifier || _header->version != kVersion ||
+        _header->vertexFormat > static_cast<uint32_t>(VertexFormat::kQuantized)) {
+        return false;
+    }
+
+    auto const fits = [fileSize](uint64_t offset, uint64_t size) {
+        return offset <= fileSize && size <= fileSize - offset;
+    };
+    if (!fits(_header->meshTableOffset, uint64_t{sizeof(MeshRecord)} * _header->meshCount) ||
+        !fits(_header->lodTableOffset, uint64_t{sizeof(Lod)} * _header->lodCount) ||
+        !fits(_header->stringTableOffset, _header->stringTableSize) ||
+        _header->meshTableOffset % alignof(MeshRecord) != 0 ||
+        _header->lodTableOffset % alignof(Lod) != 0) {
+        return false;
+    }
+    // an unterminated string would run off the table
+    if (_header->stringTableSize > 0 &&
+        _file->getData()[_header->stringTableOffset + _header->stringTableSize - 1] != '\0') {
+        return false;
+    }
+
+    unsigned char const *data = _file->getData();
+    _meshes  = reinterpret_cast<MeshRecord const *>(data + _header->meshTableOffset);
+    _lods    = reinterpret_cast<Lod const *>(data + _header->lodTableOffset);
+    _strings = reinterpret_cast<char const *>(data + _header->stringTableOffset);
+
+    size_t const expectedStride = getVertexFormat() == VertexFormat::kQuantized
+                                      ? sizeof(QuantizedVertex)
+                                      : sizeof(Vertex);
+    for (uint32_t i = 0; i < _header->meshCount; i++) {
+        auto const &mesh = _meshes[i];
+        if (mesh.vertexStride != expectedStride ||
+            (mesh.indexSize != sizeof(uint16_t) && mesh.indexSize != sizeof(uint32_t)) ||
+            !fits(mesh.vertexDataOffset, uint64_t{mesh.vertexCount} * mesh.vertexStride) ||
+            !fits(mesh.indexDataOffset, uint64_t{mesh.indexCount} * mesh.indexSize) ||
+            uint64_t{mesh.firstLod} + mesh.lodCount > _header->lodCount) {
+            return false;
+        }
+        for (uint32_t texturePath : mesh.texturePaths) {
+            if (texturePath != kNoString && texturePath >= _header->stringTableSize) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+VertexFormat MeshFile::MappedModel::getVertexFormat() const {
+    return static_cast<VertexFormat>(_header->vertexFormat);
+}
+
+MeshFile::MeshRecord const &MeshFile::MappedModel::getMesh(uint32_t meshIndex) const {
+    return _meshes[meshIndex];
+}
+
+MeshFile::Lod const &MeshFile::MappedModel::getLod(uint32_t meshIndex, uint32_t lodIndex) const {
+    return _lods[_meshes[meshIndex].firstLod + lodIndex];
+}
+
+void const *MeshFile::MappedModel::getVertexData(uint32_t meshIndex) const {
+    return _file->getData() + _meshes[meshIndex].vertexDataOffset;
+}
+
+void const *MeshFile::MappedModel::getIndexData(uint32_t meshIndex) const {
+    return _file->getData() + _meshes[meshIndex].indexDataOffset;
+}
+
+std::string MeshFile::MappedModel::getTexturePath(uint32_t meshIndex, TextureSlot slot) const {
+    uint32_t const offset = _meshes[meshIndex].texturePaths[slot];
+    if (offset == kNoString) {
+        return "";
+    }
+    std::string const path = _strings + offset;
+    // kept as it was when it wasn't below the directory of the source
+    if (std::filesystem::path(path).is_absolute()) {
+        return path;
+    }
+    return _directory + path;
+}
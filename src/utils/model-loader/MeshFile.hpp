@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ModelLoader.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class MappedFile;
+
+// the engine's cooked mesh container, written by the mesh-cooker app after import and
+// optimization, and memory mapped at load time so the vertex and index data is uploaded straight
+// from the file
+//
+// layout: Header, MeshRecord[meshCount], Lod[lodCount], the string table, then the vertex and
+// index data of every mesh, each aligned to kDataAlignment
+// the structs are stored as they are in memory, little endian like every platform the engine
+// targets
+namespace MeshFile {
+
+constexpr std::array<char, 8> kIdentifier = {'T', 'E', 'M', 'E', 'S', 'H', '\r', '\n'};
+// bumped whenever the layout or the import pipeline changes, older files are cooked again
+constexpr uint32_t kVersion       = 1;
+constexpr uint32_t kDataAlignment = 16;
+// string table offset of an absent string
+constexpr uint32_t kNoString = UINT32_MAX;
+
+struct Header {
+    std::array<char, 8> identifier{};
+    uint32_t version           = 0;
+    uint32_t vertexFormat      = 0;
+    uint32_t meshCount         = 0;
+    uint32_t lodCount          = 0;
+    uint64_t meshTableOffset   = 0;
+    uint64_t lodTableOffset    = 0;
+    uint64_t stringTableOffset = 0;
+    uint64_t stringTableSize   = 0;
+};
+static_assert(sizeof(Header) == 56);
+
+// a range of the mesh's indices, lod 0 is the full mesh
+struct Lod {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    // the object space error the lod was simplified to, 0 for the full mesh
+    float error      = 0.F;
+    uint32_t padding = 0;
+};
+static_assert(sizeof(Lod) == 16);
+
+enum TextureSlot : uint32_t {
+    kBaseColor,
+    kNormal,
+    kMetallicRoughness,
+    kEmissive,
+
+    kTextureSlotCount,
+};
+
+struct MeshRecord {
+    uint64_t vertexDataOffset = 0;
+    uint64_t indexDataOffset  = 0;
+    uint32_t vertexCount      = 0;
+    uint32_t vertexStride     = 0;
+    // of all lods together
+    uint32_t indexCount = 0;
+    // 2 or 4 bytes, see ModelLoader::getIndexType
+    uint32_t indexSize = 0;
+    uint32_t firstLod  = 0;
+    uint32_t lodCount  = 0;
+    std::array<float, 3> boundsMin{};
+    std::array<float, 3> boundsMax{};
+    // VertexDequantization
+    std::array<float, 4> dequantizationOffset{};
+    std::array<float, 4> dequantizationScale{};
+    // string table offsets of the material textures, relative to the directory of the file
+    std::array<uint32_t, kTextureSlotCount> texturePaths{};
+};
+static_assert(sizeof(MeshRecord) == 112);
+
+// foo/bar.gltf cooked to quantized vertices is stored at foo/bar.q16.mesh
+std::string getCookedPath(std::string const &sourcePath, VertexFormat vertexFormat);
+
+// the cooked file exists and is at least as new as the source
+bool isFresh(std::string const &sourcePath, std::string const &cookedPath);
+
+// the meshes must be in vertexFormat, texture paths are stored relative to the directory of path
+bool write(std::string const &path, ModelAttributes const &model, VertexFormat vertexFormat);
+
+// a cooked file mapped into memory, the pointers it hands out are valid for as long as it lives
+class MappedModel {
+  public:
+    // nullptr if the file is missing, of another version or malformed
+    static std::unique_ptr<MappedModel> open(std::string const &path);
+    ~MappedModel();
+
+    // disable move and copy
+    MappedModel(const MappedModel &)            = delete;
+    MappedModel &operator=(const MappedModel &) = delete;
+    MappedModel(MappedModel &&)                 = delete;
+    MappedModel &operator=(MappedModel &&)      = delete;
+
+    [[nodiscard]] VertexFormat getVertexFormat() const;
+    [[nodiscard]] uint32_t getMeshCount() const { return _header->meshCount; }
+    [[nodiscard]] MeshRecord const &getMesh(uint32_t meshIndex) const;
+    [[nodiscard]] Lod const &getLod(uint32_t meshIndex, uint32_t lodIndex) const;
+
+    [[nodiscard]] void const *getVertexData(uint32_t meshIndex) const;
+    [[nodiscard]] void const *getIndexData(uint32_t meshIndex) const;
+    // the full path, empty when the mesh has no texture in the slot
+    [[nodiscard]] std::string getTexturePath(uint32_t meshIndex, TextureSlot slot) const;
+
+  private:
+    MappedModel(std::unique_ptr<MappedFile> file, std::string directory);
+
+    std::unique_ptr<MappedFile> _file;
+    std::string _directory;
+    Header const *_header     = nullptr;
+    MeshRecord const *_meshes = nullptr;
+    Lod const *_lods          = nullptr;
+    char const *_strings      = nullptr;
+
+    // validates the file, false if anything points outside of it
+    [[nodiscard]] bool _mapTables();
+};
+}; // namespace MeshFile
@@ -0,0 +1,281 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace {
+constexpr uint32_t kNoVertex = std::numeric_limits<uint32_t>::max();
+
+// a fifo cache of kVertexCacheSize entries, kept as the time each vertex was last loaded, so
+// emptying it is a single jump of the clock
+class VertexCache {
+  public:
+    explicit VertexCache(size_t vertexCount) : _loadTimes(vertexCount, 0) {}
+
+    [[nodiscard]] bool contains(uint32_t vertex) const {
+        return _timestamp - _loadTimes[vertex] <= MeshOptimizer::kVertexCacheSize;
+    }
+    [[nodiscard]] uint32_t getAge(uint32_t vertex) const {
+        return _timestamp - _loadTimes[vertex];
+    }
+
+    // true on a miss
+    bool load(uint32_t vertex) {
+        if (contains(vertex)) {
+            return false;
+        }
+        _loadTimes[vertex] = _timestamp++;
+        return true;
+    }
+
+    void flush() { _timestamp += MeshOptimizer::kVertexCacheSize + 1; }
+
+  private:
+    std::vector<uint32_t> _loadTimes;
+    uint32_t _timestamp = MeshOptimizer::kVertexCacheSize + 1;
+};
+
+uint32_t _loadTriangle(VertexCache &cache, std::vector<uint32_t> const &indices,
+                       uint32_t triangle) {
+    uint32_t misses = 0;
+    for (uint32_t k = 0; k < 3; k++) {
+        misses += cache.load(indices[triangle * 3 + k]) ? 1 : 0;
+    }
+    return misses;
+}
+} // namespace
+
+float MeshOptimizer::computeAcmr(std::vector<uint32_t> const &indices, size_t vertexCount) {
+    auto const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0) {
+        return 0.F;
+    }
+    VertexCache cache(vertexCount);
+    size_t misses = 0;
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        misses += _loadTriangle(cache, indices, t);
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(std::vector<uint32_t> &indices,
+                                                         size_t vertexCount) {
+    auto const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    std::vector<uint32_t> hardClusters;
+    if (triangleCount == 0 || vertexCount == 0) {
+        return hardClusters;
+    }
+
+    // the triangles around every vertex, adjacency[offsets[v]] to adjacency[offsets[v + 1]]
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t index : indices) {
+        offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fillOffsets(offsets.begin(), offsets.end() - 1);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        for (uint32_t k = 0; k < 3; k++) {
+            adjacency[fillOffsets[indices[t * 3 + k]]++] = t;
+        }
+    }
+
+    // triangles of every vertex that are still to be emitted
+    std::vector<uint32_t> liveTriangleCounts(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        liveTriangleCounts[v] = offsets[v + 1] - offsets[v];
+    }
+
+    VertexCache cache(vertexCount);
+    std::vector<bool> isEmitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    deadEnds.reserve(indices.size());
+    output.reserve(indices.size());
+
+    // scans for a vertex with triangles left once the dead end stack runs dry
+    uint32_t cursor           = 0;
+    auto const nextLiveVertex = [&]() -> uint32_t {
+        while (!deadEnds.empty()) {
+            uint32_t const vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangleCounts[vertex] > 0) {
+                return vertex;
+            }
+        }
+        for (; cursor < vertexCount; cursor++) {
+            if (liveTriangleCounts[cursor] > 0) {
+                return cursor;
+            }
+        }
+        return kNoVertex;
+    };
+
+    uint32_t fanningVertex = nextLiveVertex();
+    hardClusters.push_back(0);
+    while (fanningVertex != kNoVertex) {
+        // emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t i = offsets[fanningVertex]; i < offsets[fanningVertex + 1]; i++) {
+            uint32_t const triangle = adjacency[i];
+            if (isEmitted[triangle]) {
+                continue;
+            }
+            for (uint32_t k = 0; k < 3; k++) {
+                uint32_t const vertex = indices[triangle * 3 + k];
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangleCounts[vertex]--;
+                cache.load(vertex);
+            }
+            isEmitted[triangle] = true;
+        }
+
+        // the next fan is around the oldest candidate that will still be cached when its own
+        // triangles are emitted, each of which brings in at most two new vertices
+        uint32_t nextVertex  = kNoVertex;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangleCounts[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (cache.getAge(vertex) + 2 * liveTriangleCounts[vertex] <= kVertexCacheSize) {
+                priority = cache.getAge(vertex);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                nextVertex   = vertex;
+            }
+        }
+
+        if (nextVertex == kNoVertex) {
+            nextVertex = nextLiveVertex();
+            // the cache has nothing for the next fan, a cluster can start here for free
+            if (nextVertex != kNoVertex && !cache.contains(nextVertex)) {
+                hardClusters.push_back(static_cast<uint32_t>(output.size() / 3));
+            }
+        }
+        fanningVertex = nextVertex;
+    }
+
+    indices = std::move(output);
+    return hardClusters;
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t> &indices,
+                                     std::vector<glm::vec3> const &positions,
+                                     std::vector<uint32_t> const &hardClusters, float threshold) {
+    auto const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0 || hardClusters.empty()) {
+        return;
+    }
+
+    // a run is split wherever the part so far has amortized its cold start to within threshold of
+    // the whole run's cache efficiency, so the split costs little vertex cache locality
+    std::vector<uint32_t> clusters;
+    VertexCache cache(positions.size());
+    for (size_t c = 0; c < hardClusters.size(); c++) {
+        uint32_t const begin = hardClusters[c];
+        uint32_t const end   = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+        if (begin >= end) {
+            continue;
+        }
+
+        cache.flush();
+        uint32_t runMisses = 0;
+        for (uint32_t t = begin; t < end; t++) {
+            runMisses += _loadTriangle(cache, indices, t);
+        }
+        float const runAcmr = static_cast<float>(runMisses) / static_cast<float>(end - begin);
+
+        cache.flush();
+        clusters.push_back(begin);
+        uint32_t clusterBegin  = begin;
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; t++) {
+            clusterMisses += _loadTriangle(cache, indices, t);
+            auto const clusterSize = static_cast<float>(t + 1 - clusterBegin);
+            bool const isEfficient =
+                static_cast<float>(clusterMisses) <= runAcmr * threshold * clusterSize;
+            if (t + 1 < end && isEfficient) {
+                clusters.push_back(t + 1);
+                clusterBegin  = t + 1;
+                clusterMisses = 0;
+                cache.flush();
+            }
+        }
+    }
+
+    // the area weighted centroid of the whole mesh
+    glm::vec3 meshCentroid(0.F);
+    float meshArea = 0.F;
+    std::vector<glm::vec3> triangleCentroids(triangleCount);
+    std::vector<glm::vec3> triangleNormals(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        glm::vec3 const &p0 = positions[indices[t * 3 + 0]];
+        glm::vec3 const &p1 = positions[indices[t * 3 + 1]];
+        glm::vec3 const &p2 = positions[indices[t * 3 + 2]];
+        // twice the area in length
+        triangleNormals[t]   = glm::cross(p1 - p0, p2 - p0);
+        triangleCentroids[t] = (p0 + p1 + p2) / 3.F;
+
+        float const area = glm::length(triangleNormals[t]);
+        meshCentroid += triangleCentroids[t] * area;
+        meshArea += area;
+    }
+    meshCentroid = meshArea > 0.F ? meshCentroid / meshArea : glm::vec3(0.F);
+
+    // clusters facing away from the centroid are on the outside of the mesh and occlude the rest
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++) {
+        uint32_t const end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        glm::vec3 centroid(0.F);
+        glm::vec3 normal(0.F);
+        float area = 0.F;
+        for (uint32_t t = clusters[c]; t < end; t++) {
+            float const triangleArea = glm::length(triangleNormals[t]);
+            centroid += triangleCentroids[t] * triangleArea;
+            normal += triangleNormals[t];
+            area += triangleArea;
+        }
+        float const normalLength = glm::length(normal);
+        if (area == 0.F || normalLength == 0.F) {
+            sortKeys[c] = 0.F;
+            continue;
+        }
+        sortKeys[c] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+    }
+
+    std::vector<uint32_t> clusterOrder(clusters.size());
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                     [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : clusterOrder) {
+        uint32_t const end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+    indices = std::move(output);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t> &indices,
+                                                         size_t vertexCount) {
+    std::vector<uint32_t> newIndices(vertexCount, kNoVertex);
+    std::vector<uint32_t> vertexOrder;
+    vertexOrder.reserve(vertexCount);
+    for (uint32_t &index : indices) {
+        if (newIndices[index] == kNoVertex) {
+            newIndices[index] = static_cast<uint32_t>(vertexOrder.size());
+            vertexOrder.push_back(index);
+        }
+        index = newIndices[index];
+    }
+    return vertexOrder;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// import time reordering of indexed triangle lists, following "Fast Triangle Reordering for Vertex
+// Locality and Reduced Overdraw" (Sander, Nehab, Barczak 2007)
+namespace MeshOptimizer {
+
+// the post transform cache is modelled as a fifo of this many vertices
+constexpr uint32_t kVertexCacheSize = 16;
+
+// average cache miss ratio: transformed vertices per triangle, 3 is the worst, ~0.5 the best
+float computeAcmr(std::vector<uint32_t> const &indices, size_t vertexCount);
+
+// tipsify, reorders the triangles for the post transform cache, returns the first triangle of
+// every run that started from a dead end (where the cache had to be refilled anyway)
+std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount);
+
+// splits the runs of optimizeVertexCache further wherever the cache efficiency stays within
+// threshold of the run's, and sorts the clusters so the ones facing outwards come first, which
+// lets the depth test reject more of what is drawn after them
+void optimizeOverdraw(std::vector<uint32_t> &indices, std::vector<glm::vec3> const &positions,
+                      std::vector<uint32_t> const &hardClusters, float threshold = 1.05F);
+
+// renumbers the vertices in the order the triangles first use them, so vertex fetches walk the
+// buffer linearly, returns the old index of every new vertex, unreferenced ones are dropped
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t> &indices, size_t vertexCount);
+}; // namespace MeshOptimizer
@@ -1,5 +1,6 @@
 // ModelLoader.cpp
 #include "ModelLoader.hpp"
+#include "MeshOptimizer.hpp"
 
 #include "utils/incl/GlmIncl.hpp" // IWYU pragma: export
 #include "utils/logger/Logger.hpp"
@@ -7,10 +8,111 @@
 #include "assimp/Importer.hpp"
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
 #include <functional> // For std::function
+#include <limits>
+#include <utility>
+
+namespace {
+// maps a unit vector onto the [-1, 1] square, the lower hemisphere is folded over the diagonals
+glm::vec2 _octEncode(glm::vec3 n) {
+    float const l1Norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1Norm == 0.F) {
+        return glm::vec2(0.F);
+    }
+    n /= l1Norm;
+    if (n.z >= 0.F) {
+        return glm::vec2(n.x, n.y);
+    }
+    return glm::vec2((1.F - std::abs(n.y)) * (n.x >= 0.F ? 1.F : -1.F),
+                     (1.F - std::abs(n.x)) * (n.y >= 0.F ? 1.F : -1.F));
+}
+
+int16_t _toSnorm16(float v) {
+    return static_cast<int16_t>(std::round(std::clamp(v, -1.F, 1.F) * 32767.F));
+}
+
+uint16_t _toUnorm16(float v) {
+    return static_cast<uint16_t>(std::round(std::clamp(v, 0.F, 1.F) * 65535.F));
+}
+
+// reorders the triangles for the vertex cache and overdraw, then the vertices in the order the
+// triangles fetch them, returns the acmr before and after
+std::pair<float, float> _optimizeMesh(MeshAttribute &meshAttr) {
+    auto &vertices = meshAttr.vertices;
+    auto &indices  = meshAttr.indices;
+
+    float const acmrBefore  = MeshOptimizer::computeAcmr(indices, vertices.size());
+    auto const hardClusters = MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+
+    std::vector<glm::vec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        positions[i] = vertices[i].pos;
+    }
+    MeshOptimizer::optimizeOverdraw(indices, positions, hardClusters);
+
+    auto const vertexOrder = MeshOptimizer::optimizeVertexFetch(indices, vertices.size());
+    std::vector<Vertex> orderedVertices(vertexOrder.size());
+    for (size_t i = 0; i < vertexOrder.size(); i++) {
+        orderedVertices[i] = vertices[vertexOrder[i]];
+    }
+    vertices = std::move(orderedVertices);
+
+    return {acmrBefore, MeshOptimizer::computeAcmr(indices, vertices.size())};
+}
+} // namespace
+
+std::vector<QuantizedVertex> ModelLoader::quantizeVertices(std::vector<Vertex> const &vertices,
+                                                           VertexDequantization &dequantization) {
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (auto const &vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.pos);
+        boundsMax = glm::max(boundsMax, vertex.pos);
+    }
+    if (vertices.empty()) {
+        boundsMin = glm::vec3(0.F);
+        boundsMax = glm::vec3(0.F);
+    }
+    // a flat axis still needs a scale to divide by
+    glm::vec3 extent = boundsMax - boundsMin;
+    for (int i = 0; i < 3; i++) {
+        extent[i] = extent[i] > 0.F ? extent[i] : 1.F;
+    }
+    dequantization.offset = glm::vec4(boundsMin, 0.F);
+    dequantization.scale  = glm::vec4(extent, 1.F);
+
+    std::vector<QuantizedVertex> quantizedVertices(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto const &vertex = vertices[i];
+        auto &quantized    = quantizedVertices[i];
+
+        glm::vec3 const normalized = (vertex.pos - boundsMin) / extent;
+        uint16_t const handedness  = vertex.tangent.w < 0.F ? 0 : 65535;
+        quantized.pos      = {_toUnorm16(normalized.x), _toUnorm16(normalized.y),
+                              _toUnorm16(normalized.z), handedness};
+        quantized.texCoord = {glm::packHalf1x16(vertex.texCoord.x),
+                              glm::packHalf1x16(vertex.texCoord.y)};
+
+        glm::vec2 const normal  = _octEncode(vertex.normal);
+        glm::vec2 const tangent = _octEncode(glm::vec3(vertex.tangent));
+        quantized.normal        = {_toSnorm16(normal.x), _toSnorm16(normal.y)};
+        quantized.tangent       = {_toSnorm16(tangent.x), _toSnorm16(tangent.y)};
+    }
+    return quantizedVertices;
+}
+
+VkIndexType ModelLoader::getIndexType(size_t vertexCount) {
+    return vertexCount < std::numeric_limits<uint16_t>::max() ? VK_INDEX_TYPE_UINT16
+                                                               : VK_INDEX_TYPE_UINT32;
+}
 
 std::optional<ModelAttributes> ModelLoader::loadModelFromPath(const std::string &filePath,
-                                                              Logger *logger) {
+                                                              Logger *logger,
+                                                              VertexFormat vertexFormat) {
     Assimp::Importer importer;
     const unsigned int flags = aiProcess_Triangulate | aiProcess_GenNormals |
                                aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices |
@@ -25,6 +127,10 @@ std::optional<ModelAttributes> ModelLoader::loadModelFromPath(const std::string
     }
 
     ModelAttributes model;
+    // triangle weighted, over the meshes that were optimized
+    double acmrBeforeSum          = 0.0;
+    double acmrAfterSum           = 0.0;
+    size_t optimizedTriangleCount = 0;
     std::function<void(aiNode *)> processNode = [&](aiNode *node) {
         for (uint32_t i = 0; i < node->mNumMeshes; i++) {
             aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
@@ -84,7 +190,32 @@ std::optional<ModelAttributes> ModelLoader::loadModelFromPath(const std::string
                 meshAttr.emissiveTexturePath = directory + aiPath.data;
             }
 
-            model.meshes.push_back(meshAttr);
+            // lines and points are left as they come
+            if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) {
+                auto const [acmrBefore, acmrAfter] = _optimizeMesh(meshAttr);
+                size_t const triangleCount         = meshAttr.indices.size() / 3;
+                acmrBeforeSum += acmrBefore * static_cast<double>(triangleCount);
+                acmrAfterSum += acmrAfter * static_cast<double>(triangleCount);
+                optimizedTriangleCount += triangleCount;
+            }
+
+            if (!meshAttr.vertices.empty()) {
+                meshAttr.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+                meshAttr.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+            }
+            for (auto const &vertex : meshAttr.vertices) {
+                meshAttr.boundsMin = glm::min(meshAttr.boundsMin, vertex.pos);
+                meshAttr.boundsMax = glm::max(meshAttr.boundsMax, vertex.pos);
+            }
+
+            if (vertexFormat == VertexFormat::kQuantized) {
+                meshAttr.quantizedVertices =
+                    quantizeVertices(meshAttr.vertices, meshAttr.dequantization);
+                meshAttr.vertices.clear();
+                meshAttr.vertices.shrink_to_fit();
+            }
+
+            model.meshes.push_back(std::move(meshAttr));
         }
         for (uint32_t i = 0; i < node->mNumChildren; i++) {
             processNode(node->mChildren[i]);
@@ -95,6 +226,13 @@ std::optional<ModelAttributes> ModelLoader::loadModelFromPath(const std::string
 
     logger->info("New Scene Model Loaded: {}", filePath);
     logger->info("Meshes count: {}", model.meshes.size());
+    if (optimizedTriangleCount > 0) {
+        auto const triangleCount = static_cast<double>(optimizedTriangleCount);
+        logger->info("Vertex cache ACMR: {:.3f} before, {:.3f} after optimization ({} triangles, "
+                     "{} entry fifo)",
+                     acmrBeforeSum / triangleCount, acmrAfterSum / triangleCount,
+                     optimizedTriangleCount, MeshOptimizer::kVertexCacheSize);
+    }
 
     return model;
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <array>
 #include <assimp/scene.h>
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <optional> // Include for std::optional
 #include <string>
@@ -53,8 +55,75 @@ struct Vertex {
     }
 };
 
+// the layout vertices are imported into, chosen per model at load time
+enum class VertexFormat {
+    // 48 bytes of fp32, see Vertex
+    kFloat,
+    // 20 bytes, see QuantizedVertex
+    kQuantized,
+};
+
+// maps the normalized positions of a quantized mesh back into model space, pos = offset + q * scale
+// pushed per draw as a vertex stage push constant, identity for fp32 meshes
+struct VertexDequantization {
+    glm::vec4 offset = glm::vec4(0.F);
+    glm::vec4 scale  = glm::vec4(1.F);
+};
+
+// the compact layout of Vertex
+// positions are 16 bit unorm within the mesh bounds, w holds the tangent handedness (0 for -1),
+// texture coordinates are half floats, normal and tangent are octahedral encoded 16 bit snorm
+struct QuantizedVertex {
+    std::array<uint16_t, 4> pos{};
+    std::array<uint16_t, 2> texCoord{};
+    std::array<int16_t, 2> normal{};
+    std::array<int16_t, 2> tangent{};
+
+    // the same locations as Vertex, the shader reads both through vec4 inputs
+    static inline std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+
+        attributeDescriptions[0].binding  = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format   = VK_FORMAT_R16G16B16A16_UNORM;
+        attributeDescriptions[0].offset   = offsetof(QuantizedVertex, pos);
+
+        attributeDescriptions[1].binding  = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format   = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[1].offset   = offsetof(QuantizedVertex, texCoord);
+
+        attributeDescriptions[2].binding  = 0;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format   = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[2].offset   = offsetof(QuantizedVertex, normal);
+
+        attributeDescriptions[3].binding  = 0;
+        attributeDescriptions[3].location = 3;
+        attributeDescriptions[3].format   = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[3].offset   = offsetof(QuantizedVertex, tangent);
+
+        return attributeDescriptions;
+    }
+
+    static inline VkVertexInputBindingDescription GetBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding   = 0;
+        bindingDescription.stride    = sizeof(QuantizedVertex);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescription;
+    }
+};
+static_assert(sizeof(QuantizedVertex) == 20, "QuantizedVertex is expected to be tightly packed");
+
 struct MeshAttribute {
     std::vector<Vertex> vertices;
+    // filled instead of vertices when the model is imported as VertexFormat::kQuantized
+    std::vector<QuantizedVertex> quantizedVertices;
+    VertexDequantization dequantization{};
+    // of the positions, in model space
+    glm::vec3 boundsMin = glm::vec3(0.F);
+    glm::vec3 boundsMax = glm::vec3(0.F);
     std::vector<uint32_t> indices;
     std::string baseColorTexturePath;
     std::string normalTexturePath;
@@ -67,5 +136,14 @@ struct ModelAttributes {
 };
 
 namespace ModelLoader {
-std::optional<ModelAttributes> loadModelFromPath(const std::string &filePath, Logger *logger);
+std::optional<ModelAttributes> loadModelFromPath(const std::string &filePath, Logger *logger,
+                                                 VertexFormat vertexFormat = VertexFormat::kFloat);
+
+// VK_INDEX_TYPE_UINT16 when every index of a mesh with vertexCount vertices fits 16 bits,
+// 0xffff is avoided as it is the primitive restart value
+VkIndexType getIndexType(size_t vertexCount);
+
+// quantizes the vertices of a mesh against its own bounds
+std::vector<QuantizedVertex> quantizeVertices(std::vector<Vertex> const &vertices,
+                                              VertexDequantization &dequantization);
 }; // namespace ModelLoader
\ No newline at end of file
@@ -36,6 +36,10 @@ shaderc_shader_kind _getShaderKind(ShaderStage stage) {
         return shaderc_glsl_vertex_shader;
     }
 }
+
+std::string _getPrecompiledKey(ShaderStage shaderStage, const std::string &fullPathToFile) {
+    return std::to_string(static_cast<uint32_t>(shaderStage)) + '|' + fullPathToFile;
+}
 }; // namespace
 
 ShaderCompiler::ShaderCompiler(Logger *logger,
@@ -57,6 +61,28 @@ ShaderCompiler::ShaderCompiler(Logger *logger,
 std::optional<std::vector<uint32_t>>
 ShaderCompiler::compileShaderFromFile(ShaderStage shaderStage, const std::string &fullPathToFile,
                                       std::string const &sourceCode) {
+    auto it = _precompiledShaders.find(_getPrecompiledKey(shaderStage, fullPathToFile));
+    if (it != _precompiledShaders.end()) {
+        auto precompiledShader = std::move(it->second);
+        _precompiledShaders.erase(it);
+        // the precompiled code is stale when the source was edited in between
+        if (precompiledShader.sourceCode == sourceCode) {
+            return std::move(precompiledShader.code);
+        }
+    }
+    return _compile(shaderStage, fullPathToFile, sourceCode);
+}
+
+void ShaderCompiler::precompileShaderFromFile(ShaderStage shaderStage,
+                                              const std::string &fullPathToFile,
+                                              std::string const &sourceCode) {
+    _precompiledShaders[_getPrecompiledKey(shaderStage, fullPathToFile)] = {
+        sourceCode, _compile(shaderStage, fullPathToFile, sourceCode)};
+}
+
+std::optional<std::vector<uint32_t>>
+ShaderCompiler::_compile(ShaderStage shaderStage, const std::string &fullPathToFile,
+                         std::string const &sourceCode) {
     auto const fullDirAndFileName = _getFullDirAndFileName(fullPathToFile, _logger);
 
     _fileIncluder->setIncludeDir(fullDirAndFileName.fullPathToDir);
@@ -7,6 +7,8 @@
 #include <functional>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class Logger;
 class CustomFileIncluder;
@@ -28,9 +30,27 @@ class ShaderCompiler : public shaderc::Compiler {
                                                                const std::string &fullPathToFile,
                                                                std::string const &sourceCode);
 
+    // compiles ahead of the first use, e.g. on another thread while the device is being created,
+    // the next compileShaderFromFile of the same stage, file and source takes the result instead
+    // of compiling again, not thread safe, like the rest of the compiler
+    void precompileShaderFromFile(ShaderStage shaderStage, const std::string &fullPathToFile,
+                                  std::string const &sourceCode);
+
   private:
+    struct PrecompiledShader {
+        std::string sourceCode;
+        std::optional<std::vector<uint32_t>> code;
+    };
+
     Logger *_logger;
     shaderc::CompileOptions _defaultOptions;
     CustomFileIncluder *_fileIncluder;
 
+    // keyed by the stage and the file, taken by the first compile that matches
+    std::unordered_map<std::string, PrecompiledShader> _precompiledShaders;
+
+    std::optional<std::vector<uint32_t>> _compile(ShaderStage shaderStage,
+                                                  const std::string &fullPathToFile,
+                                                  std::string const &sourceCode);
+
 }; // namespace ShaderCompiler
@@ -0,0 +1,258 @@
+#include "ShaderHotReloader.hpp"
+
+#include "utils/event-dispatcher/GlobalEventDispatcher.hpp"
+#include "utils/event-types/EventType.hpp"
+#include "utils/io/FileReader.hpp"
+#include "utils/logger/Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+constexpr auto kPollInterval = std::chrono::milliseconds(250);
+
+std::string _getStageFilePath(std::string const &fullPathToShaderSourceCode, ShaderStage stage) {
+    switch (stage) {
+    case ShaderStage::kVert:
+        return fullPathToShaderSourceCode + ".vert";
+    case ShaderStage::kFrag:
+        return fullPathToShaderSourceCode + ".frag";
+    default:
+        return fullPathToShaderSourceCode;
+    }
+}
+
+std::filesystem::file_time_type _getLastWriteTime(std::string const &fullPathToFile) {
+    std::error_code ec;
+    auto const lastWriteTime = std::filesystem::last_write_time(fullPathToFile, ec);
+    return ec ? std::filesystem::file_time_type::min() : lastWriteTime;
+}
+} // namespace
+
+ShaderHotReloader::ShaderHotReloader(Logger *logger, size_t workerCount) : _logger(logger) {
+    workerCount = std::max<size_t>(workerCount, 1);
+    _workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        _workers.emplace_back([this] { _workerLoop(); });
+    }
+    _watcherThread = std::thread([this] { _watcherLoop(); });
+}
+
+ShaderHotReloader::~ShaderHotReloader() {
+    {
+        std::lock_guard lock(_jobMutex);
+        _stopRequested = true;
+    }
+    _jobCondition.notify_all();
+
+    _watcherThread.join();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+void ShaderHotReloader::watch(std::string const &fullPathToShaderSourceCode,
+                              std::vector<ShaderStage> stages) {
+    uint64_t generation = 0;
+    {
+        std::lock_guard lock(_graphMutex);
+        _pipelineStages[fullPathToShaderSourceCode] = std::move(stages);
+        generation = ++_latestGenerations[fullPathToShaderSourceCode];
+    }
+    // the pipeline itself has been compiled by its owner already, only its includes are needed
+    _enqueue(fullPathToShaderSourceCode, generation, true);
+}
+
+void ShaderHotReloader::dispatchReadyResults() {
+    std::vector<Result> readyResults;
+    {
+        std::lock_guard lock(_resultMutex);
+        if (_readyResults.empty()) {
+            return;
+        }
+        readyResults.swap(_readyResults);
+    }
+
+    for (auto &result : readyResults) {
+        // two workers may have been compiling the same pipeline, never go back to older code
+        auto &dispatchedGeneration = _dispatchedGenerations[result.fullPathToShaderSourceCode];
+        if (result.generation <= dispatchedGeneration) {
+            continue;
+        }
+        dispatchedGeneration = result.generation;
+
+        E_ShaderReloaded event{};
+        event.fullPathToShaderSourceCode = result.fullPathToShaderSourceCode;
+        for (size_t i = 0; i < result.stages.size(); i++) {
+            switch (result.stages[i]) {
+            case ShaderStage::kVert:
+                event.vertCode = std::move(result.codes[i]);
+                break;
+            case ShaderStage::kFrag:
+                event.fragCode = std::move(result.codes[i]);
+                break;
+            default:
+                event.compCode = std::move(result.codes[i]);
+                break;
+            }
+        }
+        GlobalEventDispatcher::get().trigger<E_ShaderReloaded>(event);
+    }
+}
+
+void ShaderHotReloader::_enqueue(std::string const &fullPathToShaderSourceCode,
+                                 uint64_t generation, bool isDependencyScan) {
+    {
+        std::lock_guard lock(_jobMutex);
+        if (_queuedPipelines.contains(fullPathToShaderSourceCode)) {
+            // the queued job reads the sources when it starts, bump it to the newest generation
+            for (auto &job : _jobs) {
+                if (job.fullPathToShaderSourceCode == fullPathToShaderSourceCode) {
+                    job.generation = generation;
+                    job.isDependencyScan = job.isDependencyScan && isDependencyScan;
+                }
+            }
+            return;
+        }
+        _queuedPipelines.insert(fullPathToShaderSourceCode);
+        _jobs.push_back({fullPathToShaderSourceCode, generation, isDependencyScan});
+    }
+    _jobCondition.notify_one();
+}
+
+void ShaderHotReloader::_watcherLoop() {
+    while (!_stopRequested) {
+        std::this_thread::sleep_for(kPollInterval);
+
+        std::vector<std::pair<std::string, uint64_t>> pipelinesToRebuild;
+        {
+            std::lock_guard lock(_graphMutex);
+
+            std::unordered_set<std::string> affectedPipelines;
+            for (auto &[file, lastWriteTime] : _lastWriteTimes) {
+                auto const currentWriteTime = _getLastWriteTime(file);
+                // some editors delete and recreate the file on save, wait for it to reappear
+                if (currentWriteTime == std::filesystem::file_time_type::min() ||
+                    currentWriteTime == lastWriteTime) {
+                    continue;
+                }
+                lastWriteTime = currentWriteTime;
+
+                _logger->info("shader file changed: {}", file);
+                auto const &dependents = _dependents[file];
+                affectedPipelines.insert(dependents.begin(), dependents.end());
+            }
+
+            for (auto const &pipeline : affectedPipelines) {
+                pipelinesToRebuild.emplace_back(pipeline, ++_latestGenerations[pipeline]);
+            }
+        }
+
+        for (auto const &[pipeline, generation] : pipelinesToRebuild) {
+            _enqueue(pipeline, generation, false);
+        }
+    }
+}
+
+void ShaderHotReloader::_workerLoop() {
+    // every file touched by this worker's compiler is recorded here, the compiler is owned by this
+    // thread only, so no locking is needed
+    std::unordered_set<std::string> compiledFiles;
+    ShaderCompiler shaderCompiler(_logger,
+                                  [&compiledFiles](std::string const &fullPathToIncludedFile) {
+                                      compiledFiles.insert(fullPathToIncludedFile);
+                                  });
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(_jobMutex);
+            _jobCondition.wait(lock, [this] { return _stopRequested || !_jobs.empty(); });
+            if (_stopRequested) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            _queuedPipelines.erase(job.fullPathToShaderSourceCode);
+        }
+
+        std::vector<ShaderStage> stages;
+        bool allFilesPresent = true;
+        {
+            std::lock_guard lock(_graphMutex);
+            stages = _pipelineStages.at(job.fullPathToShaderSourceCode);
+            // the file reader terminates on missing files, which is fine at startup but not while
+            // an editor is halfway through saving, the watcher will trigger again once it is back
+            for (auto const &file : _dependencies[job.fullPathToShaderSourceCode]) {
+                allFilesPresent &= std::filesystem::exists(file);
+            }
+        }
+        for (auto stage : stages) {
+            allFilesPresent &=
+                std::filesystem::exists(_getStageFilePath(job.fullPathToShaderSourceCode, stage));
+        }
+        if (!allFilesPresent) {
+            continue;
+        }
+
+        compiledFiles.clear();
+        Result result{job.fullPathToShaderSourceCode, job.generation, stages, {}};
+        bool succeeded = true;
+        for (auto stage : stages) {
+            auto const stageFilePath = _getStageFilePath(job.fullPathToShaderSourceCode, stage);
+            compiledFiles.insert(stageFilePath);
+
+            auto const sourceCode = FileReader::readShaderSourceCode(stageFilePath, _logger);
+            auto compiledCode =
+                shaderCompiler.compileShaderFromFile(stage, stageFilePath, sourceCode);
+            if (!compiledCode.has_value()) {
+                succeeded = false;
+                break;
+            }
+            result.codes.push_back(std::move(compiledCode.value()));
+        }
+
+        // a failed compilation may stop before reaching every include, so the graph can only grow
+        // in that case
+        _updateDependencies(job.fullPathToShaderSourceCode, compiledFiles, succeeded);
+
+        if (!succeeded) {
+            _logger->warn("failed to recompile {}, keeping the previous pipeline",
+                          job.fullPathToShaderSourceCode);
+            continue;
+        }
+        if (job.isDependencyScan) {
+            continue;
+        }
+
+        _logger->info("recompiled {}", job.fullPathToShaderSourceCode);
+        std::lock_guard lock(_resultMutex);
+        _readyResults.push_back(std::move(result));
+    }
+}
+
+void ShaderHotReloader::_updateDependencies(std::string const &fullPathToShaderSourceCode,
+                                            std::unordered_set<std::string> const &files,
+                                            bool replace) {
+    std::lock_guard lock(_graphMutex);
+
+    auto &dependencies = _dependencies[fullPathToShaderSourceCode];
+    if (replace) {
+        for (auto const &file : dependencies) {
+            if (!files.contains(file)) {
+                _dependents[file].erase(fullPathToShaderSourceCode);
+            }
+        }
+        dependencies.clear();
+    }
+
+    for (auto const &file : files) {
+        dependencies.insert(file);
+        _dependents[file].insert(fullPathToShaderSourceCode);
+        // newly discovered files start from their current state, older ones keep the timestamp
+        // the watcher has seen so an edit made during compilation is not lost
+        if (!_lastWriteTimes.contains(file)) {
+            _lastWriteTimes[file] = _getLastWriteTime(file);
+        }
+    }
+}
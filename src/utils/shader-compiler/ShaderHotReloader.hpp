@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ShaderCompiler.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Logger;
+
+// watches the shader sources of registered pipelines together with every file they include, and
+// recompiles the affected pipelines on background workers when something changes on disk, each
+// worker owns its own shaderc compiler so compilations never share state
+//
+// the include graph is built from the CustomFileIncluder callbacks of the worker compilers, so it
+// always reflects the includes of the last successful (or attempted) compilation
+class ShaderHotReloader {
+  public:
+    ShaderHotReloader(Logger *logger, size_t workerCount);
+    ~ShaderHotReloader();
+
+    // disable move and copy
+    ShaderHotReloader(const ShaderHotReloader &)            = delete;
+    ShaderHotReloader &operator=(const ShaderHotReloader &) = delete;
+    ShaderHotReloader(ShaderHotReloader &&)                 = delete;
+    ShaderHotReloader &operator=(ShaderHotReloader &&)      = delete;
+
+    // start tracking a pipeline, the path follows the convention of the pipeline classes: gfx
+    // pipelines append .vert / .frag to it, compute pipelines use it as is
+    // its include dependencies are discovered in the background
+    void watch(std::string const &fullPathToShaderSourceCode, std::vector<ShaderStage> stages);
+
+    // must be called from the render loop thread at a frame boundary, fires E_ShaderReloaded for
+    // every pipeline whose shaders finished recompiling since the last call
+    void dispatchReadyResults();
+
+  private:
+    struct Job {
+        std::string fullPathToShaderSourceCode;
+        uint64_t generation;
+        // dependency scans only build the include graph, the result is not dispatched
+        bool isDependencyScan;
+    };
+
+    struct Result {
+        std::string fullPathToShaderSourceCode;
+        uint64_t generation;
+        std::vector<ShaderStage> stages;
+        std::vector<std::vector<uint32_t>> codes;
+    };
+
+    Logger *_logger;
+
+    // guards the pipelines, the include graph and the file timestamps
+    std::mutex _graphMutex;
+    std::unordered_map<std::string, std::vector<ShaderStage>> _pipelineStages;
+    // pipeline -> every file it is compiled from, including its own stage files
+    std::unordered_map<std::string, std::unordered_set<std::string>> _dependencies;
+    // file -> pipelines that depend on it
+    std::unordered_map<std::string, std::unordered_set<std::string>> _dependents;
+    std::unordered_map<std::string, std::filesystem::file_time_type> _lastWriteTimes;
+    std::unordered_map<std::string, uint64_t> _latestGenerations;
+
+    std::mutex _jobMutex;
+    std::condition_variable _jobCondition;
+    std::deque<Job> _jobs;
+    std::unordered_set<std::string> _queuedPipelines;
+
+    std::mutex _resultMutex;
+    std::vector<Result> _readyResults;
+    // only touched by the render loop thread
+    std::unordered_map<std::string, uint64_t> _dispatchedGenerations;
+
+    std::atomic<bool> _stopRequested = false;
+    std::vector<std::thread> _workers;
+    std::thread _watcherThread;
+
+    void _enqueue(std::string const &fullPathToShaderSourceCode, uint64_t generation,
+                  bool isDependencyScan);
+    void _watcherLoop();
+    void _workerLoop();
+    void _updateDependencies(std::string const &fullPathToShaderSourceCode,
+                             std::unordered_set<std::string> const &files, bool replace);
+};
@@ -0,0 +1,51 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::thread::hardware_concurrency();
+    }
+    workerCount = std::max<size_t>(workerCount, 1);
+    _workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        _workers.emplace_back([this] { _workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(_jobMutex);
+        _stopRequested = true;
+    }
+    _jobCondition.notify_all();
+
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::_enqueue(std::function<void()> job) {
+    {
+        std::lock_guard lock(_jobMutex);
+        _jobs.push_back(std::move(job));
+    }
+    _jobCondition.notify_one();
+}
+
+void ThreadPool::_workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(_jobMutex);
+            _jobCondition.wait(lock, [this] { return _stopRequested || !_jobs.empty(); });
+            // futures of queued jobs would never be satisfied otherwise
+            if (_jobs.empty()) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
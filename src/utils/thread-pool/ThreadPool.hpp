@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// a fixed set of worker threads that run the submitted jobs in submission order, for fanning out
+// cpu work that doesn't touch the device, like decoding assets at startup
+class ThreadPool {
+  public:
+    // 0 picks one worker per hardware thread
+    explicit ThreadPool(size_t workerCount);
+    // the jobs that are still queued are run before the workers are joined
+    ~ThreadPool();
+
+    // disable move and copy
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&)                 = delete;
+    ThreadPool &operator=(ThreadPool &&)      = delete;
+
+    [[nodiscard]] size_t getWorkerCount() const { return _workers.size(); }
+
+    // the future holds what the job returns, or the exception it throws
+    template <typename Job> auto submit(Job &&job) {
+        using Result = std::invoke_result_t<std::decay_t<Job>>;
+        // std::function needs a copyable target, the task itself is move only
+        auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<Job>(job));
+        auto future = task->get_future();
+        _enqueue([task] { (*task)(); });
+        return future;
+    }
+
+  private:
+    std::mutex _jobMutex;
+    std::condition_variable _jobCondition;
+    std::deque<std::function<void()>> _jobs;
+    bool _stopRequested = false;
+
+    std::vector<std::thread> _workers;
+
+    void _enqueue(std::function<void()> job);
+    void _workerLoop();
+};
@@ -1,15 +1,18 @@
 #include "DescriptorSetBundle.hpp"
 
+#include "app-context/DescriptorAllocator.hpp"
 #include "app-context/VulkanApplicationContext.hpp"
 
 #include "../memory/Buffer.hpp"
 #include "../memory/BufferBundle.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 DescriptorSetBundle::~DescriptorSetBundle() {
+    _appContext->getDescriptorAllocator()->free(_descriptorPool, _descriptorSets.data(),
+                                                static_cast<uint32_t>(_descriptorSets.size()));
     vkDestroyDescriptorSetLayout(_appContext->getDevice(), _descriptorSetLayout, nullptr);
-    vkDestroyDescriptorPool(_appContext->getDevice(), _descriptorPool, nullptr);
 }
 
 void DescriptorSetBundle::bindUniformBufferBundle(uint32_t bindingSlot,
@@ -48,50 +51,29 @@ void DescriptorSetBundle::bindStorageBuffer(uint32_t bindingSlot, Buffer *buffer
 }
 
 void DescriptorSetBundle::create() {
-    _createDescriptorPool();
     _createDescriptorSetLayout();
     _createDescriptorSets();
 }
 
-void DescriptorSetBundle::_createDescriptorPool() {
-    std::vector<VkDescriptorPoolSize> poolSizes{};
-
-    // https://www.reddit.com/r/vulkan/comments/8u9zqr/having_trouble_understanding_descriptor_pool/
-    // pool sizes info indicates how many descriptors of a certain type can be
-    // allocated from the pool - NOT THE SET!
-
-    auto uniformBufferSize = static_cast<uint32_t>(_uniformBufferBundles.size() * _bundleSize);
-    if (uniformBufferSize > 0) {
-        poolSizes.emplace_back(
-            VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uniformBufferSize});
-    }
-
-    auto storageImageSize = static_cast<uint32_t>(_storageImages.size());
-    if (storageImageSize > 0) {
-        poolSizes.emplace_back(
-            VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageImageSize});
-    }
-
-    auto imageSamplerSize = static_cast<uint32_t>(_imageSamplers.size());
-    if (imageSamplerSize > 0) {
-        poolSizes.emplace_back(
-            VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageSamplerSize});
-    }
-
-    auto storageBufferSize = static_cast<uint32_t>(_storageBuffers.size());
-    if (storageBufferSize > 0) {
-        poolSizes.emplace_back(
-            VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferSize});
-    }
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    // the max number of descriptor sets that can be allocated from this pool
-    poolInfo.maxSets       = static_cast<uint32_t>(_bundleSize);
-    poolInfo.pPoolSizes    = poolSizes.data();
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-
-    vkCreateDescriptorPool(_appContext->getDevice(), &poolInfo, nullptr, &_descriptorPool);
+void DescriptorSetBundle::rebindImageSampler(size_t descriptorSetIndex, uint32_t bindingSlot,
+                                             Image *image) {
+    assert(std::any_of(_imageSamplers.begin(), _imageSamplers.end(),
+                       [bindingSlot](auto const &imageSampler) {
+                           return imageSampler.first == bindingSlot;
+                       }) &&
+           "binding socket is no image sampler");
+    assert(descriptorSetIndex < _descriptorSets.size() && "descriptor set not created");
+
+    VkDescriptorImageInfo const imageInfo =
+        image->getDescriptorInfo(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    VkWriteDescriptorSet descriptorWrite{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    descriptorWrite.dstSet          = _descriptorSets[descriptorSetIndex];
+    descriptorWrite.dstBinding      = bindingSlot;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo      = &imageInfo;
+    vkUpdateDescriptorSets(_appContext->getDevice(), 1, &descriptorWrite, 0, nullptr);
 }
 
 void DescriptorSetBundle::_createDescriptorSetLayout() {
@@ -229,14 +211,15 @@ void DescriptorSetBundle::_createDescriptorSets() {
     // set bundle uses identical layout, but with different data
     std::vector<VkDescriptorSetLayout> layouts(_bundleSize, _descriptorSetLayout);
 
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool     = _descriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(_bundleSize);
-    allocInfo.pSetLayouts        = layouts.data();
-
+    // the sets come from the shared pools, a private pool per bundle adds up to hundreds of pools
+    // on large models
     _descriptorSets.resize(_bundleSize);
-    vkAllocateDescriptorSets(_appContext->getDevice(), &allocInfo, _descriptorSets.data());
+    _descriptorPool = _appContext->getDescriptorAllocator()->allocate(
+        layouts.data(), static_cast<uint32_t>(_bundleSize), _descriptorSets.data());
+    if (_descriptorPool == VK_NULL_HANDLE) {
+        _descriptorSets.clear();
+        return;
+    }
 
     for (uint32_t j = 0; j < _bundleSize; j++) {
         _createDescriptorSet(j);
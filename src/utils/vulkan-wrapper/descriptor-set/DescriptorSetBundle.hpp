@@ -37,12 +37,16 @@ class DescriptorSetBundle {
 
     void create();
 
+    // points an image sampler slot of one created set at another image, the set must not be in use
+    // by a command buffer that is still pending
+    void rebindImageSampler(size_t descriptorSetIndex, uint32_t bindingSlot, Image *image);
+
   private:
     VulkanApplicationContext *_appContext;
     size_t _bundleSize;
     VkShaderStageFlags _shaderStageFlags;
 
-    // the pool is created per descriptor set bundle
+    // the shared pool of the descriptor allocator the sets came from, needed to free them
     VkDescriptorPool _descriptorPool           = VK_NULL_HANDLE;
     VkDescriptorSetLayout _descriptorSetLayout = VK_NULL_HANDLE;
 
@@ -54,7 +58,6 @@ class DescriptorSetBundle {
 
     std::vector<VkDescriptorSet> _descriptorSets{};
 
-    void _createDescriptorPool();
     void _createDescriptorSetLayout();
     void _createDescriptorSets();
     void _createDescriptorSet(uint32_t descriptorSetIndex);
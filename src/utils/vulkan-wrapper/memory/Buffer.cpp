@@ -1,6 +1,9 @@
 #include "Buffer.hpp"
 
 #include "../utils/SimpleCommands.hpp"
+#include "app-context/AsyncUploader.hpp"
+#include "app-context/MemoryPools.hpp"
+#include "app-context/UploadManager.hpp"
 #include "app-context/VulkanApplicationContext.hpp"
 
 #include <cassert>
@@ -10,8 +13,8 @@ namespace {
 VmaAllocationCreateFlags _decideAllocationCreateFlags(MemoryStyle memoryAccessingStyle) {
     VmaAllocationCreateFlags allocFlags = 0;
     switch (memoryAccessingStyle) {
-    case MemoryStyle::kDedicated:
-        allocFlags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    case MemoryStyle::kDeviceLocal:
+        // sub-allocated from the pool of its memory class
         break;
     case MemoryStyle::kHostVisible:
         // memory is allocated with a fixed mapped address, and host can write to it sequentially
@@ -21,28 +24,34 @@ VmaAllocationCreateFlags _decideAllocationCreateFlags(MemoryStyle memoryAccessin
     }
     return allocFlags;
 }
+
+MemoryClass _decideMemoryClass(MemoryStyle memoryAccessingStyle) {
+    // device local buffers are only used for static meshes so far
+    return memoryAccessingStyle == MemoryStyle::kHostVisible ? MemoryClass::kPerFrameDynamic
+                                                             : MemoryClass::kStaticGeometry;
+}
 } // namespace
 
 Buffer::Buffer(VulkanApplicationContext *appContext, VkDeviceSize size,
                VkBufferUsageFlags bufferUsageFlags, MemoryStyle memoryStyle)
-    : _appContext(appContext), _size(size), _memoryStyle(memoryStyle) {
+    : _appContext(appContext), _size(size), _memoryStyle(memoryStyle),
+      _memoryClass(_decideMemoryClass(memoryStyle)) {
     _allocate(bufferUsageFlags);
 }
 
 Buffer::~Buffer() {
     if (_vkBuffer != VK_NULL_HANDLE) {
-        vmaDestroyBuffer(_appContext->getAllocator(), _vkBuffer, _bufferAllocation);
+        _appContext->getMemoryPools()->destroyBuffer(_memoryClass, _vkBuffer, _bufferAllocation);
         _vkBuffer = VK_NULL_HANDLE;
     }
 }
 
 void Buffer::_allocate(VkBufferUsageFlags bufferUsageFlags) {
-    VmaAllocator allocator = _appContext->getAllocator();
-
-    // all dedicated allocations are allowed to be trandferred on both directions, jfor simplicity
-    if (_memoryStyle == MemoryStyle::kDedicated) {
+    // all device local allocations are allowed to be transferred in both directions, for simplicity
+    if (_memoryStyle == MemoryStyle::kDeviceLocal) {
         bufferUsageFlags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     }
+    _usageFlags = bufferUsageFlags;
 
     auto vmaAlloationCreateFlags = _decideAllocationCreateFlags(_memoryStyle);
 
@@ -55,12 +64,33 @@ void Buffer::_allocate(VkBufferUsageFlags bufferUsageFlags) {
     allocCreateInfo.flags = vmaAlloationCreateFlags;
 
     VmaAllocationInfo allocInfo{};
-    vmaCreateBuffer(allocator, &bufferCreateInfo, &allocCreateInfo, &_vkBuffer, &_bufferAllocation,
-                    &allocInfo);
+    _appContext->getMemoryPools()->createBuffer(_memoryClass, bufferCreateInfo, allocCreateInfo,
+                                                &_vkBuffer, &_bufferAllocation, &allocInfo);
 
     if (_memoryStyle == MemoryStyle::kHostVisible) {
         _mappedAddr = allocInfo.pMappedData;
     }
+    // opts in to defragmentation, host visible buffers are mapped and never moved
+    if (_memoryStyle == MemoryStyle::kDeviceLocal && _bufferAllocation != VK_NULL_HANDLE) {
+        vmaSetAllocationUserData(_appContext->getAllocator(), _bufferAllocation,
+                                 static_cast<RelocatableBuffer *>(this));
+    }
+}
+
+bool Buffer::isRelocatable() const {
+    if (_uploadTicket == 0) {
+        // direct uploads are ordered before the moves by the upload manager
+        return true;
+    }
+    auto const *asyncUploader = _appContext->getAsyncUploader();
+    return asyncUploader == nullptr || asyncUploader->isReady(_uploadTicket);
+}
+
+VkBufferCreateInfo Buffer::getRelocatableCreateInfo() const {
+    VkBufferCreateInfo bufferCreateInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCreateInfo.size  = _size;
+    bufferCreateInfo.usage = _usageFlags;
+    return bufferCreateInfo;
 }
 
 VkBufferMemoryBarrier Buffer::getMemoryBarrier(VkAccessFlags srcAccessMask,
@@ -79,8 +109,6 @@ VkBufferMemoryBarrier Buffer::getMemoryBarrier(VkAccessFlags srcAccessMask,
 Buffer::StagingBufferHandle Buffer::_createStagingBuffer() const {
     StagingBufferHandle stagingBufferHandle{};
 
-    VmaAllocator allocator = _appContext->getAllocator();
-
     VkBufferCreateInfo stagingBufCreateInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
     stagingBufCreateInfo.size               = _size;
     stagingBufCreateInfo.usage =
@@ -88,53 +116,41 @@ Buffer::StagingBufferHandle Buffer::_createStagingBuffer() const {
 
     VmaAllocationCreateInfo stagingAllocCreateInfo = {};
     stagingAllocCreateInfo.usage                   = VMA_MEMORY_USAGE_AUTO;
+    // only used to read the device data back, so cached memory serves the host reads best
     stagingAllocCreateInfo.flags =
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
-    VmaAllocationInfo stagingAllocInfo;
-    vmaCreateBuffer(allocator, &stagingBufCreateInfo, &stagingAllocCreateInfo,
-                    &stagingBufferHandle.vkBuffer, &stagingBufferHandle.bufferAllocation,
-                    &stagingAllocInfo);
+    VmaAllocationInfo stagingAllocInfo{};
+    _appContext->getMemoryPools()->createBuffer(
+        MemoryClass::kReadback, stagingBufCreateInfo, stagingAllocCreateInfo,
+        &stagingBufferHandle.vkBuffer, &stagingBufferHandle.bufferAllocation, &stagingAllocInfo);
     stagingBufferHandle.mappedAddr = stagingAllocInfo.pMappedData;
 
     return stagingBufferHandle;
 }
 
 void Buffer::_destroyStagingBuffer(StagingBufferHandle &stagingBufferHandle) {
-    vmaDestroyBuffer(_appContext->getAllocator(), stagingBufferHandle.vkBuffer,
-                     stagingBufferHandle.bufferAllocation);
+    _appContext->getMemoryPools()->destroyBuffer(MemoryClass::kReadback,
+                                                 stagingBufferHandle.vkBuffer,
+                                                 stagingBufferHandle.bufferAllocation);
     stagingBufferHandle.vkBuffer         = VK_NULL_HANDLE;
     stagingBufferHandle.bufferAllocation = VK_NULL_HANDLE;
     stagingBufferHandle.mappedAddr       = nullptr;
 }
 
 void Buffer::fillData(const void *data) {
-    auto const &device      = _appContext->getDevice();
-    auto const &queue       = _appContext->getGraphicsQueue();
-    auto const &commandPool = _appContext->getCommandPool();
-
     switch (_memoryStyle) {
     case MemoryStyle::kHostVisible: {
-        memcpy(_mappedAddr, data, _size);
+        if (data != nullptr) {
+            memcpy(_mappedAddr, data, _size);
+        } else {
+            memset(_mappedAddr, 0, _size);
+        }
         break;
     }
-    case MemoryStyle::kDedicated: {
-        StagingBufferHandle stagingBufferHandle = _createStagingBuffer();
-        memcpy(stagingBufferHandle.mappedAddr, data, _size);
-
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
-
-        VkBufferCopy bufCopy = {
-            0,     // srcOffset
-            0,     // dstOffset,
-            _size, // size
-        };
-
-        // copy staging buffer to main buffer
-        vkCmdCopyBuffer(commandBuffer, stagingBufferHandle.vkBuffer, _vkBuffer, 1, &bufCopy);
-
-        endSingleTimeCommands(device, commandPool, queue, commandBuffer);
-        _destroyStagingBuffer(stagingBufferHandle);
+    case MemoryStyle::kDeviceLocal: {
+        // recorded into the current upload batch, which is submitted before the next frame
+        _appContext->getUploadManager()->uploadToBuffer(_vkBuffer, 0, data, _size);
         break;
     }
     }
@@ -152,7 +168,10 @@ void Buffer::fetchData(void *data) {
         return;
     }
 
-    case MemoryStyle::kDedicated: {
+    case MemoryStyle::kDeviceLocal: {
+        // pending uploads to this buffer have to reach the queue before the read back
+        _appContext->getUploadManager()->flush();
+
         StagingBufferHandle stagingBufferHandle = _createStagingBuffer();
 
         VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
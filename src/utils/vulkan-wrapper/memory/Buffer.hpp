@@ -8,24 +8,31 @@
 #include "vk_mem_alloc.h" // NO_G3_REWRITE
 #endif
 
+#include "app-context/Defragmenter.hpp"
+#include "app-context/MemoryPools.hpp"
+
 enum class MemoryStyle {
-    kDedicated,
+    // device local, filled through the upload manager, sub-allocated as static geometry
+    kDeviceLocal,
+    // persistently mapped and written by the host, sub-allocated as per frame dynamic data
     kHostVisible,
 };
 
 class VulkanApplicationContext;
 // the wrapper class of VkBuffer, handles memory allocation and data filling
-class Buffer {
+// device local buffers may be moved by the defragmenter, so their VkBuffer must be fetched again
+// whenever commands are recorded rather than kept
+class Buffer : public RelocatableBuffer {
   public:
     Buffer(VulkanApplicationContext *appContext, VkDeviceSize size,
            VkBufferUsageFlags bufferUsageFlags, MemoryStyle memoryStyle);
-    ~Buffer();
+    ~Buffer() override;
 
-    // default copy and move
-    Buffer(const Buffer &)            = default;
-    Buffer &operator=(const Buffer &) = default;
-    Buffer(Buffer &&)                 = default;
-    Buffer &operator=(Buffer &&)      = default;
+    // disable move and copy, the allocation refers back to the buffer
+    Buffer(const Buffer &)            = delete;
+    Buffer &operator=(const Buffer &) = delete;
+    Buffer(Buffer &&)                 = delete;
+    Buffer &operator=(Buffer &&)      = delete;
 
     // fill buffer with data
     //  buffer will be zero-initialized if data is nullptr
@@ -46,6 +53,14 @@ class Buffer {
     VkBufferMemoryBarrier getMemoryBarrier(VkAccessFlags srcAccessMask,
                                            VkAccessFlags dstAccessMask);
 
+    // the buffer is written by a streamed upload, it isn't moved before the ticket is ready
+    void setUploadTicket(uint64_t uploadTicket) { _uploadTicket = uploadTicket; }
+
+    [[nodiscard]] bool isRelocatable() const override;
+    [[nodiscard]] VkBuffer getRelocatableBuffer() const override { return _vkBuffer; }
+    [[nodiscard]] VkBufferCreateInfo getRelocatableCreateInfo() const override;
+    void onRelocated(VkBuffer newBuffer) override { _vkBuffer = newBuffer; }
+
     inline VkDescriptorBufferInfo getDescriptorInfo() {
         VkDescriptorBufferInfo descriptorInfo{};
         descriptorInfo.buffer = _vkBuffer;
@@ -60,6 +75,9 @@ class Buffer {
     VkDeviceSize _size; // total size of buffer
 
     MemoryStyle _memoryStyle;
+    MemoryClass _memoryClass;
+    VkBufferUsageFlags _usageFlags = 0;
+    uint64_t _uploadTicket         = 0;
 
     VkBuffer _vkBuffer              = VK_NULL_HANDLE;
     VmaAllocation _bufferAllocation = VK_NULL_HANDLE;
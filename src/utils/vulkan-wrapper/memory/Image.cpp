@@ -1,12 +1,17 @@
 #include "Image.hpp"
 
-#include "../utils/SimpleCommands.hpp"
+#include "app-context/AsyncUploader.hpp"
+#include "app-context/MemoryPools.hpp"
+#include "app-context/UploadManager.hpp"
 #include "app-context/VulkanApplicationContext.hpp"
+#include "utils/image-loader/Ktx2File.hpp"
+#include "utils/image-loader/MipmapGenerator.hpp"
+#include "utils/image-loader/TextureCooker.hpp"
 #include "utils/logger/Logger.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <unordered_map>
@@ -33,6 +38,14 @@ static const std::unordered_map<VkFormat, int> kVkFormatBytesPerPixelMap{
     {VK_FORMAT_R32G32B32A32_SFLOAT, 16},
 };
 
+// block compressed formats, bytes per 4x4 block
+static const std::unordered_map<VkFormat, int> kVkFormatBytesPerBlockMap{
+    {VK_FORMAT_BC1_RGB_UNORM_BLOCK, 8},
+    {VK_FORMAT_BC4_UNORM_BLOCK, 8},
+    {VK_FORMAT_BC5_UNORM_BLOCK, 16},
+    {VK_FORMAT_BC7_UNORM_BLOCK, 16},
+};
+
 namespace {
 unsigned char *_loadImageFromPath(const std::string &path, int &width, int &height, int &channels,
                                   Logger *logger) {
@@ -98,6 +111,181 @@ Image::Image(VulkanApplicationContext *appContext, Logger *logger, const std::st
                                    _dimensions.depth, _layerCount);
 }
 
+Image::Image(VulkanApplicationContext *appContext, Logger *logger, const std::string &filename,
+             VkImageUsageFlags usage, VkSampler sampler, ImageLoading loading,
+             ImageMipmaps mipmaps, ImageCompression compression)
+    : _appContext(appContext), _logger(logger), _vkSampler(sampler),
+      _currentImageLayout(VK_IMAGE_LAYOUT_UNDEFINED), _layerCount(1),
+      _format(VK_FORMAT_R8G8B8A8_UNORM) {
+    auto *asyncUploader         = _appContext->getAsyncUploader();
+    VkFormat const cookedFormat = getCompressedFormat(_appContext, _logger, compression);
+    bool const streamed         = loading == ImageLoading::kStreamed && asyncUploader != nullptr;
+    if (cookedFormat != VK_FORMAT_UNDEFINED) {
+        _format = cookedFormat;
+        _loadCookedTexture(filename, usage, mipmaps, streamed);
+    } else if (!streamed) {
+        int width       = 0;
+        int height      = 0;
+        int channels    = 0;
+        auto *imageData = _loadImageFromPath(filename, width, height, channels, _logger);
+
+        _dimensions = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+        if (mipmaps == ImageMipmaps::kFullChain) {
+            _mipLevels = MipmapGenerator::getMipLevelCount(_dimensions.width, _dimensions.height);
+        }
+
+        // blitting reads the previous level, so the image has to be a transfer source as well
+        bool const blitMipmaps = _mipLevels > 1 && _supportsLinearBlit();
+        _createImage(VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+                     blitMipmaps ? usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT : usage);
+        _transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        _copyDataToImage(imageData);
+        if (blitMipmaps) {
+            _generateMipmapsWithBlits();
+        } else {
+            _copyMipChainToImage(imageData);
+            _transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        _freeImageData(imageData);
+    } else {
+        // the header is enough to create the image, the decoding is the slow part
+        int width    = 0;
+        int height   = 0;
+        int channels = 0;
+        if (stbi_info(filename.c_str(), &width, &height, &channels) == 0) {
+            _logger->error("Failed to load image: {}", filename);
+            return;
+        }
+
+        _dimensions = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+        if (mipmaps == ImageMipmaps::kFullChain) {
+            _mipLevels = MipmapGenerator::getMipLevelCount(_dimensions.width, _dimensions.height);
+        }
+        if (_createImage(VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, usage) != VK_SUCCESS) {
+            return;
+        }
+        // the layout it will be in once the graphics queue acquires it
+        _currentImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        _uploadTicket = asyncUploader->enqueue([this, filename](AsyncUploader::Recorder &recorder) {
+            int decodedWidth    = 0;
+            int decodedHeight   = 0;
+            int decodedChannels = 0;
+            auto *imageData     = _loadImageFromPath(filename, decodedWidth, decodedHeight,
+                                                     decodedChannels, _logger);
+
+            uint32_t const bytesPerPixel = kVkFormatBytesPerPixelMap.at(_format);
+
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+            region.imageExtent      = {_dimensions.width, _dimensions.height, 1};
+
+            // the file may have changed since the header was read
+            VkDeviceSize imageDataSize = 0;
+            if (static_cast<uint32_t>(decodedWidth) == _dimensions.width &&
+                static_cast<uint32_t>(decodedHeight) == _dimensions.height) {
+                imageDataSize =
+                    static_cast<VkDeviceSize>(decodedWidth) * decodedHeight * bytesPerPixel;
+            }
+            recorder.uploadToImage(_vkImage, region, imageData, imageDataSize, bytesPerPixel,
+                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+            // the transfer queue can't blit, the rest of the chain is filtered right here on the
+            // loader thread instead
+            MipmapGenerator::MipChain mipChain{};
+            if (imageDataSize != 0 && _mipLevels > 1) {
+                mipChain = MipmapGenerator::generateMipChain(imageData, _dimensions.width,
+                                                             _dimensions.height, bytesPerPixel);
+            }
+            if (imageData != nullptr) {
+                _freeImageData(imageData);
+            }
+            for (uint32_t level = 1; level < _mipLevels; level++) {
+                VkBufferImageCopy mipRegion{};
+                mipRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+
+                // without data the level is only transitioned, like the base level above
+                unsigned char const *levelData = nullptr;
+                VkDeviceSize levelSize         = 0;
+                if (!mipChain.levels.empty()) {
+                    auto const &mipLevel  = mipChain.levels[level - 1];
+                    mipRegion.imageExtent = {mipLevel.width, mipLevel.height, 1};
+                    levelData             = mipChain.texels.data() + mipLevel.offset;
+                    levelSize             = mipLevel.size;
+                }
+                recorder.uploadToImage(_vkImage, mipRegion, levelData, levelSize, bytesPerPixel,
+                                       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        });
+    }
+
+    if (_vkImage != VK_NULL_HANDLE) {
+        _vkImageView =
+            createImageView(_appContext->getDevice(), _vkImage, _format, VK_IMAGE_ASPECT_COLOR_BIT,
+                            _dimensions.depth, _layerCount, _mipLevels);
+    }
+}
+
+Image::Image(VulkanApplicationContext *appContext, Logger *logger,
+             std::shared_ptr<Ktx2File::Ktx2Texture const> texture, VkImageUsageFlags usage,
+             VkSampler sampler, ImageLoading loading, ImageMipmaps mipmaps)
+    : _appContext(appContext), _logger(logger), _vkSampler(sampler),
+      _currentImageLayout(VK_IMAGE_LAYOUT_UNDEFINED), _layerCount(1), _format(texture->format),
+      _dimensions(texture->width, texture->height) {
+    if (mipmaps == ImageMipmaps::kFullChain) {
+        _mipLevels = static_cast<uint32_t>(texture->levels.size());
+    }
+    if (_createImage(VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, usage) != VK_SUCCESS) {
+        return;
+    }
+
+    // per 4x4 block for the block compressed formats, per pixel otherwise
+    auto const blockSizeIt        = kVkFormatBytesPerBlockMap.find(_format);
+    uint32_t const texelBlockSize = blockSizeIt != kVkFormatBytesPerBlockMap.end()
+                                        ? blockSizeIt->second
+                                        : kVkFormatBytesPerPixelMap.at(_format);
+
+    auto *asyncUploader = _appContext->getAsyncUploader();
+    if (loading == ImageLoading::kStreamed && asyncUploader != nullptr) {
+        // the layout it will be in once the graphics queue acquires it
+        _currentImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        // the task keeps the texture alive until the levels are in the staging ring
+        _uploadTicket = asyncUploader->enqueue(
+            [this, texture, texelBlockSize](AsyncUploader::Recorder &recorder) {
+                for (uint32_t level = 0; level < _mipLevels; level++) {
+                    auto const &textureLevel = texture->levels[level];
+
+                    VkBufferImageCopy region{};
+                    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+                    region.imageExtent      = {textureLevel.width, textureLevel.height, 1};
+                    recorder.uploadToImage(_vkImage, region,
+                                           texture->data.data() + textureLevel.offset,
+                                           textureLevel.size, texelBlockSize,
+                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                }
+            });
+    } else {
+        auto *uploadManager = _appContext->getUploadManager();
+        _transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        for (uint32_t level = 0; level < _mipLevels; level++) {
+            auto const &textureLevel = texture->levels[level];
+
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            region.imageExtent      = {textureLevel.width, textureLevel.height, 1};
+            uploadManager->uploadToImage(_vkImage, region,
+                                         texture->data.data() + textureLevel.offset,
+                                         textureLevel.size, texelBlockSize);
+        }
+        _transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    _vkImageView =
+        createImageView(_appContext->getDevice(), _vkImage, _format, VK_IMAGE_ASPECT_COLOR_BIT,
+                        _dimensions.depth, _layerCount, _mipLevels);
+}
+
 Image::Image(VulkanApplicationContext *appContext, Logger *logger,
              const std::vector<std::string> &filenames, VkImageUsageFlags usage, VkSampler sampler,
              VkImageLayout initialImageLayout, VkSampleCountFlagBits numSamples,
@@ -140,9 +328,13 @@ Image::Image(VulkanApplicationContext *appContext, Logger *logger,
 }
 
 Image::~Image() {
+    // the loader thread may still be decoding into or writing this image
+    if (_uploadTicket != 0) {
+        _appContext->getAsyncUploader()->cancel(_uploadTicket);
+    }
     if (_vkImage != VK_NULL_HANDLE) {
         vkDestroyImageView(_appContext->getDevice(), _vkImageView, nullptr);
-        vmaDestroyImage(_appContext->getAllocator(), _vkImage, _allocation);
+        _appContext->getMemoryPools()->destroyImage(_memoryClass, _vkImage, _allocation);
     }
 }
 
@@ -153,41 +345,17 @@ void Image::clearImage(VkCommandBuffer commandBuffer) {
 }
 
 void Image::_copyDataToImage(unsigned char *imageData, uint32_t layerToCopyTo) {
-    auto const &device      = _appContext->getDevice();
-    auto const &queue       = _appContext->getGraphicsQueue();
-    auto const &commandPool = _appContext->getCommandPool();
-    auto const &allocator   = _appContext->getAllocator();
+    // a failed load leaves nothing to upload, don't poison the shared upload batch with it
+    if (_vkImage == VK_NULL_HANDLE || imageData == nullptr) {
+        return;
+    }
 
     const uint32_t imagePixelCount = _dimensions.width * _dimensions.height * _dimensions.depth;
+    const uint32_t bytesPerPixel   = kVkFormatBytesPerPixelMap.at(_format);
     // the channel count is ignored here, because the VkFormat is enough
-    const uint32_t imageDataSize = imagePixelCount * kVkFormatBytesPerPixelMap.at(_format);
-
-    // create a staging buffer
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size        = imageDataSize;
-    bufferInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    VmaAllocationCreateInfo vmaAllocInfo{};
-    vmaAllocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-
-    VkBuffer stagingBuffer                = VK_NULL_HANDLE;
-    VmaAllocation stagingBufferAllocation = nullptr;
-    vmaCreateBuffer(allocator, &bufferInfo, &vmaAllocInfo, &stagingBuffer, &stagingBufferAllocation,
-                    nullptr);
-
-    // copy your data to the staging buffer
-    void *mappedData = nullptr;
-    vmaMapMemory(allocator, stagingBufferAllocation, &mappedData);
-    memcpy(mappedData, imageData, imageDataSize);
-    vmaUnmapMemory(allocator, stagingBufferAllocation);
-
-    // record a command to copy the buffer to the image
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
+    const uint32_t imageDataSize = imagePixelCount * bytesPerPixel;
 
     VkBufferImageCopy region{};
-    region.bufferOffset                = 0;
     region.bufferRowLength             = 0; // If your data is tightly packed, this can be 0
     region.bufferImageHeight           = 0; // If your data is tightly packed, this can be 0
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -200,13 +368,223 @@ void Image::_copyDataToImage(unsigned char *imageData, uint32_t layerToCopyTo) {
                                               static_cast<uint32_t>(_dimensions.height),
                                               static_cast<uint32_t>(_dimensions.depth)};
 
-    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, _vkImage,
-                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    // the pixels are copied into the staging ring right away, so the caller can free them
+    _appContext->getUploadManager()->uploadToImage(_vkImage, region, imageData, imageDataSize,
+                                                   bytesPerPixel);
+}
+
+bool Image::_supportsLinearBlit() const {
+    VkFormatProperties formatProperties{};
+    vkGetPhysicalDeviceFormatProperties(_appContext->getPhysicalDevice(), _format,
+                                        &formatProperties);
+
+    VkFormatFeatureFlags const requiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                                  VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                                  VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+void Image::_generateMipmapsWithBlits() {
+    if (_vkImage == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // recorded into the upload batch right after the copy of the base level, the upload manager
+    // submits to the graphics queue, which is able to blit
+    VkCommandBuffer commandBuffer = _appContext->getUploadManager()->getCommandBuffer();
+
+    VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image               = _vkImage;
+    barrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, _layerCount};
+
+    auto levelWidth  = static_cast<int32_t>(_dimensions.width);
+    auto levelHeight = static_cast<int32_t>(_dimensions.height);
+    for (uint32_t level = 1; level < _mipLevels; level++) {
+        // the previous level has been written, it is the source of this blit
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout                     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask                 = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &barrier);
+
+        int32_t const nextWidth  = std::max(levelWidth / 2, 1);
+        int32_t const nextHeight = std::max(levelHeight / 2, 1);
+
+        VkImageBlit blit{};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, _layerCount};
+        blit.srcOffsets[1]  = {levelWidth, levelHeight, 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, _layerCount};
+        blit.dstOffsets[1]  = {nextWidth, nextHeight, 1};
+        vkCmdBlitImage(commandBuffer, _vkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, _vkImage,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        // the previous level is final now
+        barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &barrier);
+
+        levelWidth  = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    // the last level is only ever written
+    barrier.subresourceRange.baseMipLevel = _mipLevels - 1;
+    barrier.oldLayout                     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout                     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask                 = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                         &barrier);
+
+    _currentImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void Image::_copyMipChainToImage(unsigned char const *imageData) {
+    if (_vkImage == VK_NULL_HANDLE || imageData == nullptr || _mipLevels <= 1) {
+        return;
+    }
+
+    // 8 bit channels, so the channel count is the byte size of a pixel
+    uint32_t const bytesPerPixel = kVkFormatBytesPerPixelMap.at(_format);
+    auto const mipChain          = MipmapGenerator::generateMipChain(
+        imageData, _dimensions.width, _dimensions.height, bytesPerPixel);
+
+    auto *uploadManager = _appContext->getUploadManager();
+    for (size_t i = 0; i < mipChain.levels.size(); i++) {
+        auto const &mipLevel = mipChain.levels[i];
+
+        VkBufferImageCopy region{};
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, static_cast<uint32_t>(i + 1), 0, 1};
+        region.imageExtent      = {mipLevel.width, mipLevel.height, 1};
+        uploadManager->uploadToImage(_vkImage, region, mipChain.texels.data() + mipLevel.offset,
+                                     mipLevel.size, bytesPerPixel);
+    }
+}
+
+VkFormat Image::getCompressedFormat(VulkanApplicationContext *appContext, Logger *logger,
+                                    ImageCompression compression) {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    switch (compression) {
+    case ImageCompression::kNone:
+        return VK_FORMAT_UNDEFINED;
+    case ImageCompression::kColor:
+        format = VK_FORMAT_BC7_UNORM_BLOCK;
+        break;
+    case ImageCompression::kNormal:
+        format = VK_FORMAT_BC5_UNORM_BLOCK;
+        break;
+    case ImageCompression::kMask:
+        format = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        break;
+    case ImageCompression::kSingleChannel:
+        format = VK_FORMAT_BC4_UNORM_BLOCK;
+        break;
+    }
+
+    VkPhysicalDeviceFeatures features{};
+    vkGetPhysicalDeviceFeatures(appContext->getPhysicalDevice(), &features);
+    if (features.textureCompressionBC == VK_FALSE) {
+        logger->warn("Block compressed textures are not supported, loading them uncompressed");
+        return VK_FORMAT_UNDEFINED;
+    }
+    return format;
+}
+
+void Image::_loadCookedTexture(const std::string &filename, VkImageUsageFlags usage,
+                               ImageMipmaps mipmaps, bool streamed) {
+    if (!streamed) {
+        auto const texture = TextureCooker::loadOrCook(filename, _format, _logger);
+        if (!texture) {
+            return;
+        }
+        _logger->info("New Image Loaded: {}", filename);
+
+        _dimensions = {texture->width, texture->height, 1};
+        if (mipmaps == ImageMipmaps::kFullChain) {
+            _mipLevels = static_cast<uint32_t>(texture->levels.size());
+        }
+        if (_createImage(VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, usage) != VK_SUCCESS) {
+            return;
+        }
+
+        // the blocks are copied as they are, there is nothing to decode or to filter
+        uint32_t const bytesPerBlock = kVkFormatBytesPerBlockMap.at(_format);
+        auto *uploadManager          = _appContext->getUploadManager();
+        _transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        for (uint32_t level = 0; level < _mipLevels; level++) {
+            auto const &cookedLevel = texture->levels[level];
+
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            region.imageExtent      = {cookedLevel.width, cookedLevel.height, 1};
+            uploadManager->uploadToImage(_vkImage, region,
+                                         texture->data.data() + cookedLevel.offset,
+                                         cookedLevel.size, bytesPerBlock);
+        }
+        _transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        return;
+    }
 
-    endSingleTimeCommands(device, commandPool, queue, commandBuffer);
+    // the source header is enough to create the image, the cooked file is read on the loader
+    // thread, and the cooking itself happens there too when the cache is stale
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+    if (stbi_info(filename.c_str(), &width, &height, &channels) == 0) {
+        _logger->error("Failed to load image: {}", filename);
+        return;
+    }
 
-    // Clean up the staging buffer
-    vmaDestroyBuffer(_appContext->getAllocator(), stagingBuffer, stagingBufferAllocation);
+    _dimensions = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    if (mipmaps == ImageMipmaps::kFullChain) {
+        _mipLevels = MipmapGenerator::getMipLevelCount(_dimensions.width, _dimensions.height);
+    }
+    if (_createImage(VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, usage) != VK_SUCCESS) {
+        return;
+    }
+    // the layout it will be in once the graphics queue acquires it
+    _currentImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    auto *asyncUploader = _appContext->getAsyncUploader();
+    _uploadTicket = asyncUploader->enqueue([this, filename](AsyncUploader::Recorder &recorder) {
+        auto const texture = TextureCooker::loadOrCook(filename, _format, _logger);
+
+        // the file may have changed since the header was read, the levels are only transitioned
+        // then
+        bool const matches = texture && texture->width == _dimensions.width &&
+                             texture->height == _dimensions.height &&
+                             texture->levels.size() >= _mipLevels;
+        if (matches) {
+            _logger->info("New Image Loaded: {}", filename);
+        }
+
+        uint32_t const bytesPerBlock = kVkFormatBytesPerBlockMap.at(_format);
+        for (uint32_t level = 0; level < _mipLevels; level++) {
+            VkBufferImageCopy region{};
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+
+            unsigned char const *levelData = nullptr;
+            VkDeviceSize levelSize         = 0;
+            if (matches) {
+                auto const &cookedLevel = texture->levels[level];
+                region.imageExtent      = {cookedLevel.width, cookedLevel.height, 1};
+                levelData               = texture->data.data() + cookedLevel.offset;
+                levelSize               = cookedLevel.size;
+            }
+            recorder.uploadToImage(_vkImage, region, levelData, levelSize, bytesPerBlock,
+                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+    });
 }
 
 VkResult Image::_createImage(VkSampleCountFlagBits numSamples, VkImageTiling tiling,
@@ -216,7 +594,7 @@ VkResult Image::_createImage(VkSampleCountFlagBits numSamples, VkImageTiling til
     imageInfo.extent.width  = _dimensions.width;
     imageInfo.extent.height = _dimensions.height;
     imageInfo.extent.depth  = _dimensions.depth;
-    imageInfo.mipLevels     = 1;
+    imageInfo.mipLevels     = _mipLevels;
     imageInfo.arrayLayers   = _layerCount;
     imageInfo.format        = _format;
     imageInfo.tiling        = tiling;
@@ -226,18 +604,22 @@ VkResult Image::_createImage(VkSampleCountFlagBits numSamples, VkImageTiling til
 
     VmaAllocationCreateInfo vmaallocInfo = {};
     vmaallocInfo.usage                   = VMA_MEMORY_USAGE_AUTO;
-    vmaallocInfo.flags =
-        // especially if they are large or if you plan to destroy and recreate them with different
-        // sizes
-        VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
 
-    return vmaCreateImage(_appContext->getAllocator(), &imageInfo, &vmaallocInfo, &_vkImage,
-                          &_allocation, nullptr);
+    // render targets and storage images keep dedicated memory, especially since they are large and
+    // destroyed and recreated with different sizes, sampled images share the texture pool
+    VkImageUsageFlags const renderTargetUsage =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    _memoryClass = (usage & renderTargetUsage) != 0 ? MemoryClass::kDedicated
+                                                    : MemoryClass::kStaticTexture;
+
+    return _appContext->getMemoryPools()->createImage(_memoryClass, imageInfo, vmaallocInfo,
+                                                      &_vkImage, &_allocation);
 }
 
 VkImageView Image::createImageView(VkDevice device, const VkImage &image, VkFormat format,
                                    VkImageAspectFlags aspectFlags, uint32_t imageDepth,
-                                   uint32_t layerCount) {
+                                   uint32_t layerCount, uint32_t mipLevels) {
 
     VkImageView imageView{};
 
@@ -256,7 +638,7 @@ VkImageView Image::createImageView(VkDevice device, const VkImage &image, VkForm
     viewInfo.format                          = format;
     viewInfo.subresourceRange.aspectMask     = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel   = 0;
-    viewInfo.subresourceRange.levelCount     = 1;
+    viewInfo.subresourceRange.levelCount     = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount     = layerCount;
 
@@ -265,6 +647,15 @@ VkImageView Image::createImageView(VkDevice device, const VkImage &image, VkForm
     return imageView;
 }
 
+VkDeviceSize Image::getAllocationSize() const {
+    if (_allocation == VK_NULL_HANDLE) {
+        return 0;
+    }
+    VmaAllocationInfo allocInfo{};
+    vmaGetAllocationInfo(_appContext->getAllocator(), _allocation, &allocInfo);
+    return allocInfo.size;
+}
+
 VkDescriptorImageInfo Image::getDescriptorInfo(VkImageLayout imageLayout) const {
     VkDescriptorImageInfo imageInfo{};
     imageInfo.imageLayout = imageLayout;
@@ -276,11 +667,12 @@ VkDescriptorImageInfo Image::getDescriptorInfo(VkImageLayout imageLayout) const
 }
 
 void Image::_transitionImageLayout(VkImageLayout newLayout) {
-    auto const &device      = _appContext->getDevice();
-    auto const &queue       = _appContext->getGraphicsQueue();
-    auto const &commandPool = _appContext->getCommandPool();
+    if (_vkImage == VK_NULL_HANDLE) {
+        return;
+    }
 
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
+    // recorded into the upload batch so it stays ordered with the copies into this image
+    VkCommandBuffer commandBuffer = _appContext->getUploadManager()->getCommandBuffer();
 
     VkImageMemoryBarrier barrier{};
     barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -291,7 +683,7 @@ void Image::_transitionImageLayout(VkImageLayout newLayout) {
     barrier.image                           = _vkImage;
     barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel   = 0;
-    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.levelCount     = _mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount     = _layerCount;
 
@@ -336,8 +728,6 @@ void Image::_transitionImageLayout(VkImageLayout newLayout) {
     vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1,
                          &barrier);
 
-    endSingleTimeCommands(device, commandPool, queue, commandBuffer);
-
     _currentImageLayout = newLayout;
 }
 
@@ -4,11 +4,44 @@
 
 #include "vma/vk_mem_alloc.h" // NO_G3_REWRITE
 
+#include "app-context/MemoryPools.hpp"
+
+#include <memory>
 #include <string>
 #include <vector>
 
 class Logger;
 class VulkanApplicationContext;
+namespace Ktx2File {
+struct Ktx2Texture;
+}; // namespace Ktx2File
+
+enum class ImageLoading {
+    kBlocking,
+    // decoded and uploaded on the loader thread of the async uploader
+    kStreamed,
+};
+
+enum class ImageMipmaps {
+    kSingleLevel,
+    // every level down to 1x1, blitted on the gpu when the format allows it, filtered on the cpu
+    // otherwise
+    kFullChain,
+};
+
+// block compression of textures loaded from files, cooked once into a ktx2 file next to the
+// source and read from there afterwards, falls back to kNone when the device can't sample bc
+enum class ImageCompression {
+    kNone,
+    // bc7, rgba
+    kColor,
+    // bc5, only xy is kept, z is reconstructed in the shader
+    kNormal,
+    // bc1, rgb without alpha
+    kMask,
+    // bc4, r only
+    kSingleChannel,
+};
 
 struct ImageDimensions {
     uint32_t width;
@@ -48,6 +81,21 @@ class Image {
           VkImageTiling tiling             = VK_IMAGE_TILING_OPTIMAL,
           VkImageAspectFlags aspectFlags   = VK_IMAGE_ASPECT_COLOR_BIT);
 
+    // create a sampled texture from a file, only the header is read here when streamed, the image
+    // ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and must not be used before its upload
+    // ticket is ready, loads blocking when the device has no async uploader
+    Image(VulkanApplicationContext *appContext, Logger *logger, const std::string &filename,
+          VkImageUsageFlags usage, VkSampler sampler, ImageLoading loading,
+          ImageMipmaps mipmaps         = ImageMipmaps::kSingleLevel,
+          ImageCompression compression = ImageCompression::kNone);
+
+    // create a sampled texture from a texture decoded ahead of time (see TextureDecoder), in the
+    // format and with the levels it was decoded to, streamed like the file constructor above,
+    // except that the loader thread only copies the levels
+    Image(VulkanApplicationContext *appContext, Logger *logger,
+          std::shared_ptr<Ktx2File::Ktx2Texture const> texture, VkImageUsageFlags usage,
+          VkSampler sampler, ImageLoading loading, ImageMipmaps mipmaps);
+
     // create a texture array from a set of image files, all images should be in
     // the same dimension and the same format..
     Image(VulkanApplicationContext *appContext, Logger *logger,
@@ -70,16 +118,27 @@ class Image {
 
     [[nodiscard]] VkDescriptorImageInfo getDescriptorInfo(VkImageLayout imageLayout) const;
     [[nodiscard]] ImageDimensions getDimensions() const { return _dimensions; }
+    [[nodiscard]] uint32_t getMipLevels() const { return _mipLevels; }
+    // device memory held by the image, the whole mip chain included
+    [[nodiscard]] VkDeviceSize getAllocationSize() const;
 
     void clearImage(VkCommandBuffer commandBuffer);
 
+    // the block compressed format a texture is cooked to, VK_FORMAT_UNDEFINED when it should stay
+    // uncompressed, either by choice or because the device can't sample bc
+    static VkFormat getCompressedFormat(VulkanApplicationContext *appContext, Logger *logger,
+                                        ImageCompression compression);
+
     static VkImageView createImageView(VkDevice device, const VkImage &image, VkFormat format,
                                        VkImageAspectFlags aspectFlags, uint32_t imageDepth = 1,
-                                       uint32_t layerCount = 1);
+                                       uint32_t layerCount = 1, uint32_t mipLevels = 1);
 
     VkImage getVkImage() const { return _vkImage; }
     VkImageView getVkImageView() const { return _vkImageView; }
 
+    // ticket of the async uploader that writes the pixels, 0 when they were uploaded directly
+    [[nodiscard]] uint64_t getUploadTicket() const { return _uploadTicket; }
+
   private:
     VulkanApplicationContext *_appContext;
 
@@ -87,15 +146,33 @@ class Image {
     VkImageView _vkImageView  = VK_NULL_HANDLE;
     VkSampler _vkSampler      = VK_NULL_HANDLE;
     VmaAllocation _allocation = VK_NULL_HANDLE;
+    MemoryClass _memoryClass  = MemoryClass::kStaticTexture;
     VkImageLayout _currentImageLayout;
     uint32_t _layerCount;
+    uint32_t _mipLevels = 1;
     VkFormat _format;
 
     ImageDimensions _dimensions;
     Logger *_logger;
 
+    uint64_t _uploadTicket = 0;
+
     void _copyDataToImage(unsigned char *imageData, uint32_t layerToCopyTo = 0);
 
+    // whether the mip chain can be blitted from the base level on the gpu
+    [[nodiscard]] bool _supportsLinearBlit() const;
+    // expects every level in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with the base level written,
+    // leaves every level in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    void _generateMipmapsWithBlits();
+    // filters the levels after the base one on the cpu and uploads them, the image must be in
+    // VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    void _copyMipChainToImage(unsigned char const *imageData);
+
+    // loads the cooked ktx2 file of the source, cooking it first if needed, _format has to be the
+    // block compressed format already
+    void _loadCookedTexture(const std::string &filename, VkImageUsageFlags usage,
+                            ImageMipmaps mipmaps, bool streamed);
+
     // creates an image with VK_IMAGE_LAYOUT_UNDEFINED initially
     VkResult _createImage(VkSampleCountFlagBits numSamples, VkImageTiling tiling,
                           VkImageUsageFlags usage);
@@ -1,34 +1,119 @@
 // Model.cpp
 #include "Model.hpp"
 
+#include "app-context/AsyncUploader.hpp"
 #include "app-context/VulkanApplicationContext.hpp"
 #include "utils/logger/Logger.hpp"
+#include "utils/model-loader/MeshFile.hpp"
 
-Model::Model(VulkanApplicationContext *appContext, Logger *logger, const std::string &filePath)
-    : _appContext(appContext), _logger(logger) {
-    auto attrsOpt = ModelLoader::loadModelFromPath(filePath, logger);
-    if (!attrsOpt.has_value()) {
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+Model::Source::Source()                                     = default;
+Model::Source::~Source()                                    = default;
+Model::Source::Source(Source &&) noexcept                   = default;
+Model::Source &Model::Source::operator=(Source &&) noexcept = default;
+
+Model::Source Model::Source::load(const std::string &filePath, VertexFormat vertexFormat,
+                                  Logger *logger) {
+    auto const loadStart = std::chrono::steady_clock::now();
+
+    Source source;
+    source.filePath     = filePath;
+    source.vertexFormat = vertexFormat;
+
+    std::string const cookedPath = MeshFile::getCookedPath(filePath, vertexFormat);
+    if (MeshFile::isFresh(filePath, cookedPath)) {
+        source.cookedModel = MeshFile::MappedModel::open(cookedPath);
+        if (source.cookedModel == nullptr) {
+            logger->warn("Model: {} is unreadable or of another version, importing {} instead",
+                         cookedPath, filePath);
+        }
+    }
+    if (source.cookedModel == nullptr) {
+        source.importedModel = ModelLoader::loadModelFromPath(filePath, logger, vertexFormat);
+    }
+
+    auto const loadEnd = std::chrono::steady_clock::now();
+    source.loadTimeMs  = std::chrono::duration<double, std::milli>(loadEnd - loadStart).count();
+    return source;
+}
+
+Model::Model(VulkanApplicationContext *appContext, Logger *logger, const std::string &filePath,
+             VertexFormat vertexFormat)
+    : Model(appContext, logger, Source::load(filePath, vertexFormat, logger)) {}
+
+Model::Model(VulkanApplicationContext *appContext, Logger *logger, Source source)
+    : vertexFormat(source.vertexFormat), _appContext(appContext), _logger(logger),
+      _cookedModel(std::move(source.cookedModel)) {
+    std::string const &filePath = source.filePath;
+    if (_cookedModel != nullptr) {
+        _loadCooked();
+    } else if (source.importedModel.has_value()) {
+        _import(*source.importedModel);
+    } else {
         logger->error("Failed to load model: {}", filePath);
         return;
     }
-    auto attrs = attrsOpt.value();
 
-    for (const auto& mesh : attrs.meshes) {
-        vertices.push_back(mesh.vertices);
-        indices.push_back(mesh.indices);
+    // what the vertex buffers take in either format, for comparing against the frame timing
+    bool const isQuantized   = vertexFormat == VertexFormat::kQuantized;
+    size_t const vertexCount = std::accumulate(vertCnts.begin(), vertCnts.end(), size_t{0});
+    auto const toMiB = [](size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+    logger->info("Model {}: {} in {:.1f} ms", filePath,
+                 _cookedModel != nullptr
+                     ? "mapped from " + MeshFile::getCookedPath(filePath, vertexFormat)
+                     : "imported",
+                 source.loadTimeMs);
+    logger->info("Model {}: {} vertices, {:.2f} MB as {}, {:.2f} MB as fp32", filePath,
+                 vertexCount,
+                 toMiB(vertexCount * (isQuantized ? sizeof(QuantizedVertex) : sizeof(Vertex))),
+                 isQuantized ? "quantized" : "fp32", toMiB(vertexCount * sizeof(Vertex)));
 
-        auto vb = std::make_shared<Buffer>(appContext, mesh.vertices.size() * sizeof(Vertex),
-                                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, MemoryStyle::kDedicated);
-        vb->fillData(mesh.vertices.data());
-        vertexBuffers.push_back(vb);
+    size_t shortIndexCount = 0;
+    for (size_t i = 0; i < indexTypes.size(); ++i) {
+        shortIndexCount += indexTypes[i] == VK_INDEX_TYPE_UINT16 ? idxCnts[i] : 0;
+    }
+    logger->info("Model {}: {} of {} meshes with 16 bit indices, {:.2f} MB of index data saved",
+                 filePath,
+                 std::count(indexTypes.begin(), indexTypes.end(), VK_INDEX_TYPE_UINT16),
+                 indexTypes.size(), toMiB(shortIndexCount * sizeof(uint16_t)));
 
-        auto ib = std::make_shared<Buffer>(appContext, mesh.indices.size() * sizeof(uint32_t),
-                                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT, MemoryStyle::kDedicated);
-        ib->fillData(mesh.indices.data());
-        indexBuffers.push_back(ib);
+    _upload();
+}
 
-        vertCnts.push_back(static_cast<uint32_t>(mesh.vertices.size()));
-        idxCnts.push_back(static_cast<uint32_t>(mesh.indices.size()));
+Model::~Model() {
+    // the loader thread may still be reading the vertices or writing the buffers
+    if (uploadTicket != 0) {
+        _appContext->getAsyncUploader()->cancel(uploadTicket);
+    }
+}
+
+void Model::_import(ModelAttributes &model) {
+    bool const isQuantized = vertexFormat == VertexFormat::kQuantized;
+    for (auto &mesh : model.meshes) {
+        size_t const vertexCount =
+            isQuantized ? mesh.quantizedVertices.size() : mesh.vertices.size();
+        VkIndexType const indexType = ModelLoader::getIndexType(vertexCount);
+        _createMeshBuffers(static_cast<uint32_t>(vertexCount),
+                           static_cast<uint32_t>(mesh.indices.size()), indexType);
+
+        // moved, the model keeps the only cpu side copy until the upload is done
+        if (isQuantized) {
+            quantizedVertices.push_back(std::move(mesh.quantizedVertices));
+        } else {
+            vertices.push_back(std::move(mesh.vertices));
+        }
+        dequantizations.push_back(mesh.dequantization);
+
+        if (indexType == VK_INDEX_TYPE_UINT16) {
+            indices.emplace_back();
+            shortIndices.emplace_back(mesh.indices.begin(), mesh.indices.end());
+        } else {
+            indices.push_back(std::move(mesh.indices));
+            shortIndices.emplace_back();
+        }
 
         baseColorTexturePaths.push_back(mesh.baseColorTexturePath);
         normalTexturePaths.push_back(mesh.normalTexturePath);
@@ -37,6 +122,110 @@ Model::Model(VulkanApplicationContext *appContext, Logger *logger, const std::st
     }
 }
 
-Model::~Model() {
-    // Cleanup if necessary
-}
\ No newline at end of file
+void Model::_loadCooked() {
+    // only the tables are read here, the vertex and index pages are first touched by the upload
+    for (uint32_t i = 0; i < _cookedModel->getMeshCount(); ++i) {
+        auto const &mesh = _cookedModel->getMesh(i);
+        // lod 0 comes first in the index data, the other levels aren't drawn yet
+        _createMeshBuffers(mesh.vertexCount, _cookedModel->getLod(i, 0).indexCount,
+                           mesh.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16
+                                                              : VK_INDEX_TYPE_UINT32);
+
+        VertexDequantization dequantization{};
+        auto const &offset    = mesh.dequantizationOffset;
+        auto const &scale     = mesh.dequantizationScale;
+        dequantization.offset = glm::vec4(offset[0], offset[1], offset[2], offset[3]);
+        dequantization.scale  = glm::vec4(scale[0], scale[1], scale[2], scale[3]);
+        dequantizations.push_back(dequantization);
+
+        baseColorTexturePaths.push_back(_cookedModel->getTexturePath(i, MeshFile::kBaseColor));
+        normalTexturePaths.push_back(_cookedModel->getTexturePath(i, MeshFile::kNormal));
+        metallicRoughnessTexturePaths.push_back(
+            _cookedModel->getTexturePath(i, MeshFile::kMetallicRoughness));
+        emissiveTexturePaths.push_back(_cookedModel->getTexturePath(i, MeshFile::kEmissive));
+    }
+}
+
+void Model::_createMeshBuffers(uint32_t vertexCount, uint32_t indexCount,
+                               VkIndexType indexType) {
+    size_t const vertexSize =
+        vertexFormat == VertexFormat::kQuantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+    size_t const indexSize =
+        indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    vertexBuffers.push_back(std::make_shared<Buffer>(_appContext, vertexCount * vertexSize,
+                                                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                     MemoryStyle::kDeviceLocal));
+    indexBuffers.push_back(std::make_shared<Buffer>(_appContext, indexCount * indexSize,
+                                                    VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                                    MemoryStyle::kDeviceLocal));
+    vertCnts.push_back(vertexCount);
+    idxCnts.push_back(indexCount);
+    indexTypes.push_back(indexType);
+}
+
+void Model::_upload() {
+    auto *asyncUploader = _appContext->getAsyncUploader();
+    if (asyncUploader == nullptr) {
+        for (size_t i = 0; i < vertexBuffers.size(); ++i) {
+            vertexBuffers[i]->fillData(_getVertexData(i));
+            indexBuffers[i]->fillData(_getIndexData(i));
+        }
+        _releaseCpuData();
+        return;
+    }
+
+    // the cpu side copies (or the mapped file) are kept by the model until the ticket is ready,
+    // so the loader thread can read them directly
+    _isUploading = true;
+    uploadTicket = asyncUploader->enqueue([this](AsyncUploader::Recorder &recorder) {
+        for (size_t i = 0; i < vertexBuffers.size(); ++i) {
+            recorder.uploadToBuffer(vertexBuffers[i]->getVkBuffer(), 0, _getVertexData(i),
+                                    vertexBuffers[i]->getSize());
+            recorder.uploadToBuffer(indexBuffers[i]->getVkBuffer(), 0, _getIndexData(i),
+                                    indexBuffers[i]->getSize());
+        }
+    });
+    // the loader thread records the current VkBuffers, they must stay put until it is done
+    for (size_t i = 0; i < vertexBuffers.size(); ++i) {
+        vertexBuffers[i]->setUploadTicket(uploadTicket);
+        indexBuffers[i]->setUploadTicket(uploadTicket);
+    }
+}
+
+void Model::releaseUploadedData() {
+    if (!_isUploading || !_appContext->getAsyncUploader()->isReady(uploadTicket)) {
+        return;
+    }
+    _isUploading = false;
+    _releaseCpuData();
+}
+
+void Model::_releaseCpuData() {
+    // the buffers hold everything that is drawn, the inner vectors go with the outer ones
+    vertices.clear();
+    quantizedVertices.clear();
+    indices.clear();
+    shortIndices.clear();
+    _cookedModel.reset();
+}
+
+void const *Model::_getVertexData(size_t meshIndex) const {
+    if (_cookedModel != nullptr) {
+        return _cookedModel->getVertexData(static_cast<uint32_t>(meshIndex));
+    }
+    if (vertexFormat == VertexFormat::kQuantized) {
+        return quantizedVertices[meshIndex].data();
+    }
+    return vertices[meshIndex].data();
+}
+
+void const *Model::_getIndexData(size_t meshIndex) const {
+    if (_cookedModel != nullptr) {
+        return _cookedModel->getIndexData(static_cast<uint32_t>(meshIndex));
+    }
+    if (indexTypes[meshIndex] == VK_INDEX_TYPE_UINT16) {
+        return shortIndices[meshIndex].data();
+    }
+    return indices[meshIndex].data();
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -7,10 +8,38 @@
 #include "utils/vulkan-wrapper/memory/Buffer.hpp"
 
 class VulkanApplicationContext;
+namespace MeshFile {
+class MappedModel;
+}; // namespace MeshFile
 
+// loaded from the cooked .mesh file next to the source when there is a fresh one (see
+// MeshFile::getCookedPath and the mesh-cooker app), imported through assimp otherwise
 class Model {
   public:
-    Model(VulkanApplicationContext *appContext, Logger *logger, const std::string &filePath);
+    // everything that is read from disk before the first vulkan object is created, loading it
+    // touches neither the device nor a model, so several can be loaded on worker threads at once
+    struct Source {
+        std::string filePath;
+        VertexFormat vertexFormat = VertexFormat::kFloat;
+        // the mapped cooked file, or the imported model when there is no fresh one, neither when
+        // the load failed
+        std::unique_ptr<MeshFile::MappedModel> cookedModel;
+        std::optional<ModelAttributes> importedModel;
+        double loadTimeMs = 0.0;
+
+        Source();
+        ~Source();
+        Source(Source &&) noexcept;
+        Source &operator=(Source &&) noexcept;
+
+        // thread safe
+        static Source load(const std::string &filePath, VertexFormat vertexFormat, Logger *logger);
+    };
+
+    Model(VulkanApplicationContext *appContext, Logger *logger, const std::string &filePath,
+          VertexFormat vertexFormat = VertexFormat::kFloat);
+    // creates and uploads the buffers of a loaded source
+    Model(VulkanApplicationContext *appContext, Logger *logger, Source source);
     ~Model();
 
     Model(const Model &)            = delete;
@@ -18,8 +47,19 @@ class Model {
     Model(Model &&)                 = delete;
     Model &operator=(Model &&)      = delete;
 
+    // the layout of the vertex buffers, only the matching one of vertices and quantizedVertices
+    // is filled, and neither is for cooked models, whose data stays in the mapped file; the cpu
+    // side data is only kept until it's uploaded, see releaseUploadedData
+    VertexFormat vertexFormat;
     std::vector<std::vector<Vertex>> vertices;
+    std::vector<std::vector<QuantizedVertex>> quantizedVertices;
+    // per mesh, pushed with its draws
+    std::vector<VertexDequantization> dequantizations;
+    // per mesh, VK_INDEX_TYPE_UINT16 for meshes that fit, their indices are kept in shortIndices
+    // and indices is left empty
+    std::vector<VkIndexType> indexTypes;
     std::vector<std::vector<uint32_t>> indices;
+    std::vector<std::vector<uint16_t>> shortIndices;
     std::vector<std::shared_ptr<Buffer>> vertexBuffers;
     std::vector<uint32_t> vertCnts;
     std::vector<std::shared_ptr<Buffer>> indexBuffers;
@@ -30,8 +70,32 @@ class Model {
     std::vector<std::string> metallicRoughnessTexturePaths;
     std::vector<std::string> emissiveTexturePaths;
 
+    // the vertex and index data is streamed through the async uploader when there is one, the
+    // buffers must not be drawn before the ticket is ready, 0 when they were uploaded directly
+    uint64_t uploadTicket = 0;
+
+    // render thread, drops the cpu side copies and unmaps the cooked file once the ticket is
+    // ready, meant to be called every frame
+    void releaseUploadedData();
+
   private:
     VulkanApplicationContext *_appContext;
 
     Logger *_logger;
+
+    // the mapped cooked file the buffers are uploaded from, nullptr for imported models and once
+    // the upload is done
+    std::unique_ptr<MeshFile::MappedModel> _cookedModel;
+    // the upload task still reads the cpu side data
+    bool _isUploading = false;
+
+    void _import(ModelAttributes &model);
+    void _loadCooked();
+    void _createMeshBuffers(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType);
+    void _upload();
+    void _releaseCpuData();
+
+    // the cpu side data of a mesh, in the model's format
+    [[nodiscard]] void const *_getVertexData(size_t meshIndex) const;
+    [[nodiscard]] void const *_getIndexData(size_t meshIndex) const;
 };
\ No newline at end of file
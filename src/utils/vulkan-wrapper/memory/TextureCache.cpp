@@ -0,0 +1,124 @@
+#include "TextureCache.hpp"
+
+#include "utils/image-loader/TextureDecoder.hpp"
+#include "utils/logger/Logger.hpp"
+#include "utils/thread-pool/ThreadPool.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <system_error>
+#include <utility>
+
+namespace {
+// different spellings of the same file share the entry, the options are part of the key because
+// they change the resulting image
+std::string _makeKey(const std::string &path, VkImageUsageFlags usage, ImageMipmaps mipmaps,
+                     ImageCompression compression) {
+    std::error_code errorCode;
+    auto canonicalPath = std::filesystem::weakly_canonical(path, errorCode);
+    std::string key    = errorCode ? path : canonicalPath.generic_string();
+
+    key += '|' + std::to_string(usage) + '|' + std::to_string(static_cast<int>(mipmaps)) + '|' +
+           std::to_string(static_cast<int>(compression));
+    return key;
+}
+} // namespace
+
+TextureCache::TextureCache(VulkanApplicationContext *appContext, Logger *logger)
+    : _appContext(appContext), _logger(logger) {}
+
+std::shared_ptr<Image> TextureCache::acquire(const std::string &path, VkImageUsageFlags usage,
+                                             VkSampler sampler, ImageLoading loading,
+                                             ImageMipmaps mipmaps, ImageCompression compression) {
+    std::string const key = _makeKey(path, usage, mipmaps, compression);
+
+    auto it = _entries.find(key);
+    if (it != _entries.end()) {
+        if (auto image = it->second.lock()) {
+            _hits++;
+            return image;
+        }
+    }
+
+    _misses++;
+    std::shared_ptr<Image> image;
+    auto preloadedIt = _preloaded.find(key);
+    if (preloadedIt != _preloaded.end()) {
+        image = std::make_shared<Image>(_appContext, _logger, std::move(preloadedIt->second), usage,
+                                        sampler, loading, mipmaps);
+        _preloaded.erase(preloadedIt);
+    } else {
+        image = std::make_shared<Image>(_appContext, _logger, path, usage, sampler, loading,
+                                        mipmaps, compression);
+    }
+    if (image->getVkImage() == VK_NULL_HANDLE) {
+        return nullptr;
+    }
+    _entries[key] = image;
+    return image;
+}
+
+void TextureCache::preload(std::vector<Request> const &requests, ThreadPool *threadPool) {
+    auto const decodeStart = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<std::string, std::future<std::optional<Ktx2File::Ktx2Texture>>>>
+        decodes;
+    for (auto const &request : requests) {
+        std::string key = _makeKey(request.path, request.usage, request.mipmaps,
+                                   request.compression);
+        auto it         = _entries.find(key);
+        if ((it != _entries.end() && !it->second.expired()) || _preloaded.count(key) != 0) {
+            continue;
+        }
+
+        // picked here, the device is only queried from this thread
+        VkFormat format = Image::getCompressedFormat(_appContext, _logger, request.compression);
+        if (format == VK_FORMAT_UNDEFINED) {
+            format = VK_FORMAT_R8G8B8A8_UNORM;
+        }
+        bool const fullMipChain = request.mipmaps == ImageMipmaps::kFullChain;
+        // a null entry keeps the key from being decoded twice, it is dropped again below
+        _preloaded[key] = nullptr;
+        decodes.emplace_back(std::move(key),
+                             threadPool->submit([this, path = request.path, format, fullMipChain] {
+                                 return TextureDecoder::decode(path, format, fullMipChain,
+                                                               _logger);
+                             }));
+    }
+
+    size_t decodedCount = 0;
+    for (auto &[key, decode] : decodes) {
+        auto texture = decode.get();
+        if (!texture) {
+            // acquire loads it from the file again, and reports the failure there
+            _preloaded.erase(key);
+            continue;
+        }
+        _preloaded[key] = std::make_shared<Ktx2File::Ktx2Texture const>(std::move(*texture));
+        decodedCount++;
+    }
+
+    auto const decodeEnd = std::chrono::steady_clock::now();
+    _logger->info("TextureCache: decoded {} of {} textures on {} workers in {:.1f} ms",
+                  decodedCount, decodes.size(), threadPool->getWorkerCount(),
+                  std::chrono::duration<double, std::milli>(decodeEnd - decodeStart).count());
+}
+
+TextureCache::Stats TextureCache::getStats() {
+    Stats stats{};
+    stats.hits   = _hits;
+    stats.misses = _misses;
+
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        auto image = it->second.lock();
+        if (!image) {
+            it = _entries.erase(it);
+            continue;
+        }
+        stats.residentCount++;
+        stats.residentBytes += image->getAllocationSize();
+        ++it;
+    }
+    return stats;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Image.hpp"
+
+#include "volk.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Logger;
+class ThreadPool;
+class VulkanApplicationContext;
+
+// shares the images loaded from files, a file referenced by several meshes or models is decoded
+// and uploaded once, the entries are keyed by the canonical path together with the load options
+// and hold weak references, so an image lives as long as any handle to it
+class TextureCache {
+  public:
+    // a file together with the options it will be acquired with
+    struct Request {
+        std::string path;
+        VkImageUsageFlags usage      = 0;
+        ImageMipmaps mipmaps         = ImageMipmaps::kSingleLevel;
+        ImageCompression compression = ImageCompression::kNone;
+    };
+
+    struct Stats {
+        size_t hits          = 0;
+        size_t misses        = 0;
+        size_t residentCount = 0;
+        // device memory of the images that are still referenced
+        VkDeviceSize residentBytes = 0;
+    };
+
+    TextureCache(VulkanApplicationContext *appContext, Logger *logger);
+    ~TextureCache() = default;
+
+    // disable move and copy
+    TextureCache(const TextureCache &)            = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+    TextureCache(TextureCache &&)                 = delete;
+    TextureCache &operator=(TextureCache &&)      = delete;
+
+    // returns the cached image of the file if it is still alive, loads it otherwise, nullptr when
+    // the file can't be loaded, the sampler of the first load is kept for every later hit
+    std::shared_ptr<Image> acquire(const std::string &path, VkImageUsageFlags usage,
+                                   VkSampler sampler, ImageLoading loading, ImageMipmaps mipmaps,
+                                   ImageCompression compression);
+
+    // decodes the files that aren't resident yet on the pool, all at once, and blocks until they
+    // are done, so the acquires with the same options that follow only create and upload the
+    // images, the decoded textures are held until then
+    void preload(std::vector<Request> const &requests, ThreadPool *threadPool);
+
+    // entries of released images are dropped here as well
+    [[nodiscard]] Stats getStats();
+
+  private:
+    VulkanApplicationContext *_appContext;
+    Logger *_logger;
+
+    std::unordered_map<std::string, std::weak_ptr<Image>> _entries;
+    // decoded by preload and not acquired yet, by the same key as the entries
+    std::unordered_map<std::string, std::shared_ptr<Ktx2File::Ktx2Texture const>> _preloaded;
+    size_t _hits   = 0;
+    size_t _misses = 0;
+};
@@ -12,17 +12,30 @@
 GfxPipeline::GfxPipeline(VulkanApplicationContext *appContext, Logger *logger,
                          std::string fullPathToShaderSourceCode,
                          DescriptorSetBundle *descriptorSetBundle, ShaderCompiler *shaderCompiler,
-                         VkRenderPass renderPass)
+                         VkRenderPass renderPass, uint32_t variantFeatureCount,
+                         uint32_t quantizedVertexFeature)
     : Pipeline(appContext, logger, fullPathToShaderSourceCode, descriptorSetBundle,
                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
-      _shaderCompiler(shaderCompiler), _renderPass(renderPass) {
+      _shaderCompiler(shaderCompiler), _renderPass(renderPass),
+      _variantFeatureCount(variantFeatureCount),
+      _quantizedVertexFeature(quantizedVertexFeature) {
+    // variants only differ in their specialization constants, a cache lets the driver reuse most
+    // of the work between them
+    VkPipelineCacheCreateInfo pipelineCacheInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    vkCreatePipelineCache(_appContext->getDevice(), &pipelineCacheInfo, nullptr, &_pipelineCache);
+
     compileAndCacheShaderModule();
     build();
 }
 
 GfxPipeline::~GfxPipeline() {
+    _cleanupVariantPipelines();
     _cleanupPipelineAndLayout();
     _cleanupShaderModules();
+    for (auto const &retiredPipeline : _retiredPipelines) {
+        _destroyRetiredPipeline(retiredPipeline);
+    }
+    vkDestroyPipelineCache(_appContext->getDevice(), _pipelineCache, nullptr);
 }
 
 void GfxPipeline::compileAndCacheShaderModule() {
@@ -45,30 +58,104 @@ void GfxPipeline::compileAndCacheShaderModule() {
     }
 }
 
+void GfxPipeline::precompileShaders(ShaderCompiler *shaderCompiler, Logger *logger,
+                                    std::string const &fullPathToShaderSourceCode) {
+    auto const &path = fullPathToShaderSourceCode;
+    shaderCompiler->precompileShaderFromFile(
+        ShaderStage::kVert, path, FileReader::readShaderSourceCode(path + ".vert", logger));
+    shaderCompiler->precompileShaderFromFile(
+        ShaderStage::kFrag, path, FileReader::readShaderSourceCode(path + ".frag", logger));
+}
+
 void GfxPipeline::build() {
     if (_vertShaderModule == VK_NULL_HANDLE || _fragShaderModule == VK_NULL_HANDLE) {
         throw std::runtime_error("Shader modules are not created!");
     }
 
+    if (!_descriptorSetBundle || _descriptorSetBundle->getDescriptorSetLayout() == VK_NULL_HANDLE) {
+        throw std::runtime_error("Descriptor set layout is not created!");
+    }
+
+    _cleanupVariantPipelines();
+    _cleanupPipelineAndLayout();
+
+    // the per mesh dequantization of the vertex positions
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = sizeof(VertexDequantization);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = 1;
+    pipelineLayoutInfo.pSetLayouts            = &_descriptorSetBundle->getDescriptorSetLayout();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(_appContext->getDevice(), &pipelineLayoutInfo, nullptr,
+                               &_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    // variant 0 (every feature off) doubles as the default pipeline
+    _pipeline            = _createPipelineVariant(0);
+    _variantPipelines[0] = _pipeline;
+}
+
+VkPipeline GfxPipeline::getPipelineVariant(uint32_t variantKey) {
+    auto it = _variantPipelines.find(variantKey);
+    if (it != _variantPipelines.end()) {
+        return it->second;
+    }
+
+    _logger->info("GfxPipeline: building variant {:#x} of {}", variantKey,
+                  _fullPathToShaderSourceCode);
+    VkPipeline pipeline           = _createPipelineVariant(variantKey);
+    _variantPipelines[variantKey] = pipeline;
+    return pipeline;
+}
+
+VkPipeline GfxPipeline::_createPipelineVariant(uint32_t variantKey) {
+    // bit i of the variant key feeds the boolean specialization constant with constant_id i
+    std::vector<VkBool32> specializationData(_variantFeatureCount);
+    std::vector<VkSpecializationMapEntry> specializationEntries(_variantFeatureCount);
+    for (uint32_t i = 0; i < _variantFeatureCount; i++) {
+        specializationData[i]               = (variantKey >> i) & 1U;
+        specializationEntries[i].constantID = i;
+        specializationEntries[i].offset     = i * sizeof(VkBool32);
+        specializationEntries[i].size       = sizeof(VkBool32);
+    }
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+    specializationInfo.pMapEntries   = specializationEntries.data();
+    specializationInfo.dataSize      = specializationData.size() * sizeof(VkBool32);
+    specializationInfo.pData         = specializationData.data();
+
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = _vertShaderModule;
-    vertShaderStageInfo.pName  = "main";
+    vertShaderStageInfo.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage               = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module              = _vertShaderModule;
+    vertShaderStageInfo.pName               = "main";
+    vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
     VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = _fragShaderModule;
-    fragShaderStageInfo.pName  = "main";
+    fragShaderStageInfo.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage               = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module              = _fragShaderModule;
+    fragShaderStageInfo.pName               = "main";
+    fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
 
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto vertexBindingDescription    = Vertex::GetBindingDescription();
-    auto vertexAttributeDescriptions = Vertex::GetAttributeDescriptions();
+    bool const isQuantized           = (variantKey & _quantizedVertexFeature) != 0;
+    auto vertexBindingDescription    = isQuantized ? QuantizedVertex::GetBindingDescription()
+                                                   : Vertex::GetBindingDescription();
+    auto vertexAttributeDescriptions = isQuantized ? QuantizedVertex::GetAttributeDescriptions()
+                                                   : Vertex::GetAttributeDescriptions();
 
     // Instance binding description (binding index 1)
     VkVertexInputBindingDescription instanceBindingDescription{};
@@ -182,21 +269,6 @@ void GfxPipeline::build() {
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStatesArray.size());
     dynamicState.pDynamicStates    = dynamicStatesArray.data();
 
-    if (!_descriptorSetBundle || _descriptorSetBundle->getDescriptorSetLayout() == VK_NULL_HANDLE) {
-        throw std::runtime_error("Descriptor set layout is not created!");
-    }
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount         = 1;
-    pipelineLayoutInfo.pSetLayouts            = &_descriptorSetBundle->getDescriptorSetLayout();
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-
-    if (vkCreatePipelineLayout(_appContext->getDevice(), &pipelineLayoutInfo, nullptr,
-                               &_pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
-
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount          = 2;
@@ -214,10 +286,22 @@ void GfxPipeline::build() {
     pipelineInfo.subpass             = 0;
     pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(_appContext->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo,
-                                  nullptr, &_pipeline) != VK_SUCCESS) {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(_appContext->getDevice(), _pipelineCache, 1, &pipelineInfo,
+                                  nullptr, &pipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
+    return pipeline;
+}
+
+// destroys every variant except the default one, which is owned by the base class
+void GfxPipeline::_cleanupVariantPipelines() {
+    for (auto const &[variantKey, pipeline] : _variantPipelines) {
+        if (pipeline != _pipeline) {
+            vkDestroyPipeline(_appContext->getDevice(), pipeline, nullptr);
+        }
+    }
+    _variantPipelines.clear();
 }
 
 void GfxPipeline::_cleanupShaderModules() {
@@ -231,6 +315,64 @@ void GfxPipeline::_cleanupShaderModules() {
     }
 }
 
+bool GfxPipeline::hotSwap(std::vector<uint32_t> const &vertCode,
+                          std::vector<uint32_t> const &fragCode, size_t framesToKeepAlive) {
+    RetiredPipeline previous{_pipeline,         _variantPipelines, _pipelineLayout,
+                             _vertShaderModule, _fragShaderModule, framesToKeepAlive};
+
+    _pipeline         = VK_NULL_HANDLE;
+    _pipelineLayout   = VK_NULL_HANDLE;
+    _variantPipelines = {};
+    _vertShaderModule = _createShaderModule(vertCode);
+    _fragShaderModule = _createShaderModule(fragCode);
+
+    try {
+        build();
+        // rebuild the variants that were in use right away, so the next frame doesn't hitch
+        for (auto const &[variantKey, pipeline] : previous.variantPipelines) {
+            getPipelineVariant(variantKey);
+        }
+    } catch (std::runtime_error const &e) {
+        _logger->warn("GfxPipeline::hotSwap() failed for {}: {}", _fullPathToShaderSourceCode,
+                      e.what());
+        _cleanupVariantPipelines();
+        _cleanupPipelineAndLayout();
+        _cleanupShaderModules();
+
+        _pipeline         = previous.pipeline;
+        _variantPipelines = std::move(previous.variantPipelines);
+        _pipelineLayout   = previous.pipelineLayout;
+        _vertShaderModule = previous.vertShaderModule;
+        _fragShaderModule = previous.fragShaderModule;
+        return false;
+    }
+
+    // command buffers of the frames still in flight may reference the previous pipeline
+    _retiredPipelines.push_back(std::move(previous));
+    return true;
+}
+
+void GfxPipeline::releaseRetiredPipelines() {
+    std::erase_if(_retiredPipelines, [this](RetiredPipeline &retiredPipeline) {
+        if (retiredPipeline.framesLeft > 0) {
+            retiredPipeline.framesLeft--;
+            return false;
+        }
+        _destroyRetiredPipeline(retiredPipeline);
+        return true;
+    });
+}
+
+void GfxPipeline::_destroyRetiredPipeline(RetiredPipeline const &retiredPipeline) {
+    VkDevice device = _appContext->getDevice();
+    for (auto const &[variantKey, pipeline] : retiredPipeline.variantPipelines) {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    }
+    vkDestroyPipelineLayout(device, retiredPipeline.pipelineLayout, nullptr);
+    vkDestroyShaderModule(device, retiredPipeline.vertShaderModule, nullptr);
+    vkDestroyShaderModule(device, retiredPipeline.fragShaderModule, nullptr);
+}
+
 void GfxPipeline::recordDrawIndexed(VkCommandBuffer commandBuffer, size_t currentFrame) {
     recordBind(commandBuffer, currentFrame);
     // TODO:
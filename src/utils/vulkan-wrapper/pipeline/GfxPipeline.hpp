@@ -4,14 +4,24 @@
 #include "utils/incl/GlmIncl.hpp" // IWYU pragma: export
 #include "vma/vk_mem_alloc.h"
 
+#include <unordered_map>
+#include <vector>
+
 class ShaderCompiler;
 
 // GFX shaders should be placed in a folder and name as vert.glsl & frag.glsl
+//
+// shaders may declare up to variantFeatureCount boolean specialization constants with
+// constant_id 0, 1, ..., a variant key selects their values bitwise, and one pipeline is built and
+// cached per variant key actually requested
+// variants with the quantizedVertexFeature bit set read QuantizedVertex instead of Vertex, the
+// vertex stage always gets a VertexDequantization push constant
 class GfxPipeline : public Pipeline {
   public:
     GfxPipeline(VulkanApplicationContext *appContext, Logger *logger,
                 std::string fullPathToShaderSourceCode, DescriptorSetBundle *descriptorSetBundle,
-                ShaderCompiler *shaderCompiler, VkRenderPass renderPass);
+                ShaderCompiler *shaderCompiler, VkRenderPass renderPass,
+                uint32_t variantFeatureCount = 0, uint32_t quantizedVertexFeature = 0);
 
     ~GfxPipeline() override;
 
@@ -23,8 +33,25 @@ class GfxPipeline : public Pipeline {
     void build() override;
     void compileAndCacheShaderModule() override;
 
+    // compiles the stages of the pipeline at fullPathToShaderSourceCode before it is created, its
+    // constructor then takes them from the compiler, see ShaderCompiler::precompileShaderFromFile
+    static void precompileShaders(ShaderCompiler *shaderCompiler, Logger *logger,
+                                  std::string const &fullPathToShaderSourceCode);
+
     void recordDrawIndexed(VkCommandBuffer commandBuffer, size_t currentFrame);
 
+    // returns the cached pipeline of the variant, builds it on first use
+    VkPipeline getPipelineVariant(uint32_t variantKey);
+
+    // swaps in shader code compiled elsewhere (e.g. by the hot reloader) without stalling the
+    // device, the old pipeline stays alive until framesToKeepAlive more frames have been retired
+    // returns false and keeps the old pipeline if the new one cannot be built
+    bool hotSwap(std::vector<uint32_t> const &vertCode, std::vector<uint32_t> const &fragCode,
+                 size_t framesToKeepAlive);
+
+    // call once per frame, after the frame's fence has been waited on
+    void releaseRetiredPipelines();
+
   private:
     ShaderCompiler *_shaderCompiler;
 
@@ -35,5 +62,22 @@ class GfxPipeline : public Pipeline {
 
     VkRenderPass _renderPass;
 
+    uint32_t _variantFeatureCount;
+    uint32_t _quantizedVertexFeature;
+    std::unordered_map<uint32_t, VkPipeline> _variantPipelines{};
+
+    struct RetiredPipeline {
+        VkPipeline pipeline;
+        std::unordered_map<uint32_t, VkPipeline> variantPipelines;
+        VkPipelineLayout pipelineLayout;
+        VkShaderModule vertShaderModule;
+        VkShaderModule fragShaderModule;
+        size_t framesLeft;
+    };
+    std::vector<RetiredPipeline> _retiredPipelines{};
+
+    VkPipeline _createPipelineVariant(uint32_t variantKey);
+    void _cleanupVariantPipelines();
     void _cleanupShaderModules();
+    void _destroyRetiredPipeline(RetiredPipeline const &retiredPipeline);
 };
@@ -2,21 +2,42 @@
 
 #include "app-context/VulkanApplicationContext.hpp"
 
+#include <algorithm>
+
+namespace {
+float _getSupportedAnisotropy(VkPhysicalDevice physicalDevice, float requestedAnisotropy) {
+    // the device is created with every feature it supports, so supported means enabled here
+    VkPhysicalDeviceFeatures features{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    if (features.samplerAnisotropy == VK_FALSE) {
+        return 1.0F;
+    }
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return std::clamp(requestedAnisotropy, 1.0F, properties.limits.maxSamplerAnisotropy);
+}
+} // namespace
+
 Sampler::Sampler(VulkanApplicationContext *appContext, Sampler::Settings const &settings)
     : _appContext(appContext) {
     VkSamplerCreateInfo samplerInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
     samplerInfo.magFilter               = VK_FILTER_LINEAR; // For bilinear interpolation
     samplerInfo.minFilter               = VK_FILTER_LINEAR; // For bilinear interpolation
-    samplerInfo.anisotropyEnable        = VK_FALSE;
-    samplerInfo.maxAnisotropy           = 1;
     samplerInfo.borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
     samplerInfo.compareEnable           = VK_FALSE;
     samplerInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.mipLodBias              = 0.0F;
-    samplerInfo.minLod                  = 0.0F;
-    samplerInfo.maxLod                  = 0.0F;
+
+    samplerInfo.mipmapMode = static_cast<VkSamplerMipmapMode>(settings.mipmapMode);
+    samplerInfo.mipLodBias = settings.mipLodBias;
+    samplerInfo.minLod     = settings.minLod;
+    samplerInfo.maxLod     = settings.maxLod;
+
+    float const maxAnisotropy =
+        _getSupportedAnisotropy(_appContext->getPhysicalDevice(), settings.maxAnisotropy);
+    samplerInfo.anisotropyEnable = maxAnisotropy > 1.0F ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy    = maxAnisotropy;
 
     samplerInfo.addressModeU = static_cast<VkSamplerAddressMode>(settings.addressModeU);
     samplerInfo.addressModeV = static_cast<VkSamplerAddressMode>(settings.addressModeV);
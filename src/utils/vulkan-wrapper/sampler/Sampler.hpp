@@ -13,10 +13,25 @@ class Sampler {
         kClampToBorder  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER
     };
 
+    // how the two nearest mip levels are combined, linear gives trilinear filtering
+    enum class MipmapMode {
+        kNearest = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        kLinear  = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+    };
+
     struct Settings {
         AddressMode addressModeU;
         AddressMode addressModeV;
         AddressMode addressModeW;
+        MipmapMode mipmapMode = MipmapMode::kLinear;
+        // clamped to the device limit, 1 (or a device without samplerAnisotropy) disables it
+        float maxAnisotropy = 1.0F;
+        float mipLodBias    = 0.0F;
+        float minLod        = 0.0F;
+        // VK_LOD_CLAMP_NONE allows every mip level the image view has
+        float maxLod = VK_LOD_CLAMP_NONE;
+
+        bool operator==(Settings const &rhs) const = default;
     };
 
     Sampler(VulkanApplicationContext *appContext, Settings const &settings);
@@ -0,0 +1,30 @@
+#include "SamplerCache.hpp"
+
+#include <functional>
+
+namespace {
+void _hashCombine(size_t &seed, size_t value) {
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+} // namespace
+
+size_t SamplerCache::SettingsHash::operator()(Sampler::Settings const &settings) const {
+    size_t seed = 0;
+    _hashCombine(seed, static_cast<size_t>(settings.addressModeU));
+    _hashCombine(seed, static_cast<size_t>(settings.addressModeV));
+    _hashCombine(seed, static_cast<size_t>(settings.addressModeW));
+    _hashCombine(seed, static_cast<size_t>(settings.mipmapMode));
+    _hashCombine(seed, std::hash<float>{}(settings.maxAnisotropy));
+    _hashCombine(seed, std::hash<float>{}(settings.mipLodBias));
+    _hashCombine(seed, std::hash<float>{}(settings.minLod));
+    _hashCombine(seed, std::hash<float>{}(settings.maxLod));
+    return seed;
+}
+
+Sampler *SamplerCache::get(Sampler::Settings const &settings) {
+    auto it = _samplers.find(settings);
+    if (it == _samplers.end()) {
+        it = _samplers.emplace(settings, std::make_unique<Sampler>(_appContext, settings)).first;
+    }
+    return it->second.get();
+}
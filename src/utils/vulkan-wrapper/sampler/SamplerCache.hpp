@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Sampler.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+class VulkanApplicationContext;
+
+// samplers are immutable and only differ by their settings, so one per distinct settings is
+// enough for the whole renderer, they live as long as the cache
+class SamplerCache {
+  public:
+    explicit SamplerCache(VulkanApplicationContext *appContext) : _appContext(appContext) {}
+    ~SamplerCache() = default;
+
+    // disable move and copy
+    SamplerCache(const SamplerCache &)            = delete;
+    SamplerCache &operator=(const SamplerCache &) = delete;
+    SamplerCache(SamplerCache &&)                 = delete;
+    SamplerCache &operator=(SamplerCache &&)      = delete;
+
+    // creates the sampler on the first request for these settings
+    Sampler *get(Sampler::Settings const &settings);
+
+    [[nodiscard]] size_t getSamplerCount() const { return _samplers.size(); }
+
+  private:
+    struct SettingsHash {
+        size_t operator()(Sampler::Settings const &settings) const;
+    };
+
+    VulkanApplicationContext *_appContext;
+
+    std::unordered_map<Sampler::Settings, std::unique_ptr<Sampler>, SettingsHash> _samplers{};
+};
@@ -0,0 +1,131 @@
+// Ktx2File::read must reject a cached texture whose levels don't hold exactly the blocks of their
+// extent, the loader uploads every level with a copy of its full extent
+#include "utils/image-loader/Ktx2File.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+// the level index follows the 80 byte header, 24 bytes per level
+constexpr size_t kLevelIndexOffset    = 80;
+constexpr size_t kLevelIndexEntrySize = 24;
+constexpr size_t kLevelCountOffset    = 40;
+
+int _failureCount = 0;
+
+void _check(bool condition, char const *what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        _failureCount++;
+    }
+}
+
+// an 8x8 bc7 texture with its full chain of 4 levels, 16 bytes per 4x4 block
+Ktx2File::Ktx2Texture _makeTexture() {
+    Ktx2File::Ktx2Texture texture{};
+    texture.format = VK_FORMAT_BC7_UNORM_BLOCK;
+    texture.width  = 8;
+    texture.height = 8;
+    uint32_t size  = 8;
+    for (size_t offset = 0; size > 0; size /= 2) {
+        size_t const byteSize = size == 8 ? 64 : 16;
+        texture.levels.push_back({size, size, offset, byteSize});
+        offset += byteSize;
+    }
+    for (auto const &level : texture.levels) {
+        for (size_t i = 0; i < level.size; i++) {
+            texture.data.push_back(static_cast<unsigned char>(level.width + i));
+        }
+    }
+    return texture;
+}
+
+std::vector<unsigned char> _readBytes(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void _writeBytes(std::string const &path, std::vector<unsigned char> const &bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<char const *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+}
+
+void _writeU64(std::vector<unsigned char> &bytes, size_t offset, uint64_t value) {
+    for (size_t i = 0; i < 8; i++) {
+        bytes[offset + i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFFU);
+    }
+}
+
+uint64_t _readU64(std::vector<unsigned char> const &bytes, size_t offset) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; i++) {
+        value |= static_cast<uint64_t>(bytes[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+// writes the valid file, lets corrupt change it and checks that it's rejected
+void _checkRejected(std::string const &path, std::vector<unsigned char> const &valid,
+                    std::function<void(std::vector<unsigned char> &)> const &corrupt,
+                    char const *what) {
+    auto bytes = valid;
+    corrupt(bytes);
+    _writeBytes(path, bytes);
+    _check(!Ktx2File::read(path).has_value(), what);
+}
+} // namespace
+
+int main() {
+    auto const path = (std::filesystem::temp_directory_path() / "ktx2-file-test.ktx2").string();
+
+    auto const texture = _makeTexture();
+    _check(Ktx2File::write(path, texture), "an 8x8 bc7 texture is written");
+    auto const read = Ktx2File::read(path);
+    _check(read.has_value() && read->levels.size() == texture.levels.size(),
+           "the written texture is read back with all of its levels");
+    if (read.has_value()) {
+        for (size_t i = 0; i < read->levels.size() && i < texture.levels.size(); i++) {
+            _check(read->levels[i].size == texture.levels[i].size,
+                   "every level is read back with its size");
+        }
+    }
+
+    auto const valid = _readBytes(path);
+    // level 0 is stored last, so the end of the file is part of it
+    _checkRejected(
+        path, valid, [](auto &bytes) { bytes.resize(bytes.size() - 8); },
+        "a truncated file is rejected");
+    _checkRejected(
+        path, valid,
+        [](auto &bytes) { _writeU64(bytes, kLevelIndexOffset + kLevelIndexEntrySize + 8, 8); },
+        "a level smaller than its extent is rejected");
+    _checkRejected(
+        path, valid,
+        [](auto &bytes) { _writeU64(bytes, kLevelIndexOffset + kLevelIndexEntrySize + 8, 32); },
+        "a level larger than its extent is rejected");
+    // the smallest level is stored first, so there is room after it
+    _checkRejected(
+        path, valid,
+        [](auto &bytes) {
+            size_t const entry = kLevelIndexOffset + kLevelIndexEntrySize * 3;
+            _writeU64(bytes, entry, _readU64(bytes, entry) + 1);
+        },
+        "a level offset off the block alignment is rejected");
+    _checkRejected(
+        path, valid, [](auto &bytes) { bytes[kLevelCountOffset] = 5; },
+        "more levels than an 8x8 texture has are rejected");
+
+    std::filesystem::remove(path);
+    if (_failureCount > 0) {
+        return 1;
+    }
+    std::printf("Ktx2File tests passed\n");
+    return 0;
+}